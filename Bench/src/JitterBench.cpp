@@ -0,0 +1,218 @@
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <getopt.h>
+#include <cerrno>
+#include <time.h>
+#include "../../System/include/StatsPage.h"
+#include "../../DaemonLib/include/Realtime.h"
+#include "../../DaemonLib/include/Trace.h"
+
+/**
+ * Measures how late a periodic thread wakes up, the way the monitoring
+ * loop does (absolute CLOCK_MONOTONIC deadlines), while CPU-bound load
+ * threads compete for the cores. The run is repeated with the default
+ * policy and with the requested pinning/scheduling so the effect of the
+ * radio-server real-time options can be compared on the target host.
+ */
+
+struct CommandLineOptions {
+    unsigned period_us = 1000;
+    size_t iterations = 5000;
+    unsigned load_threads = std::max(1u, std::thread::hardware_concurrency());
+    ThreadPolicy policy;
+    bool lock_memory = false;
+    bool help = false;
+};
+
+void showUsage(const char* programName) {
+    std::cout << "Monitoring Loop Wakeup Jitter Benchmark" << std::endl;
+    std::cout << "Usage: " << programName << " [OPTION]" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  -p, --period US        Tick period in microseconds (default 1000)" << std::endl;
+    std::cout << "  -n, --iterations N     Ticks per run (default 5000)" << std::endl;
+    std::cout << "  -l, --load N           CPU-bound load threads (default: one per core)" << std::endl;
+    std::cout << "  -c, --cpu N            Pin the measured thread to core N in the tuned run" << std::endl;
+    std::cout << "  -s, --sched POLICY     fifo:PRIO, rr:PRIO or other for the tuned run" << std::endl;
+    std::cout << "  -m, --mlock            Lock process memory before the tuned run" << std::endl;
+    std::cout << "  -h, --help             Show this help message" << std::endl;
+}
+
+bool parseCommandLine(int argc, char* argv[], CommandLineOptions& options) {
+    static struct option longOptions[] = {
+        {"period", required_argument, 0, 'p'},
+        {"iterations", required_argument, 0, 'n'},
+        {"load", required_argument, 0, 'l'},
+        {"cpu", required_argument, 0, 'c'},
+        {"sched", required_argument, 0, 's'},
+        {"mlock", no_argument, 0, 'm'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    const char* shortOptions = "p:n:l:c:s:mh";
+
+    int optionIndex = 0;
+    int c;
+
+    optind = 0;
+    opterr = 0;
+
+    try {
+        while ((c = getopt_long(argc, argv, shortOptions, longOptions, &optionIndex)) != -1) {
+            switch (c) {
+                case 'p':
+                    options.period_us = static_cast<unsigned>(std::stoul(optarg));
+                    break;
+                case 'n':
+                    options.iterations = std::stoul(optarg);
+                    break;
+                case 'l':
+                    options.load_threads = static_cast<unsigned>(std::stoul(optarg));
+                    break;
+                case 'c':
+                    options.policy.cpu = std::stoi(optarg);
+                    break;
+                case 's': {
+                    std::string error;
+                    if (!ThreadPolicy::parseScheduling(optarg, options.policy, error)) {
+                        std::cerr << error << std::endl;
+                        return false;
+                    }
+                    break;
+                }
+                case 'm':
+                    options.lock_memory = true;
+                    break;
+                case 'h':
+                    options.help = true;
+                    break;
+                default:
+                    std::cerr << "Unknown option: " << argv[optind - 1] << std::endl;
+                    return false;
+            }
+        }
+    } catch (const std::exception&) {
+        std::cerr << "Invalid numeric argument: " << argv[optind - 1] << std::endl;
+        return false;
+    }
+
+    if (optind < argc) {
+        std::cerr << "Unexpected argument: " << argv[optind] << std::endl;
+        return false;
+    }
+    if (options.period_us == 0 || options.iterations == 0) {
+        std::cerr << "Period and iterations must be positive" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+std::string formatDuration(double ns) {
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(1);
+    if (ns < 1e3) ss << ns << "ns";
+    else if (ns < 1e6) ss << ns / 1e3 << "us";
+    else if (ns < 1e9) ss << ns / 1e6 << "ms";
+    else ss << ns / 1e9 << "s";
+    return ss.str();
+}
+
+/**
+ * @brief Runs one measurement and prints its row
+ */
+void runPhase(const std::string& name, const CommandLineOptions& options, const ThreadPolicy& policy) {
+    std::atomic<bool> stop_load{false};
+    std::vector<std::thread> load;
+    for (unsigned i = 0; i < options.load_threads; ++i) {
+        load.emplace_back([&stop_load]() {
+            volatile uint64_t sink = 0;
+            while (!stop_load.load(std::memory_order_relaxed)) {
+                for (int k = 0; k < 1000; ++k) sink = sink + k;
+            }
+        });
+    }
+
+    std::unique_ptr<LatencyHistogram> jitter(new LatencyHistogram());
+    std::string error;
+
+    std::thread measured([&]() {
+        // On failure measure anyway; the warning marks the row as untuned
+        if (!policy.isDefault()) {
+            policy.apply(pthread_self(), error);
+        }
+
+        int64_t period = static_cast<int64_t>(options.period_us) * 1000;
+        int64_t next = Tracer::now() + period;
+        for (size_t i = 0; i < options.iterations; ++i) {
+            timespec ts;
+            ts.tv_sec = next / 1000000000LL;
+            ts.tv_nsec = next % 1000000000LL;
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+            }
+            int64_t late = Tracer::now() - next;
+            jitter->record(static_cast<uint64_t>(late > 0 ? late : 0));
+            next += period;
+        }
+    });
+    measured.join();
+
+    stop_load = true;
+    for (auto& thread : load) {
+        thread.join();
+    }
+
+    std::cout << std::left << std::setw(30) << (name + " (" + policy.describe() + ")") << std::right
+              << std::setw(10) << formatDuration(jitter->mean())
+              << std::setw(10) << formatDuration(jitter->percentile(0.50))
+              << std::setw(10) << formatDuration(jitter->percentile(0.99))
+              << std::setw(10) << formatDuration(jitter->percentile(0.999))
+              << std::setw(10) << formatDuration(jitter->max.load()) << std::endl;
+    if (!error.empty()) {
+        std::cout << "  warning: " << error << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    CommandLineOptions options;
+
+    if (!parseCommandLine(argc, argv, options)) {
+        showUsage(argv[0]);
+        return -1;
+    }
+
+    if (options.help) {
+        showUsage(argv[0]);
+        return 0;
+    }
+
+    std::cout << options.iterations << " ticks of " << options.period_us << " us, "
+              << options.load_threads << " load threads" << std::endl;
+    std::cout << std::left << std::setw(30) << "wakeup delay" << std::right
+              << std::setw(10) << "mean" << std::setw(10) << "p50"
+              << std::setw(10) << "p99" << std::setw(10) << "p999"
+              << std::setw(10) << "max" << std::endl;
+
+    runPhase("default", options, ThreadPolicy());
+
+    if (options.lock_memory) {
+        std::string error;
+        if (!RealtimeConfig::lockMemory(error)) {
+            std::cout << "  warning: " << error << std::endl;
+        }
+    }
+    if (!options.policy.isDefault()) {
+        runPhase("tuned", options, options.policy);
+    } else {
+        std::cout << "No --cpu or --sched given; pass e.g. --sched fifo:80 to compare." << std::endl;
+    }
+
+    return 0;
+}
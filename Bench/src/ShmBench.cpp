@@ -0,0 +1,306 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <getopt.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "../../System/include/SharedData.h"
+#include "../../DaemonLib/include/Trace.h"
+
+/**
+ * Measures command round trips through the shared segment, the way
+ * Client and Server use it (command copy, sem_post, response copy,
+ * sem_post), while two writer threads keep publishing telemetry and
+ * alarms like the monitoring thread and the alarm dispatcher do. The run
+ * is repeated with the packed pre-v2 layout, where all writers share
+ * cache lines, and with the current SharedData layout in a SharedSegment
+ * (optionally on huge pages and locked), using one request slot. Both
+ * runs hand over with a pair of semaphores, so only the layouts differ.
+ */
+
+/**
+ * @brief SharedData before cache-line separation, for comparison
+ */
+struct LegacySharedData {
+    char command[256];
+    char response[1024];
+    int64_t command_posted_ns;
+
+    struct {
+        double temperature;
+        double current;
+        double power;
+        double voltage;
+        int active_alarms_count;
+        bool service_enabled;
+        char last_update[64];
+        unsigned int alarm_events;
+        char last_alarm[160];
+    } monitoring;
+};
+
+struct CommandLineOptions {
+    size_t iterations = 100000;
+    bool writers = true;
+    ShmOptions shm;
+    bool help = false;
+};
+
+void showUsage(const char* programName) {
+    std::cout << "Shared Memory Round-Trip Benchmark" << std::endl;
+    std::cout << "Usage: " << programName << " [OPTION]" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  -n, --iterations N     Round trips per run (default 100000)" << std::endl;
+    std::cout << "  -q, --quiet            No telemetry/alarm writer threads" << std::endl;
+    std::cout << "  -H, --hugepages        Back the v2 segment with huge pages" << std::endl;
+    std::cout << "  -m, --mlock            Lock the v2 segment" << std::endl;
+    std::cout << "  -h, --help             Show this help message" << std::endl;
+}
+
+bool parseCommandLine(int argc, char* argv[], CommandLineOptions& options) {
+    static struct option longOptions[] = {
+        {"iterations", required_argument, 0, 'n'},
+        {"quiet", no_argument, 0, 'q'},
+        {"hugepages", no_argument, 0, 'H'},
+        {"mlock", no_argument, 0, 'm'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    const char* shortOptions = "n:qHmh";
+
+    int optionIndex = 0;
+    int c;
+
+    optind = 0;
+    opterr = 0;
+
+    try {
+        while ((c = getopt_long(argc, argv, shortOptions, longOptions, &optionIndex)) != -1) {
+            switch (c) {
+                case 'n':
+                    options.iterations = std::stoul(optarg);
+                    break;
+                case 'q':
+                    options.writers = false;
+                    break;
+                case 'H':
+                    options.shm.hugepages = true;
+                    break;
+                case 'm':
+                    options.shm.lock = true;
+                    break;
+                case 'h':
+                    options.help = true;
+                    break;
+                default:
+                    std::cerr << "Unknown option: " << argv[optind - 1] << std::endl;
+                    return false;
+            }
+        }
+    } catch (const std::exception&) {
+        std::cerr << "Invalid numeric argument: " << argv[optind - 1] << std::endl;
+        return false;
+    }
+
+    if (optind < argc) {
+        std::cerr << "Unexpected argument: " << argv[optind] << std::endl;
+        return false;
+    }
+    if (options.iterations == 0) {
+        std::cerr << "Iterations must be positive" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+std::string formatDuration(double ns) {
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(1);
+    if (ns < 1e3) ss << ns << "ns";
+    else if (ns < 1e6) ss << ns / 1e3 << "us";
+    else if (ns < 1e9) ss << ns / 1e6 << "ms";
+    else ss << ns / 1e9 << "s";
+    return ss.str();
+}
+
+// Field access that differs between the two layouts
+char* commandOf(LegacySharedData* data) { return data->command; }
+char* responseOf(LegacySharedData* data) { return data->response; }
+int64_t& postedOf(LegacySharedData* data) { return data->command_posted_ns; }
+
+char* commandOf(SharedData* data) { return data->slots[0].command; }
+char* responseOf(SharedData* data) { return data->slots[0].response; }
+int64_t& postedOf(SharedData* data) { return data->slots[0].posted_ns; }
+
+void publishTelemetry(LegacySharedData* data, double value) {
+    data->monitoring.temperature = value;
+    data->monitoring.current = value;
+    data->monitoring.power = value;
+    data->monitoring.voltage = value;
+}
+
+void publishTelemetry(SharedData* data, double value) {
+    data->monitoring.temperature = value;
+    data->monitoring.current = value;
+    data->monitoring.power = value;
+    data->monitoring.voltage = value;
+}
+
+void publishAlarm(LegacySharedData* data) {
+    data->monitoring.alarm_events++;
+    data->monitoring.last_alarm[0] = static_cast<char>('A' + data->monitoring.alarm_events % 26);
+}
+
+void publishAlarm(SharedData* data) {
+    data->alarms.events++;
+    data->alarms.last[0] = static_cast<char>('A' + data->alarms.events % 26);
+}
+
+/**
+ * @brief Runs one measurement over the given segment and prints its row
+ */
+template <typename Layout>
+void runPhase(const std::string& name, Layout* data, const CommandLineOptions& options) {
+    // Process-shared semaphores in their own mapping, like the named ones
+    void* sem_page = mmap(nullptr, 2 * sizeof(sem_t), PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (sem_page == MAP_FAILED) {
+        std::cerr << "mmap failed" << std::endl;
+        return;
+    }
+    sem_t* sem_client = static_cast<sem_t*>(sem_page);
+    sem_t* sem_server = sem_client + 1;
+    sem_init(sem_client, 1, 0);
+    sem_init(sem_server, 1, 0);
+
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> writers;
+    if (options.writers) {
+        writers.emplace_back([&]() {
+            for (double value = 0; !stop.load(std::memory_order_relaxed); value += 1.0) {
+                publishTelemetry(data, value);
+            }
+        });
+        writers.emplace_back([&]() {
+            while (!stop.load(std::memory_order_relaxed)) {
+                publishAlarm(data);
+            }
+        });
+    }
+
+    std::thread server([&]() {
+        for (size_t i = 0; i < options.iterations; ++i) {
+            sem_wait(sem_client);
+            postedOf(data) = 0;
+            // Same work as Server::writeResponse for a short reply
+            char reply[64];
+            snprintf(reply, sizeof(reply), "SUCCESS: %.32s", commandOf(data));
+            strncpy(responseOf(data), reply, 1023);
+            sem_post(sem_server);
+        }
+    });
+
+    std::vector<int64_t> samples;
+    samples.reserve(options.iterations);
+    size_t checksum = 0;
+    for (size_t i = 0; i < options.iterations; ++i) {
+        int64_t start = Tracer::now();
+        strncpy(commandOf(data), "GET frequency", 255);
+        postedOf(data) = start;
+        sem_post(sem_client);
+        sem_wait(sem_server);
+        checksum += static_cast<unsigned char>(responseOf(data)[0]);
+        samples.push_back(Tracer::now() - start);
+    }
+    server.join();
+
+    stop = true;
+    for (auto& thread : writers) {
+        thread.join();
+    }
+    sem_destroy(sem_client);
+    sem_destroy(sem_server);
+    munmap(sem_page, 2 * sizeof(sem_t));
+
+    double mean = 0;
+    for (int64_t sample : samples) mean += static_cast<double>(sample);
+    mean /= static_cast<double>(samples.size());
+    double variance = 0;
+    for (int64_t sample : samples) {
+        double diff = static_cast<double>(sample) - mean;
+        variance += diff * diff;
+    }
+    double stddev = std::sqrt(variance / static_cast<double>(samples.size()));
+
+    std::sort(samples.begin(), samples.end());
+    auto at = [&samples](double quantile) {
+        size_t index = static_cast<size_t>(quantile * static_cast<double>(samples.size() - 1));
+        return static_cast<double>(samples[index]);
+    };
+
+    std::cout << std::left << std::setw(24) << name << std::right
+              << std::setw(10) << formatDuration(mean)
+              << std::setw(10) << formatDuration(stddev)
+              << std::setw(10) << formatDuration(at(0.50))
+              << std::setw(10) << formatDuration(at(0.99))
+              << std::setw(10) << formatDuration(at(0.999))
+              << std::setw(10) << formatDuration(static_cast<double>(samples.back()));
+    std::cout << (checksum ? "" : " (no responses)") << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    CommandLineOptions options;
+
+    if (!parseCommandLine(argc, argv, options)) {
+        showUsage(argv[0]);
+        return -1;
+    }
+
+    if (options.help) {
+        showUsage(argv[0]);
+        return 0;
+    }
+
+    std::cout << options.iterations << " round trips, "
+              << (options.writers ? "with" : "without") << " telemetry/alarm writers" << std::endl;
+    std::cout << std::left << std::setw(24) << "round trip" << std::right
+              << std::setw(10) << "mean" << std::setw(10) << "stddev"
+              << std::setw(10) << "p50" << std::setw(10) << "p99"
+              << std::setw(10) << "p999" << std::setw(10) << "max" << std::endl;
+
+    void* legacy_page = mmap(nullptr, sizeof(LegacySharedData), PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (legacy_page == MAP_FAILED) {
+        std::cerr << "mmap failed" << std::endl;
+        return 1;
+    }
+    runPhase("packed (v1)", static_cast<LegacySharedData*>(legacy_page), options);
+    munmap(legacy_page, sizeof(LegacySharedData));
+
+    std::string name = "/radio_bench_shm." + std::to_string(getpid());
+    std::string error, warning;
+    SharedSegment segment;
+    if (!segment.create(name, options.shm, error, warning)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    std::string label = "aligned (v" + std::to_string(SharedData::VERSION) + (segment.hugepages() ? ", huge" : "") +
+                        (segment.locked() ? ", locked" : "") + ")";
+    runPhase(label, segment.data(), options);
+    if (!warning.empty()) {
+        std::cout << "  warning: " << warning << std::endl;
+    }
+    segment.unmap();
+    SharedSegment::unlink(name);
+
+    return 0;
+}
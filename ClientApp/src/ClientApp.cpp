@@ -1,13 +1,486 @@
 #include <iostream>
-#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
 #include <thread>
+#include <chrono>
+#include <cerrno>
+#include <csignal>
+#include <getopt.h>
+#include <unistd.h>
 #include "../../System/include/Client.h"
+#include "../../System/include/CommandOutput.h"
+#include "../../System/include/Server.h"
+#include "../../System/include/StatsPage.h"
+#include "../../DaemonLib/include/Trace.h"
+
+/**
+ * Without command arguments the client is interactive. With them it
+ * sends one command (`radio-client GET frequency`); with --batch it
+ * sends every line of a file or stdin over one connection, keeping up
+ * to --pipeline requests in flight. Results are printed in input order,
+ * as text or as one JSON object per command.
+ *
+ * With --watch it renders a dashboard of sensors, alarms, thread
+ * heartbeats and command statistics instead. The dashboard maps the
+ * server's segments read-only and never sends a command, so watching
+ * does not compete with control traffic for request slots.
+ *
+ * Exit status: 0 if every command succeeded, 1 if the server answered
+ * any command with ERROR or a command was too long to send, 2 if the
+ * server could not be reached or stopped answering.
+ */
+
+struct CommandLineOptions {
+    std::string instance;
+    std::string batch;               ///< Command file, "-" for stdin
+    OutputFormat format = OutputFormat::Text;
+    int connect_timeout_ms = 10000;
+    int timeout_ms = RadioClient::DEFAULT_TIMEOUT_MS;  ///< Per request
+    size_t pipeline = 8;             ///< Batch requests in flight
+    std::string command;             ///< One-shot command from the arguments
+    bool watch = false;
+    double interval = 1.0;           ///< Watch refresh period, seconds
+    size_t count = 0;                ///< Watch refreshes, 0 until interrupted
+    bool help = false;
+};
+
+/// Shortest watch refresh period
+static constexpr double MIN_WATCH_INTERVAL = 0.05;
+/// Heartbeat age shown as stalled; the daemon watchdog's minimum
+static constexpr int64_t STALLED_HEARTBEAT_MS = 4 * Server::HEARTBEAT_INTERVAL_MS;
+
+void showUsage(const char* programName) {
+    std::cout << "Radio Control Client" << std::endl;
+    std::cout << "Usage: " << programName << " [OPTION] [COMMAND...]" << std::endl;
+    std::cout << "Without COMMAND, --batch or --watch the client is interactive." << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  -I, --instance NAME    Server instance (default $" << INSTANCE_ENV
+              << ", else the unnamed instance)" << std::endl;
+    std::cout << "  -b, --batch FILE       Send each line of FILE (- for stdin); blank lines" << std::endl;
+    std::cout << "                         and lines starting with # are skipped" << std::endl;
+    std::cout << "  -o, --output FORMAT    text (default) or json, one object per line" << std::endl;
+    std::cout << "  -w, --wait MS          Wait up to MS for a starting server (default 10000)" << std::endl;
+    std::cout << "  -T, --timeout MS       Wait up to MS for each response (default "
+              << RadioClient::DEFAULT_TIMEOUT_MS << ")" << std::endl;
+    std::cout << "  -p, --pipeline N       Batch commands in flight, 1-" << RadioClient::MAX_OUTSTANDING
+              << " (default 8)" << std::endl;
+    std::cout << "  -W, --watch            Show live sensors, alarms and statistics from shared" << std::endl;
+    std::cout << "                         memory; sends no commands" << std::endl;
+    std::cout << "  -i, --interval SEC     Watch refresh period (default 1.0)" << std::endl;
+    std::cout << "  -n, --count N          Stop watching after N refreshes" << std::endl;
+    std::cout << "  -h, --help             Show this help message" << std::endl;
+    std::cout << "Exit status: 0 success, 1 a command failed, 2 server unavailable" << std::endl;
+    std::cout << "Example: " << programName << " -o json GET frequency" << std::endl;
+}
+
+bool parseCommandLine(int argc, char* argv[], CommandLineOptions& options) {
+    static struct option longOptions[] = {
+        {"instance", required_argument, 0, 'I'},
+        {"batch", required_argument, 0, 'b'},
+        {"output", required_argument, 0, 'o'},
+        {"wait", required_argument, 0, 'w'},
+        {"timeout", required_argument, 0, 'T'},
+        {"pipeline", required_argument, 0, 'p'},
+        {"watch", no_argument, 0, 'W'},
+        {"interval", required_argument, 0, 'i'},
+        {"count", required_argument, 0, 'n'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    // '+' stops at the first command word, so commands need no "--"
+    const char* shortOptions = "+I:b:o:w:T:p:Wi:n:h";
+
+    int optionIndex = 0;
+    int c;
+
+    optind = 0;
+    opterr = 0;
+
+    while ((c = getopt_long(argc, argv, shortOptions, longOptions, &optionIndex)) != -1) {
+        switch (c) {
+            case 'I':
+                options.instance = optarg;
+                break;
+            case 'b':
+                options.batch = optarg;
+                break;
+            case 'o':
+                if (std::string(optarg) == "text") {
+                    options.format = OutputFormat::Text;
+                } else if (std::string(optarg) == "json") {
+                    options.format = OutputFormat::Json;
+                } else {
+                    std::cerr << "Unknown output format: " << optarg << std::endl;
+                    return false;
+                }
+                break;
+            case 'w': {
+                char* end = nullptr;
+                long ms = std::strtol(optarg, &end, 10);
+                if (end == optarg || *end != '\0' || ms < 0) {
+                    std::cerr << "Invalid wait: " << optarg << std::endl;
+                    return false;
+                }
+                options.connect_timeout_ms = static_cast<int>(ms);
+                break;
+            }
+            case 'T': {
+                char* end = nullptr;
+                long ms = std::strtol(optarg, &end, 10);
+                if (end == optarg || *end != '\0' || ms <= 0) {
+                    std::cerr << "Invalid timeout: " << optarg << std::endl;
+                    return false;
+                }
+                options.timeout_ms = static_cast<int>(ms);
+                break;
+            }
+            case 'p': {
+                char* end = nullptr;
+                long depth = std::strtol(optarg, &end, 10);
+                if (end == optarg || *end != '\0' || depth < 1 ||
+                    depth > static_cast<long>(RadioClient::MAX_OUTSTANDING)) {
+                    std::cerr << "Invalid pipeline depth: " << optarg << std::endl;
+                    return false;
+                }
+                options.pipeline = static_cast<size_t>(depth);
+                break;
+            }
+            case 'W':
+                options.watch = true;
+                break;
+            case 'i': {
+                char* end = nullptr;
+                double seconds = std::strtod(optarg, &end);
+                if (end == optarg || *end != '\0' || !(seconds >= MIN_WATCH_INTERVAL)) {
+                    std::cerr << "Invalid interval: " << optarg << " (at least "
+                              << MIN_WATCH_INTERVAL << " s)" << std::endl;
+                    return false;
+                }
+                options.interval = seconds;
+                break;
+            }
+            case 'n': {
+                char* end = nullptr;
+                long count = std::strtol(optarg, &end, 10);
+                if (end == optarg || *end != '\0' || count < 1) {
+                    std::cerr << "Invalid count: " << optarg << std::endl;
+                    return false;
+                }
+                options.count = static_cast<size_t>(count);
+                break;
+            }
+            case 'h':
+                options.help = true;
+                break;
+            default:
+                std::cerr << "Unknown option: " << argv[optind - 1] << std::endl;
+                return false;
+        }
+    }
+
+    for (int i = optind; i < argc; ++i) {
+        if (!options.command.empty()) options.command += ' ';
+        options.command += argv[i];
+    }
+
+    if (!options.command.empty() && !options.batch.empty()) {
+        std::cerr << "Give either a command or --batch, not both" << std::endl;
+        return false;
+    }
+
+    if (options.watch && (!options.command.empty() || !options.batch.empty())) {
+        std::cerr << "--watch sends no commands; drop the command or --batch" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Formats nanoseconds with a readable unit
+ */
+std::string formatDuration(double ns) {
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(1);
+    if (ns < 1e3) ss << ns << "ns";
+    else if (ns < 1e6) ss << ns / 1e3 << "us";
+    else if (ns < 1e9) ss << ns / 1e6 << "ms";
+    else ss << ns / 1e9 << "s";
+    return ss.str();
+}
+
+/**
+ * @brief Read-only view of a server instance for --watch
+ *
+ * Attaches lazily and drops the mappings when the server process is
+ * gone, so the dashboard follows a restarted server.
+ */
+class Watcher {
+public:
+    explicit Watcher(const IpcNames& names) : names_(names) {}
+    ~Watcher() { detach(); }
+
+    /**
+     * @brief Renders one frame
+     *
+     * @return false if no server was available for this frame
+     */
+    bool render(std::ostream& out);
+
+private:
+    struct Sensors {
+        double temperature, current, power, voltage;
+        int active_alarms_count;
+        bool service_enabled;
+        char last_update[sizeof(SharedData::Monitoring::last_update)];
+        uint32_t updates;
+    };
+
+    struct AlarmEvents {
+        unsigned int events;
+        char last[sizeof(SharedData::Alarms::last)];
+    };
+
+    bool attach(std::string& error);
+    void detach();
+    void renderHeartbeat(std::ostream& out, const char* name, const SharedData::Heartbeat& heartbeat,
+                         int64_t now) const;
+    void renderStats(std::ostream& out, int64_t now);
+
+    IpcNames names_;
+    SharedSegment segment_;
+    const SharedData* data_ = nullptr;
+    const StatsPage* stats_ = nullptr;
+    pid_t server_pid_ = 0;
+
+    // Previous frame, for rates
+    uint64_t last_commands_ = 0;
+    int64_t last_frame_ns_ = 0;
+};
+
+bool Watcher::attach(std::string& error) {
+    if (!segment_.attach(names_.shm, error, false)) {
+        return false;
+    }
+    data_ = segment_.data();
+    server_pid_ = data_->header.server_pid;
+    if (server_pid_ <= 0 || (kill(server_pid_, 0) == -1 && errno == ESRCH)) {
+        // Left behind by a server that did not shut down cleanly
+        error = "Server not running";
+        detach();
+        return false;
+    }
+    stats_ = StatsPage::openReadOnly(names_.stats_shm.c_str());
+    last_frame_ns_ = 0;
+    return true;
+}
+
+void Watcher::detach() {
+    if (stats_) {
+        StatsPage::unmap(stats_);
+        stats_ = nullptr;
+    }
+    segment_.unmap();
+    data_ = nullptr;
+    server_pid_ = 0;
+}
+
+bool Watcher::render(std::ostream& out) {
+    if (data_ && kill(server_pid_, 0) == -1 && errno == ESRCH) {
+        out << "Server process " << server_pid_ << " exited" << std::endl;
+        detach();
+    }
+    std::string error;
+    if (!data_ && !attach(error)) {
+        out << error << ", waiting for " << names_.shm << std::endl;
+        return false;
+    }
+
+    Sensors sensors;
+    const auto& monitoring = data_->monitoring;
+    bool consistent = monitoring.lock.read([&]() {
+        sensors.temperature = monitoring.temperature;
+        sensors.current = monitoring.current;
+        sensors.power = monitoring.power;
+        sensors.voltage = monitoring.voltage;
+        sensors.active_alarms_count = monitoring.active_alarms_count;
+        sensors.service_enabled = monitoring.service_enabled;
+        memcpy(sensors.last_update, monitoring.last_update, sizeof(sensors.last_update));
+    });
+    sensors.updates = monitoring.lock.writes();
+    sensors.last_update[sizeof(sensors.last_update) - 1] = '\0';
+
+    AlarmEvents alarms;
+    const auto& alarm_block = data_->alarms;
+    alarm_block.lock.read([&]() {
+        alarms.events = alarm_block.events;
+        memcpy(alarms.last, alarm_block.last, sizeof(alarms.last));
+    });
+    alarms.last[sizeof(alarms.last) - 1] = '\0';
+
+    out << "Radio server PID " << server_pid_ << " (" << names_.shm << ")" << std::endl;
+    if (!consistent) {
+        // The monitoring thread stopped in the middle of a publish
+        out << "Sensors: no consistent update" << std::endl;
+    } else if (sensors.updates == 0) {
+        out << "Sensors: not published yet" << std::endl;
+    } else {
+        out << "Sensors (" << (sensors.service_enabled ? "monitoring on" : "monitoring OFF")
+            << ", update " << sensors.updates << " at " << sensors.last_update << ")" << std::endl;
+        out << std::fixed << std::setprecision(2)
+            << "  Temperature: " << std::setw(10) << sensors.temperature << " \u00b0C" << std::endl
+            << "  Current:     " << std::setw(10) << sensors.current << " A" << std::endl
+            << "  Power:       " << std::setw(10) << sensors.power << " W" << std::endl
+            << "  Voltage:     " << std::setw(10) << sensors.voltage << " V" << std::endl;
+        out.unsetf(std::ios::floatfield);
+    }
+    out << "Alarms: " << sensors.active_alarms_count << " active, " << alarms.events << " delivered";
+    if (alarms.last[0] != '\0') {
+        out << "; last: " << alarms.last;
+    }
+    out << std::endl;
+
+    int64_t now = Tracer::now();
+    out << "Threads:";
+    renderHeartbeat(out, "monitoring", data_->monitoring_heartbeat, now);
+    out << ",";
+    renderHeartbeat(out, "command", data_->command_heartbeat, now);
+    out << std::endl;
+
+    renderStats(out, now);
+    return true;
+}
+
+void Watcher::renderHeartbeat(std::ostream& out, const char* name, const SharedData::Heartbeat& heartbeat,
+                              int64_t now) const {
+    int64_t last = heartbeat.last_ns.load(std::memory_order_acquire);
+    out << ' ' << name << ' ';
+    if (last == 0) {
+        out << "not started";
+        return;
+    }
+    int64_t age_ms = (now - last) / 1000000;
+    out << "beat " << age_ms << " ms ago";
+    if (age_ms >= STALLED_HEARTBEAT_MS) {
+        out << " (STALLED)";
+    }
+}
+
+void Watcher::renderStats(std::ostream& out, int64_t now) {
+    if (!stats_) {
+        out << "Statistics: stats page " << names_.stats_shm << " not available" << std::endl;
+        return;
+    }
+    uint64_t commands = stats_->commands_total.load(std::memory_order_relaxed);
+    out << "Commands: " << commands << " (" << stats_->commands_failed.load(std::memory_order_relaxed)
+        << " failed)";
+    if (last_frame_ns_ != 0 && now > last_frame_ns_) {
+        out << ", " << std::fixed << std::setprecision(1)
+            << (commands - last_commands_) * 1e9 / (now - last_frame_ns_) << "/s";
+        out.unsetf(std::ios::floatfield);
+    }
+    out << ", p99 " << formatDuration(stats_->histogram(StatsMetric::Command).percentile(0.99)) << std::endl;
+    out << "Monitoring ticks: p99 " << formatDuration(stats_->histogram(StatsMetric::MonitoringTick).percentile(0.99))
+        << ", jitter p99 " << formatDuration(stats_->histogram(StatsMetric::TickJitter).percentile(0.99))
+        << ", " << stats_->monitoring_overruns.load(std::memory_order_relaxed) << " overruns" << std::endl;
+    last_commands_ = commands;
+    last_frame_ns_ = now;
+}
+
+/**
+ * @brief Refreshes the dashboard until --count frames or an interrupt
+ *
+ * On a terminal each frame replaces the previous one; otherwise frames
+ * are separated by a blank line, so the output can be logged.
+ *
+ * @return EXIT_UNAVAILABLE if the last frame found no server
+ */
+ExitStatus runWatch(const IpcNames& names, const CommandLineOptions& options) {
+    Watcher watcher(names);
+    bool terminal = isatty(STDOUT_FILENO);
+    auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(options.interval));
+    auto next = std::chrono::steady_clock::now();
+    bool available = false;
+
+    for (size_t frame = 1; ; ++frame) {
+        std::ostringstream out;
+        available = watcher.render(out);
+        if (terminal) {
+            // Home and clear, then the frame in one write to avoid flicker
+            std::cout << "\033[H\033[2J";
+        } else if (frame > 1) {
+            std::cout << '\n';
+        }
+        std::cout << out.str() << std::flush;
+
+        if (options.count && frame >= options.count) {
+            break;
+        }
+        next += period;
+        std::this_thread::sleep_until(next);
+    }
+    return available ? EXIT_OK : EXIT_UNAVAILABLE;
+}
+
+int main(int argc, char* argv[]) {
+    CommandLineOptions options;
+
+    if (!parseCommandLine(argc, argv, options)) {
+        showUsage(argv[0]);
+        return -1;
+    }
+
+    if (options.help) {
+        showUsage(argv[0]);
+        return 0;
+    }
+
+    std::string instance, error;
+    if (!IpcNames::resolveInstance(options.instance, instance, error)) {
+        std::cerr << error << std::endl;
+        return -1;
+    }
+
+    if (options.watch) {
+        return runWatch(IpcNames::forInstance(instance), options);
+    }
+
+    Client client(IpcNames::forInstance(instance));
+
+    if (options.command.empty() && options.batch.empty()) {
+        client.run();
+        return 0;
+    }
+
+    std::ifstream file;
+    if (!options.batch.empty() && options.batch != "-") {
+        file.open(options.batch);
+        if (!file) {
+            std::cerr << "Cannot open " << options.batch << std::endl;
+            return -1;
+        }
+    }
+
+    // Results are written in bulk rather than one flush per line
+    std::ios::sync_with_stdio(false);
+
+    if (!client.connect(options.connect_timeout_ms, error)) {
+        std::cerr << "Error: " << error << std::endl;
+        return EXIT_UNAVAILABLE;
+    }
 
-int main() {
-    std::cout << "Waiting for server to start..." << std::endl;
-    std::this_thread::sleep_for(std::chrono::seconds(2));
-    
-    Client client;
-    client.run();
-    return 0;
-}
\ No newline at end of file
+    if (!options.command.empty()) {
+        return printResult(std::cout, std::cerr, options.format, options.command,
+                           client.connection().execute(options.command, options.timeout_ms));
+    }
+    BatchOptions batch;
+    batch.format = options.format;
+    batch.timeout_ms = options.timeout_ms;
+    batch.pipeline = options.pipeline;
+    return runBatch(client.connection(), file.is_open() ? static_cast<std::istream&>(file) : std::cin,
+                    std::cout, std::cerr, batch);
+}
@@ -0,0 +1,179 @@
+/**
+ * @file RadioClient.h
+ * @brief Embeddable client of the radio control server (libradioclient)
+ *
+ * @ingroup CommunicationClasses
+ */
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <semaphore.h>
+#include "../../System/include/SharedData.h"
+#include "../../System/include/IpcNames.h"
+
+/**
+ * @brief Outcome of one request
+ */
+enum class RequestStatus {
+    Ok,             ///< Server answered
+    CommandFailed,  ///< Server answered with "ERROR: ..."
+    Timeout,        ///< No response, or no room to send (window or server slots full), within the request's timeout
+    Disconnected,   ///< Not connected, or the server exited
+    Invalid         ///< Not sent: the command is too long
+};
+
+/**
+ * @brief Response to one request, or why there is none
+ */
+struct RadioResponse {
+    uint64_t request_id = 0;         ///< Id the server answered, 0 if the request was never sent
+    RequestStatus status = RequestStatus::Disconnected;
+    std::string response;            ///< Server text for Ok and CommandFailed
+    std::string error;               ///< Reason for the other statuses
+    int64_t latency_ns = 0;          ///< Submission to completion
+
+    /// The server answered, successfully or not
+    bool answered() const { return status == RequestStatus::Ok || status == RequestStatus::CommandFailed; }
+    bool ok() const { return status == RequestStatus::Ok; }
+};
+
+/**
+ * @brief Connection to a server instance with asynchronous requests
+ *
+ * One connection carries up to MAX_OUTSTANDING requests at a time.
+ * Each request has its own timeout and gets its own response, matched
+ * by request id; the server answers requests of all clients in the order
+ * they were submitted.
+ *
+ * Waiting costs no polling: the server bumps and wakes the connection's
+ * futex word in the shared segment after each response. execute() waits
+ * on it in the calling thread and picks up its own response. Responses
+ * to submit() are delivered by a completion thread that only waits on
+ * the word while such requests are outstanding. Callbacks run on that
+ * thread, except for requests that fail before they are sent, whose
+ * callback runs in submit(). A callback may submit further requests but
+ * must not wait for one (future::get(), execute()), and must not
+ * disconnect or destroy the client: that would join the completion
+ * thread from itself.
+ *
+ * Thread-safe: any thread may submit.
+ */
+class RadioClient {
+public:
+    using Callback = std::function<void(const RadioResponse&)>;
+
+    static constexpr int DEFAULT_TIMEOUT_MS = 5000;
+    static constexpr size_t MAX_COMMAND_LENGTH = sizeof(SharedData::RequestSlot::command) - 1;
+    /// Per connection, so one client cannot take every slot of the server
+    static constexpr size_t MAX_OUTSTANDING = SharedData::REQUEST_SLOTS / 4;
+    static constexpr int LIVENESS_CHECK_MS = 100;  ///< How often the server process is checked while requests wait
+
+    /**
+     * @param names IPC objects of the server instance to connect to
+     */
+    explicit RadioClient(const IpcNames& names = IpcNames::forInstance());
+
+    /**
+     * @brief Disconnects; outstanding requests complete as Disconnected
+     */
+    ~RadioClient();
+
+    RadioClient(const RadioClient&) = delete;
+    RadioClient& operator=(const RadioClient&) = delete;
+
+    /**
+     * @brief Opens the server's semaphore and segment and takes a connection
+     *
+     * Watches /dev/shm with inotify, so a server that becomes ready while
+     * the client waits is picked up immediately. Does nothing if already
+     * connected.
+     *
+     * @param timeout_ms How long to wait for a starting server
+     * @param error Receives the reason on failure
+     * @param waiting Called once if the server is not ready yet
+     */
+    bool connect(int timeout_ms, std::string& error, const std::function<void()>& waiting = nullptr);
+
+    /**
+     * @brief Releases the connection; outstanding requests complete as Disconnected
+     *
+     * Joins the completion thread, so it must not be called from a callback.
+     */
+    void disconnect();
+
+    bool isConnected() const { return data_ != nullptr && !server_lost_; }
+
+    /**
+     * @brief Sends a command, the callback receives its response
+     *
+     * Waits while MAX_OUTSTANDING requests are outstanding or the
+     * server has no free slot; that wait counts against the timeout, and
+     * if it outlasts it the request is not sent and completes as Timeout.
+     * The callback is called exactly once.
+     *
+     * @return uint64_t Request id, 0 if the request was not sent
+     */
+    uint64_t submit(const std::string& command, Callback callback, int timeout_ms = DEFAULT_TIMEOUT_MS);
+
+    /**
+     * @brief Sends a command, the future receives its response
+     */
+    std::future<RadioResponse> submit(const std::string& command, int timeout_ms = DEFAULT_TIMEOUT_MS);
+
+    /**
+     * @brief Sends a command and waits for its response
+     */
+    RadioResponse execute(const std::string& command, int timeout_ms = DEFAULT_TIMEOUT_MS);
+
+    /**
+     * @brief Requests sent and not completed yet
+     */
+    size_t outstanding() const;
+
+private:
+    struct Pending {
+        int slot;
+        int64_t submitted_ns;
+        int64_t deadline_ns;
+        Callback callback;
+        bool waited;   ///< Picked up by execute(), not by the completion thread
+        bool expired;  ///< Reported as timed out; the slot is freed once the server answers
+    };
+
+    bool openSemaphore(int timeout_ms, const std::function<void()>& waiting);
+    uint64_t send(const std::string& command, int timeout_ms, Callback& callback, bool waited,
+                  RadioResponse& failure);
+    RadioResponse await(uint64_t id);
+    bool takeResponse(uint64_t id, Pending& pending, int64_t now, RadioResponse& response);
+    void completionLoop();
+    RadioResponse fail(RequestStatus status, const std::string& error) const;
+    bool serverExited() const;
+
+    IpcNames names_;
+    sem_t* sem_client_ = SEM_FAILED;
+    SharedSegment segment_;
+    SharedData* data_ = nullptr;
+    int connection_ = -1;
+    uint32_t token_ = 0;   ///< Owner token of connection_
+    pid_t server_pid_ = 0;
+
+    mutable std::mutex mutex_;
+    std::condition_variable released_;   ///< A pending request completed
+    std::condition_variable watch_;      ///< The completion thread has requests to watch
+    std::unordered_map<uint64_t, Pending> pending_;
+    size_t watched_ = 0;                 ///< Pending requests the completion thread handles
+    int64_t next_wake_ns_ = 0;           ///< When the completion thread looks again
+    uint32_t slot_hint_ = 0;
+
+    std::thread completion_thread_;
+    std::atomic<bool> stopping_{false};
+    std::atomic<bool> server_lost_{false};
+};
@@ -0,0 +1,85 @@
+/**
+ * @file radio_client.h
+ * @brief C interface of libradioclient, for C programs and language bindings
+ *
+ * @ingroup CommunicationClasses
+ *
+ * Wraps RadioClient. Callbacks run on the library's completion thread;
+ * the result and its text are valid only during the callback. A callback
+ * may submit further requests, but must not wait for one
+ * (radio_client_execute()) or close the client.
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct radio_client radio_client;
+
+/** Same values as RequestStatus */
+typedef enum radio_status {
+    RADIO_OK = 0,
+    RADIO_COMMAND_FAILED,   /**< Server answered with "ERROR: ..." */
+    RADIO_TIMEOUT,
+    RADIO_DISCONNECTED,
+    RADIO_INVALID           /**< Command too long, or invalid arguments */
+} radio_status;
+
+typedef struct radio_result {
+    uint64_t request_id;    /**< 0 if the request was never sent */
+    radio_status status;
+    const char* text;       /**< Response, or the error for statuses without one */
+    int64_t latency_ns;
+} radio_result;
+
+typedef void (*radio_callback)(const radio_result* result, void* user_data);
+
+/**
+ * @brief Connects to a server instance
+ *
+ * @param instance Instance name, NULL or "" for the default instance
+ * @param connect_timeout_ms How long to wait for a starting server
+ * @param error Receives the reason on failure, may be NULL
+ * @return Client handle, NULL on failure
+ */
+radio_client* radio_client_open(const char* instance, int connect_timeout_ms, char* error, size_t error_size);
+
+/**
+ * @brief Disconnects and frees the client; outstanding callbacks get RADIO_DISCONNECTED
+ *
+ * Waits for the completion thread to exit, so it must not be called from
+ * a callback.
+ */
+void radio_client_close(radio_client* client);
+
+/**
+ * @brief Sends a command; the callback is called exactly once with its result
+ *
+ * @param timeout_ms Per-request timeout, 0 for the default of 5000
+ * @return Request id, 0 if the request was not sent
+ */
+uint64_t radio_client_submit(radio_client* client, const char* command, int timeout_ms,
+                             radio_callback callback, void* user_data);
+
+/**
+ * @brief Sends a command and waits for its result
+ *
+ * @param text Receives the response or the error, truncated to text_size
+ */
+radio_status radio_client_execute(radio_client* client, const char* command, int timeout_ms,
+                                  char* text, size_t text_size);
+
+/**
+ * @brief Requests sent and not completed yet
+ */
+size_t radio_client_outstanding(const radio_client* client);
+
+const char* radio_status_name(radio_status status);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,433 @@
+/**
+ * @file RadioClient.cpp
+ * @brief Request submission and completion over the shared segment
+ */
+
+#include "../include/RadioClient.h"
+#include "../../DaemonLib/include/Trace.h"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+RadioClient::RadioClient(const IpcNames& names) : names_(names) {
+}
+
+RadioClient::~RadioClient() {
+    disconnect();
+}
+
+bool RadioClient::openSemaphore(int timeout_ms, const std::function<void()>& waiting) {
+    sem_client_ = sem_open(names_.sem_client.c_str(), 0);
+    if (sem_client_ != SEM_FAILED) return true;
+
+    if (waiting) waiting();
+
+    // Watch before the next attempt so a creation in between is not missed
+    int watch_fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (watch_fd != -1 && inotify_add_watch(watch_fd, "/dev/shm", IN_CREATE | IN_MOVED_TO) == -1) {
+        close(watch_fd);
+        watch_fd = -1;
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while ((sem_client_ = sem_open(names_.sem_client.c_str(), 0)) == SEM_FAILED) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (left <= 0) break;
+
+        if (watch_fd != -1) {
+            pollfd pfd = {watch_fd, POLLIN, 0};
+            if (poll(&pfd, 1, static_cast<int>(left)) > 0) {
+                char events[4096];
+                while (read(watch_fd, events, sizeof(events)) > 0) {
+                }
+            }
+        } else {
+            // No inotify: fall back to short polling
+            std::this_thread::sleep_for(std::chrono::milliseconds(std::min<long long>(left, 50)));
+        }
+    }
+
+    if (watch_fd != -1) close(watch_fd);
+    return sem_client_ != SEM_FAILED;
+}
+
+bool RadioClient::connect(int timeout_ms, std::string& error, const std::function<void()>& waiting) {
+    if (data_) {
+        return true;
+    }
+
+    if (!openSemaphore(timeout_ms, waiting)) {
+        error = "Server is not running! (could not open semaphore)";
+        return false;
+    }
+
+    if (!segment_.attach(names_.shm, error)) {
+        sem_close(sem_client_);
+        sem_client_ = SEM_FAILED;
+        return false;
+    }
+
+    connection_ = segment_.data()->claimConnection(token_);
+    if (connection_ < 0) {
+        error = "Server has no free connection (" + std::to_string(SharedData::MAX_CONNECTIONS) +
+                " clients connected)";
+        segment_.unmap();
+        sem_close(sem_client_);
+        sem_client_ = SEM_FAILED;
+        return false;
+    }
+
+    data_ = segment_.data();
+    server_pid_ = data_->header.server_pid;
+    slot_hint_ = static_cast<uint32_t>(connection_) * (SharedData::REQUEST_SLOTS / SharedData::MAX_CONNECTIONS);
+    stopping_ = false;
+    server_lost_ = false;
+    completion_thread_ = std::thread(&RadioClient::completionLoop, this);
+    return true;
+}
+
+void RadioClient::disconnect() {
+    if (!data_) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    watch_.notify_all();
+    std::atomic<uint32_t>& completions = data_->connections[connection_].completions;
+    completions.fetch_add(1, std::memory_order_release);
+    futexWake(completions);
+    completion_thread_.join();
+
+    std::vector<std::pair<Callback, RadioResponse>> dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& entry : pending_) {
+            if (!entry.second.expired && !entry.second.waited) {
+                RadioResponse response = fail(RequestStatus::Disconnected, "Client disconnected");
+                response.request_id = entry.first;
+                dropped.emplace_back(std::move(entry.second.callback), std::move(response));
+            }
+        }
+        pending_.clear();
+        watched_ = 0;
+    }
+    released_.notify_all();
+    for (auto& entry : dropped) {
+        entry.first(entry.second);
+    }
+
+    // An exited server's segment is gone for everyone else anyway
+    if (!server_lost_) {
+        data_->releaseConnection(connection_, token_);
+    }
+    data_ = nullptr;
+    connection_ = -1;
+    segment_.unmap();
+    sem_close(sem_client_);
+    sem_client_ = SEM_FAILED;
+}
+
+RadioResponse RadioClient::fail(RequestStatus status, const std::string& error) const {
+    RadioResponse response;
+    response.status = status;
+    response.error = error;
+    return response;
+}
+
+bool RadioClient::serverExited() const {
+    return server_pid_ > 0 && kill(server_pid_, 0) == -1 && errno == ESRCH;
+}
+
+/**
+ * @brief Claims a slot, publishes the command and registers it as pending
+ *
+ * @param callback Moved into the pending entry once the request is sent
+ * @param failure Receives the reason when nothing was sent
+ * @return uint64_t Request id, 0 if nothing was sent
+ */
+uint64_t RadioClient::send(const std::string& command, int timeout_ms, Callback& callback, bool waited,
+                           RadioResponse& failure) {
+    if (!data_ || server_lost_) {
+        failure = fail(RequestStatus::Disconnected, server_lost_ ? "Server process exited" : "Not connected");
+        return 0;
+    }
+    if (command.size() > MAX_COMMAND_LENGTH) {
+        failure = fail(RequestStatus::Invalid,
+                       "Command longer than " + std::to_string(MAX_COMMAND_LENGTH) + " characters");
+        return 0;
+    }
+
+    int64_t start = Tracer::now();
+    int64_t deadline = start + static_cast<int64_t>(timeout_ms) * 1000000LL;
+    auto limit = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    // The completion thread delivers the releases, it must not wait for them
+    if (std::this_thread::get_id() != completion_thread_.get_id() &&
+        !released_.wait_until(lock, limit, [this]() {
+            return pending_.size() < MAX_OUTSTANDING || server_lost_ || stopping_;
+        })) {
+        failure = fail(RequestStatus::Timeout, std::to_string(MAX_OUTSTANDING) +
+                                               " requests still outstanding after " +
+                                               std::to_string(timeout_ms) + " ms");
+        return 0;
+    }
+    if (server_lost_ || stopping_) {
+        failure = fail(RequestStatus::Disconnected, "Server process exited");
+        return 0;
+    }
+
+    int slot;
+    while ((slot = data_->claimSlot(token_, slot_hint_)) < 0) {
+        // Every slot of the server is busy: back off without holding up completions
+        lock.unlock();
+        if (std::chrono::steady_clock::now() >= limit) {
+            failure = fail(RequestStatus::Timeout, "No free request slot within " +
+                                                   std::to_string(timeout_ms) + " ms");
+            return 0;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        lock.lock();
+    }
+    slot_hint_ = (static_cast<uint32_t>(slot) + 1) % SharedData::REQUEST_SLOTS;
+
+    // Registered before anyone can look for the response, so a fast
+    // response is never missed
+    uint64_t id = data_->submit(slot, token_, command.c_str(), command.size(), start);
+    pending_.emplace(id, Pending{slot, start, deadline, std::move(callback), waited, false});
+    bool first_watched = !waited && watched_++ == 0;
+    bool earlier = !waited && deadline < next_wake_ns_;
+    lock.unlock();
+
+    sem_post(sem_client_);
+
+    if (first_watched) {
+        watch_.notify_one();
+    } else if (earlier) {
+        // The completion thread sleeps past this deadline: make it look again
+        std::atomic<uint32_t>& completions = data_->connections[connection_].completions;
+        completions.fetch_add(1, std::memory_order_release);
+        futexWake(completions);
+    }
+    return id;
+}
+
+uint64_t RadioClient::submit(const std::string& command, Callback callback, int timeout_ms) {
+    RadioResponse failure;
+    uint64_t id = send(command, timeout_ms, callback, false, failure);
+    if (id == 0) {
+        callback(failure);
+    }
+    return id;
+}
+
+std::future<RadioResponse> RadioClient::submit(const std::string& command, int timeout_ms) {
+    auto promise = std::make_shared<std::promise<RadioResponse>>();
+    std::future<RadioResponse> future = promise->get_future();
+    submit(command, [promise](const RadioResponse& response) { promise->set_value(response); }, timeout_ms);
+    return future;
+}
+
+RadioResponse RadioClient::execute(const std::string& command, int timeout_ms) {
+    Callback none;
+    RadioResponse failure;
+    uint64_t id = send(command, timeout_ms, none, true, failure);
+    return id != 0 ? await(id) : failure;
+}
+
+size_t RadioClient::outstanding() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return static_cast<size_t>(std::count_if(pending_.begin(), pending_.end(),
+        [](const std::pair<const uint64_t, Pending>& entry) { return !entry.second.expired; }));
+}
+
+/**
+ * @brief Copies the response of a completed request and frees its slot
+ *
+ * @return false if the server has not answered it yet
+ */
+bool RadioClient::takeResponse(uint64_t id, Pending& pending, int64_t now, RadioResponse& response) {
+    SharedData::RequestSlot& slot = data_->slots[pending.slot];
+    uint64_t word = slot.control.load(std::memory_order_acquire);
+    if (SharedData::RequestSlot::stateOf(word) != SharedData::SLOT_DONE ||
+        SharedData::RequestSlot::ownerOf(word) != token_ || slot.response_id != id) {
+        return false;
+    }
+
+    response.request_id = id;
+    response.response = slot.response;
+    response.status = strncmp(slot.response, "ERROR", 5) == 0 ? RequestStatus::CommandFailed : RequestStatus::Ok;
+    response.latency_ns = now - pending.submitted_ns;
+    slot.control.store(0, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Waits in the calling thread for the response to a request of execute()
+ *
+ * Saves the hand-over through the completion thread on the synchronous
+ * path. A request that times out after the server picked it up is
+ * handed to the completion thread, which frees its slot later.
+ */
+RadioResponse RadioClient::await(uint64_t id) {
+    std::atomic<uint32_t>& completions = data_->connections[connection_].completions;
+    int64_t next_liveness_ns = Tracer::now() + LIVENESS_CHECK_MS * 1000000LL;
+
+    while (true) {
+        // Read before looking, so a response published meanwhile ends the wait at once
+        uint32_t seen = completions.load(std::memory_order_acquire);
+        int64_t now = Tracer::now();
+        bool lost = false;
+        if (now >= next_liveness_ns) {
+            lost = serverExited();
+            next_liveness_ns = now + LIVENESS_CHECK_MS * 1000000LL;
+        }
+
+        RadioResponse response;
+        response.request_id = id;
+        int64_t deadline;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            auto it = pending_.find(id);
+            if (it == pending_.end()) {
+                return fail(RequestStatus::Disconnected, "Client disconnected");
+            }
+            Pending& pending = it->second;
+            deadline = pending.deadline_ns;
+
+            bool done = takeResponse(id, pending, now, response);
+            if (!done && lost) {
+                server_lost_ = true;
+                response.status = RequestStatus::Disconnected;
+                response.error = "Server process " + std::to_string(server_pid_) + " exited";
+                done = true;
+            } else if (!done && now >= deadline) {
+                response.status = RequestStatus::Timeout;
+                response.error = "Server response timeout (server may be busy or stalled)";
+                response.latency_ns = now - pending.submitted_ns;
+                done = data_->withdraw(pending.slot, token_);
+                if (!done) {
+                    // Once the server has it, the slot stays ours until it is answered
+                    pending.waited = false;
+                    pending.expired = true;
+                    bool first_watched = watched_++ == 0;
+                    lock.unlock();
+                    if (first_watched) watch_.notify_one();
+                    released_.notify_all();
+                    return response;
+                }
+            }
+            if (done) {
+                pending_.erase(it);
+                lock.unlock();
+                released_.notify_all();
+                return response;
+            }
+        }
+        futexWait(completions, seen, std::max<int64_t>(std::min(deadline, next_liveness_ns) - now, 0));
+    }
+}
+
+/**
+ * @brief Completion thread: hands responses, timeouts and a lost server to callbacks
+ *
+ * Sleeps on a condition variable while no submitted request needs it.
+ * Otherwise the completion counter is read before the slots are
+ * scanned; a response published after the scan has changed it, so the
+ * futex wait returns at once instead of sleeping on a stale value.
+ */
+void RadioClient::completionLoop() {
+    std::atomic<uint32_t>& completions = data_->connections[connection_].completions;
+    int64_t next_liveness_ns = 0;
+    std::vector<std::pair<Callback, RadioResponse>> ready;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            watch_.wait(lock, [this]() { return stopping_ || watched_ > 0; });
+        }
+        if (stopping_) {
+            break;
+        }
+
+        uint32_t seen = completions.load(std::memory_order_acquire);
+        int64_t now = Tracer::now();
+
+        bool lost = false;
+        if (now >= next_liveness_ns) {
+            lost = serverExited();
+            next_liveness_ns = now + LIVENESS_CHECK_MS * 1000000LL;
+        }
+
+        int64_t wake = next_liveness_ns;
+        bool released = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto it = pending_.begin(); it != pending_.end();) {
+                Pending& pending = it->second;
+                if (pending.waited) {
+                    ++it;
+                    continue;
+                }
+
+                RadioResponse response;
+                response.request_id = it->first;
+                bool done = takeResponse(it->first, pending, now, response);
+
+                if (!done && lost) {
+                    response.status = RequestStatus::Disconnected;
+                    response.error = "Server process " + std::to_string(server_pid_) + " exited";
+                    done = true;
+                } else if (!done && !pending.expired && now >= pending.deadline_ns) {
+                    response.status = RequestStatus::Timeout;
+                    response.error = "Server response timeout (server may be busy or stalled)";
+                    response.latency_ns = now - pending.submitted_ns;
+                    // Once the server has it, the slot stays ours until it is answered
+                    done = data_->withdraw(pending.slot, token_);
+                    if (!done) {
+                        ready.emplace_back(std::move(pending.callback), std::move(response));
+                        pending.expired = true;
+                    }
+                }
+
+                if (done) {
+                    if (!pending.expired) {
+                        ready.emplace_back(std::move(pending.callback), std::move(response));
+                    }
+                    it = pending_.erase(it);
+                    watched_--;
+                    released = true;
+                } else {
+                    if (!pending.expired) wake = std::min(wake, pending.deadline_ns);
+                    ++it;
+                }
+            }
+            next_wake_ns_ = wake;
+            if (lost) server_lost_ = true;
+        }
+        if (released || lost) {
+            released_.notify_all();
+        }
+
+        for (auto& entry : ready) {
+            entry.first(entry.second);
+        }
+        ready.clear();
+
+        if (lost) {
+            break;
+        }
+        futexWait(completions, seen, std::max<int64_t>(wake - Tracer::now(), 0));
+    }
+}
@@ -0,0 +1,104 @@
+/**
+ * @file radio_client.cpp
+ * @brief C interface over RadioClient
+ */
+
+#include "../include/radio_client.h"
+#include "../include/RadioClient.h"
+#include <cstdio>
+
+static_assert(static_cast<int>(RequestStatus::Ok) == RADIO_OK &&
+              static_cast<int>(RequestStatus::CommandFailed) == RADIO_COMMAND_FAILED &&
+              static_cast<int>(RequestStatus::Timeout) == RADIO_TIMEOUT &&
+              static_cast<int>(RequestStatus::Disconnected) == RADIO_DISCONNECTED &&
+              static_cast<int>(RequestStatus::Invalid) == RADIO_INVALID,
+              "radio_status must mirror RequestStatus");
+
+struct radio_client {
+    RadioClient client;
+
+    explicit radio_client(const IpcNames& names) : client(names) {}
+};
+
+namespace {
+
+void copyText(const std::string& text, char* buffer, size_t size) {
+    if (buffer && size > 0) {
+        std::snprintf(buffer, size, "%s", text.c_str());
+    }
+}
+
+int timeoutOrDefault(int timeout_ms) {
+    return timeout_ms > 0 ? timeout_ms : RadioClient::DEFAULT_TIMEOUT_MS;
+}
+
+} // namespace
+
+radio_client* radio_client_open(const char* instance, int connect_timeout_ms, char* error, size_t error_size) {
+    std::string name = instance ? instance : "";
+    if (!name.empty() && !IpcNames::isValidInstance(name)) {
+        copyText("Invalid instance name '" + name + "'", error, error_size);
+        return nullptr;
+    }
+
+    radio_client* handle = new radio_client(IpcNames::forInstance(name));
+    std::string reason;
+    if (!handle->client.connect(connect_timeout_ms, reason)) {
+        copyText(reason, error, error_size);
+        delete handle;
+        return nullptr;
+    }
+    return handle;
+}
+
+void radio_client_close(radio_client* client) {
+    delete client;
+}
+
+uint64_t radio_client_submit(radio_client* client, const char* command, int timeout_ms,
+                             radio_callback callback, void* user_data) {
+    auto deliver = [callback, user_data](const RadioResponse& response) {
+        if (!callback) return;
+        radio_result result;
+        result.request_id = response.request_id;
+        result.status = static_cast<radio_status>(response.status);
+        result.text = response.answered() ? response.response.c_str() : response.error.c_str();
+        result.latency_ns = response.latency_ns;
+        callback(&result, user_data);
+    };
+
+    if (!client || !command) {
+        RadioResponse response;
+        response.status = RequestStatus::Invalid;
+        response.error = "Missing client or command";
+        deliver(response);
+        return 0;
+    }
+    return client->client.submit(command, deliver, timeoutOrDefault(timeout_ms));
+}
+
+radio_status radio_client_execute(radio_client* client, const char* command, int timeout_ms,
+                                  char* text, size_t text_size) {
+    if (!client || !command) {
+        copyText("Missing client or command", text, text_size);
+        return RADIO_INVALID;
+    }
+    RadioResponse response = client->client.execute(command, timeoutOrDefault(timeout_ms));
+    copyText(response.answered() ? response.response : response.error, text, text_size);
+    return static_cast<radio_status>(response.status);
+}
+
+size_t radio_client_outstanding(const radio_client* client) {
+    return client ? client->client.outstanding() : 0;
+}
+
+const char* radio_status_name(radio_status status) {
+    switch (status) {
+        case RADIO_OK: return "ok";
+        case RADIO_COMMAND_FAILED: return "command_failed";
+        case RADIO_TIMEOUT: return "timeout";
+        case RADIO_DISCONNECTED: return "disconnected";
+        case RADIO_INVALID: return "invalid";
+    }
+    return "unknown";
+}
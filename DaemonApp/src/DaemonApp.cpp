@@ -1,6 +1,8 @@
 #include <iostream>
 #include <string>
 #include <getopt.h>
+#include <cstdlib>
+#include <climits>
 #include "../../System/include/ServerDaemon.h"
 
 struct CommandLineOptions {
@@ -8,6 +10,25 @@ struct CommandLineOptions {
     bool stop = false;
     bool status = false;
     bool help = false;
+    unsigned idle_timeout = DEFAULT_IDLE_TIMEOUT_S;
+    std::string config_path = "/etc/radio-server.conf";
+    std::string instance;
+    RealtimeConfig realtime;
+    ShmOptions shm;
+    unsigned watchdog_ms = 0;
+};
+
+/// Several heartbeat intervals, so a busy but healthy thread is not restarted
+static constexpr unsigned MIN_WATCHDOG_MS = 4 * Server::HEARTBEAT_INTERVAL_MS;
+
+enum LongOnlyOption {
+    OPT_MONITOR_CPU = 1000,
+    OPT_COMMAND_CPU,
+    OPT_MONITOR_SCHED,
+    OPT_COMMAND_SCHED,
+    OPT_MLOCK,
+    OPT_SHM_HUGEPAGES,
+    OPT_SHM_LOCK
 };
 
 void showUsage(const char* programName) {
@@ -18,6 +39,26 @@ void showUsage(const char* programName) {
     std::cout << "  -t, --stop     Stop the daemon" << std::endl;
     std::cout << "  -S, --status   Check daemon status" << std::endl;
     std::cout << "  -h, --help     Show this help message" << std::endl;
+    std::cout << "  -I, --instance NAME  Server instance (default $" << INSTANCE_ENV
+              << ", else the unnamed instance)" << std::endl;
+    std::cout << "Start options:" << std::endl;
+    std::cout << "  -p, --persistent        Keep one server and its state until stopped" << std::endl;
+    std::cout << "  -i, --idle-timeout SEC  Rebuild the server after SEC idle seconds (default "
+              << DEFAULT_IDLE_TIMEOUT_S << ", 0 = persistent)" << std::endl;
+    std::cout << "  -c, --config FILE       Monitoring configuration, reloaded on SIGHUP" << std::endl;
+    std::cout << "                          (default /etc/radio-server.conf)" << std::endl;
+    std::cout << "  -w, --watchdog MS       Supervise the server: restart a thread without a heartbeat" << std::endl;
+    std::cout << "                          for MS milliseconds, and the worker process if that fails" << std::endl;
+    std::cout << "                          (at least " << MIN_WATCHDOG_MS << ", e.g. 500)" << std::endl;
+    std::cout << "Real-time options (skipped with a warning without privileges):" << std::endl;
+    std::cout << "  --monitor-cpu N         Pin the monitoring thread to core N" << std::endl;
+    std::cout << "  --command-cpu N         Pin the command thread to core N" << std::endl;
+    std::cout << "  --monitor-sched POLICY  fifo:PRIO, rr:PRIO or other (default)" << std::endl;
+    std::cout << "  --command-sched POLICY  Same for the command thread" << std::endl;
+    std::cout << "  --mlock                 Lock all process memory (mlockall)" << std::endl;
+    std::cout << "  --shm-hugepages         Back the command segment with huge pages" << std::endl;
+    std::cout << "                          (hugetlbfs at " << SharedSegment::HUGETLBFS_DIR << ")" << std::endl;
+    std::cout << "  --shm-lock              Lock the command segment (mlock)" << std::endl;
 }
 
 bool parseCommandLine(int argc, char* argv[], CommandLineOptions& options) {
@@ -26,10 +67,22 @@ bool parseCommandLine(int argc, char* argv[], CommandLineOptions& options) {
         {"stop", no_argument, 0, 't'},
         {"status", no_argument, 0, 'S'},
         {"help", no_argument, 0, 'h'},
+        {"persistent", no_argument, 0, 'p'},
+        {"idle-timeout", required_argument, 0, 'i'},
+        {"config", required_argument, 0, 'c'},
+        {"watchdog", required_argument, 0, 'w'},
+        {"instance", required_argument, 0, 'I'},
+        {"monitor-cpu", required_argument, 0, OPT_MONITOR_CPU},
+        {"command-cpu", required_argument, 0, OPT_COMMAND_CPU},
+        {"monitor-sched", required_argument, 0, OPT_MONITOR_SCHED},
+        {"command-sched", required_argument, 0, OPT_COMMAND_SCHED},
+        {"mlock", no_argument, 0, OPT_MLOCK},
+        {"shm-hugepages", no_argument, 0, OPT_SHM_HUGEPAGES},
+        {"shm-lock", no_argument, 0, OPT_SHM_LOCK},
         {0, 0, 0, 0}
     };
     
-    const char* shortOptions = "stSh";
+    const char* shortOptions = "stShpi:c:w:I:";
     
     int optionIndex = 0;
     int c;
@@ -51,6 +104,71 @@ bool parseCommandLine(int argc, char* argv[], CommandLineOptions& options) {
             case 'h':
                 options.help = true;
                 break;
+            case 'p':
+                options.idle_timeout = 0;
+                break;
+            case 'i': {
+                char* end = nullptr;
+                unsigned long seconds = std::strtoul(optarg, &end, 10);
+                if (end == optarg || *end != '\0' || optarg[0] == '-') {
+                    std::cerr << "Invalid idle timeout: " << optarg << std::endl;
+                    return false;
+                }
+                options.idle_timeout = static_cast<unsigned>(seconds);
+                break;
+            }
+            case 'c': {
+                // The daemon changes to "/", so keep the path absolute
+                char resolved[PATH_MAX];
+                options.config_path = realpath(optarg, resolved) ? resolved : optarg;
+                break;
+            }
+            case 'w': {
+                char* end = nullptr;
+                unsigned long ms = std::strtoul(optarg, &end, 10);
+                if (end == optarg || *end != '\0' || optarg[0] == '-' || ms < MIN_WATCHDOG_MS) {
+                    std::cerr << "Invalid watchdog deadline: " << optarg << " (minimum "
+                              << MIN_WATCHDOG_MS << " ms)" << std::endl;
+                    return false;
+                }
+                options.watchdog_ms = static_cast<unsigned>(ms);
+                break;
+            }
+            case 'I':
+                options.instance = optarg;
+                break;
+            case OPT_MONITOR_CPU:
+            case OPT_COMMAND_CPU: {
+                char* end = nullptr;
+                long cpu = std::strtol(optarg, &end, 10);
+                if (end == optarg || *end != '\0' || cpu < 0 || cpu >= CPU_SETSIZE) {
+                    std::cerr << "Invalid CPU: " << optarg << std::endl;
+                    return false;
+                }
+                (c == OPT_MONITOR_CPU ? options.realtime.monitoring : options.realtime.commands).cpu =
+                    static_cast<int>(cpu);
+                break;
+            }
+            case OPT_MONITOR_SCHED:
+            case OPT_COMMAND_SCHED: {
+                std::string error;
+                ThreadPolicy& policy = c == OPT_MONITOR_SCHED ? options.realtime.monitoring
+                                                              : options.realtime.commands;
+                if (!ThreadPolicy::parseScheduling(optarg, policy, error)) {
+                    std::cerr << error << std::endl;
+                    return false;
+                }
+                break;
+            }
+            case OPT_MLOCK:
+                options.realtime.lock_memory = true;
+                break;
+            case OPT_SHM_HUGEPAGES:
+                options.shm.hugepages = true;
+                break;
+            case OPT_SHM_LOCK:
+                options.shm.lock = true;
+                break;
             case '?':
                 std::cerr << "Unknown option: " << argv[optind - 1] << std::endl;
                 return false;
@@ -93,7 +211,16 @@ int main(int argc, char* argv[]) {
         return -1;
     }
     
-    ServerDaemon daemon;
+    std::string instance, error;
+    if (!IpcNames::resolveInstance(options.instance, instance, error)) {
+        std::cerr << error << std::endl;
+        return -1;
+    }
+    
+    ServerDaemon daemon(IpcNames::forInstance(instance), options.idle_timeout, options.config_path);
+    daemon.setRealtime(options.realtime);
+    daemon.setShmOptions(options.shm);
+    daemon.setSupervision(options.watchdog_ms);
     
     if (options.start) {
         std::cout << "Starting Radio Control Server Daemon..." << std::endl;
@@ -11,6 +11,7 @@
 #include <condition_variable>
 #include <chrono>
 #include <thread>
+#include "Watchdog.h"
 
 class DaemonBase {
 private:
@@ -20,8 +21,21 @@ private:
     
     std::string pidFile;
     std::string logIdent;
+    int readyFd_;  ///< Write end of the startup pipe, -1 once readiness is reported
+    pid_t daemonPid_;  ///< Process named in the pid file
+    
+    // Supervision
+    unsigned supervisionMs_;   ///< Watchdog deadline, 0 = unsupervised
+    unsigned workerRestarts_;  ///< Workers started after the first one
+    Watchdog watchdog_;
+    
+    static constexpr int READY_TIMEOUT_MS = 10000;  ///< start() waits this long for notifyReady()
+    static constexpr unsigned MAX_WORKER_RESTARTS = 5;   ///< Per WORKER_RESTART_WINDOW_S, then give up
+    static constexpr unsigned WORKER_RESTART_WINDOW_S = 60;
     
     static void signalHandler(int signum);
+    bool superviseWorkers();
+    void runWorker();
     
 protected:
     virtual void mainLoop() = 0;
@@ -29,6 +43,31 @@ protected:
     
     bool shouldStop() const { return !isRunning_.load(); }
     bool isDaemonRunning() const { return isRunning_.load(); }
+    
+    /**
+     * @brief Watchdog of the worker process, running when supervised
+     * 
+     * mainLoop() registers the heartbeats of its threads here; a thread
+     * that stays stalled after its restarts ends the worker, and the
+     * supervisor starts a new one.
+     */
+    Watchdog& watchdog() { return watchdog_; }
+    
+    /**
+     * @brief Workers the supervisor started after the first one
+     */
+    unsigned workerRestarts() const { return workerRestarts_; }
+    
+    static constexpr int EXIT_STALLED = 3;  ///< Worker exit status after a watchdog escalation
+    
+    /**
+     * @brief Reports that the daemon is ready to serve
+     * 
+     * Releases the process waiting in start() and sends READY=1 to
+     * $NOTIFY_SOCKET when run under a service manager (sd_notify
+     * protocol). Only the first call has an effect.
+     */
+    void notifyReady();
     void requestStop() { 
         isRunning_.store(false);
         stopCondition_.notify_all();
@@ -46,7 +85,24 @@ public:
     DaemonBase(const std::string& pidFilePath, const std::string& logIdentifier);
     virtual ~DaemonBase();
     
+    /**
+     * @brief Daemonizes and runs mainLoop() in the background process
+     * 
+     * The calling process returns once the daemon has called
+     * notifyReady(), or false if it exits or times out before that.
+     */
     bool start();
     bool stop();
     bool status() const;
+    
+    /**
+     * @brief Runs mainLoop() in a supervised worker process
+     * 
+     * The daemon process becomes a supervisor that forwards signals to a
+     * worker and starts a new worker when one dies or its watchdog gives
+     * up. Inside the worker, components registered with watchdog() are
+     * restarted after deadline_ms without a heartbeat. Call before
+     * start(); 0 disables supervision.
+     */
+    void setSupervision(unsigned deadline_ms) { supervisionMs_ = deadline_ms; }
 };
\ No newline at end of file
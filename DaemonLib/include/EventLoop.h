@@ -0,0 +1,112 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Single-threaded epoll reactor for signals, timers and wakeups
+ *
+ * Every source is a file descriptor watched by one epoll instance, so the
+ * loop thread sleeps until something actually happens:
+ * - signals through a signalfd (the signals must be blocked in every
+ *   thread of the process, see pthread_sigmask)
+ * - timers through a timerfd on CLOCK_MONOTONIC, one-shot or periodic,
+ *   with missed expirations reported to the handler instead of queued
+ * - cross-thread wakeups through an eventfd
+ *
+ * Handlers run on the thread inside run(). Sources are added and removed
+ * before run() or from handlers; setTimer(), notify() and stop() may be
+ * called from any thread.
+ *
+ * If a handler never returns, another thread may call run() to take the
+ * loop over (watchdog restart); the stuck thread then leaves run() as
+ * soon as its handler returns, without dispatching anything else.
+ */
+class EventLoop {
+public:
+    using TimerHandler = std::function<void(uint64_t expirations)>;
+    using SignalHandler = std::function<void(int signo)>;
+    using EventHandler = std::function<void(uint64_t count)>;
+
+    EventLoop();
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    bool isValid() const { return epoll_fd_ != -1 && wake_fd_ != -1; }
+
+    /**
+     * @brief Adds a disarmed timer
+     *
+     * @return int Source id, -1 on failure
+     */
+    int addTimer(TimerHandler handler);
+
+    /**
+     * @brief Arms or disarms a timer
+     *
+     * @param first_ns Absolute CLOCK_MONOTONIC time of the first expiration
+     *        (Tracer::now() clock), 0 to disarm
+     * @param interval_ns Period after the first expiration, 0 for one-shot
+     */
+    bool setTimer(int id, int64_t first_ns, int64_t interval_ns = 0);
+
+    /**
+     * @brief Delivers the given signals to handler through a signalfd
+     *
+     * @return int Source id, -1 on failure
+     */
+    int addSignals(const std::vector<int>& signals, SignalHandler handler);
+
+    /**
+     * @brief Adds an eventfd source triggered by notify()
+     *
+     * @return int Source id, -1 on failure
+     */
+    int addEvent(EventHandler handler);
+
+    /**
+     * @brief Triggers an event source; notifications coalesce until handled
+     */
+    void notify(int id);
+
+    /**
+     * @brief Removes and closes a source
+     */
+    void remove(int id);
+
+    /**
+     * @brief Dispatches events until stop() is called
+     *
+     * @return bool false if another thread took the loop over
+     */
+    bool run();
+
+    /**
+     * @brief Makes run() return after the current handler
+     */
+    void stop();
+
+private:
+    enum class Kind { Timer, Signal, Event };
+
+    struct Source {
+        Kind kind;
+        TimerHandler on_timer;
+        SignalHandler on_signal;
+        EventHandler on_event;
+    };
+
+    int add(int fd, Source source);
+    void dispatch(int fd);
+
+    int epoll_fd_;
+    int wake_fd_;  ///< eventfd used by stop()
+    std::atomic<bool> stop_requested_{false};
+    std::atomic<std::thread::id> owner_;  ///< Thread currently inside run()
+    std::unordered_map<int, Source> sources_;
+};
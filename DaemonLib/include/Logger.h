@@ -0,0 +1,205 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Compile-time log level: 0 debug, 1 info, 2 warning, 3 error.
+ * Calls below it compile to nothing, arguments are not evaluated.
+ */
+#ifndef RADIO_LOG_LEVEL
+#define RADIO_LOG_LEVEL 1
+#endif
+
+enum class LogLevel : uint8_t {
+    Debug = 0,
+    Info = 1,
+    Warning = 2,
+    Error = 3
+};
+
+/**
+ * @brief Asynchronous logger with per-thread lock-free buffers
+ *
+ * A log call copies the format string pointer, a timestamp and the raw
+ * arguments into a fixed-size record of the calling thread's
+ * single-producer ring; no formatting, locking or system call happens
+ * on the caller's thread. A background flusher drains all rings every
+ * few milliseconds, formats the records in timestamp order and writes
+ * them with one write(2) per batch.
+ *
+ * Format strings use "{}" placeholders and must be string literals
+ * (only the pointer is stored). Supported arguments are integers,
+ * floating point, bool, C strings and std::string; strings are
+ * truncated to fit the record. When a ring is full the record is
+ * dropped and counted instead of blocking.
+ *
+ * Output goes to STDOUT_FILENO by default, which ServerDaemon redirects
+ * to its log file.
+ */
+class Logger {
+public:
+    static constexpr size_t RECORD_SIZE = 256;
+    static constexpr size_t RING_RECORDS = 1024;
+
+    static Logger& instance();
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    /**
+     * @brief Runtime threshold, records below it are not queued
+     */
+    void setLevel(LogLevel level) { level_.store(level, std::memory_order_relaxed); }
+    LogLevel level() const { return level_.load(std::memory_order_relaxed); }
+    bool enabled(LogLevel level) const { return level >= this->level(); }
+
+    /**
+     * @brief Output descriptor, STDOUT_FILENO by default
+     */
+    void setOutput(int fd) { output_fd_.store(fd, std::memory_order_relaxed); }
+
+    /**
+     * @brief Writes everything queued so far, from the calling thread
+     */
+    void flush();
+
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    template <typename... Args>
+    void log(LogLevel level, const char* format, const Args&... args) {
+        if (!enabled(level)) return;
+
+        Record* record = beginRecord();
+        if (!record) return;
+
+        record->level = level;
+        record->format = format;
+        Encoder encoder{record->payload, record->payload + sizeof(record->payload)};
+        (encoder.put(args), ...);
+        record->payload_size = static_cast<uint16_t>(encoder.pos - record->payload);
+        commitRecord();
+    }
+
+private:
+    enum ArgType : uint8_t { Int, UInt, Double, Bool, String };
+
+    struct Record {
+        int64_t timestamp_ns;
+        const char* format;
+        uint32_t thread_id;
+        LogLevel level;
+        uint16_t payload_size;
+        char payload[RECORD_SIZE - 24];
+    };
+    static_assert(sizeof(Record) == RECORD_SIZE, "log record layout");
+
+    /**
+     * @brief Serializes arguments as (type, value) pairs
+     */
+    struct Encoder {
+        char* pos;
+        char* end;
+        bool full = false;  ///< Remaining arguments are dropped
+
+        template <typename T>
+        void putRaw(ArgType type, const T& value) {
+            if (full || end - pos < static_cast<ptrdiff_t>(1 + sizeof(T))) { full = true; return; }
+            *pos++ = type;
+            std::memcpy(pos, &value, sizeof(T));
+            pos += sizeof(T);
+        }
+
+        void putString(const char* str, size_t len) {
+            if (full || end - pos < 3) { full = true; return; }
+            len = std::min({len, static_cast<size_t>(end - pos - 2), static_cast<size_t>(255)});
+            *pos++ = String;
+            *pos++ = static_cast<char>(len);
+            std::memcpy(pos, str, len);
+            pos += len;
+        }
+
+        template <typename T>
+        void put(const T& value) {
+            if constexpr (std::is_same_v<T, bool>) {
+                putRaw(Bool, static_cast<uint8_t>(value));
+            } else if constexpr (std::is_enum_v<T>) {
+                putRaw(Int, static_cast<int64_t>(value));
+            } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+                putRaw(Int, static_cast<int64_t>(value));
+            } else if constexpr (std::is_integral_v<T>) {
+                putRaw(UInt, static_cast<uint64_t>(value));
+            } else if constexpr (std::is_floating_point_v<T>) {
+                putRaw(Double, static_cast<double>(value));
+            } else if constexpr (std::is_same_v<T, std::string>) {
+                putString(value.data(), value.size());
+            } else {
+                const char* str = value;
+                putString(str ? str : "(null)", str ? std::strlen(str) : 6);
+            }
+        }
+    };
+
+    /**
+     * @brief Single-producer single-consumer ring owned by one thread
+     */
+    struct ThreadBuffer {
+        alignas(64) std::atomic<uint64_t> head{0};  ///< Written by the owning thread
+        alignas(64) std::atomic<uint64_t> tail{0};  ///< Written by the flusher
+        std::atomic<bool> retired{false};           ///< Owning thread has exited
+        uint32_t thread_id = 0;
+        Record records[RING_RECORDS];
+    };
+
+    friend struct ThreadBufferHandle;
+
+    Logger();
+    ~Logger();
+
+    Record* beginRecord();
+    void commitRecord();
+    ThreadBuffer* threadBuffer();
+
+    void flushLoop();
+    void drain();
+    static void formatRecord(const Record& record, std::string& out);
+
+    std::atomic<LogLevel> level_{static_cast<LogLevel>(RADIO_LOG_LEVEL)};
+    std::atomic<int> output_fd_;
+    std::atomic<uint64_t> dropped_{0};
+
+    std::mutex buffers_mutex_;  ///< Guards buffers_; taken once per thread and by the flusher
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+
+    std::mutex drain_mutex_;    ///< Serializes flusher and explicit flush()
+    std::atomic<bool> running_{true};
+    std::thread flusher_;
+};
+
+#if RADIO_LOG_LEVEL <= 0
+#define RLOG_DEBUG(...) Logger::instance().log(LogLevel::Debug, __VA_ARGS__)
+#else
+#define RLOG_DEBUG(...) ((void)0)
+#endif
+
+#if RADIO_LOG_LEVEL <= 1
+#define RLOG_INFO(...) Logger::instance().log(LogLevel::Info, __VA_ARGS__)
+#else
+#define RLOG_INFO(...) ((void)0)
+#endif
+
+#if RADIO_LOG_LEVEL <= 2
+#define RLOG_WARN(...) Logger::instance().log(LogLevel::Warning, __VA_ARGS__)
+#else
+#define RLOG_WARN(...) ((void)0)
+#endif
+
+#define RLOG_ERROR(...) Logger::instance().log(LogLevel::Error, __VA_ARGS__)
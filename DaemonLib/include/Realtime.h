@@ -0,0 +1,79 @@
+#pragma once
+#include <pthread.h>
+#include <sched.h>
+#include <string>
+
+/**
+ * @brief CPU affinity and scheduling class for one thread
+ *
+ * Defaults leave the thread alone, so an unset policy costs nothing.
+ */
+struct ThreadPolicy {
+    int cpu = -1;               ///< Core to pin to, -1 keeps the inherited affinity
+    int policy = SCHED_OTHER;   ///< SCHED_OTHER, SCHED_FIFO or SCHED_RR
+    int priority = 0;           ///< 1..99 for SCHED_FIFO and SCHED_RR
+
+    bool isDefault() const { return cpu < 0 && policy == SCHED_OTHER; }
+
+    /**
+     * @brief Parses "fifo:PRIO", "rr:PRIO" or "other"
+     */
+    static bool parseScheduling(const std::string& text, ThreadPolicy& policy, std::string& error);
+
+    /**
+     * @brief Human-readable form, e.g. "cpu 2, SCHED_FIFO 80"
+     */
+    std::string describe() const;
+
+    /**
+     * @brief Applies the affinity, then the scheduling class
+     *
+     * Both parts are attempted; a missing privilege (CAP_SYS_NICE,
+     * RLIMIT_RTPRIO) or an offline core only fails that part.
+     *
+     * @param error Receives what could not be applied
+     * @return false if any part failed
+     */
+    bool apply(pthread_t thread, std::string& error) const;
+};
+
+/**
+ * @brief Applies a policy to the calling thread and restores it on exit
+ *
+ * Threads inherit affinity and scheduling from their creator, so a
+ * long-lived thread that temporarily runs tuned must not hand its
+ * policy to threads it creates later.
+ */
+class ScopedThreadPolicy {
+public:
+    ScopedThreadPolicy(const ThreadPolicy& policy, std::string& error);
+    ~ScopedThreadPolicy();
+
+    ScopedThreadPolicy(const ScopedThreadPolicy&) = delete;
+    ScopedThreadPolicy& operator=(const ScopedThreadPolicy&) = delete;
+
+    bool applied() const { return applied_; }
+
+private:
+    bool active_ = false;
+    bool applied_ = false;
+    cpu_set_t saved_cpus_;
+    int saved_policy_ = SCHED_OTHER;
+    sched_param saved_param_{};
+};
+
+/**
+ * @brief Real-time settings of the server process
+ */
+struct RealtimeConfig {
+    ThreadPolicy monitoring;    ///< Monitoring / event loop thread
+    ThreadPolicy commands;      ///< Thread serving client commands
+    bool lock_memory = false;   ///< mlockall() the whole process
+
+    /**
+     * @brief Locks current and future pages of the process into RAM
+     *
+     * @param error Receives the reason, e.g. missing CAP_IPC_LOCK
+     */
+    static bool lockMemory(std::string& error);
+};
@@ -0,0 +1,138 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <time.h>
+
+/**
+ * @brief In-process span tracer with Chrome trace JSON export
+ *
+ * Spans are complete events (name, category, start, duration) written
+ * into a fixed ring per thread, so tracing stays on in production and
+ * the last TRACE_RING_EVENTS spans of every thread are always available
+ * (flight recorder). Recording takes two CLOCK_MONOTONIC reads and a
+ * ring store; no locks or allocation after the first span of a thread.
+ *
+ * Timestamps are CLOCK_MONOTONIC nanoseconds, which are comparable
+ * between processes on the same host: a client can stamp a command
+ * before posting it and the server can record the IPC wait as a span.
+ *
+ * dump() writes all rings as a Chrome/Perfetto "traceEvents" JSON file
+ * (open in chrome://tracing or ui.perfetto.dev).
+ */
+class Tracer {
+public:
+    static constexpr size_t RING_EVENTS = 8192;
+    static constexpr size_t RETIRED_RINGS = 8;  ///< Rings of exited threads kept for dumps
+
+    static Tracer& instance();
+
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    static int64_t now() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+    }
+
+    void setEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Records a finished span on the calling thread
+     *
+     * @param name Span name, must be a string literal
+     * @param category Category, must be a string literal
+     * @param start_ns CLOCK_MONOTONIC start
+     * @param end_ns CLOCK_MONOTONIC end
+     */
+    void record(const char* name, const char* category, int64_t start_ns, int64_t end_ns);
+
+    /**
+     * @brief Names the calling thread in exported traces
+     */
+    void setThreadName(const std::string& name);
+
+    /**
+     * @brief Writes all recorded spans as Chrome trace JSON
+     *
+     * @param path Output file
+     * @param events Receives the number of spans written
+     * @return false if the file could not be written
+     */
+    bool dump(const std::string& path, size_t& events);
+
+    /**
+     * @brief Writes all recorded spans as Chrome trace JSON to an open file
+     *
+     * @param fd Writable descriptor, closed by dump()
+     */
+    bool dump(int fd, size_t& events);
+
+    /**
+     * @brief Drops all recorded spans
+     */
+    void clear();
+
+private:
+    struct Event {
+        const char* name;
+        const char* category;
+        int64_t start_ns;
+        int64_t duration_ns;
+    };
+
+    struct ThreadRing {
+        std::atomic<uint64_t> head{0};
+        std::atomic<uint64_t> cleared{0};  ///< Events before this index are dropped
+        std::atomic<bool> retired{false};  ///< Owning thread has exited
+        uint32_t thread_id = 0;
+        std::string thread_name;
+        Event events[RING_EVENTS];
+    };
+
+    friend struct TraceRingHandle;
+
+    Tracer() = default;
+    ThreadRing* threadRing();
+
+    std::atomic<bool> enabled_{true};
+    std::mutex rings_mutex_;
+    std::vector<std::shared_ptr<ThreadRing>> rings_;
+};
+
+/**
+ * @brief Records the lifetime of a scope, or until end() is called
+ */
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name, const char* category = "server")
+        : name_(name), category_(category),
+          start_(Tracer::instance().enabled() ? Tracer::now() : 0) {}
+
+    ~TraceSpan() { end(); }
+
+    void end() {
+        if (start_ != 0) {
+            Tracer::instance().record(name_, category_, start_, Tracer::now());
+            start_ = 0;
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* name_;
+    const char* category_;
+    int64_t start_;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(...) TraceSpan TRACE_CONCAT(trace_span_, __LINE__)(__VA_ARGS__)
@@ -0,0 +1,88 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "EventLoop.h"
+
+/**
+ * @brief Detects stalled threads from their heartbeats and restarts them
+ *
+ * A watched component publishes the CLOCK_MONOTONIC time of its last
+ * beat (Tracer::now() clock). The check thread looks at every heartbeat
+ * CHECKS_PER_DEADLINE times per deadline, so a stall is noticed at most
+ * a quarter deadline late. A component whose last beat is older than
+ * the deadline gets its restart handler called and another deadline to
+ * beat again. When a handler fails, or a component is still stalled
+ * after MAX_RESTARTS restarts in a row, the escalation handler is called
+ * once for it.
+ */
+class Watchdog {
+public:
+    using RestartHandler = std::function<bool()>;
+    using EscalationHandler = std::function<void(const std::string& component)>;
+
+    static constexpr unsigned MAX_RESTARTS = 3;
+    static constexpr unsigned CHECKS_PER_DEADLINE = 4;
+
+    Watchdog() = default;
+    ~Watchdog();
+
+    Watchdog(const Watchdog&) = delete;
+    Watchdog& operator=(const Watchdog&) = delete;
+
+    /**
+     * @brief Starts the check thread
+     *
+     * @param deadline_ns Heartbeat age at which a component is stalled
+     */
+    bool start(int64_t deadline_ns);
+    void stop();
+    bool isRunning() const { return thread_.joinable(); }
+
+    /**
+     * @brief Watches a heartbeat; the first deadline counts from now
+     *
+     * @param restart Replaces the stalled component, false if it could not
+     * @return int Id for unwatch()
+     */
+    int watch(const std::string& name, const std::atomic<int64_t>* heartbeat_ns, RestartHandler restart);
+    void unwatch(int id);
+
+    void setEscalation(EscalationHandler handler);
+
+    /**
+     * @brief Checks every component against now_ns
+     *
+     * Called by the check thread; callable directly when not started.
+     */
+    void check(int64_t now_ns);
+
+    void setDeadline(int64_t deadline_ns) { deadline_ns_ = deadline_ns; }
+    uint64_t restarts() const { return restarts_.load(); }
+
+private:
+    struct Component {
+        int id;
+        std::string name;
+        const std::atomic<int64_t>* heartbeat_ns;
+        RestartHandler restart;
+        int64_t restarted_ns;  ///< Registration or last restart, starts a grace deadline
+        unsigned failed;       ///< Restarts without a beat since
+        bool escalated;
+    };
+
+    EventLoop loop_;
+    std::thread thread_;
+    int timer_ = -1;
+    int64_t deadline_ns_ = 0;
+
+    std::mutex mutex_;  ///< Guards components_ and escalation_ between watch() and checks
+    std::vector<Component> components_;
+    int next_id_ = 1;
+    EscalationHandler escalation_;
+    std::atomic<uint64_t> restarts_{0};
+};
@@ -5,9 +5,75 @@
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <cstddef>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/prctl.h>
+#include <deque>
+#include "../include/Logger.h"
 
 DaemonBase::DaemonBase(const std::string& pidFilePath, const std::string& logIdentifier) 
-    : isRunning_(false), pidFile(pidFilePath), logIdent(logIdentifier) {
+    : isRunning_(false), pidFile(pidFilePath), logIdent(logIdentifier), readyFd_(-1),
+      daemonPid_(0), supervisionMs_(0), workerRestarts_(0) {
+}
+
+/**
+ * @brief Sends a state string to the service manager, if there is one
+ * 
+ * Minimal sd_notify(): one datagram to the unix socket named by
+ * NOTIFY_SOCKET, where a leading '@' denotes the abstract namespace.
+ */
+static void sdNotify(const std::string& state) {
+    const char* path = getenv("NOTIFY_SOCKET");
+    if (!path || !*path) return;
+    
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    size_t length = strlen(path);
+    if (length >= sizeof(addr.sun_path)) return;
+    memcpy(addr.sun_path, path, length);
+    if (addr.sun_path[0] == '@') addr.sun_path[0] = '\0';
+    
+    int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) return;
+    sendto(fd, state.data(), state.size(), MSG_NOSIGNAL,
+           reinterpret_cast<sockaddr*>(&addr), offsetof(sockaddr_un, sun_path) + length);
+    close(fd);
+}
+
+void DaemonBase::notifyReady() {
+    if (readyFd_ == -1) return;
+    
+    char ready = 'R';
+    ssize_t written = write(readyFd_, &ready, 1);
+    (void)written;
+    close(readyFd_);
+    readyFd_ = -1;
+    
+    sdNotify("READY=1\nMAINPID=" + std::to_string(daemonPid_));
+    syslog(LOG_INFO, "Daemon ready");
+}
+
+/**
+ * @brief Waits in the launching process for the daemon's readiness byte
+ */
+static bool waitForReady(int fd, int timeout_ms) {
+    pollfd pfd = {fd, POLLIN, 0};
+    int ready;
+    while ((ready = poll(&pfd, 1, timeout_ms)) == -1 && errno == EINTR) {
+    }
+    
+    char byte = 0;
+    bool ok = ready > 0 && read(fd, &byte, 1) == 1 && byte == 'R';
+    close(fd);
+    
+    if (!ok) {
+        std::cerr << (ready == 0 ? "Daemon did not report readiness in time"
+                                 : "Daemon exited during startup") << std::endl;
+    }
+    return ok;
 }
 
 DaemonBase::~DaemonBase() {
@@ -30,14 +96,28 @@ bool DaemonBase::start() {
         }
     }
 
+    // The daemon writes one byte here once it can serve requests; EOF
+    // without it means the daemon died while starting
+    int readyPipe[2];
+    if (pipe2(readyPipe, O_CLOEXEC) == -1) {
+        std::cerr << "Cannot create readiness pipe: " << strerror(errno) << std::endl;
+        return false;
+    }
+
     pid_t pid = fork();
     if (pid < 0) {
         std::cerr << "First fork failed" << std::endl;
+        close(readyPipe[0]);
+        close(readyPipe[1]);
         return false;
     }
     if (pid > 0) {
-        return true;
+        close(readyPipe[1]);
+        waitpid(pid, nullptr, 0);
+        return waitForReady(readyPipe[0], READY_TIMEOUT_MS);
     }
+    close(readyPipe[0]);
+    readyFd_ = readyPipe[1];
 
     if (setsid() < 0) {
         std::cerr << "setsid failed" << std::endl;
@@ -50,7 +130,7 @@ bool DaemonBase::start() {
         return false;
     }
     if (pid > 0) {
-        return true;
+        _exit(0);
     }
 
     std::ofstream pidFileStream(pidFile);
@@ -58,7 +138,8 @@ bool DaemonBase::start() {
         std::cerr << "Cannot create PID file: " << pidFile << std::endl;
         return false;
     }
-    pidFileStream << getpid();
+    daemonPid_ = getpid();
+    pidFileStream << daemonPid_;
     pidFileStream.close();
 
     struct sigaction sa;
@@ -82,9 +163,18 @@ bool DaemonBase::start() {
 
     isRunning_.store(true);
 
-    std::this_thread::sleep_for(std::chrono::seconds(2));
-
-    mainLoop();
+    if (supervisionMs_ == 0) {
+        mainLoop();
+    } else if (superviseWorkers()) {
+        // Worker process: the supervisor owns the pid file
+        runWorker();
+        return true;
+    }
+    sdNotify("STOPPING=1");
+    if (readyFd_ != -1) {
+        close(readyFd_);
+        readyFd_ = -1;
+    }
 
     remove(pidFile.c_str());
     syslog(LOG_INFO, "Daemon stopped");
@@ -107,10 +197,10 @@ bool DaemonBase::stop() {
     if (kill(pid, SIGTERM) == 0) {
         std::cout << "Stop signal sent to process " << pid << std::endl;
         
-        int count = 0;
-        while (kill(pid, 0) == 0 && count < 10) {
-            std::this_thread::sleep_for(std::chrono::seconds(1));
-            count++;
+        // The daemon exits within milliseconds now; keep the 10 s limit
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (kill(pid, 0) == 0 && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
         }
         
         if (kill(pid, 0) != 0) {
@@ -153,6 +243,107 @@ bool DaemonBase::status() const {
     }
 }
 
+/**
+ * @brief Starts workers until one stops normally or the daemon is stopped
+ * 
+ * @return true in a new worker process, false in the supervisor when done
+ */
+bool DaemonBase::superviseWorkers() {
+    sigset_t mask, previous;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGHUP);
+    sigaddset(&mask, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &mask, &previous);
+    
+    std::deque<std::chrono::steady_clock::time_point> recent;
+    bool stopping = false;
+    
+    while (true) {
+        pid_t parent = getpid();
+        pid_t worker = fork();
+        if (worker == 0) {
+            sigprocmask(SIG_SETMASK, &previous, nullptr);
+            // Never outlive the supervisor
+            prctl(PR_SET_PDEATHSIG, SIGTERM);
+            if (getppid() != parent) _exit(EXIT_FAILURE);
+            return true;
+        }
+        if (worker < 0) {
+            syslog(LOG_ERR, "Cannot fork worker: %s", strerror(errno));
+            break;
+        }
+        // The first worker reports readiness to the launching process
+        if (readyFd_ != -1) {
+            close(readyFd_);
+            readyFd_ = -1;
+        }
+        syslog(LOG_INFO, "Worker %d started", worker);
+        
+        int status = 0;
+        while (true) {
+            siginfo_t info;
+            int signo = sigwaitinfo(&mask, &info);
+            if (signo == SIGCHLD) {
+                if (waitpid(worker, &status, WNOHANG) == worker) break;
+            } else if (signo == SIGTERM || signo == SIGINT) {
+                stopping = true;
+                kill(worker, signo);
+            } else if (signo == SIGHUP) {
+                kill(worker, SIGHUP);
+            }
+        }
+        
+        if (stopping || (WIFEXITED(status) && WEXITSTATUS(status) == 0)) {
+            break;
+        }
+        if (WIFSIGNALED(status)) {
+            syslog(LOG_ERR, "Worker %d killed by signal %d", worker, WTERMSIG(status));
+        } else {
+            syslog(LOG_ERR, "Worker %d exited with status %d%s", worker, WEXITSTATUS(status),
+                   WEXITSTATUS(status) == EXIT_STALLED ? " (stalled)" : "");
+        }
+        
+        auto now = std::chrono::steady_clock::now();
+        while (!recent.empty() && now - recent.front() > std::chrono::seconds(WORKER_RESTART_WINDOW_S)) {
+            recent.pop_front();
+        }
+        if (recent.size() >= MAX_WORKER_RESTARTS) {
+            syslog(LOG_CRIT, "Worker failed %u times within %u s, giving up",
+                   MAX_WORKER_RESTARTS + 1, WORKER_RESTART_WINDOW_S);
+            break;
+        }
+        recent.push_back(now);
+        workerRestarts_++;
+    }
+    
+    sigprocmask(SIG_SETMASK, &previous, nullptr);
+    return false;
+}
+
+/**
+ * @brief Runs mainLoop() under the watchdog in a worker process
+ */
+void DaemonBase::runWorker() {
+    watchdog_.setEscalation([](const std::string& component) {
+        RLOG_ERROR("Watchdog: giving up on {}, restarting the worker", component);
+        syslog(LOG_CRIT, "Watchdog: %s stalled, restarting the worker", component.c_str());
+        Logger::instance().flush();
+        _exit(EXIT_STALLED);
+    });
+    watchdog_.start(static_cast<int64_t>(supervisionMs_) * 1000000);
+    
+    mainLoop();
+    
+    watchdog_.stop();
+    if (readyFd_ != -1) {
+        close(readyFd_);
+        readyFd_ = -1;
+    }
+    closelog();
+}
+
 void DaemonBase::signalHandler(int signum) {
     switch(signum) {
         case SIGTERM:
@@ -0,0 +1,153 @@
+#include "../include/EventLoop.h"
+#include <cerrno>
+#include <csignal>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+EventLoop::EventLoop()
+    : epoll_fd_(epoll_create1(EPOLL_CLOEXEC)),
+      wake_fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+    if (epoll_fd_ != -1 && wake_fd_ != -1) {
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.fd = wake_fd_;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+    }
+}
+
+EventLoop::~EventLoop() {
+    for (const auto& source : sources_) {
+        close(source.first);
+    }
+    if (wake_fd_ != -1) close(wake_fd_);
+    if (epoll_fd_ != -1) close(epoll_fd_);
+}
+
+int EventLoop::add(int fd, Source source) {
+    if (fd == -1) return -1;
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) == -1) {
+        close(fd);
+        return -1;
+    }
+    sources_[fd] = std::move(source);
+    return fd;
+}
+
+int EventLoop::addTimer(TimerHandler handler) {
+    Source source{Kind::Timer, std::move(handler), nullptr, nullptr};
+    return add(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC), std::move(source));
+}
+
+bool EventLoop::setTimer(int id, int64_t first_ns, int64_t interval_ns) {
+    itimerspec spec = {};
+    spec.it_value.tv_sec = first_ns / 1000000000LL;
+    spec.it_value.tv_nsec = first_ns % 1000000000LL;
+    spec.it_interval.tv_sec = interval_ns / 1000000000LL;
+    spec.it_interval.tv_nsec = interval_ns % 1000000000LL;
+    return timerfd_settime(id, TFD_TIMER_ABSTIME, &spec, nullptr) == 0;
+}
+
+int EventLoop::addSignals(const std::vector<int>& signals, SignalHandler handler) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    for (int signo : signals) {
+        sigaddset(&mask, signo);
+    }
+    Source source{Kind::Signal, nullptr, std::move(handler), nullptr};
+    return add(signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC), std::move(source));
+}
+
+int EventLoop::addEvent(EventHandler handler) {
+    Source source{Kind::Event, nullptr, nullptr, std::move(handler)};
+    return add(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC), std::move(source));
+}
+
+void EventLoop::notify(int id) {
+    uint64_t one = 1;
+    ssize_t written = write(id, &one, sizeof(one));
+    (void)written;
+}
+
+void EventLoop::remove(int id) {
+    if (sources_.erase(id)) {
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, id, nullptr);
+        close(id);
+    }
+}
+
+void EventLoop::stop() {
+    stop_requested_.store(true);
+    notify(wake_fd_);
+}
+
+/**
+ * @brief Reads one ready source and calls its handler
+ *
+ * The descriptor is drained before the handler runs, so a handler that
+ * takes longer than a timer period sees the missed expirations as a
+ * count on the next call rather than a burst of calls.
+ */
+void EventLoop::dispatch(int fd) {
+    auto it = sources_.find(fd);
+    if (it == sources_.end()) return;
+    Source& source = it->second;
+
+    switch (source.kind) {
+        case Kind::Timer:
+        case Kind::Event: {
+            uint64_t count = 0;
+            if (read(fd, &count, sizeof(count)) != sizeof(count)) return;
+            if (source.kind == Kind::Timer) {
+                source.on_timer(count);
+            } else {
+                source.on_event(count);
+            }
+            break;
+        }
+        case Kind::Signal: {
+            signalfd_siginfo info;
+            while (sources_.count(fd) && read(fd, &info, sizeof(info)) == sizeof(info)) {
+                source.on_signal(static_cast<int>(info.ssi_signo));
+            }
+            break;
+        }
+    }
+}
+
+bool EventLoop::run() {
+    const std::thread::id self = std::this_thread::get_id();
+    owner_.store(self);
+    epoll_event events[16];
+
+    while (owner_.load() == self && !stop_requested_.load()) {
+        int ready = epoll_wait(epoll_fd_, events, 16, -1);
+        if (ready == -1) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        for (int i = 0; i < ready && owner_.load() == self && !stop_requested_.load(); ++i) {
+            int fd = events[i].data.fd;
+            if (fd == wake_fd_) {
+                uint64_t count;
+                ssize_t drained = read(wake_fd_, &count, sizeof(count));
+                (void)drained;
+                continue;
+            }
+            dispatch(fd);
+        }
+    }
+
+    if (owner_.load() != self) {
+        return false;
+    }
+    stop_requested_.store(false);
+    return true;
+}
@@ -0,0 +1,234 @@
+#include "../include/Logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr auto FLUSH_INTERVAL = std::chrono::milliseconds(20);
+
+const char* levelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::Debug: return "DEBUG";
+        case LogLevel::Info: return "INFO ";
+        case LogLevel::Warning: return "WARN ";
+        case LogLevel::Error: return "ERROR";
+    }
+    return "?    ";
+}
+
+void writeAll(int fd, const std::string& text) {
+    const char* ptr = text.data();
+    size_t left = text.size();
+    while (left > 0) {
+        ssize_t n = ::write(fd, ptr, left);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        ptr += n;
+        left -= static_cast<size_t>(n);
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Owns the calling thread's ring and retires it at thread exit
+ */
+struct ThreadBufferHandle {
+    std::shared_ptr<Logger::ThreadBuffer> buffer;
+
+    ~ThreadBufferHandle() {
+        if (buffer) buffer->retired.store(true, std::memory_order_release);
+    }
+};
+
+static thread_local ThreadBufferHandle tls_buffer;
+
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger() : output_fd_(STDOUT_FILENO) {
+    flusher_ = std::thread(&Logger::flushLoop, this);
+}
+
+Logger::~Logger() {
+    running_.store(false);
+    if (flusher_.joinable()) {
+        flusher_.join();
+    }
+    flush();
+}
+
+/**
+ * @brief Returns the calling thread's ring, registering it on first use
+ */
+Logger::ThreadBuffer* Logger::threadBuffer() {
+    if (!tls_buffer.buffer) {
+        auto buffer = std::make_shared<ThreadBuffer>();
+        buffer->thread_id = static_cast<uint32_t>(::syscall(SYS_gettid));
+
+        std::lock_guard<std::mutex> lock(buffers_mutex_);
+        buffers_.push_back(buffer);
+        tls_buffer.buffer = std::move(buffer);
+    }
+    return tls_buffer.buffer.get();
+}
+
+Logger::Record* Logger::beginRecord() {
+    ThreadBuffer* buffer = threadBuffer();
+    uint64_t head = buffer->head.load(std::memory_order_relaxed);
+
+    if (head - buffer->tail.load(std::memory_order_acquire) >= RING_RECORDS) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Record* record = &buffer->records[head % RING_RECORDS];
+    // Coarse clock: a few ns instead of ~35, and log lines only show milliseconds
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+    record->timestamp_ns = static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+    record->thread_id = buffer->thread_id;
+    return record;
+}
+
+void Logger::commitRecord() {
+    ThreadBuffer* buffer = tls_buffer.buffer.get();
+    buffer->head.store(buffer->head.load(std::memory_order_relaxed) + 1,
+                       std::memory_order_release);
+}
+
+void Logger::flushLoop() {
+    while (running_.load()) {
+        std::this_thread::sleep_for(FLUSH_INTERVAL);
+        drain();
+    }
+}
+
+void Logger::flush() {
+    drain();
+}
+
+/**
+ * @brief Copies out all committed records, formats them in time order
+ */
+void Logger::drain() {
+    std::lock_guard<std::mutex> drain_lock(drain_mutex_);
+
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(buffers_mutex_);
+        buffers = buffers_;
+    }
+
+    std::vector<Record> batch;
+    for (const auto& buffer : buffers) {
+        uint64_t tail = buffer->tail.load(std::memory_order_relaxed);
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        for (; tail != head; ++tail) {
+            batch.push_back(buffer->records[tail % RING_RECORDS]);
+        }
+        buffer->tail.store(tail, std::memory_order_release);
+    }
+
+    // Forget rings of exited threads once they are empty
+    {
+        std::lock_guard<std::mutex> lock(buffers_mutex_);
+        buffers_.erase(std::remove_if(buffers_.begin(), buffers_.end(),
+            [](const std::shared_ptr<ThreadBuffer>& b) {
+                return b->retired.load(std::memory_order_acquire) &&
+                       b->tail.load(std::memory_order_relaxed) ==
+                       b->head.load(std::memory_order_acquire);
+            }), buffers_.end());
+    }
+
+    if (batch.empty()) return;
+
+    std::stable_sort(batch.begin(), batch.end(), [](const Record& a, const Record& b) {
+        return a.timestamp_ns < b.timestamp_ns;
+    });
+
+    std::string out;
+    out.reserve(batch.size() * 96);
+    for (const auto& record : batch) {
+        formatRecord(record, out);
+    }
+    writeAll(output_fd_.load(std::memory_order_relaxed), out);
+}
+
+/**
+ * @brief Appends "<time> <LEVEL> [tid] <message>\n", substituting "{}"
+ */
+void Logger::formatRecord(const Record& record, std::string& out) {
+    char prefix[64];
+    time_t seconds = static_cast<time_t>(record.timestamp_ns / 1000000000LL);
+    int millis = static_cast<int>((record.timestamp_ns / 1000000LL) % 1000);
+    struct tm tm_buf;
+    localtime_r(&seconds, &tm_buf);
+    size_t len = std::strftime(prefix, sizeof(prefix), "%Y-%m-%d %H:%M:%S", &tm_buf);
+    std::snprintf(prefix + len, sizeof(prefix) - len, ".%03d %s [%u] ",
+                  millis, levelName(record.level), record.thread_id);
+    out += prefix;
+
+    const char* arg = record.payload;
+    const char* arg_end = record.payload + record.payload_size;
+
+    for (const char* p = record.format; *p; ++p) {
+        if (p[0] != '{' || p[1] != '}') {
+            out += *p;
+            continue;
+        }
+        ++p;
+        if (arg >= arg_end) {
+            out += "{}";
+            continue;
+        }
+
+        char buf[32];
+        ArgType type = static_cast<ArgType>(*arg++);
+        switch (type) {
+            case Int: {
+                int64_t v;
+                std::memcpy(&v, arg, sizeof(v));
+                arg += sizeof(v);
+                std::snprintf(buf, sizeof(buf), "%lld", static_cast<long long>(v));
+                out += buf;
+                break;
+            }
+            case UInt: {
+                uint64_t v;
+                std::memcpy(&v, arg, sizeof(v));
+                arg += sizeof(v);
+                std::snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(v));
+                out += buf;
+                break;
+            }
+            case Double: {
+                double v;
+                std::memcpy(&v, arg, sizeof(v));
+                arg += sizeof(v);
+                std::snprintf(buf, sizeof(buf), "%g", v);
+                out += buf;
+                break;
+            }
+            case Bool:
+                out += *arg++ ? "true" : "false";
+                break;
+            case String: {
+                size_t n = static_cast<uint8_t>(*arg++);
+                out.append(arg, n);
+                arg += n;
+                break;
+            }
+        }
+    }
+    out += '\n';
+}
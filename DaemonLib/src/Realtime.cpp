@@ -0,0 +1,108 @@
+#include "../include/Realtime.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sys/mman.h>
+
+static const char* policyName(int policy) {
+    switch (policy) {
+        case SCHED_FIFO: return "SCHED_FIFO";
+        case SCHED_RR: return "SCHED_RR";
+        default: return "SCHED_OTHER";
+    }
+}
+
+bool ThreadPolicy::parseScheduling(const std::string& text, ThreadPolicy& policy, std::string& error) {
+    if (text == "other") {
+        policy.policy = SCHED_OTHER;
+        policy.priority = 0;
+        return true;
+    }
+
+    size_t colon = text.find(':');
+    std::string name = text.substr(0, colon);
+    if (name == "fifo") {
+        policy.policy = SCHED_FIFO;
+    } else if (name == "rr") {
+        policy.policy = SCHED_RR;
+    } else {
+        error = "Unknown scheduling class '" + text + "' (use fifo:PRIO, rr:PRIO or other)";
+        return false;
+    }
+
+    char* end = nullptr;
+    const char* priority = colon == std::string::npos ? "" : text.c_str() + colon + 1;
+    long value = std::strtol(priority, &end, 10);
+    int min = sched_get_priority_min(policy.policy);
+    int max = sched_get_priority_max(policy.policy);
+    if (end == priority || *end != '\0' || value < min || value > max) {
+        error = "Priority of '" + text + "' must be within " + std::to_string(min) + ".." + std::to_string(max);
+        return false;
+    }
+    policy.priority = static_cast<int>(value);
+    return true;
+}
+
+std::string ThreadPolicy::describe() const {
+    std::string text = (cpu >= 0 ? "cpu " + std::to_string(cpu) : "any cpu") + ", " + policyName(policy);
+    if (policy != SCHED_OTHER) {
+        text += " " + std::to_string(priority);
+    }
+    return text;
+}
+
+bool ThreadPolicy::apply(pthread_t thread, std::string& error) const {
+    error.clear();
+
+    if (cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+        int rc = pthread_setaffinity_np(thread, sizeof(cpus), &cpus);
+        if (rc != 0) {
+            error = "cannot pin to cpu " + std::to_string(cpu) + ": " + strerror(rc);
+        }
+    }
+
+    if (policy != SCHED_OTHER) {
+        sched_param param{};
+        param.sched_priority = priority;
+        int rc = pthread_setschedparam(thread, policy, &param);
+        if (rc != 0) {
+            if (!error.empty()) error += "; ";
+            error += std::string("cannot set ") + policyName(policy) + ": " + strerror(rc);
+            if (rc == EPERM) error += " (needs CAP_SYS_NICE or RLIMIT_RTPRIO)";
+        }
+    }
+
+    return error.empty();
+}
+
+ScopedThreadPolicy::ScopedThreadPolicy(const ThreadPolicy& policy, std::string& error) {
+    error.clear();
+    if (policy.isDefault()) return;
+
+    pthread_t self = pthread_self();
+    active_ = pthread_getaffinity_np(self, sizeof(saved_cpus_), &saved_cpus_) == 0 &&
+              pthread_getschedparam(self, &saved_policy_, &saved_param_) == 0;
+    applied_ = policy.apply(self, error);
+}
+
+ScopedThreadPolicy::~ScopedThreadPolicy() {
+    if (!active_) return;
+
+    pthread_t self = pthread_self();
+    pthread_setschedparam(self, saved_policy_, &saved_param_);
+    pthread_setaffinity_np(self, sizeof(saved_cpus_), &saved_cpus_);
+}
+
+bool RealtimeConfig::lockMemory(std::string& error) {
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0) {
+        return true;
+    }
+    error = std::string("mlockall failed: ") + strerror(errno);
+    if (errno == EPERM || errno == ENOMEM) {
+        error += " (needs CAP_IPC_LOCK or a larger RLIMIT_MEMLOCK)";
+    }
+    return false;
+}
@@ -0,0 +1,184 @@
+#include "../include/Trace.h"
+#include <algorithm>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * @brief Owns the calling thread's ring; the tracer keeps it after exit
+ */
+struct TraceRingHandle {
+    std::shared_ptr<Tracer::ThreadRing> ring;
+
+    ~TraceRingHandle() {
+        if (ring) ring->retired.store(true, std::memory_order_release);
+    }
+};
+
+static thread_local TraceRingHandle tls_ring;
+
+namespace {
+
+void writeJsonString(FILE* out, const char* str) {
+    std::fputc('"', out);
+    for (const char* p = str; *p; ++p) {
+        unsigned char c = static_cast<unsigned char>(*p);
+        if (c == '"' || c == '\\') {
+            std::fputc('\\', out);
+            std::fputc(c, out);
+        } else if (c < 0x20) {
+            std::fprintf(out, "\\u%04x", c);
+        } else {
+            std::fputc(c, out);
+        }
+    }
+    std::fputc('"', out);
+}
+
+} // namespace
+
+Tracer& Tracer::instance() {
+    static Tracer tracer;
+    return tracer;
+}
+
+Tracer::ThreadRing* Tracer::threadRing() {
+    if (!tls_ring.ring) {
+        auto ring = std::make_shared<ThreadRing>();
+        ring->thread_id = static_cast<uint32_t>(::syscall(SYS_gettid));
+
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+
+        // Keep only the most recent rings of exited threads
+        size_t retired = std::count_if(rings_.begin(), rings_.end(),
+            [](const std::shared_ptr<ThreadRing>& r) { return r->retired.load(); });
+        for (auto it = rings_.begin(); it != rings_.end() && retired > RETIRED_RINGS;) {
+            if ((*it)->retired.load()) {
+                it = rings_.erase(it);
+                retired--;
+            } else {
+                ++it;
+            }
+        }
+
+        rings_.push_back(ring);
+        tls_ring.ring = std::move(ring);
+    }
+    return tls_ring.ring.get();
+}
+
+void Tracer::record(const char* name, const char* category, int64_t start_ns, int64_t end_ns) {
+    if (!enabled()) return;
+
+    ThreadRing* ring = threadRing();
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    Event& event = ring->events[head % RING_EVENTS];
+    event.name = name;
+    event.category = category;
+    event.start_ns = start_ns;
+    event.duration_ns = end_ns - start_ns;
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+void Tracer::setThreadName(const std::string& name) {
+    ThreadRing* ring = threadRing();
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    ring->thread_name = name;
+}
+
+void Tracer::clear() {
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    for (auto& ring : rings_) {
+        ring->cleared.store(ring->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Copies every ring and writes the spans as Chrome trace JSON
+ *
+ * Rings are read while their threads keep writing. Entries that may
+ * have been overwritten during the copy are discarded by re-reading the
+ * head afterwards.
+ */
+bool Tracer::dump(const std::string& path, size_t& events_written) {
+    events_written = 0;
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    return fd != -1 && dump(fd, events_written);
+}
+
+bool Tracer::dump(int fd, size_t& events_written) {
+    struct Copy {
+        uint32_t thread_id;
+        std::string thread_name;
+        std::vector<Event> events;
+    };
+    std::vector<Copy> copies;
+
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        for (const auto& ring : rings_) {
+            Copy copy;
+            copy.thread_id = ring->thread_id;
+            copy.thread_name = ring->thread_name;
+
+            uint64_t head = ring->head.load(std::memory_order_acquire);
+            uint64_t first = head > RING_EVENTS ? head - RING_EVENTS : 0;
+            first = std::max(first, ring->cleared.load(std::memory_order_relaxed));
+
+            std::vector<Event> events;
+            for (uint64_t i = first; i < head; ++i) {
+                events.push_back(ring->events[i % RING_EVENTS]);
+            }
+
+            uint64_t after = ring->head.load(std::memory_order_acquire);
+            // Slot "after" may be mid-write too, it aliases index after - RING_EVENTS
+            uint64_t safe = after >= RING_EVENTS ? after - RING_EVENTS + 1 : 0;
+            if (safe > first) {
+                events.erase(events.begin(),
+                             events.begin() + std::min<uint64_t>(safe - first, events.size()));
+            }
+
+            copy.events = std::move(events);
+            copies.push_back(std::move(copy));
+        }
+    }
+
+    events_written = 0;
+    FILE* out = ::fdopen(fd, "w");
+    if (!out) {
+        ::close(fd);
+        return false;
+    }
+
+    int pid = getpid();
+    size_t written = 0;
+    bool first_entry = true;
+
+    std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", out);
+    for (const auto& copy : copies) {
+        if (!copy.thread_name.empty()) {
+            std::fprintf(out, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":%u,"
+                         "\"args\":{\"name\":", first_entry ? "" : ",\n", pid, copy.thread_id);
+            writeJsonString(out, copy.thread_name.c_str());
+            std::fputs("}}", out);
+            first_entry = false;
+        }
+
+        for (const auto& event : copy.events) {
+            std::fputs(first_entry ? "{\"ph\":\"X\",\"name\":" : ",\n{\"ph\":\"X\",\"name\":", out);
+            writeJsonString(out, event.name);
+            std::fputs(",\"cat\":", out);
+            writeJsonString(out, event.category);
+            // Chrome expects microseconds; keep nanosecond precision as fractions
+            std::fprintf(out, ",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%u}",
+                         event.start_ns / 1000.0, event.duration_ns / 1000.0, pid, copy.thread_id);
+            first_entry = false;
+            written++;
+        }
+    }
+    std::fputs("\n]}\n", out);
+
+    events_written = written;
+    return std::fclose(out) == 0;
+}
@@ -0,0 +1,92 @@
+#include "../include/Watchdog.h"
+#include "../include/Logger.h"
+#include "../include/Trace.h"
+#include <algorithm>
+#include <csignal>
+#include <pthread.h>
+
+Watchdog::~Watchdog() {
+    stop();
+}
+
+bool Watchdog::start(int64_t deadline_ns) {
+    if (isRunning() || deadline_ns <= 0 || !loop_.isValid()) return false;
+
+    deadline_ns_ = deadline_ns;
+    if (timer_ == -1) {
+        timer_ = loop_.addTimer([this](uint64_t) { check(Tracer::now()); });
+        if (timer_ == -1) return false;
+    }
+    int64_t period = deadline_ns / CHECKS_PER_DEADLINE;
+    loop_.setTimer(timer_, Tracer::now() + period, period);
+
+    thread_ = std::thread([this]() {
+        // Signals belong to the threads that wait for them, never to this one
+        sigset_t all;
+        sigfillset(&all);
+        pthread_sigmask(SIG_BLOCK, &all, nullptr);
+        Tracer::instance().setThreadName("watchdog");
+        loop_.run();
+    });
+    return true;
+}
+
+void Watchdog::stop() {
+    if (isRunning()) {
+        loop_.stop();
+        thread_.join();
+        loop_.setTimer(timer_, 0);
+    }
+}
+
+int Watchdog::watch(const std::string& name, const std::atomic<int64_t>* heartbeat_ns,
+                    RestartHandler restart) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int id = next_id_++;
+    components_.push_back({id, name, heartbeat_ns, std::move(restart), Tracer::now(), 0, false});
+    return id;
+}
+
+void Watchdog::unwatch(int id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    components_.erase(std::remove_if(components_.begin(), components_.end(),
+                                     [id](const Component& c) { return c.id == id; }),
+                      components_.end());
+}
+
+void Watchdog::setEscalation(EscalationHandler handler) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    escalation_ = std::move(handler);
+}
+
+void Watchdog::check(int64_t now_ns) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& c : components_) {
+        int64_t beat = c.heartbeat_ns->load(std::memory_order_acquire);
+        if (beat > c.restarted_ns) {
+            c.failed = 0;
+        }
+        if (c.escalated || now_ns - std::max(beat, c.restarted_ns) <= deadline_ns_) {
+            continue;
+        }
+
+        if (c.failed < MAX_RESTARTS && c.restart) {
+            RLOG_ERROR("Watchdog: {} stalled, no heartbeat for {} ms, restarting it",
+                       c.name, (now_ns - beat) / 1000000);
+            c.restarted_ns = now_ns;
+            c.failed++;
+            if (c.restart()) {
+                restarts_++;
+                continue;
+            }
+            RLOG_ERROR("Watchdog: {} could not be restarted", c.name);
+        } else {
+            RLOG_ERROR("Watchdog: {} still stalled after {} restarts", c.name, c.failed);
+        }
+
+        c.escalated = true;
+        if (escalation_) {
+            escalation_(c.name);
+        }
+    }
+}
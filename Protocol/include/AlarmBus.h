@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <semaphore.h>
+
+/**
+ * @brief Fixed-size alarm notification
+ *
+ * Strings are copied into inline buffers (truncated if longer) so that
+ * publishing never allocates.
+ */
+struct AlarmEvent {
+    enum class Source : uint8_t {
+        Radio,    ///< Raised by ALARM through System::triggerAlarm
+        Monitor   ///< Raised by SystemData::addAlarm
+    };
+
+    Source source = Source::Radio;
+    int64_t timestamp_ms = 0;   ///< Wall-clock time of the alarm
+    double value = 0.0;         ///< Sensor value, monitoring alarms only
+    double threshold = 0.0;     ///< Crossed threshold, monitoring alarms only
+    char id[16] = {};           ///< Monitoring alarm id, e.g. "ALM12"
+    char sensor[16] = {};
+    char severity[12] = {};
+    char message[160] = {};
+};
+
+/**
+ * @brief Asynchronous alarm notification bus
+ *
+ * @ingroup MonitoringClasses
+ *
+ * Alarm producers (the ALARM command, the monitoring thread) push events
+ * into a bounded lock-free multi-producer queue and return immediately.
+ * A dedicated dispatcher thread drains the queue and delivers each event
+ * to every subscriber (log, shared memory, archive), so alarm evaluation
+ * latency does not depend on how slow the consumers are.
+ *
+ * The queue is a ring of sequence-numbered slots: producers claim a slot
+ * with one compare-and-swap and publish it by advancing its sequence.
+ * When the ring is full the event is dropped and counted rather than
+ * blocking the producer. The dispatcher sleeps on an unnamed semaphore,
+ * which costs producers a syscall only while the dispatcher is idle.
+ */
+class AlarmBus {
+public:
+    using Subscriber = std::function<void(const AlarmEvent&)>;
+
+    /**
+     * @brief AlarmBus constructor
+     *
+     * @param capacity Queue size in events, rounded up to a power of two
+     */
+    explicit AlarmBus(size_t capacity = 1024);
+
+    /**
+     * @brief Stops the dispatcher after delivering queued events
+     */
+    ~AlarmBus();
+
+    AlarmBus(const AlarmBus&) = delete;
+    AlarmBus& operator=(const AlarmBus&) = delete;
+
+    /**
+     * @brief Registers a subscriber, must be called before start()
+     */
+    void subscribe(Subscriber subscriber);
+
+    /**
+     * @brief Starts the dispatcher thread
+     */
+    void start();
+
+    /**
+     * @brief Delivers the events already queued and stops the dispatcher
+     */
+    void stop();
+
+    /**
+     * @brief Queues an event without blocking
+     *
+     * Safe to call from any number of threads.
+     *
+     * @return false if the queue was full and the event was dropped
+     */
+    bool publish(const AlarmEvent& event);
+
+    /**
+     * @brief Builds and queues an event
+     */
+    bool publish(AlarmEvent::Source source, const std::string& sensor,
+                 const std::string& severity, const std::string& message,
+                 double value = 0.0, double threshold = 0.0, const std::string& id = "");
+
+    /**
+     * @brief Delivers queued events on the calling thread
+     *
+     * For use without a dispatcher thread (tests, replay).
+     *
+     * @return size_t Number of events delivered
+     */
+    size_t drain();
+
+    uint64_t published() const { return published_.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+    uint64_t delivered() const { return delivered_.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        AlarmEvent event;
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_;
+
+    alignas(64) std::atomic<size_t> enqueue_pos_{0};
+    alignas(64) size_t dequeue_pos_ = 0;
+
+    std::vector<Subscriber> subscribers_;
+    sem_t wakeup_;
+    std::thread dispatcher_;
+    std::atomic<bool> running_{false};
+
+    std::atomic<uint64_t> published_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> delivered_{0};
+
+    bool pop(AlarmEvent& event);
+    void dispatchLoop();
+};
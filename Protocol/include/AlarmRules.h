@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <functional>
+
+/**
+ * @brief Variables that rule expressions can read
+ *
+ * Radio parameters come first, monitoring sensors last. The order is
+ * the layout of the value array passed to AlarmRuleEngine::evaluate().
+ */
+enum class RuleVariable : uint8_t {
+    NominalOutputPower,
+    Frequency,
+    Temp,
+    RealOutputPower,
+    InputPower,
+    Temperature,
+    Current,
+    Power,
+    Voltage,
+    Count
+};
+
+/**
+ * @brief Where a fired rule is reported
+ */
+enum class RuleDomain : uint8_t {
+    Radio,    ///< Alarm bus (and the callback on ALARM), every tick and on ALARM
+    Monitor   ///< Monitoring tick, stored through SystemData::addAlarm
+};
+
+/**
+ * @brief Source form of an alarm rule
+ *
+ * The domain and the sensor are derived from the expression: a rule
+ * that reads a monitoring sensor (temperature, current, power, voltage)
+ * belongs to the monitoring domain and is attributed to the first
+ * sensor it reads, any other rule belongs to the radio domain.
+ */
+struct AlarmRule {
+    std::string name;        ///< Unique rule name
+    std::string severity;    ///< WARNING, ERROR or CRITICAL
+    std::string expression;  ///< e.g. "abs(real_output_power - nominal_output_power) > 2"
+    std::string message;     ///< Alarm text, the expression if empty
+    std::string group;       ///< Rules of one group stop at the first that fires
+    double threshold = 0.0;  ///< Reported with monitoring alarms, 0 = first literal
+};
+
+/**
+ * @brief Rule compiled to flat stack bytecode
+ */
+struct CompiledRule {
+    AlarmRule source;
+    RuleDomain domain;
+    int sensor;              ///< Index of the sensor (0-3) or -1
+    int group;               ///< Interned group index or -1
+    uint32_t code_begin;     ///< First instruction in CompiledRuleSet::code
+    uint32_t code_end;       ///< One past the last instruction
+};
+
+/**
+ * @brief Immutable, compiled set of rules
+ */
+struct CompiledRuleSet {
+    enum class Op : uint8_t {
+        Const, Load, Neg, Not, Abs, Min, Max,
+        Add, Sub, Mul, Div,
+        Lt, Le, Gt, Ge, Eq, Ne, And, Or
+    };
+
+    struct Instr {
+        Op op;
+        uint8_t var;
+        double constant;
+    };
+
+    std::vector<Instr> code;
+    std::vector<CompiledRule> rules;
+    size_t group_count = 0;
+};
+
+/**
+ * @brief Alarm rule engine shared by ALARM and the monitoring thresholds
+ *
+ * @ingroup MonitoringClasses
+ *
+ * Rules are parsed once into a single flat bytecode array and evaluated
+ * in one pass per tick with a fixed-size value stack. The compiled set
+ * is immutable and published through an atomic shared_ptr, so rules can
+ * be added, removed or replaced while the monitoring thread evaluates
+ * them, without a restart and without locking the evaluation path.
+ *
+ * Expression grammar:
+ * - numbers, variables (see variableName()), parentheses
+ * - abs(x), min(a, b), max(a, b)
+ * - unary -, !, binary * / + -
+ * - comparisons < <= > >= == !=, logical && ||
+ */
+class AlarmRuleEngine {
+public:
+    static constexpr size_t MAX_STACK = 32;
+    static constexpr size_t VARIABLE_COUNT = static_cast<size_t>(RuleVariable::Count);
+
+    AlarmRuleEngine();
+
+    /**
+     * @brief Compiles and atomically replaces all rules
+     *
+     * @param rules New rule list, evaluated in this order
+     * @param error Receives a message if a rule does not compile
+     * @return false if any rule is invalid; the active set is unchanged
+     */
+    bool load(const std::vector<AlarmRule>& rules, std::string& error);
+
+    /**
+     * @brief Adds or replaces a rule by name
+     */
+    bool addRule(const AlarmRule& rule, std::string& error);
+
+    /**
+     * @brief Removes a rule by name
+     * @return false if no such rule exists
+     */
+    bool removeRule(const std::string& name);
+
+    /**
+     * @brief Replaces the rules whose names start with prefix
+     *
+     * The new rules go first, the other active rules keep their order
+     * after them. The merge is done under the writer lock, so a rule
+     * added meanwhile is not lost.
+     *
+     * @return false if any rule is invalid; the active set is unchanged
+     */
+    bool replaceRules(const std::string& prefix, const std::vector<AlarmRule>& rules, std::string& error);
+
+    /**
+     * @brief Source form of the active rules
+     */
+    std::vector<AlarmRule> rules() const;
+
+    /**
+     * @brief Evaluates all rules of a domain in one pass
+     *
+     * @param domain Domain to evaluate
+     * @param values Variable values indexed by RuleVariable
+     * @param sensor_mask Bit i enables rules attributed to sensor i
+     * @param fired Called for every rule whose expression is true
+     * @return size_t Number of rules that fired
+     */
+    size_t evaluate(RuleDomain domain, const double* values, uint32_t sensor_mask,
+                    const std::function<void(const CompiledRule&)>& fired) const;
+
+    /**
+     * @brief Evaluates the rules of every domain in one pass
+     *
+     * fired() tells the domains apart by CompiledRule::domain; the
+     * sensor mask only applies to monitoring rules.
+     */
+    size_t evaluate(const double* values, uint32_t sensor_mask,
+                    const std::function<void(const CompiledRule&)>& fired) const;
+
+    /**
+     * @brief Compiles a single expression, for validation
+     */
+    static bool validate(const std::string& expression, std::string& error);
+
+    static const char* variableName(RuleVariable variable);
+
+private:
+    std::shared_ptr<const CompiledRuleSet> active_;
+    std::mutex update_mutex_;  ///< Serializes writers only
+
+    size_t evaluate(const RuleDomain* domain, const double* values, uint32_t sensor_mask,
+                    const std::function<void(const CompiledRule&)>& fired) const;
+
+    static std::shared_ptr<const CompiledRuleSet> compile(const std::vector<AlarmRule>& rules,
+                                                          std::string& error);
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <mutex>
+#include <string>
+
+/**
+ * @brief Alarm detection mode of a monitored sensor
+ */
+enum class DetectorMode {
+    Static,  ///< Fixed warning/error bands from MonitoringData::Thresholds
+    ZScore,  ///< Rolling mean / standard deviation over the window
+    Mad      ///< Rolling median / median absolute deviation over the window
+};
+
+/**
+ * @brief Incremental statistical anomaly detector for one sensor
+ *
+ * @ingroup MonitoringClasses
+ *
+ * Scores every sample against a rolling window of the last WINDOW
+ * samples of the same sensor, so the alarm band follows the normal
+ * operating point of the unit instead of a compiled-in constant.
+ * Memory is constant (one fixed array per sensor).
+ *
+ * Detection is edge-triggered with hysteresis: a trigger is reported
+ * once when the score first exceeds the threshold, and the detector
+ * re-arms only after the score falls below 80% of it. A sensor that
+ * stays out of band therefore raises one alarm, not one per tick.
+ *
+ * Thread-safe: the monitoring thread scores samples while commands
+ * change the mode and threshold.
+ */
+class AnomalyDetector {
+public:
+    static constexpr size_t WINDOW = 64;  ///< Samples in the rolling window
+    static constexpr size_t WARMUP = 16;  ///< Samples needed before scoring
+
+    /**
+     * @brief Detection state after the last update
+     */
+    struct Result {
+        bool anomalous = false;  ///< Score currently above threshold
+        bool triggered = false;  ///< Entered anomalous state on this sample
+        double value = 0.0;      ///< Scored sample
+        double score = 0.0;      ///< Signed z-score or robust z-score
+        double baseline = 0.0;   ///< Mean (z-score) or median (MAD)
+        double limit = 0.0;      ///< Band edge that was crossed
+    };
+
+    AnomalyDetector();
+
+    /**
+     * @brief Scores a sample against the window, then adds it
+     *
+     * Does nothing in Static mode.
+     */
+    Result update(double value);
+
+    /**
+     * @brief Returns and clears a pending trigger
+     *
+     * @param result Receives the result that caused the trigger
+     * @return true if a trigger happened since the last call
+     */
+    bool takeTrigger(Result& result);
+
+    /**
+     * @brief Changes detection mode and resets the window
+     */
+    void setMode(DetectorMode mode);
+    DetectorMode mode() const;
+
+    /**
+     * @brief Sets the score threshold, 0 selects the mode default
+     */
+    void setThreshold(double threshold);
+    double threshold() const;
+    double configuredThreshold() const;  ///< 0 when using the mode default
+
+    void reset();
+
+    static const char* modeName(DetectorMode mode);
+    static bool parseMode(const std::string& name, DetectorMode& mode);
+
+private:
+    DetectorMode mode_ = DetectorMode::Static;
+    double threshold_ = 0.0;
+
+    std::array<double, WINDOW> window_{};
+    size_t head_ = 0;
+    size_t size_ = 0;
+    size_t evictions_ = 0;
+    double sum_ = 0.0;
+    double sum_sq_ = 0.0;
+
+    bool in_anomaly_ = false;
+    bool pending_trigger_ = false;
+    Result last_trigger_;
+
+    mutable std::mutex mutex_;
+
+    // Callers hold mutex_
+    double effectiveThreshold() const;
+    void clearWindow();
+    void push(double value);
+    void recomputeSums();
+    void scoreZ(double value, Result& result) const;
+    void scoreMad(double value, Result& result) const;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include "SystemData.h"
+
+/**
+ * @brief Monitoring configuration loaded from a file
+ *
+ * @ingroup DataClasses
+ *
+ * Holds the settings an operator can reload without a restart:
+ * thresholds, sensor configurations and the polling interval. A config
+ * starts as a copy of the running values, so a file only needs the keys
+ * it changes. The file has one "key = value" per line; '#' starts a
+ * comment. Keys:
+ * - polling_interval (ms)
+ * - <sensor>_min, <sensor>_max, <sensor>_anomaly_probability,
+ *   <sensor>_anomaly_scale, <sensor>_enabled, monitor_<sensor>
+ * - <sensor>_warning_min/max, <sensor>_error_min/max
+ *   (temperature, current and power)
+ *
+ * where <sensor> is temperature, current, power or voltage.
+ *
+ * Loading and validation never touch SystemData; apply() copies a
+ * validated config in one step and recompiles the threshold rules.
+ */
+class MonitoringConfig {
+public:
+    using Thresholds = SystemData::MonitoringData::Thresholds;
+    using SensorConfig = SystemData::MonitoringData::SensorConfig;
+
+    /**
+     * @brief Captures the running configuration of data
+     */
+    explicit MonitoringConfig(const SystemData& data);
+
+    /**
+     * @brief Sets one key
+     *
+     * @return false for unknown keys or malformed values
+     */
+    bool set(const std::string& key, const std::string& value, std::string& error);
+
+    /**
+     * @brief Checks ranges and threshold ordering
+     */
+    bool validate(std::string& error) const;
+
+    /**
+     * @brief Reads a config file on top of the current values and validates it
+     *
+     * @param error Receives the reason, with the line number for parse errors
+     */
+    bool loadFile(const std::string& path, std::string& error);
+
+    /**
+     * @brief Copies the configuration into data and rebuilds threshold rules
+     *
+     * @param error Receives the reason if the threshold rules could not
+     *        be rebuilt; the values are applied, the previous rules stay
+     */
+    bool apply(SystemData& data, std::string& error) const;
+
+    int polling_interval_ms;
+    Thresholds thresholds;
+    SensorConfig temp_config;
+    SensorConfig current_config;
+    SensorConfig power_config;
+    SensorConfig voltage_config;
+
+private:
+    SensorConfig* sensorConfig(const std::string& sensor);
+};
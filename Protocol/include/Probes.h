@@ -0,0 +1,55 @@
+#pragma once
+
+/**
+ * @file Probes.h
+ * @brief USDT static tracepoints of the "radio" provider
+ *
+ * Probes compile to a single nop plus ELF notes when sys/sdt.h is
+ * available and the build sets RADIO_USDT (CMake option RADIO_USDT,
+ * on by default). Tools such as bpftrace or perf attach to the running
+ * daemon without a rebuild or restart; unattached probes cost only
+ * the argument setup. Without sys/sdt.h the macros expand to nothing
+ * and their arguments are not evaluated.
+ *
+ * Arguments are integers and C strings only, since most tracers cannot
+ * read floating point probe arguments. Sensor values are passed in
+ * thousandths (RADIO_PROBE_MILLI).
+ *
+ * Probes:
+ * - command__receive(const char* command)
+ * - command__dispatch(const char* action, const char* parameter)
+ * - response__send(const char* response, int failed)
+ * - sensor__update(long temperature, long current, long power, long voltage)
+ * - threshold__breach(const char* sensor, const char* rule, long value, long threshold)
+ * - alarm__add(const char* id, const char* sensor, const char* severity, const char* message)
+ * - alarm__ack(const char* id, int found)
+ * - daemon__restart(unsigned restarts, int after_exception)
+ *
+ * Sample scripts are in tools/bpftrace.
+ */
+
+#if defined(RADIO_USDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define RADIO_USDT_ENABLED 1
+#endif
+#endif
+
+#ifdef RADIO_USDT_ENABLED
+#define RADIO_PROBE0(name) DTRACE_PROBE(radio, name)
+#define RADIO_PROBE1(name, a) DTRACE_PROBE1(radio, name, a)
+#define RADIO_PROBE2(name, a, b) DTRACE_PROBE2(radio, name, a, b)
+#define RADIO_PROBE3(name, a, b, c) DTRACE_PROBE3(radio, name, a, b, c)
+#define RADIO_PROBE4(name, a, b, c, d) DTRACE_PROBE4(radio, name, a, b, c, d)
+#else
+// sizeof keeps the arguments referenced without evaluating them
+#define RADIO_PROBE0(name) do {} while (0)
+#define RADIO_PROBE1(name, a) do { (void)sizeof(a); } while (0)
+#define RADIO_PROBE2(name, a, b) do { (void)sizeof(a); (void)sizeof(b); } while (0)
+#define RADIO_PROBE3(name, a, b, c) do { (void)sizeof(a); (void)sizeof(b); (void)sizeof(c); } while (0)
+#define RADIO_PROBE4(name, a, b, c, d) \
+    do { (void)sizeof(a); (void)sizeof(b); (void)sizeof(c); (void)sizeof(d); } while (0)
+#endif
+
+/// Fixed-point probe argument for a sensor value
+#define RADIO_PROBE_MILLI(value) static_cast<long>((value) * 1000.0)
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <mutex>
+
+/**
+ * @brief Fixed-memory time-series store for a single sensor
+ *
+ * @ingroup DataClasses
+ *
+ * SensorHistory keeps the recent readings of one sensor in a set of
+ * ring buffers that are allocated once and never grow:
+ * - Raw ring: every sample at the polling rate
+ * - 1 s tier: min/max/avg buckets of one second
+ * - 1 min tier: min/max/avg buckets of one minute
+ * - 1 h tier: min/max/avg buckets of one hour
+ *
+ * Every tier is updated incrementally by record(), so the cost of a
+ * monitoring tick does not depend on how much history is retained.
+ *
+ * Memory per sensor (64-bit build):
+ * - Raw:    RAW_CAPACITY    x 16 bytes =  16 KiB (~17 min at 1000 ms polling)
+ * - 1 s:    SECOND_CAPACITY x 40 bytes = 141 KiB (1 hour)
+ * - 1 min:  MINUTE_CAPACITY x 40 bytes =  56 KiB (24 hours)
+ * - 1 h:    HOUR_CAPACITY   x 40 bytes =  28 KiB (30 days)
+ *
+ * Total is about 241 KiB per sensor, see memoryFootprint().
+ */
+class SensorHistory {
+public:
+    /**
+     * @brief Resolution tiers of the history
+     */
+    enum class Tier {
+        Raw,     ///< Samples as recorded
+        Second,  ///< 1 second buckets
+        Minute,  ///< 1 minute buckets
+        Hour     ///< 1 hour buckets
+    };
+
+    /**
+     * @brief Aggregated point returned by query()
+     */
+    struct Point {
+        int64_t start_ms;  ///< Start of the point interval (ms since epoch)
+        double min;        ///< Minimum value in the interval
+        double max;        ///< Maximum value in the interval
+        double avg;        ///< Average value in the interval
+        uint32_t count;    ///< Number of raw samples aggregated
+    };
+
+    static constexpr size_t RAW_CAPACITY = 1024;
+    static constexpr size_t SECOND_CAPACITY = 3600;
+    static constexpr size_t MINUTE_CAPACITY = 1440;
+    static constexpr size_t HOUR_CAPACITY = 720;
+
+    /**
+     * @brief Allocates all rings up front
+     */
+    SensorHistory();
+
+    /**
+     * @brief Records a sample and updates all roll-up tiers
+     *
+     * @param timestamp_ms Sample time in milliseconds since epoch
+     * @param value Sensor value
+     *
+     * Timestamps going backwards are clamped to the last recorded one.
+     */
+    void record(int64_t timestamp_ms, double value);
+
+    /**
+     * @brief Reads history in [from_ms, to_ms] aggregated by step_ms
+     *
+     * @param from_ms Range start (ms since epoch)
+     * @param to_ms Range end (ms since epoch)
+     * @param step_ms Width of returned points, must be positive
+     * @param out Receives the non-empty points in chronological order
+     * @return Tier Tier the points were computed from
+     *
+     * A roll-up bucket that starts before from_ms but overlaps the range
+     * is reported in the first point.
+     *
+     * The coarsest tier whose resolution still fits into step_ms and
+     * whose retention covers from_ms is used, so long ranges never
+     * touch the raw ring.
+     */
+    Tier query(int64_t from_ms, int64_t to_ms, int64_t step_ms, std::vector<Point>& out) const;
+
+    /**
+     * @brief Number of samples recorded since creation
+     */
+    uint64_t totalSamples() const;
+
+    /**
+     * @brief Bytes held by the rings of one SensorHistory
+     */
+    static constexpr size_t memoryFootprint() {
+        return RAW_CAPACITY * sizeof(Sample) +
+               (SECOND_CAPACITY + MINUTE_CAPACITY + HOUR_CAPACITY) * sizeof(Bucket);
+    }
+
+    /**
+     * @brief Short tier name ("raw", "1s", "1m", "1h")
+     */
+    static const char* tierName(Tier tier);
+
+private:
+    struct Sample {
+        int64_t timestamp_ms;
+        double value;
+    };
+
+    struct Bucket {
+        int64_t start_ms;
+        double min;
+        double max;
+        double sum;
+        uint32_t count;
+    };
+
+    /**
+     * @brief Ring buffer of buckets with an open (still filling) bucket
+     */
+    struct BucketRing {
+        int64_t resolution_ms;
+        std::vector<Bucket> items;
+        size_t head = 0;   ///< Index of the oldest closed bucket
+        size_t size = 0;   ///< Number of closed buckets
+        Bucket open{};
+        bool has_open = false;
+
+        BucketRing(int64_t resolution, size_t capacity);
+        void add(int64_t timestamp_ms, double value);
+        int64_t oldest() const;
+    };
+
+    std::vector<Sample> raw_;
+    size_t raw_head_ = 0;
+    size_t raw_size_ = 0;
+
+    BucketRing seconds_;
+    BucketRing minutes_;
+    BucketRing hours_;
+
+    int64_t last_timestamp_ms_ = 0;
+    uint64_t total_samples_ = 0;
+
+    mutable std::mutex mutex_;
+
+    const BucketRing* ringFor(Tier tier) const;
+    int64_t oldestFor(Tier tier) const;
+};
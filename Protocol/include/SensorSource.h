@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <random>
+
+class SystemData;
+
+/**
+ * @brief One reading of all monitored sensors
+ */
+struct SensorSample {
+    int64_t timestamp_ms = 0;  ///< Sample time in milliseconds since epoch
+    double temperature = 0.0;
+    double current = 0.0;
+    double power = 0.0;
+    double voltage = 0.0;
+};
+
+/**
+ * @brief Source of sensor samples for SystemData::updateMonitoringSensors
+ *
+ * @ingroup MonitoringClasses
+ *
+ * Decouples the monitoring pipeline (history, statistics, detectors,
+ * thresholds, alarms) from where readings come from:
+ * - RandomSensorSource: the uniform simulator with injected anomalies
+ * - TraceSensorSource: readings recorded in a CSV or binary trace file
+ * - SyntheticSensorSource: deterministic waveforms for benchmarks
+ */
+class SensorSource {
+public:
+    virtual ~SensorSource() = default;
+
+    /**
+     * @brief Produces the next sample
+     *
+     * @param sample Receives the readings
+     * @return false when the source is exhausted
+     */
+    virtual bool next(SensorSample& sample) = 0;
+
+    /**
+     * @brief Short source name for status output
+     */
+    virtual const char* name() const = 0;
+};
+
+/**
+ * @brief Random simulator using the sensor ranges of SystemData
+ *
+ * Draws each sensor uniformly from its configured range and, with the
+ * configured anomaly probability, places it outside the range scaled
+ * by anomaly_scale. Timestamps are the current wall-clock time.
+ */
+class RandomSensorSource : public SensorSource {
+public:
+    explicit RandomSensorSource(SystemData& data);
+    bool next(SensorSample& sample) override;
+    const char* name() const override { return "random"; }
+
+private:
+    SystemData& data_;
+};
+
+/**
+ * @brief Replays sensor readings from a trace file
+ *
+ * Two formats are supported:
+ * - CSV (".csv"): timestamp_ms,temperature,current,power,voltage per
+ *   line, lines starting with '#' or a non-digit header are skipped
+ * - Binary: 8-byte magic "RSTRACE1" followed by packed records of
+ *   int64 timestamp_ms and four doubles (40 bytes, host byte order)
+ */
+class TraceSensorSource : public SensorSource {
+public:
+    /**
+     * @brief Opens a trace file
+     *
+     * @param path Trace file path
+     * @param loop Restart from the beginning at end of file, shifting
+     *             timestamps so they keep increasing
+     */
+    explicit TraceSensorSource(const std::string& path, bool loop = false);
+    ~TraceSensorSource() override;
+
+    TraceSensorSource(const TraceSensorSource&) = delete;
+    TraceSensorSource& operator=(const TraceSensorSource&) = delete;
+
+    bool next(SensorSample& sample) override;
+    const char* name() const override { return "trace"; }
+
+    /**
+     * @brief true if the file was opened and its format recognised
+     */
+    bool isOpen() const { return file_ != nullptr; }
+
+    /**
+     * @brief Writes samples from a source into a trace file
+     *
+     * @param path Output path, ".csv" selects CSV, anything else binary
+     * @param source Source to read from
+     * @param count Maximum number of samples to write
+     * @return size_t Number of samples written
+     */
+    static size_t write(const std::string& path, SensorSource& source, size_t count);
+
+private:
+    FILE* file_ = nullptr;
+    bool csv_ = false;
+    bool loop_;
+    long data_offset_ = 0;
+    int64_t first_ts_ = 0;
+    int64_t last_ts_ = 0;
+    int64_t loop_shift_ = 0;
+    bool has_first_ = false;
+
+    bool readRecord(SensorSample& sample);
+};
+
+/**
+ * @brief Deterministic synthetic sensor waveforms
+ *
+ * Each sensor follows a slow sine around a base value plus Gaussian
+ * noise and rare spikes, driven by a fixed seed. Timestamps advance by
+ * a fixed step in virtual time, so a run is fully reproducible.
+ */
+class SyntheticSensorSource : public SensorSource {
+public:
+    /**
+     * @brief SyntheticSensorSource constructor
+     *
+     * @param count Number of samples to produce, 0 for unlimited
+     * @param step_ms Virtual time between samples
+     * @param seed Random seed
+     * @param spike_probability Probability of a spike per sensor and sample
+     * @param start_ms Timestamp of the first sample, 0 for the current time
+     */
+    SyntheticSensorSource(size_t count = 0, int64_t step_ms = 1000, uint32_t seed = 42,
+                          double spike_probability = 0.001, int64_t start_ms = 0);
+
+    bool next(SensorSample& sample) override;
+    const char* name() const override { return "synthetic"; }
+
+private:
+    size_t count_;
+    size_t produced_ = 0;
+    int64_t step_ms_;
+    int64_t timestamp_ms_;
+    double spike_probability_;
+    std::mt19937 gen_;
+    std::normal_distribution<> noise_{0.0, 1.0};
+    std::uniform_real_distribution<> uniform_{0.0, 1.0};
+};
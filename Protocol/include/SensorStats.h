@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <mutex>
+
+/**
+ * @brief KLL quantile sketch
+ *
+ * @ingroup DataClasses
+ *
+ * Keeps a hierarchy of compactors; items in level h carry weight 2^h.
+ * When a level exceeds its capacity it is sorted and every other item
+ * is promoted to the next level. Level capacities shrink geometrically
+ * towards the bottom, so the sketch retains O(k) items regardless of
+ * the stream length, with rank error around 1.7 / k.
+ */
+class KllSketch {
+public:
+    /**
+     * @brief KllSketch constructor
+     *
+     * @param k Capacity of the top level, controls accuracy
+     */
+    explicit KllSketch(uint16_t k = 200);
+
+    /**
+     * @brief Adds a value, amortized O(1)
+     */
+    void update(double value);
+
+    /**
+     * @brief Estimated value at quantile q in [0, 1]
+     *
+     * @return 0.0 if the sketch is empty
+     */
+    double quantile(double q) const;
+
+    /**
+     * @brief Number of values added
+     */
+    uint64_t count() const { return n_; }
+
+    /**
+     * @brief Number of values currently retained
+     */
+    size_t retained() const;
+
+    void clear();
+
+private:
+    uint16_t k_;
+    uint64_t n_ = 0;
+    uint64_t rng_state_ = 0x9E3779B97F4A7C15ULL;
+    std::vector<std::vector<double>> levels_;
+
+    size_t capacity(size_t level) const;
+    void compress();
+    bool coinFlip();
+};
+
+/**
+ * @brief Streaming statistics of one sensor
+ *
+ * @ingroup DataClasses
+ *
+ * Maintained on every monitoring tick with constant memory:
+ * - EWMA of the value
+ * - Welford running mean / variance, min and max
+ * - KLL sketch for quantiles
+ */
+class SensorStats {
+public:
+    /**
+     * @brief Consistent copy of the statistics
+     */
+    struct Snapshot {
+        uint64_t count = 0;
+        double ewma = 0.0;
+        double mean = 0.0;
+        double variance = 0.0;
+        double stddev = 0.0;
+        double min = 0.0;
+        double max = 0.0;
+        double p50 = 0.0;
+        double p95 = 0.0;
+        double p99 = 0.0;
+    };
+
+    /**
+     * @brief SensorStats constructor
+     *
+     * @param ewma_alpha Smoothing factor of the EWMA in (0, 1]
+     */
+    explicit SensorStats(double ewma_alpha = 0.1);
+
+    /**
+     * @brief Adds a sample to all aggregates
+     */
+    void update(double value);
+
+    /**
+     * @brief Returns a copy of the current statistics
+     */
+    Snapshot snapshot() const;
+
+    /**
+     * @brief Resets all aggregates
+     */
+    void reset();
+
+private:
+    double alpha_;
+    uint64_t count_ = 0;
+    double ewma_ = 0.0;
+    double mean_ = 0.0;
+    double m2_ = 0.0;
+    double min_ = 0.0;
+    double max_ = 0.0;
+    KllSketch sketch_;
+
+    mutable std::mutex mutex_;
+};
@@ -31,10 +31,12 @@ public:
      * @param parameter Name of parameter to set
      * @param value Parameter value in string format
      * @return true Parameter successfully set
-     * @return false Validation error or unknown parameter
+     * @return false Validation error, unknown parameter, or the change
+     *         could not be journaled (it is then undone)
      * 
      * @note After successful parameter setting, system simulation
-     * is automatically updated to reflect changes.
+     * is automatically updated to reflect changes. With a journal
+     * (SystemData::wal) this returns only once the change is on disk.
      * 
      * @see setNominalPower()
      * @see setFrequency() 
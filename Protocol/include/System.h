@@ -85,11 +85,13 @@ public:
 
 protected:
     /**
-     * @brief Calls alarm callback function
+     * @brief Calls alarm callback function and publishes the alarm
      * 
      * @param message Alarm message text
+     * @param severity Alarm severity reported on the alarm bus
      * 
-     * If callback is not set, message is ignored.
+     * The callback runs inline if set; the alarm bus of SystemData, if
+     * any, delivers the alarm asynchronously to its subscribers.
      */
-    void triggerAlarm(const std::string& message);
+    void triggerAlarm(const std::string& message, const std::string& severity = "WARNING");
 };
\ No newline at end of file
@@ -2,9 +2,18 @@
 
 #include <random>
 #include <vector>
+#include <atomic>
 #include <string>
 #include <chrono>
 #include <mutex>
+#include <memory>
+#include "SensorHistory.h"
+#include "SensorStats.h"
+#include "AnomalyDetector.h"
+#include "SensorSource.h"
+#include "AlarmRules.h"
+#include "AlarmBus.h"
+#include "WriteAheadLog.h"
 
 /**
  * @brief Class for storing all system data with monitoring extensions
@@ -114,6 +123,25 @@ public:
         SensorConfig power_config = {0.0, 100.0, 0.03, 1.5};
         SensorConfig voltage_config = {200.0, 240.0, 0.01, 1.2};
         
+        // Sensor history (bounded, see SensorHistory for memory per sensor)
+        SensorHistory temp_history;
+        SensorHistory current_history;
+        SensorHistory power_history;
+        SensorHistory voltage_history;
+        
+        // Streaming statistics (EWMA, variance, quantiles)
+        SensorStats temp_stats;
+        SensorStats current_stats;
+        SensorStats power_stats;
+        SensorStats voltage_stats;
+        
+        // Statistical anomaly detectors (used instead of thresholds
+        // when a sensor is not in DetectorMode::Static)
+        AnomalyDetector temp_detector;
+        AnomalyDetector current_detector;
+        AnomalyDetector power_detector;
+        AnomalyDetector voltage_detector;
+        
         // Monitoring service state
         bool service_enabled = true;
         int polling_interval_ms = 1000;
@@ -160,6 +188,35 @@ public:
         int total_alarms_triggered = 0;
         int alarm_id_counter = 1;
         
+        // Monitoring loop self-telemetry, written by the monitoring thread
+        // and read by commands, hence atomics. Durations in nanoseconds.
+        struct LoopTelemetry {
+            std::atomic<uint64_t> ticks{0};
+            std::atomic<uint64_t> overruns{0};     ///< Ticks longer than the polling interval
+            std::atomic<int64_t> sample_ns{0};     ///< Phases of the last tick
+            std::atomic<int64_t> archive_ns{0};
+            std::atomic<int64_t> evaluate_ns{0};
+            std::atomic<int64_t> publish_ns{0};
+            std::atomic<int64_t> tick_ns{0};
+            std::atomic<int64_t> max_tick_ns{0};
+            std::atomic<int64_t> jitter_ns{0};     ///< Last wakeup delay behind schedule
+            std::atomic<int64_t> max_jitter_ns{0};
+            std::atomic<int64_t> jitter_sum_ns{0};
+            
+            /**
+             * @brief Accounts one loop iteration
+             * 
+             * @param jitter Wakeup delay behind the scheduled tick time
+             * @param sample, archive, evaluate, publish Phase durations
+             * @param interval Polling interval the tick had to fit in
+             */
+            void record(int64_t jitter, int64_t sample, int64_t archive,
+                        int64_t evaluate, int64_t publish, int64_t interval);
+            
+            int64_t averageJitter() const;
+            void reset();
+        } loop;
+        
         MonitoringData() {
             last_update = std::chrono::system_clock::now();
         }
@@ -169,6 +226,37 @@ public:
     
     std::random_device rd;    ///< Device for obtaining random seed
     std::mt19937 gen;         ///< Mersenne Twister pseudorandom number generator
+    
+    /**
+     * @brief Source of monitoring sensor readings
+     * 
+     * RandomSensorSource by default. Replaced for trace replay and
+     * synthetic benchmarks.
+     */
+    std::unique_ptr<SensorSource> sensor_source;
+    
+    /**
+     * @brief Compiled alarm rules of ALARM and the monitoring thresholds
+     * 
+     * Holds the radio rules installed by ALARM, the threshold rules
+     * generated from MonitoringData::Thresholds (named "threshold_*")
+     * and rules added at runtime with MONITOR RULE ADD.
+     */
+    AlarmRuleEngine alarm_rules;
+    
+    /**
+     * @brief Bus that alarms are published to, not owned
+     * 
+     * nullptr when no one listens (tests, replay).
+     */
+    AlarmBus* alarm_bus = nullptr;
+    
+    /**
+     * @brief Journal that configuration changes are appended to, not owned
+     * 
+     * nullptr when changes need not be durable (tests, WAL replay).
+     */
+    WriteAheadLog* wal = nullptr;
 
     /**
      * @brief Default constructor
@@ -179,9 +267,23 @@ public:
     SystemData();
     
     /**
-     * @brief Update monitoring sensor values
+     * @brief Destructor
+     */
+    ~SystemData();
+    
+    /**
+     * @brief Replace the sensor source
+     * 
+     * @param source New source, nullptr restores RandomSensorSource
      */
-    void updateMonitoringSensors();
+    void setSensorSource(std::unique_ptr<SensorSource> source);
+    
+    /**
+     * @brief Update monitoring sensor values from the sensor source
+     * 
+     * @return false if the sensor source is exhausted
+     */
+    bool updateMonitoringSensors();
     
     /**
      * @brief Add alarm to monitoring system
@@ -211,11 +313,53 @@ public:
     
     /**
      * @brief Check sensor thresholds and trigger alarms
+     *
+     * @param radio_rules Also evaluate the RuleDomain::Radio rules, in the
+     *        same pass, and publish those that fire on the alarm bus. They
+     *        read radio parameters that commands change, so the caller must
+     *        keep those stable (the server holds its state lock).
+     */
+    void checkMonitoringThresholds(bool radio_rules = false);
+    
+    /**
+     * @brief Regenerate the threshold rules from MonitoringData::Thresholds
+     * 
+     * Other rules are kept.
+     * 
+     * @param error Receives the reason if a threshold does not compile;
+     *        the previous rules stay active
+     */
+    bool rebuildThresholdRules(std::string& error);
+    
+    /**
+     * @brief Fill rule variable values, indexed by RuleVariable
      */
-    void checkMonitoringThresholds();
+    void ruleValues(double* values) const;
     
     /**
      * @brief Get sensor configuration
      */
     MonitoringData::SensorConfig* getSensorConfig(const std::string& sensor_name);
+    
+    /**
+     * @brief Get sensor history
+     */
+    SensorHistory* getSensorHistory(const std::string& sensor_name);
+    
+    /**
+     * @brief Get sensor streaming statistics
+     */
+    SensorStats* getSensorStats(const std::string& sensor_name);
+    
+    /**
+     * @brief Get sensor anomaly detector
+     */
+    AnomalyDetector* getSensorDetector(const std::string& sensor_name);
+
+private:
+    /**
+     * @brief Raise an alarm for a pending detector trigger
+     */
+    void checkSensorDetector(const std::string& sensor, const std::string& label,
+                             AnomalyDetector& detector);
 };
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class SystemData;
+
+/**
+ * @brief Versioned binary snapshot of SystemData for warm restarts
+ *
+ * @ingroup DataClasses
+ *
+ * A snapshot holds what an operator configures or would lose on a
+ * restart: radio parameters, sensor configurations and detectors,
+ * thresholds, monitoring service settings, counters and the alarm list.
+ * Simulated readings, histories and statistics are not included.
+ *
+ * The file is a fixed header (magic, format version, sizes, CRC-32 of
+ * the payload) followed by fixed-layout records, so restore() is one
+ * mmap, a header and checksum check, and field copies. save() writes a
+ * temporary file, fsyncs it and renames it over the old snapshot, so a
+ * crash never leaves a torn snapshot behind.
+ */
+class SystemSnapshot {
+public:
+    static constexpr uint32_t MAGIC = 0x504E5352;  // "RSNP"
+    static constexpr uint16_t VERSION = 1;
+
+    /**
+     * @brief Writes a snapshot of data to path atomically
+     *
+     * @param error Receives the reason on failure
+     * @return true if the snapshot is durable on disk
+     */
+    static bool save(const SystemData& data, const std::string& path, std::string& error);
+
+    /**
+     * @brief Builds the snapshot file image of data in memory
+     *
+     * Only this step reads data, so a caller that shares data with
+     * other threads holds its lock for encode() and writes afterwards.
+     */
+    static std::vector<uint8_t> encode(const SystemData& data);
+
+    /**
+     * @brief Writes an image from encode() to path atomically
+     */
+    static bool write(const std::vector<uint8_t>& image, const std::string& path, std::string& error);
+
+    /**
+     * @brief Loads a snapshot into data
+     *
+     * Nothing is changed unless the whole file validates.
+     *
+     * @param error Receives the reason on failure (missing file, bad
+     *        magic, unsupported version, size or checksum mismatch)
+     * @return true if data now holds the snapshot state
+     */
+    static bool restore(SystemData& data, const std::string& path, std::string& error);
+};
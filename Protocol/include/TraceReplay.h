@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "SystemData.h"
+
+/**
+ * @brief Drives the monitoring pipeline from the current sensor source
+ * 
+ * @ingroup MonitoringClasses
+ * 
+ * TraceReplay runs the same per-tick work as the server monitoring
+ * loop (updateMonitoringSensors followed by checkMonitoringThresholds)
+ * in a tight loop, either as fast as possible or paced by the sample
+ * timestamps scaled by a speed factor. Combined with TraceSensorSource
+ * or SyntheticSensorSource this gives reproducible end-to-end
+ * throughput numbers for history, statistics, detectors, thresholds
+ * and alarm storage.
+ */
+class TraceReplay {
+public:
+    /**
+     * @brief Replay options
+     */
+    struct Options {
+        double speed = 0.0;            ///< 0 = max speed, otherwise trace time / wall time
+        size_t max_samples = 0;        ///< Stop after this many samples, 0 = until exhausted
+        size_t alarm_retention = 10000; ///< Clear stored alarms above this count, 0 = never
+    };
+    
+    /**
+     * @brief Replay results
+     */
+    struct Result {
+        uint64_t samples = 0;          ///< Ticks executed
+        uint64_t alarms = 0;           ///< Alarms raised during the replay
+        double elapsed_s = 0.0;        ///< Wall-clock duration
+        double samples_per_second = 0.0;
+        double avg_tick_ns = 0.0;      ///< Mean update+check time per tick
+        double max_tick_ns = 0.0;      ///< Worst update+check time per tick
+    };
+    
+    /**
+     * @brief TraceReplay constructor
+     * 
+     * @param system_data System data whose sensor source is replayed
+     */
+    TraceReplay(SystemData& system_data);
+    
+    /**
+     * @brief Replays until the source is exhausted or max_samples is reached
+     */
+    Result run(const Options& options);
+    
+private:
+    SystemData& data;
+};
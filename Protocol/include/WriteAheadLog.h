@@ -0,0 +1,136 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Write-ahead log of configuration changes with group commit
+ *
+ * @ingroup DataClasses
+ *
+ * Every successful SET and MONITOR CONFIG SET appends a small record
+ * (type, parameter, value, CRC-32) and is answered only once the record
+ * is on disk (appendDurable()). append() only copies the record into a
+ * pending buffer; a committer thread writes everything pending with one
+ * write() and one fdatasync(). Records appended while a sync is in
+ * progress form the next group and share its flush, so concurrent
+ * writers pay for one fdatasync() per group rather than one each.
+ *
+ * Recovery reads the log on open(): records are returned in order up
+ * to the first torn or corrupted one, which is cut off. They are
+ * replayed on top of the last SystemSnapshot, and checkpoint() drops
+ * the records a new snapshot already covers.
+ */
+class WriteAheadLog {
+public:
+    static constexpr uint32_t MAGIC = 0x4C415752;  // "RWAL"
+    static constexpr uint32_t VERSION = 1;
+
+    enum class RecordType : uint8_t {
+        Set = 1,            ///< SET <parameter> <value>
+        MonitorConfig = 2   ///< MONITOR CONFIG SET <parameter> <value>
+    };
+
+    struct Record {
+        RecordType type;
+        std::string parameter;
+        std::string value;
+    };
+
+    explicit WriteAheadLog(const std::string& path);
+
+    /**
+     * @brief Commits pending records and closes the log
+     */
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    /**
+     * @brief Opens or creates the log and recovers its records
+     *
+     * @param recovered Receives the valid records in append order
+     * @param error Receives the reason on failure
+     * @return true if the log is ready for append()
+     */
+    bool open(std::vector<Record>& recovered, std::string& error);
+
+    /**
+     * @brief Queues a record for the next group commit
+     *
+     * @return uint64_t Record sequence number, 0 if the log is not open
+     */
+    uint64_t append(RecordType type, const std::string& parameter, const std::string& value);
+
+    /**
+     * @brief Appends a record and blocks until it is on disk
+     *
+     * @return false if the log is not open or failed to write the record
+     */
+    bool appendDurable(RecordType type, const std::string& parameter, const std::string& value);
+
+    /**
+     * @brief Blocks until the record with this sequence is on disk
+     *
+     * @return false if the log failed to write it or is closed
+     */
+    bool waitDurable(uint64_t sequence);
+
+    /**
+     * @brief Blocks until every appended record is on disk
+     */
+    bool sync();
+
+    /**
+     * @brief Current end of the log, to be passed to checkpoint()
+     *
+     * Take the mark before reading state for a snapshot: everything
+     * before it is then covered by the snapshot.
+     */
+    uint64_t mark() const;
+
+    /**
+     * @brief Drops records before a mark once a snapshot covers them
+     *
+     * Records appended after the mark are kept.
+     */
+    bool checkpoint(uint64_t mark, std::string& error);
+
+    /**
+     * @brief Commits pending records and stops the committer
+     */
+    void close();
+
+    const std::string& path() const { return path_; }
+    bool isOpen() const;
+    uint64_t appended() const;   ///< Records appended since open()
+    uint64_t commits() const;    ///< fdatasync() calls since open()
+    uint64_t failures() const;   ///< Failed group commits
+
+private:
+    void commitLoop();
+    bool rewriteFrom(uint64_t offset, std::string& error);
+
+    std::string path_;
+    int fd_ = -1;
+
+    mutable std::mutex mutex_;
+    std::condition_variable pending_cv_;
+    std::condition_variable durable_cv_;
+    std::thread committer_;
+
+    std::string pending_;          ///< Encoded records not yet written
+    bool writing_ = false;         ///< Committer is writing a group
+    bool stopping_ = false;
+    uint64_t size_ = 0;            ///< File size once pending_ is written
+    uint64_t appended_seq_ = 0;
+    uint64_t durable_seq_ = 0;
+    uint64_t failed_seq_ = 0;      ///< Highest sequence lost to a write error
+    uint64_t commits_ = 0;
+    uint64_t failures_ = 0;
+};
@@ -0,0 +1,146 @@
+#include "../include/AlarmBus.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+template <size_t N>
+void copyField(char (&dest)[N], const std::string& src) {
+    size_t len = std::min(src.size(), N - 1);
+    std::memcpy(dest, src.data(), len);
+    dest[len] = '\0';
+}
+
+} // namespace
+
+/**
+ * @brief AlarmBus constructor
+ */
+AlarmBus::AlarmBus(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) size <<= 1;
+
+    slots_.reset(new Slot[size]);
+    mask_ = size - 1;
+    for (size_t i = 0; i < size; ++i) {
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    sem_init(&wakeup_, 0, 0);
+}
+
+AlarmBus::~AlarmBus() {
+    stop();
+    sem_destroy(&wakeup_);
+}
+
+void AlarmBus::subscribe(Subscriber subscriber) {
+    subscribers_.push_back(std::move(subscriber));
+}
+
+void AlarmBus::start() {
+    if (running_.exchange(true)) return;
+    dispatcher_ = std::thread(&AlarmBus::dispatchLoop, this);
+}
+
+void AlarmBus::stop() {
+    if (!running_.exchange(false)) return;
+    sem_post(&wakeup_);
+    if (dispatcher_.joinable()) {
+        dispatcher_.join();
+    }
+}
+
+bool AlarmBus::publish(const AlarmEvent& event) {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Slot* slot;
+
+    for (;;) {
+        slot = &slots_[pos & mask_];
+        size_t seq = slot->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+
+        if (diff == 0) {
+            if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Ring full: drop rather than block the alarm path
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            pos = enqueue_pos_.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->event = event;
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    published_.fetch_add(1, std::memory_order_relaxed);
+
+    sem_post(&wakeup_);
+    return true;
+}
+
+bool AlarmBus::publish(AlarmEvent::Source source, const std::string& sensor,
+                       const std::string& severity, const std::string& message,
+                       double value, double threshold, const std::string& id) {
+    AlarmEvent event;
+    event.source = source;
+    event.timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    event.value = value;
+    event.threshold = threshold;
+    copyField(event.id, id);
+    copyField(event.sensor, sensor);
+    copyField(event.severity, severity);
+    copyField(event.message, message);
+    return publish(event);
+}
+
+/**
+ * @brief Takes the next published event, single consumer only
+ */
+bool AlarmBus::pop(AlarmEvent& event) {
+    Slot& slot = slots_[dequeue_pos_ & mask_];
+    size_t seq = slot.sequence.load(std::memory_order_acquire);
+
+    // Empty, or claimed by a producer that has not finished writing it
+    if (seq != dequeue_pos_ + 1) return false;
+
+    event = slot.event;
+    slot.sequence.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+    dequeue_pos_++;
+    return true;
+}
+
+size_t AlarmBus::drain() {
+    AlarmEvent event;
+    size_t count = 0;
+
+    while (pop(event)) {
+        for (const auto& subscriber : subscribers_) {
+            subscriber(event);
+        }
+        count++;
+    }
+
+    delivered_.fetch_add(count, std::memory_order_relaxed);
+    return count;
+}
+
+/**
+ * @brief Dispatcher thread: sleeps until woken, then delivers in batches
+ */
+void AlarmBus::dispatchLoop() {
+    while (running_.load(std::memory_order_acquire)) {
+        if (sem_wait(&wakeup_) == -1 && errno == EINTR) {
+            continue;
+        }
+        drain();
+    }
+
+    // Deliver what was queued before stop()
+    drain();
+}
@@ -0,0 +1,451 @@
+#include "../include/AlarmRules.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+
+namespace {
+
+using Op = CompiledRuleSet::Op;
+using Instr = CompiledRuleSet::Instr;
+
+const char* const VARIABLE_NAMES[AlarmRuleEngine::VARIABLE_COUNT] = {
+    "nominal_output_power", "frequency", "temp", "real_output_power", "input_power",
+    "temperature", "current", "power", "voltage"
+};
+
+constexpr size_t FIRST_SENSOR = static_cast<size_t>(RuleVariable::Temperature);
+
+/**
+ * @brief Recursive descent parser emitting postfix bytecode
+ *
+ * Precedence from lowest: ||, &&, comparisons, + -, * /, unary.
+ */
+class ExpressionParser {
+public:
+    ExpressionParser(const std::string& text, std::vector<Instr>& code)
+        : text_(text), code_(code) {}
+
+    bool parse(std::string& error) {
+        size_t start = code_.size();
+        if (!parseOr() || !expectEnd()) {
+            code_.resize(start);
+            error = error_;
+            return false;
+        }
+        if (max_depth_ > static_cast<int>(AlarmRuleEngine::MAX_STACK)) {
+            code_.resize(start);
+            error = "expression too deep";
+            return false;
+        }
+        return true;
+    }
+
+    int firstSensor() const { return first_sensor_; }
+
+    // First literal of the expression after sign folding, e.g. 85 in "temperature >= 85"
+    double firstConstant() const {
+        return first_constant_ < code_.size() ? code_[first_constant_].constant : 0.0;
+    }
+
+private:
+    const std::string& text_;
+    std::vector<Instr>& code_;
+    size_t pos_ = 0;
+    int depth_ = 0;
+    int max_depth_ = 0;
+    int first_sensor_ = -1;
+    size_t first_constant_ = SIZE_MAX;
+    std::string error_;
+
+    void skipSpace() {
+        while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) pos_++;
+    }
+
+    bool accept(const char* token) {
+        skipSpace();
+        size_t len = std::char_traits<char>::length(token);
+        if (text_.compare(pos_, len, token) != 0) return false;
+        pos_ += len;
+        return true;
+    }
+
+    bool fail(const std::string& message) {
+        if (error_.empty()) {
+            error_ = message + " at position " + std::to_string(pos_);
+        }
+        return false;
+    }
+
+    bool expectEnd() {
+        skipSpace();
+        return pos_ == text_.size() || fail("unexpected '" + text_.substr(pos_, 1) + "'");
+    }
+
+    // Tracks the value stack depth the emitted code will reach
+    void emit(Op op, int stack_delta, uint8_t var = 0, double constant = 0.0) {
+        code_.push_back({op, var, constant});
+        depth_ += stack_delta;
+        max_depth_ = std::max(max_depth_, depth_);
+    }
+
+    bool parseOr() {
+        if (!parseAnd()) return false;
+        while (accept("||")) {
+            if (!parseAnd()) return false;
+            emit(Op::Or, -1);
+        }
+        return true;
+    }
+
+    bool parseAnd() {
+        if (!parseComparison()) return false;
+        while (accept("&&")) {
+            if (!parseComparison()) return false;
+            emit(Op::And, -1);
+        }
+        return true;
+    }
+
+    bool parseComparison() {
+        if (!parseAdditive()) return false;
+        for (;;) {
+            Op op;
+            if (accept("<=")) op = Op::Le;
+            else if (accept(">=")) op = Op::Ge;
+            else if (accept("==")) op = Op::Eq;
+            else if (accept("!=")) op = Op::Ne;
+            else if (accept("<")) op = Op::Lt;
+            else if (accept(">")) op = Op::Gt;
+            else return true;
+            if (!parseAdditive()) return false;
+            emit(op, -1);
+        }
+    }
+
+    bool parseAdditive() {
+        if (!parseMultiplicative()) return false;
+        for (;;) {
+            Op op;
+            if (accept("+")) op = Op::Add;
+            else if (accept("-")) op = Op::Sub;
+            else return true;
+            if (!parseMultiplicative()) return false;
+            emit(op, -1);
+        }
+    }
+
+    bool parseMultiplicative() {
+        if (!parseUnary()) return false;
+        for (;;) {
+            Op op;
+            if (accept("*")) op = Op::Mul;
+            else if (accept("/")) op = Op::Div;
+            else return true;
+            if (!parseUnary()) return false;
+            emit(op, -1);
+        }
+    }
+
+    bool parseUnary() {
+        skipSpace();
+        if (pos_ < text_.size() && text_[pos_] == '!' &&
+            (pos_ + 1 >= text_.size() || text_[pos_ + 1] != '=')) {
+            pos_++;
+            if (!parseUnary()) return false;
+            emit(Op::Not, 0);
+            return true;
+        }
+        if (accept("-")) {
+            if (!parseUnary()) return false;
+            // Fold negative literals so "temp < -20" is one constant
+            if (code_.back().op == Op::Const) {
+                code_.back().constant = -code_.back().constant;
+            } else {
+                emit(Op::Neg, 0);
+            }
+            return true;
+        }
+        return parsePrimary();
+    }
+
+    bool parseCall(Op op, size_t args) {
+        if (!accept("(")) return fail("expected '('");
+        for (size_t i = 0; i < args; ++i) {
+            if (i > 0 && !accept(",")) return fail("expected ','");
+            if (!parseOr()) return false;
+        }
+        if (!accept(")")) return fail("expected ')'");
+        emit(op, 1 - static_cast<int>(args));
+        return true;
+    }
+
+    bool parsePrimary() {
+        skipSpace();
+        if (pos_ >= text_.size()) return fail("unexpected end of expression");
+
+        if (accept("(")) {
+            if (!parseOr()) return false;
+            return accept(")") || fail("expected ')'");
+        }
+
+        char c = text_[pos_];
+        if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+            const char* begin = text_.c_str() + pos_;
+            char* end = nullptr;
+            double value = std::strtod(begin, &end);
+            if (end == begin) return fail("invalid number");
+            pos_ += end - begin;
+            if (first_constant_ == SIZE_MAX) first_constant_ = code_.size();
+            emit(Op::Const, 1, 0, value);
+            return true;
+        }
+
+        if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            size_t start = pos_;
+            while (pos_ < text_.size() &&
+                   (std::isalnum(static_cast<unsigned char>(text_[pos_])) || text_[pos_] == '_')) {
+                pos_++;
+            }
+            std::string name = text_.substr(start, pos_ - start);
+
+            if (name == "abs") return parseCall(Op::Abs, 1);
+            if (name == "min") return parseCall(Op::Min, 2);
+            if (name == "max") return parseCall(Op::Max, 2);
+
+            for (size_t i = 0; i < AlarmRuleEngine::VARIABLE_COUNT; ++i) {
+                if (name == VARIABLE_NAMES[i]) {
+                    if (first_sensor_ < 0 && i >= FIRST_SENSOR) {
+                        first_sensor_ = static_cast<int>(i - FIRST_SENSOR);
+                    }
+                    emit(Op::Load, 1, static_cast<uint8_t>(i));
+                    return true;
+                }
+            }
+            pos_ = start;
+            return fail("unknown variable '" + name + "'");
+        }
+
+        return fail(std::string("unexpected '") + c + "'");
+    }
+};
+
+/**
+ * @brief Runs one rule's bytecode on a fixed-size stack
+ */
+inline bool execute(const Instr* ip, const Instr* end, const double* values) {
+    double stack[AlarmRuleEngine::MAX_STACK];
+    size_t sp = 0;
+
+    for (; ip != end; ++ip) {
+        switch (ip->op) {
+            case Op::Const: stack[sp++] = ip->constant; break;
+            case Op::Load:  stack[sp++] = values[ip->var]; break;
+            case Op::Neg:   stack[sp - 1] = -stack[sp - 1]; break;
+            case Op::Not:   stack[sp - 1] = stack[sp - 1] == 0.0 ? 1.0 : 0.0; break;
+            case Op::Abs:   stack[sp - 1] = std::fabs(stack[sp - 1]); break;
+            default: {
+                double b = stack[--sp];
+                double& a = stack[sp - 1];
+                switch (ip->op) {
+                    case Op::Min: a = std::min(a, b); break;
+                    case Op::Max: a = std::max(a, b); break;
+                    case Op::Add: a = a + b; break;
+                    case Op::Sub: a = a - b; break;
+                    case Op::Mul: a = a * b; break;
+                    case Op::Div: a = b != 0.0 ? a / b : 0.0; break;
+                    case Op::Lt:  a = a < b; break;
+                    case Op::Le:  a = a <= b; break;
+                    case Op::Gt:  a = a > b; break;
+                    case Op::Ge:  a = a >= b; break;
+                    case Op::Eq:  a = a == b; break;
+                    case Op::Ne:  a = a != b; break;
+                    case Op::And: a = (a != 0.0) && (b != 0.0); break;
+                    case Op::Or:  a = (a != 0.0) || (b != 0.0); break;
+                    default: break;
+                }
+            }
+        }
+    }
+    return sp > 0 && stack[sp - 1] != 0.0;
+}
+
+} // namespace
+
+/**
+ * @brief AlarmRuleEngine constructor, starts with an empty rule set
+ */
+AlarmRuleEngine::AlarmRuleEngine() : active_(std::make_shared<CompiledRuleSet>()) {}
+
+const char* AlarmRuleEngine::variableName(RuleVariable variable) {
+    size_t index = static_cast<size_t>(variable);
+    return index < VARIABLE_COUNT ? VARIABLE_NAMES[index] : "";
+}
+
+std::shared_ptr<const CompiledRuleSet> AlarmRuleEngine::compile(const std::vector<AlarmRule>& rules,
+                                                                std::string& error) {
+    auto set = std::make_shared<CompiledRuleSet>();
+    std::map<std::string, int> groups;
+
+    for (const auto& rule : rules) {
+        if (rule.name.empty()) {
+            error = "rule without a name";
+            return nullptr;
+        }
+        for (const auto& other : set->rules) {
+            if (other.source.name == rule.name) {
+                error = "duplicate rule '" + rule.name + "'";
+                return nullptr;
+            }
+        }
+
+        CompiledRule compiled;
+        compiled.source = rule;
+        compiled.code_begin = static_cast<uint32_t>(set->code.size());
+
+        ExpressionParser parser(rule.expression, set->code);
+        std::string parse_error;
+        if (!parser.parse(parse_error)) {
+            error = rule.name + ": " + parse_error;
+            return nullptr;
+        }
+
+        compiled.code_end = static_cast<uint32_t>(set->code.size());
+        compiled.sensor = parser.firstSensor();
+        compiled.domain = compiled.sensor >= 0 ? RuleDomain::Monitor : RuleDomain::Radio;
+        if (compiled.source.message.empty()) {
+            compiled.source.message = rule.expression;
+        }
+        if (compiled.source.threshold == 0.0) {
+            compiled.source.threshold = parser.firstConstant();
+        }
+
+        compiled.group = -1;
+        if (!rule.group.empty()) {
+            auto it = groups.emplace(rule.group, static_cast<int>(groups.size())).first;
+            compiled.group = it->second;
+        }
+        set->rules.push_back(std::move(compiled));
+    }
+
+    set->group_count = groups.size();
+    return set;
+}
+
+bool AlarmRuleEngine::validate(const std::string& expression, std::string& error) {
+    std::vector<Instr> code;
+    ExpressionParser parser(expression, code);
+    return parser.parse(error);
+}
+
+bool AlarmRuleEngine::load(const std::vector<AlarmRule>& rules, std::string& error) {
+    auto set = compile(rules, error);
+    if (!set) return false;
+
+    std::lock_guard<std::mutex> lock(update_mutex_);
+    std::atomic_store(&active_, set);
+    return true;
+}
+
+bool AlarmRuleEngine::addRule(const AlarmRule& rule, std::string& error) {
+    std::lock_guard<std::mutex> lock(update_mutex_);
+    std::vector<AlarmRule> list = rules();
+
+    auto it = std::find_if(list.begin(), list.end(),
+                           [&](const AlarmRule& r) { return r.name == rule.name; });
+    if (it != list.end()) {
+        *it = rule;
+    } else {
+        list.push_back(rule);
+    }
+
+    auto set = compile(list, error);
+    if (!set) return false;
+    std::atomic_store(&active_, set);
+    return true;
+}
+
+bool AlarmRuleEngine::removeRule(const std::string& name) {
+    std::lock_guard<std::mutex> lock(update_mutex_);
+    std::vector<AlarmRule> list = rules();
+
+    auto it = std::find_if(list.begin(), list.end(),
+                           [&](const AlarmRule& r) { return r.name == name; });
+    if (it == list.end()) return false;
+    list.erase(it);
+
+    std::string error;
+    auto set = compile(list, error);
+    if (!set) return false;
+    std::atomic_store(&active_, set);
+    return true;
+}
+
+bool AlarmRuleEngine::replaceRules(const std::string& prefix, const std::vector<AlarmRule>& rules,
+                                   std::string& error) {
+    std::lock_guard<std::mutex> lock(update_mutex_);
+    std::vector<AlarmRule> list = rules;
+    for (auto& rule : this->rules()) {
+        if (rule.name.rfind(prefix, 0) != 0) {
+            list.push_back(std::move(rule));
+        }
+    }
+
+    auto set = compile(list, error);
+    if (!set) return false;
+    std::atomic_store(&active_, set);
+    return true;
+}
+
+std::vector<AlarmRule> AlarmRuleEngine::rules() const {
+    auto set = std::atomic_load(&active_);
+    std::vector<AlarmRule> list;
+    list.reserve(set->rules.size());
+    for (const auto& rule : set->rules) {
+        list.push_back(rule.source);
+    }
+    return list;
+}
+
+size_t AlarmRuleEngine::evaluate(RuleDomain domain, const double* values, uint32_t sensor_mask,
+                                 const std::function<void(const CompiledRule&)>& fired) const {
+    return evaluate(&domain, values, sensor_mask, fired);
+}
+
+size_t AlarmRuleEngine::evaluate(const double* values, uint32_t sensor_mask,
+                                 const std::function<void(const CompiledRule&)>& fired) const {
+    return evaluate(nullptr, values, sensor_mask, fired);
+}
+
+/**
+ * @brief Single pass over the compiled rules of a domain, or of all of them
+ *
+ * Within a group only the first rule that fires is reported, which is
+ * how the severity bands (critical, error, warning) are expressed.
+ */
+size_t AlarmRuleEngine::evaluate(const RuleDomain* domain, const double* values, uint32_t sensor_mask,
+                                 const std::function<void(const CompiledRule&)>& fired) const {
+    auto set = std::atomic_load(&active_);
+
+    // Reused per thread so the tick does not allocate
+    thread_local std::vector<char> group_fired;
+    group_fired.assign(set->group_count, 0);
+    const Instr* code = set->code.data();
+    size_t count = 0;
+
+    for (const auto& rule : set->rules) {
+        if (domain && rule.domain != *domain) continue;
+        if (rule.sensor >= 0 && !(sensor_mask & (1u << rule.sensor))) continue;
+        if (rule.group >= 0 && group_fired[rule.group]) continue;
+
+        if (execute(code + rule.code_begin, code + rule.code_end, values)) {
+            if (rule.group >= 0) group_fired[rule.group] = 1;
+            fired(rule);
+            count++;
+        }
+    }
+    return count;
+}
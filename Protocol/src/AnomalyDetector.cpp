@@ -0,0 +1,191 @@
+#include "../include/AnomalyDetector.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr double DEFAULT_Z_THRESHOLD = 3.0;
+constexpr double DEFAULT_MAD_THRESHOLD = 3.5;
+constexpr double REARM_RATIO = 0.8;
+constexpr double MAD_SCALE = 1.4826;  // MAD to standard deviation for normal data
+constexpr double MIN_SPREAD = 1e-9;
+
+} // namespace
+
+/**
+ * @brief AnomalyDetector constructor
+ */
+AnomalyDetector::AnomalyDetector() {}
+
+void AnomalyDetector::setMode(DetectorMode mode) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    mode_ = mode;
+    clearWindow();
+}
+
+DetectorMode AnomalyDetector::mode() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return mode_;
+}
+
+void AnomalyDetector::setThreshold(double threshold) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    threshold_ = threshold > 0.0 ? threshold : 0.0;
+}
+
+double AnomalyDetector::threshold() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return effectiveThreshold();
+}
+
+double AnomalyDetector::configuredThreshold() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return threshold_;
+}
+
+double AnomalyDetector::effectiveThreshold() const {
+    if (threshold_ > 0.0) return threshold_;
+    return mode_ == DetectorMode::Mad ? DEFAULT_MAD_THRESHOLD : DEFAULT_Z_THRESHOLD;
+}
+
+void AnomalyDetector::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    clearWindow();
+}
+
+void AnomalyDetector::clearWindow() {
+    head_ = 0;
+    size_ = 0;
+    evictions_ = 0;
+    sum_ = 0.0;
+    sum_sq_ = 0.0;
+    in_anomaly_ = false;
+    pending_trigger_ = false;
+}
+
+/**
+ * @brief Adds a value to the window, keeping running sums in O(1)
+ */
+void AnomalyDetector::push(double value) {
+    if (size_ == WINDOW) {
+        double old = window_[head_];
+        sum_ -= old;
+        sum_sq_ -= old * old;
+        window_[head_] = value;
+        head_ = (head_ + 1) % WINDOW;
+    } else {
+        window_[(head_ + size_) % WINDOW] = value;
+        size_++;
+    }
+    sum_ += value;
+    sum_sq_ += value * value;
+
+    // Running sums drift with subtraction; rebuild them once per window
+    if (size_ == WINDOW && ++evictions_ % WINDOW == 0) {
+        recomputeSums();
+    }
+}
+
+void AnomalyDetector::recomputeSums() {
+    sum_ = 0.0;
+    sum_sq_ = 0.0;
+    for (size_t i = 0; i < size_; ++i) {
+        double v = window_[(head_ + i) % WINDOW];
+        sum_ += v;
+        sum_sq_ += v * v;
+    }
+}
+
+void AnomalyDetector::scoreZ(double value, Result& result) const {
+    double n = static_cast<double>(size_);
+    double mean = sum_ / n;
+    double variance = std::max(0.0, (sum_sq_ - n * mean * mean) / (n - 1.0));
+    double sd = std::max(std::sqrt(variance), MIN_SPREAD);
+
+    result.baseline = mean;
+    result.score = (value - mean) / sd;
+    result.limit = mean + (result.score >= 0 ? 1.0 : -1.0) * effectiveThreshold() * sd;
+}
+
+void AnomalyDetector::scoreMad(double value, Result& result) const {
+    std::array<double, WINDOW> buf{};
+    for (size_t i = 0; i < size_; ++i) {
+        buf[i] = window_[(head_ + i) % WINDOW];
+    }
+
+    auto mid = buf.begin() + size_ / 2;
+    std::nth_element(buf.begin(), mid, buf.begin() + size_);
+    double median = *mid;
+
+    for (size_t i = 0; i < size_; ++i) {
+        buf[i] = std::fabs(buf[i] - median);
+    }
+    std::nth_element(buf.begin(), mid, buf.begin() + size_);
+    double spread = std::max(*mid * MAD_SCALE, MIN_SPREAD);
+
+    result.baseline = median;
+    result.score = (value - median) / spread;
+    result.limit = median + (result.score >= 0 ? 1.0 : -1.0) * effectiveThreshold() * spread;
+}
+
+/**
+ * @brief Scores the value, updates hysteresis state and adds it to the window
+ */
+AnomalyDetector::Result AnomalyDetector::update(double value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Result result;
+    result.value = value;
+    if (mode_ == DetectorMode::Static) {
+        return result;
+    }
+
+    if (size_ >= WARMUP) {
+        if (mode_ == DetectorMode::ZScore) {
+            scoreZ(value, result);
+        } else {
+            scoreMad(value, result);
+        }
+
+        double magnitude = std::fabs(result.score);
+        double threshold = effectiveThreshold();
+        if (!in_anomaly_ && magnitude > threshold) {
+            in_anomaly_ = true;
+            result.triggered = true;
+        } else if (in_anomaly_ && magnitude < threshold * REARM_RATIO) {
+            in_anomaly_ = false;
+        }
+        result.anomalous = in_anomaly_;
+
+        if (result.triggered) {
+            pending_trigger_ = true;
+            last_trigger_ = result;
+        }
+    }
+
+    push(value);
+    return result;
+}
+
+bool AnomalyDetector::takeTrigger(Result& result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!pending_trigger_) return false;
+    pending_trigger_ = false;
+    result = last_trigger_;
+    return true;
+}
+
+const char* AnomalyDetector::modeName(DetectorMode mode) {
+    switch (mode) {
+        case DetectorMode::Static: return "static";
+        case DetectorMode::ZScore: return "zscore";
+        case DetectorMode::Mad: return "mad";
+    }
+    return "static";
+}
+
+bool AnomalyDetector::parseMode(const std::string& name, DetectorMode& mode) {
+    if (name == "static") { mode = DetectorMode::Static; return true; }
+    if (name == "zscore") { mode = DetectorMode::ZScore; return true; }
+    if (name == "mad") { mode = DetectorMode::Mad; return true; }
+    return false;
+}
@@ -0,0 +1,222 @@
+#include "../include/MonitoringConfig.h"
+#include <fstream>
+
+namespace {
+
+using Thresholds = MonitoringConfig::Thresholds;
+
+struct ThresholdKey {
+    const char* name;
+    double Thresholds::* field;
+};
+
+const ThresholdKey THRESHOLD_KEYS[] = {
+    {"temperature_warning_min", &Thresholds::temp_warning_min},
+    {"temperature_warning_max", &Thresholds::temp_warning_max},
+    {"temperature_error_min", &Thresholds::temp_error_min},
+    {"temperature_error_max", &Thresholds::temp_error_max},
+    {"current_warning_min", &Thresholds::current_warning_min},
+    {"current_warning_max", &Thresholds::current_warning_max},
+    {"current_error_min", &Thresholds::current_error_min},
+    {"current_error_max", &Thresholds::current_error_max},
+    {"power_warning_min", &Thresholds::power_warning_min},
+    {"power_warning_max", &Thresholds::power_warning_max},
+    {"power_error_min", &Thresholds::power_error_min},
+    {"power_error_max", &Thresholds::power_error_max},
+};
+
+const char* const SENSORS[] = {"temperature", "current", "power", "voltage"};
+
+bool parseDouble(const std::string& text, double& value) {
+    try {
+        size_t used = 0;
+        value = std::stod(text, &used);
+        return used == text.size();
+    } catch (...) {
+        return false;
+    }
+}
+
+bool parseBool(const std::string& text, bool& value) {
+    if (text == "true" || text == "1" || text == "on") {
+        value = true;
+        return true;
+    }
+    if (text == "false" || text == "0" || text == "off") {
+        value = false;
+        return true;
+    }
+    return false;
+}
+
+std::string trim(const std::string& text) {
+    size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) return "";
+    size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+} // namespace
+
+MonitoringConfig::MonitoringConfig(const SystemData& data)
+    : polling_interval_ms(data.monitoring.polling_interval_ms),
+      thresholds(data.monitoring.thresholds),
+      temp_config(data.monitoring.temp_config),
+      current_config(data.monitoring.current_config),
+      power_config(data.monitoring.power_config),
+      voltage_config(data.monitoring.voltage_config) {}
+
+MonitoringConfig::SensorConfig* MonitoringConfig::sensorConfig(const std::string& sensor) {
+    if (sensor == "temperature") return &temp_config;
+    if (sensor == "current") return &current_config;
+    if (sensor == "power") return &power_config;
+    if (sensor == "voltage") return &voltage_config;
+    return nullptr;
+}
+
+bool MonitoringConfig::set(const std::string& key, const std::string& value, std::string& error) {
+    error.clear();
+
+    if (key == "polling_interval") {
+        double interval;
+        if (!parseDouble(value, interval) || interval != static_cast<int>(interval)) {
+            error = "polling_interval must be an integer";
+            return false;
+        }
+        polling_interval_ms = static_cast<int>(interval);
+        return true;
+    }
+
+    for (const auto& threshold : THRESHOLD_KEYS) {
+        if (key == threshold.name) {
+            if (!parseDouble(value, thresholds.*threshold.field)) {
+                error = key + " must be a number";
+                return false;
+            }
+            return true;
+        }
+    }
+
+    if (key.rfind("monitor_", 0) == 0) {
+        SensorConfig* config = sensorConfig(key.substr(8));
+        if (config) {
+            if (!parseBool(value, config->monitor)) {
+                error = key + " must be on or off";
+                return false;
+            }
+            return true;
+        }
+    }
+
+    for (const char* sensor : SENSORS) {
+        std::string prefix = std::string(sensor) + "_";
+        if (key.rfind(prefix, 0) != 0) continue;
+
+        SensorConfig* config = sensorConfig(sensor);
+        std::string field = key.substr(prefix.size());
+        if (field == "enabled") {
+            if (!parseBool(value, config->enabled)) {
+                error = key + " must be on or off";
+                return false;
+            }
+            return true;
+        }
+
+        double* target = field == "min" ? &config->min_value
+                       : field == "max" ? &config->max_value
+                       : field == "anomaly_probability" ? &config->anomaly_probability
+                       : field == "anomaly_scale" ? &config->anomaly_scale
+                       : nullptr;
+        if (target) {
+            if (!parseDouble(value, *target)) {
+                error = key + " must be a number";
+                return false;
+            }
+            return true;
+        }
+    }
+
+    error = "unknown key " + key;
+    return false;
+}
+
+bool MonitoringConfig::validate(std::string& error) const {
+    if (polling_interval_ms < 10 || polling_interval_ms > 3600000) {
+        error = "polling_interval must be within 10..3600000 ms";
+        return false;
+    }
+
+    const SensorConfig* configs[] = {&temp_config, &current_config, &power_config, &voltage_config};
+    for (size_t i = 0; i < 4; ++i) {
+        const SensorConfig& config = *configs[i];
+        if (!(config.min_value < config.max_value)) {
+            error = std::string(SENSORS[i]) + "_min must be below " + SENSORS[i] + "_max";
+            return false;
+        }
+        if (!(config.anomaly_probability >= 0.0 && config.anomaly_probability <= 1.0)) {
+            error = std::string(SENSORS[i]) + "_anomaly_probability must be within 0..1";
+            return false;
+        }
+        if (!(config.anomaly_scale > 0.0)) {
+            error = std::string(SENSORS[i]) + "_anomaly_scale must be positive";
+            return false;
+        }
+    }
+
+    // Bands must nest: error_min <= warning_min < warning_max <= error_max
+    for (size_t i = 0; i < 3; ++i) {
+        const ThresholdKey* keys = &THRESHOLD_KEYS[i * 4];
+        double warning_min = thresholds.*keys[0].field;
+        double warning_max = thresholds.*keys[1].field;
+        double error_min = thresholds.*keys[2].field;
+        double error_max = thresholds.*keys[3].field;
+        if (!(error_min <= warning_min && warning_min < warning_max && warning_max <= error_max)) {
+            error = std::string(SENSORS[i]) + " thresholds must satisfy error_min <= warning_min"
+                    " < warning_max <= error_max";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool MonitoringConfig::loadFile(const std::string& path, std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    std::string line;
+    for (int number = 1; std::getline(file, line); ++number) {
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        line = trim(line);
+        if (line.empty()) continue;
+
+        size_t equals = line.find('=');
+        if (equals == std::string::npos) {
+            error = path + ":" + std::to_string(number) + ": expected key = value";
+            return false;
+        }
+        std::string reason;
+        if (!set(trim(line.substr(0, equals)), trim(line.substr(equals + 1)), reason)) {
+            error = path + ":" + std::to_string(number) + ": " + reason;
+            return false;
+        }
+    }
+
+    return validate(error);
+}
+
+bool MonitoringConfig::apply(SystemData& data, std::string& error) const {
+    data.monitoring.polling_interval_ms = polling_interval_ms;
+    data.monitoring.thresholds = thresholds;
+    data.monitoring.temp_config = temp_config;
+    data.monitoring.current_config = current_config;
+    data.monitoring.power_config = power_config;
+    data.monitoring.voltage_config = voltage_config;
+    return data.rebuildThresholdRules(error);
+}
@@ -0,0 +1,223 @@
+#include "../include/SensorHistory.h"
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+/**
+ * @brief Accumulator used when re-aggregating tier data into query points
+ */
+struct PointAccumulator {
+    double min = std::numeric_limits<double>::max();
+    double max = std::numeric_limits<double>::lowest();
+    double sum = 0.0;
+    uint32_t count = 0;
+
+    void add(double bucket_min, double bucket_max, double bucket_sum, uint32_t bucket_count) {
+        min = std::min(min, bucket_min);
+        max = std::max(max, bucket_max);
+        sum += bucket_sum;
+        count += bucket_count;
+    }
+};
+
+int64_t alignDown(int64_t timestamp_ms, int64_t resolution_ms) {
+    int64_t rem = timestamp_ms % resolution_ms;
+    if (rem < 0) rem += resolution_ms;
+    return timestamp_ms - rem;
+}
+
+} // namespace
+
+/**
+ * @brief BucketRing constructor
+ */
+SensorHistory::BucketRing::BucketRing(int64_t resolution, size_t capacity)
+    : resolution_ms(resolution), items(capacity) {}
+
+/**
+ * @brief Adds a sample to the open bucket, closing it on boundary crossing
+ */
+void SensorHistory::BucketRing::add(int64_t timestamp_ms, double value) {
+    int64_t start = alignDown(timestamp_ms, resolution_ms);
+
+    if (has_open && open.start_ms != start) {
+        size_t tail = (head + size) % items.size();
+        items[tail] = open;
+        if (size < items.size()) {
+            size++;
+        } else {
+            head = (head + 1) % items.size();
+        }
+        has_open = false;
+    }
+
+    if (!has_open) {
+        open.start_ms = start;
+        open.min = value;
+        open.max = value;
+        open.sum = value;
+        open.count = 1;
+        has_open = true;
+        return;
+    }
+
+    open.min = std::min(open.min, value);
+    open.max = std::max(open.max, value);
+    open.sum += value;
+    open.count++;
+}
+
+/**
+ * @brief Start of the oldest retained bucket
+ */
+int64_t SensorHistory::BucketRing::oldest() const {
+    if (size > 0) return items[head].start_ms;
+    if (has_open) return open.start_ms;
+    return std::numeric_limits<int64_t>::max();
+}
+
+/**
+ * @brief SensorHistory constructor
+ */
+SensorHistory::SensorHistory()
+    : raw_(RAW_CAPACITY),
+      seconds_(1000, SECOND_CAPACITY),
+      minutes_(60 * 1000, MINUTE_CAPACITY),
+      hours_(60 * 60 * 1000, HOUR_CAPACITY) {}
+
+/**
+ * @brief Records a sample in the raw ring and all tiers
+ */
+void SensorHistory::record(int64_t timestamp_ms, double value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (total_samples_ > 0 && timestamp_ms < last_timestamp_ms_) {
+        timestamp_ms = last_timestamp_ms_;
+    }
+    last_timestamp_ms_ = timestamp_ms;
+
+    size_t tail = (raw_head_ + raw_size_) % raw_.size();
+    raw_[tail] = {timestamp_ms, value};
+    if (raw_size_ < raw_.size()) {
+        raw_size_++;
+    } else {
+        raw_head_ = (raw_head_ + 1) % raw_.size();
+    }
+
+    seconds_.add(timestamp_ms, value);
+    minutes_.add(timestamp_ms, value);
+    hours_.add(timestamp_ms, value);
+
+    total_samples_++;
+}
+
+const SensorHistory::BucketRing* SensorHistory::ringFor(Tier tier) const {
+    switch (tier) {
+        case Tier::Second: return &seconds_;
+        case Tier::Minute: return &minutes_;
+        case Tier::Hour: return &hours_;
+        default: return nullptr;
+    }
+}
+
+int64_t SensorHistory::oldestFor(Tier tier) const {
+    if (tier == Tier::Raw) {
+        return raw_size_ > 0 ? raw_[raw_head_].timestamp_ms : std::numeric_limits<int64_t>::max();
+    }
+    return ringFor(tier)->oldest();
+}
+
+/**
+ * @brief Selects the cheapest tier and aggregates it into step-wide points
+ */
+SensorHistory::Tier SensorHistory::query(int64_t from_ms, int64_t to_ms, int64_t step_ms,
+                                         std::vector<Point>& out) const {
+    out.clear();
+    if (step_ms <= 0 || to_ms < from_ms) {
+        return Tier::Raw;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Coarsest first: the first tier that fits the step and covers the
+    // range wins. Otherwise keep the eligible tier reaching furthest back.
+    static const Tier order[] = {Tier::Hour, Tier::Minute, Tier::Second, Tier::Raw};
+    Tier tier = Tier::Raw;
+    int64_t best_oldest = std::numeric_limits<int64_t>::max();
+
+    for (Tier candidate : order) {
+        const BucketRing* ring = ringFor(candidate);
+        if (ring && ring->resolution_ms > step_ms) {
+            continue;
+        }
+        int64_t oldest = oldestFor(candidate);
+        if (oldest <= from_ms) {
+            tier = candidate;
+            break;
+        }
+        if (oldest < best_oldest) {
+            best_oldest = oldest;
+            tier = candidate;
+        }
+    }
+
+    // Tier data is chronological, so points are emitted as soon as the
+    // next item falls into a later step.
+    PointAccumulator acc;
+    int64_t acc_index = -1;
+
+    auto flush = [&]() {
+        if (acc.count == 0) return;
+        out.push_back({from_ms + acc_index * step_ms, acc.min, acc.max, acc.sum / acc.count, acc.count});
+        acc = PointAccumulator();
+    };
+
+    // A bucket of the given length counts if it overlaps the range; one
+    // starting before from_ms goes into the first point
+    auto accumulate = [&](int64_t start, int64_t length, double mn, double mx, double sum, uint32_t count) {
+        if (start + length <= from_ms || start > to_ms) return;
+        int64_t index = start > from_ms ? (start - from_ms) / step_ms : 0;
+        if (index != acc_index) {
+            flush();
+            acc_index = index;
+        }
+        acc.add(mn, mx, sum, count);
+    };
+
+    if (tier == Tier::Raw) {
+        for (size_t i = 0; i < raw_size_; ++i) {
+            const Sample& s = raw_[(raw_head_ + i) % raw_.size()];
+            accumulate(s.timestamp_ms, 1, s.value, s.value, s.value, 1);
+        }
+    } else {
+        const BucketRing* ring = ringFor(tier);
+        for (size_t i = 0; i < ring->size; ++i) {
+            const Bucket& b = ring->items[(ring->head + i) % ring->items.size()];
+            accumulate(b.start_ms, ring->resolution_ms, b.min, b.max, b.sum, b.count);
+        }
+        if (ring->has_open) {
+            const Bucket& b = ring->open;
+            accumulate(b.start_ms, ring->resolution_ms, b.min, b.max, b.sum, b.count);
+        }
+    }
+
+    flush();
+
+    return tier;
+}
+
+uint64_t SensorHistory::totalSamples() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return total_samples_;
+}
+
+const char* SensorHistory::tierName(Tier tier) {
+    switch (tier) {
+        case Tier::Raw: return "raw";
+        case Tier::Second: return "1s";
+        case Tier::Minute: return "1m";
+        case Tier::Hour: return "1h";
+    }
+    return "raw";
+}
@@ -0,0 +1,194 @@
+#include "../include/SensorSource.h"
+#include "../include/SystemData.h"
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+const char TRACE_MAGIC[8] = {'R', 'S', 'T', 'R', 'A', 'C', 'E', '1'};
+
+bool endsWith(const std::string& str, const std::string& suffix) {
+    return str.size() >= suffix.size() &&
+           str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/**
+ * @brief Draws a simulated reading the way the original simulator did
+ */
+double simulateSensor(const SystemData::MonitoringData::SensorConfig& config, std::mt19937& gen) {
+    std::uniform_real_distribution<> uniform_dist(0.0, 1.0);
+    std::uniform_real_distribution<> value_dist(config.min_value, config.max_value);
+    double value = value_dist(gen);
+
+    if (uniform_dist(gen) < config.anomaly_probability) {
+        double span = (config.max_value - config.min_value) * config.anomaly_scale;
+        if (uniform_dist(gen) < 0.5) {
+            value = config.min_value - span;
+        } else {
+            value = config.max_value + span;
+        }
+    }
+
+    return value;
+}
+
+} // namespace
+
+// RandomSensorSource
+
+RandomSensorSource::RandomSensorSource(SystemData& data) : data_(data) {}
+
+bool RandomSensorSource::next(SensorSample& sample) {
+    auto& m = data_.monitoring;
+
+    sample.timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    sample.temperature = simulateSensor(m.temp_config, data_.gen);
+    sample.current = simulateSensor(m.current_config, data_.gen);
+    sample.power = simulateSensor(m.power_config, data_.gen);
+    sample.voltage = simulateSensor(m.voltage_config, data_.gen);
+    return true;
+}
+
+// TraceSensorSource
+
+TraceSensorSource::TraceSensorSource(const std::string& path, bool loop) : loop_(loop) {
+    file_ = std::fopen(path.c_str(), "rb");
+    if (!file_) return;
+
+    if (endsWith(path, ".csv")) {
+        csv_ = true;
+        return;
+    }
+
+    char magic[sizeof(TRACE_MAGIC)];
+    if (std::fread(magic, 1, sizeof(magic), file_) != sizeof(magic) ||
+        std::memcmp(magic, TRACE_MAGIC, sizeof(magic)) != 0) {
+        std::fclose(file_);
+        file_ = nullptr;
+        return;
+    }
+    data_offset_ = std::ftell(file_);
+}
+
+TraceSensorSource::~TraceSensorSource() {
+    if (file_) std::fclose(file_);
+}
+
+bool TraceSensorSource::readRecord(SensorSample& sample) {
+    if (!csv_) {
+        int64_t ts;
+        double values[4];
+        if (std::fread(&ts, sizeof(ts), 1, file_) != 1 ||
+            std::fread(values, sizeof(values), 1, file_) != 1) {
+            return false;
+        }
+        sample.timestamp_ms = ts;
+        sample.temperature = values[0];
+        sample.current = values[1];
+        sample.power = values[2];
+        sample.voltage = values[3];
+        return true;
+    }
+
+    char line[256];
+    while (std::fgets(line, sizeof(line), file_)) {
+        long long ts;
+        if (std::sscanf(line, "%lld,%lf,%lf,%lf,%lf", &ts, &sample.temperature,
+                        &sample.current, &sample.power, &sample.voltage) == 5) {
+            sample.timestamp_ms = ts;
+            return true;
+        }
+        // Header, comment or malformed line
+    }
+    return false;
+}
+
+bool TraceSensorSource::next(SensorSample& sample) {
+    if (!file_) return false;
+
+    if (!readRecord(sample)) {
+        if (!loop_ || !has_first_) return false;
+
+        std::fseek(file_, data_offset_, SEEK_SET);
+        loop_shift_ += last_ts_ - first_ts_ + 1;
+        has_first_ = false;
+        if (!readRecord(sample)) return false;
+    }
+
+    if (!has_first_) {
+        first_ts_ = sample.timestamp_ms;
+        has_first_ = true;
+    }
+    last_ts_ = sample.timestamp_ms;
+    sample.timestamp_ms += loop_shift_;
+    return true;
+}
+
+size_t TraceSensorSource::write(const std::string& path, SensorSource& source, size_t count) {
+    FILE* out = std::fopen(path.c_str(), "wb");
+    if (!out) return 0;
+
+    bool csv = endsWith(path, ".csv");
+    if (csv) {
+        std::fputs("timestamp_ms,temperature,current,power,voltage\n", out);
+    } else {
+        std::fwrite(TRACE_MAGIC, 1, sizeof(TRACE_MAGIC), out);
+    }
+
+    size_t written = 0;
+    SensorSample sample;
+    while (written < count && source.next(sample)) {
+        if (csv) {
+            std::fprintf(out, "%" PRId64 ",%.6f,%.6f,%.6f,%.6f\n", sample.timestamp_ms,
+                         sample.temperature, sample.current, sample.power, sample.voltage);
+        } else {
+            double values[4] = {sample.temperature, sample.current, sample.power, sample.voltage};
+            std::fwrite(&sample.timestamp_ms, sizeof(sample.timestamp_ms), 1, out);
+            std::fwrite(values, sizeof(values), 1, out);
+        }
+        written++;
+    }
+
+    std::fclose(out);
+    return written;
+}
+
+// SyntheticSensorSource
+
+SyntheticSensorSource::SyntheticSensorSource(size_t count, int64_t step_ms, uint32_t seed,
+                                             double spike_probability, int64_t start_ms)
+    : count_(count), step_ms_(step_ms), timestamp_ms_(start_ms),
+      spike_probability_(spike_probability), gen_(seed) {
+    if (timestamp_ms_ == 0) {
+        timestamp_ms_ = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+}
+
+bool SyntheticSensorSource::next(SensorSample& sample) {
+    if (count_ != 0 && produced_ >= count_) return false;
+
+    // One sine period per simulated hour
+    double phase = 2.0 * M_PI * static_cast<double>(produced_ * step_ms_ % 3600000) / 3600000.0;
+
+    auto wave = [&](double base, double amplitude, double sigma, double spike) {
+        double value = base + amplitude * std::sin(phase) + sigma * noise_(gen_);
+        if (uniform_(gen_) < spike_probability_) {
+            value += uniform_(gen_) < 0.5 ? -spike : spike;
+        }
+        return value;
+    };
+
+    sample.timestamp_ms = timestamp_ms_;
+    sample.temperature = wave(45.0, 10.0, 0.5, 60.0);
+    sample.current = wave(5.0, 1.0, 0.1, 6.0);
+    sample.power = wave(50.0, 15.0, 1.0, 60.0);
+    sample.voltage = wave(220.0, 5.0, 0.5, 40.0);
+
+    timestamp_ms_ += step_ms_;
+    produced_++;
+    return true;
+}
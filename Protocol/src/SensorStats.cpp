@@ -0,0 +1,170 @@
+#include "../include/SensorStats.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+/**
+ * @brief KllSketch constructor
+ */
+KllSketch::KllSketch(uint16_t k) : k_(std::max<uint16_t>(k, 8)) {
+    levels_.emplace_back();
+    levels_.back().reserve(k_);
+}
+
+/**
+ * @brief Capacity of a level, shrinking by 2/3 below the top level
+ */
+size_t KllSketch::capacity(size_t level) const {
+    size_t depth = levels_.size() - level - 1;
+    double cap = k_ * std::pow(2.0 / 3.0, static_cast<double>(depth));
+    return std::max<size_t>(2, static_cast<size_t>(std::ceil(cap)));
+}
+
+bool KllSketch::coinFlip() {
+    // xorshift64, enough randomness for the compaction offset
+    rng_state_ ^= rng_state_ << 13;
+    rng_state_ ^= rng_state_ >> 7;
+    rng_state_ ^= rng_state_ << 17;
+    return rng_state_ & 1;
+}
+
+void KllSketch::update(double value) {
+    levels_[0].push_back(value);
+    n_++;
+    if (levels_[0].size() >= capacity(0)) {
+        compress();
+    }
+}
+
+/**
+ * @brief Compacts every level that is over capacity, bottom up
+ */
+void KllSketch::compress() {
+    for (size_t level = 0; level < levels_.size(); ++level) {
+        if (levels_[level].size() < capacity(level)) {
+            continue;
+        }
+
+        if (level + 1 == levels_.size()) {
+            levels_.emplace_back();
+        }
+
+        std::vector<double>& items = levels_[level];
+        std::sort(items.begin(), items.end());
+
+        // An odd item stays behind so the total weight is preserved
+        size_t leftover = items.size() % 2;
+        size_t offset = coinFlip() ? 1 : 0;
+        std::vector<double>& next = levels_[level + 1];
+        for (size_t i = leftover + offset; i < items.size(); i += 2) {
+            next.push_back(items[i]);
+        }
+
+        if (leftover) {
+            double kept = items[0];
+            items.clear();
+            items.push_back(kept);
+        } else {
+            items.clear();
+        }
+    }
+}
+
+double KllSketch::quantile(double q) const {
+    if (n_ == 0) return 0.0;
+    q = std::min(1.0, std::max(0.0, q));
+
+    std::vector<std::pair<double, uint64_t>> weighted;
+    weighted.reserve(retained());
+    for (size_t level = 0; level < levels_.size(); ++level) {
+        for (double value : levels_[level]) {
+            weighted.emplace_back(value, 1ULL << level);
+        }
+    }
+    std::sort(weighted.begin(), weighted.end());
+
+    uint64_t total = 0;
+    for (const auto& item : weighted) total += item.second;
+
+    double target = q * static_cast<double>(total);
+    uint64_t cumulative = 0;
+    for (const auto& item : weighted) {
+        cumulative += item.second;
+        if (static_cast<double>(cumulative) >= target) {
+            return item.first;
+        }
+    }
+    return weighted.back().first;
+}
+
+size_t KllSketch::retained() const {
+    size_t total = 0;
+    for (const auto& level : levels_) total += level.size();
+    return total;
+}
+
+void KllSketch::clear() {
+    levels_.clear();
+    levels_.emplace_back();
+    levels_.back().reserve(k_);
+    n_ = 0;
+}
+
+/**
+ * @brief SensorStats constructor
+ */
+SensorStats::SensorStats(double ewma_alpha) : alpha_(ewma_alpha) {}
+
+/**
+ * @brief Adds a sample: EWMA, Welford and sketch update
+ */
+void SensorStats::update(double value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    count_++;
+    if (count_ == 1) {
+        ewma_ = value;
+        min_ = value;
+        max_ = value;
+    } else {
+        ewma_ += alpha_ * (value - ewma_);
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+    }
+
+    double delta = value - mean_;
+    mean_ += delta / static_cast<double>(count_);
+    m2_ += delta * (value - mean_);
+
+    sketch_.update(value);
+}
+
+SensorStats::Snapshot SensorStats::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    Snapshot s;
+    s.count = count_;
+    if (count_ == 0) return s;
+
+    s.ewma = ewma_;
+    s.mean = mean_;
+    s.variance = count_ > 1 ? m2_ / static_cast<double>(count_ - 1) : 0.0;
+    s.stddev = std::sqrt(s.variance);
+    s.min = min_;
+    s.max = max_;
+    s.p50 = sketch_.quantile(0.50);
+    s.p95 = sketch_.quantile(0.95);
+    s.p99 = sketch_.quantile(0.99);
+    return s;
+}
+
+void SensorStats::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    count_ = 0;
+    ewma_ = 0.0;
+    mean_ = 0.0;
+    m2_ = 0.0;
+    min_ = 0.0;
+    max_ = 0.0;
+    sketch_.clear();
+}
@@ -11,6 +11,12 @@ SET::SET(SystemData& system_data) : System(system_data) {}
 bool SET::execute(const std::string& parameter, const std::string& value) {
     bool result = false;
     
+    // Restored if the change cannot be journaled
+    double nominal_output_power = data.nominal_output_power;
+    double frequency = data.frequency;
+    bool automatic_modulation = data.automatic_modulation;
+    bool modulation = data.modulation;
+    
     if (parameter == "nominal_output_power") {
         result = setNominalPower(value);
     }
@@ -26,6 +32,13 @@ bool SET::execute(const std::string& parameter, const std::string& value) {
     
     if (result) {
         updateSimulation();
+        if (data.wal && !data.wal->appendDurable(WriteAheadLog::RecordType::Set, parameter, value)) {
+            data.nominal_output_power = nominal_output_power;
+            data.frequency = frequency;
+            data.automatic_modulation = automatic_modulation;
+            data.modulation = modulation;
+            result = false;
+        }
     }
     
     return result;
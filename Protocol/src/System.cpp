@@ -71,8 +71,11 @@ void System::updateSimulation() {
 /**
  * @brief Calls alarm callback
  */
-void System::triggerAlarm(const std::string& message) {
+void System::triggerAlarm(const std::string& message, const std::string& severity) {
     if (alarm_callback_) {
         alarm_callback_(message);
     }
+    if (data.alarm_bus) {
+        data.alarm_bus->publish(AlarmEvent::Source::Radio, "radio", severity, message);
+    }
 }
\ No newline at end of file
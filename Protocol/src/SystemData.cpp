@@ -1,8 +1,10 @@
 #include "../include/SystemData.h"
+#include "../include/Probes.h"
 #include <sstream>
 #include <iomanip>
 #include <ctime>
 #include <algorithm>
+#include <limits>
 
 /**
  * @brief SystemData constructor
@@ -12,89 +14,101 @@
 SystemData::SystemData() : gen(rd()) {
     std::uniform_int_distribution<> dis(0, 1);
     modulation = dis(gen);
+    sensor_source = std::make_unique<RandomSensorSource>(*this);
+    std::string error;
+    rebuildThresholdRules(error);  // the default thresholds always compile
 }
 
-void SystemData::updateMonitoringSensors() {
-    std::uniform_real_distribution<> uniform_dist(0.0, 1.0);
+SystemData::~SystemData() = default;
+
+void SystemData::setSensorSource(std::unique_ptr<SensorSource> source) {
+    if (!source) {
+        source = std::make_unique<RandomSensorSource>(*this);
+    }
+    sensor_source = std::move(source);
+}
+
+bool SystemData::updateMonitoringSensors() {
+    SensorSample sample;
+    if (!sensor_source->next(sample)) {
+        return false;
+    }
+    
+    monitoring.last_update = std::chrono::system_clock::time_point(
+        std::chrono::milliseconds(sample.timestamp_ms));
+    monitoring.total_sensor_updates++;
+    
+    // Apply readings and feed history, statistics and detector windows
+    int64_t now_ms = sample.timestamp_ms;
     
-    // Update temperature
     if (monitoring.temp_config.enabled && monitoring.temp_config.monitor) {
-        std::uniform_real_distribution<> temp_dist(monitoring.temp_config.min_value, 
-                                                   monitoring.temp_config.max_value);
-        monitoring.temperature = temp_dist(gen);
-        
-        if (uniform_dist(gen) < monitoring.temp_config.anomaly_probability) {
-            if (uniform_dist(gen) < 0.5) {
-                monitoring.temperature = monitoring.temp_config.min_value - 
-                    (monitoring.temp_config.max_value - monitoring.temp_config.min_value) * 
-                    monitoring.temp_config.anomaly_scale;
-            } else {
-                monitoring.temperature = monitoring.temp_config.max_value + 
-                    (monitoring.temp_config.max_value - monitoring.temp_config.min_value) * 
-                    monitoring.temp_config.anomaly_scale;
-            }
-        }
+        monitoring.temperature = sample.temperature;
+        monitoring.temp_history.record(now_ms, monitoring.temperature);
+        monitoring.temp_stats.update(monitoring.temperature);
+        monitoring.temp_detector.update(monitoring.temperature);
     }
-    
-    // Update current
     if (monitoring.current_config.enabled && monitoring.current_config.monitor) {
-        std::uniform_real_distribution<> current_dist(monitoring.current_config.min_value, 
-                                                      monitoring.current_config.max_value);
-        monitoring.current = current_dist(gen);
-        
-        if (uniform_dist(gen) < monitoring.current_config.anomaly_probability) {
-            if (uniform_dist(gen) < 0.5) {
-                monitoring.current = monitoring.current_config.min_value - 
-                    (monitoring.current_config.max_value - monitoring.current_config.min_value) * 
-                    monitoring.current_config.anomaly_scale;
-            } else {
-                monitoring.current = monitoring.current_config.max_value + 
-                    (monitoring.current_config.max_value - monitoring.current_config.min_value) * 
-                    monitoring.current_config.anomaly_scale;
-            }
-        }
+        monitoring.current = sample.current;
+        monitoring.current_history.record(now_ms, monitoring.current);
+        monitoring.current_stats.update(monitoring.current);
+        monitoring.current_detector.update(monitoring.current);
     }
-    
-    // Update power
     if (monitoring.power_config.enabled && monitoring.power_config.monitor) {
-        std::uniform_real_distribution<> power_dist(monitoring.power_config.min_value, 
-                                                    monitoring.power_config.max_value);
-        monitoring.power = power_dist(gen);
-        
-        if (uniform_dist(gen) < monitoring.power_config.anomaly_probability) {
-            if (uniform_dist(gen) < 0.5) {
-                monitoring.power = monitoring.power_config.min_value - 
-                    (monitoring.power_config.max_value - monitoring.power_config.min_value) * 
-                    monitoring.power_config.anomaly_scale;
-            } else {
-                monitoring.power = monitoring.power_config.max_value + 
-                    (monitoring.power_config.max_value - monitoring.power_config.min_value) * 
-                    monitoring.power_config.anomaly_scale;
-            }
-        }
+        monitoring.power = sample.power;
+        monitoring.power_history.record(now_ms, monitoring.power);
+        monitoring.power_stats.update(monitoring.power);
+        monitoring.power_detector.update(monitoring.power);
     }
-    
-    // Update voltage
     if (monitoring.voltage_config.enabled && monitoring.voltage_config.monitor) {
-        std::uniform_real_distribution<> voltage_dist(monitoring.voltage_config.min_value, 
-                                                      monitoring.voltage_config.max_value);
-        monitoring.voltage = voltage_dist(gen);
-        
-        if (uniform_dist(gen) < monitoring.voltage_config.anomaly_probability) {
-            if (uniform_dist(gen) < 0.5) {
-                monitoring.voltage = monitoring.voltage_config.min_value - 
-                    (monitoring.voltage_config.max_value - monitoring.voltage_config.min_value) * 
-                    monitoring.voltage_config.anomaly_scale;
-            } else {
-                monitoring.voltage = monitoring.voltage_config.max_value + 
-                    (monitoring.voltage_config.max_value - monitoring.voltage_config.min_value) * 
-                    monitoring.voltage_config.anomaly_scale;
-            }
-        }
+        monitoring.voltage = sample.voltage;
+        monitoring.voltage_history.record(now_ms, monitoring.voltage);
+        monitoring.voltage_stats.update(monitoring.voltage);
+        monitoring.voltage_detector.update(monitoring.voltage);
     }
     
-    monitoring.last_update = std::chrono::system_clock::now();
-    monitoring.total_sensor_updates++;
+    RADIO_PROBE4(sensor__update,
+                 RADIO_PROBE_MILLI(monitoring.temperature), RADIO_PROBE_MILLI(monitoring.current),
+                 RADIO_PROBE_MILLI(monitoring.power), RADIO_PROBE_MILLI(monitoring.voltage));
+    return true;
+}
+
+void SystemData::MonitoringData::LoopTelemetry::record(int64_t jitter, int64_t sample, int64_t archive,
+                                                      int64_t evaluate, int64_t publish, int64_t interval) {
+    int64_t tick = sample + archive + evaluate + publish;
+    
+    sample_ns.store(sample, std::memory_order_relaxed);
+    archive_ns.store(archive, std::memory_order_relaxed);
+    evaluate_ns.store(evaluate, std::memory_order_relaxed);
+    publish_ns.store(publish, std::memory_order_relaxed);
+    tick_ns.store(tick, std::memory_order_relaxed);
+    jitter_ns.store(jitter, std::memory_order_relaxed);
+    jitter_sum_ns.fetch_add(jitter, std::memory_order_relaxed);
+    
+    // Single writer, so plain load/store is enough for the maxima
+    if (tick > max_tick_ns.load(std::memory_order_relaxed)) {
+        max_tick_ns.store(tick, std::memory_order_relaxed);
+    }
+    if (jitter > max_jitter_ns.load(std::memory_order_relaxed)) {
+        max_jitter_ns.store(jitter, std::memory_order_relaxed);
+    }
+    if (tick > interval) {
+        overruns.fetch_add(1, std::memory_order_relaxed);
+    }
+    ticks.fetch_add(1, std::memory_order_release);
+}
+
+int64_t SystemData::MonitoringData::LoopTelemetry::averageJitter() const {
+    uint64_t n = ticks.load(std::memory_order_acquire);
+    return n ? jitter_sum_ns.load(std::memory_order_relaxed) / static_cast<int64_t>(n) : 0;
+}
+
+void SystemData::MonitoringData::LoopTelemetry::reset() {
+    for (auto* value : {&sample_ns, &archive_ns, &evaluate_ns, &publish_ns, &tick_ns,
+                        &max_tick_ns, &jitter_ns, &max_jitter_ns, &jitter_sum_ns}) {
+        value->store(0, std::memory_order_relaxed);
+    }
+    overruns.store(0, std::memory_order_relaxed);
+    ticks.store(0, std::memory_order_release);
 }
 
 std::string SystemData::addAlarm(const std::string& sensor, const std::string& message, 
@@ -114,6 +128,12 @@ std::string SystemData::addAlarm(const std::string& sensor, const std::string& m
     
     monitoring.active_alarms.push_back(alarm);
     monitoring.total_alarms_triggered++;
+    RADIO_PROBE4(alarm__add, alarm.id.c_str(), sensor.c_str(), severity.c_str(), message.c_str());
+    
+    if (alarm_bus) {
+        alarm_bus->publish(AlarmEvent::Source::Monitor, sensor, severity, message,
+                           value, threshold, alarm.id);
+    }
     
     return alarm.id;
 }
@@ -129,10 +149,12 @@ bool SystemData::acknowledgeAlarm(const std::string& alarm_id) {
     for (auto& alarm : monitoring.active_alarms) {
         if (alarm.id == alarm_id) {
             alarm.acknowledged = true;
+            RADIO_PROBE2(alarm__ack, alarm_id.c_str(), 1);
             return true;
         }
     }
     
+    RADIO_PROBE2(alarm__ack, alarm_id.c_str(), 0);
     return false;
 }
 
@@ -152,57 +174,124 @@ void SystemData::clearAllAlarms() {
     monitoring.active_alarms.clear();
 }
 
-void SystemData::checkMonitoringThresholds() {
-    // Check temperature thresholds
-    if (monitoring.temp_config.monitor) {
-        if (monitoring.temperature <= monitoring.thresholds.temp_error_min) {
-            addAlarm("temperature", "Temperature below error threshold", 
-                    "ERROR", monitoring.temperature, monitoring.thresholds.temp_error_min);
-        } else if (monitoring.temperature >= monitoring.thresholds.temp_error_max) {
-            addAlarm("temperature", "Temperature above error threshold", 
-                    "ERROR", monitoring.temperature, monitoring.thresholds.temp_error_max);
-        } else if (monitoring.temperature <= monitoring.thresholds.temp_warning_min) {
-            addAlarm("temperature", "Temperature below warning threshold", 
-                    "WARNING", monitoring.temperature, monitoring.thresholds.temp_warning_min);
-        } else if (monitoring.temperature >= monitoring.thresholds.temp_warning_max) {
-            addAlarm("temperature", "Temperature above warning threshold", 
-                    "WARNING", monitoring.temperature, monitoring.thresholds.temp_warning_max);
+void SystemData::checkMonitoringThresholds(bool radio_rules) {
+    // Threshold rules apply to monitored sensors in static detector mode
+    const AnomalyDetector* detectors[] = {
+        &monitoring.temp_detector, &monitoring.current_detector,
+        &monitoring.power_detector, &monitoring.voltage_detector
+    };
+    const MonitoringData::SensorConfig* configs[] = {
+        &monitoring.temp_config, &monitoring.current_config,
+        &monitoring.power_config, &monitoring.voltage_config
+    };
+    static const char* const sensors[] = {"temperature", "current", "power", "voltage"};
+    
+    uint32_t mask = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (configs[i]->monitor && detectors[i]->mode() == DetectorMode::Static) {
+            mask |= 1u << i;
         }
     }
     
-    // Check current thresholds
-    if (monitoring.current_config.monitor) {
-        if (monitoring.current <= monitoring.thresholds.current_error_min) {
-            addAlarm("current", "Current below error threshold", 
-                    "ERROR", monitoring.current, monitoring.thresholds.current_error_min);
-        } else if (monitoring.current >= monitoring.thresholds.current_error_max) {
-            addAlarm("current", "Current above error threshold", 
-                    "ERROR", monitoring.current, monitoring.thresholds.current_error_max);
-        } else if (monitoring.current <= monitoring.thresholds.current_warning_min) {
-            addAlarm("current", "Current below warning threshold", 
-                    "WARNING", monitoring.current, monitoring.thresholds.current_warning_min);
-        } else if (monitoring.current >= monitoring.thresholds.current_warning_max) {
-            addAlarm("current", "Current above warning threshold", 
-                    "WARNING", monitoring.current, monitoring.thresholds.current_warning_max);
+    double values[AlarmRuleEngine::VARIABLE_COUNT];
+    ruleValues(values);
+    auto fired = [&](const CompiledRule& rule) {
+        if (rule.domain == RuleDomain::Radio) {
+            if (alarm_bus) {
+                alarm_bus->publish(AlarmEvent::Source::Radio, "radio",
+                                   rule.source.severity, rule.source.message);
+            }
+            return;
         }
+        RADIO_PROBE4(threshold__breach, sensors[rule.sensor], rule.source.name.c_str(),
+                     RADIO_PROBE_MILLI(values[static_cast<size_t>(RuleVariable::Temperature) + rule.sensor]),
+                     RADIO_PROBE_MILLI(rule.source.threshold));
+        addAlarm(sensors[rule.sensor], rule.source.message, rule.source.severity,
+                 values[static_cast<size_t>(RuleVariable::Temperature) + rule.sensor],
+                 rule.source.threshold);
+    };
+    if (radio_rules) {
+        alarm_rules.evaluate(values, mask, fired);
+    } else {
+        alarm_rules.evaluate(RuleDomain::Monitor, values, mask, fired);
     }
     
-    // Check power thresholds
+    // Check statistical detectors
+    if (monitoring.temp_config.monitor) {
+        checkSensorDetector("temperature", "Temperature", monitoring.temp_detector);
+    }
+    if (monitoring.current_config.monitor) {
+        checkSensorDetector("current", "Current", monitoring.current_detector);
+    }
     if (monitoring.power_config.monitor) {
-        if (monitoring.power <= monitoring.thresholds.power_error_min) {
-            addAlarm("power", "Power below error threshold", 
-                    "ERROR", monitoring.power, monitoring.thresholds.power_error_min);
-        } else if (monitoring.power >= monitoring.thresholds.power_error_max) {
-            addAlarm("power", "Power above error threshold", 
-                    "ERROR", monitoring.power, monitoring.thresholds.power_error_max);
-        } else if (monitoring.power <= monitoring.thresholds.power_warning_min) {
-            addAlarm("power", "Power below warning threshold", 
-                    "WARNING", monitoring.power, monitoring.thresholds.power_warning_min);
-        } else if (monitoring.power >= monitoring.thresholds.power_warning_max) {
-            addAlarm("power", "Power above warning threshold", 
-                    "WARNING", monitoring.power, monitoring.thresholds.power_warning_max);
-        }
+        checkSensorDetector("power", "Power", monitoring.power_detector);
+    }
+    if (monitoring.voltage_config.monitor) {
+        checkSensorDetector("voltage", "Voltage", monitoring.voltage_detector);
+    }
+}
+
+bool SystemData::rebuildThresholdRules(std::string& error) {
+    const auto& t = monitoring.thresholds;
+    
+    // Same order as the severity bands: errors before warnings, one alarm per sensor
+    auto bands = [](std::vector<AlarmRule>& rules, const std::string& sensor,
+                    const std::string& label, double error_min, double error_max,
+                    double warning_min, double warning_max) {
+        auto rule = [&](const char* suffix, const char* op, double limit,
+                        const char* severity, const char* message) {
+            std::ostringstream expression;
+            expression << std::setprecision(std::numeric_limits<double>::max_digits10)
+                       << sensor << " " << op << " " << limit;
+            rules.push_back({"threshold_" + sensor + "_" + suffix, severity, expression.str(),
+                             label + message, "threshold_" + sensor, limit});
+        };
+        rule("error_min", "<=", error_min, "ERROR", " below error threshold");
+        rule("error_max", ">=", error_max, "ERROR", " above error threshold");
+        rule("warning_min", "<=", warning_min, "WARNING", " below warning threshold");
+        rule("warning_max", ">=", warning_max, "WARNING", " above warning threshold");
+    };
+    
+    std::vector<AlarmRule> rules;
+    bands(rules, "temperature", "Temperature", t.temp_error_min, t.temp_error_max,
+          t.temp_warning_min, t.temp_warning_max);
+    bands(rules, "current", "Current", t.current_error_min, t.current_error_max,
+          t.current_warning_min, t.current_warning_max);
+    bands(rules, "power", "Power", t.power_error_min, t.power_error_max,
+          t.power_warning_min, t.power_warning_max);
+    
+    if (!alarm_rules.replaceRules("threshold_", rules, error)) {
+        error = "threshold rules: " + error;
+        return false;
     }
+    return true;
+}
+
+void SystemData::ruleValues(double* values) const {
+    values[static_cast<size_t>(RuleVariable::NominalOutputPower)] = nominal_output_power;
+    values[static_cast<size_t>(RuleVariable::Frequency)] = frequency;
+    values[static_cast<size_t>(RuleVariable::Temp)] = temp;
+    values[static_cast<size_t>(RuleVariable::RealOutputPower)] = real_output_power;
+    values[static_cast<size_t>(RuleVariable::InputPower)] = input_power;
+    values[static_cast<size_t>(RuleVariable::Temperature)] = monitoring.temperature;
+    values[static_cast<size_t>(RuleVariable::Current)] = monitoring.current;
+    values[static_cast<size_t>(RuleVariable::Power)] = monitoring.power;
+    values[static_cast<size_t>(RuleVariable::Voltage)] = monitoring.voltage;
+}
+
+void SystemData::checkSensorDetector(const std::string& sensor, const std::string& label,
+                                     AnomalyDetector& detector) {
+    AnomalyDetector::Result result;
+    if (!detector.takeTrigger(result)) {
+        return;
+    }
+    
+    std::ostringstream message;
+    message << std::fixed << std::setprecision(1)
+            << label << " anomaly (" << AnomalyDetector::modeName(detector.mode())
+            << " score " << result.score << ", baseline " << result.baseline << ")";
+    
+    addAlarm(sensor, message.str(), "WARNING", result.value, result.limit);
 }
 
 SystemData::MonitoringData::SensorConfig* SystemData::getSensorConfig(const std::string& sensor_name) {
@@ -211,4 +300,28 @@ SystemData::MonitoringData::SensorConfig* SystemData::getSensorConfig(const std:
     if (sensor_name == "power") return &monitoring.power_config;
     if (sensor_name == "voltage") return &monitoring.voltage_config;
     return nullptr;
+}
+
+SensorHistory* SystemData::getSensorHistory(const std::string& sensor_name) {
+    if (sensor_name == "temperature") return &monitoring.temp_history;
+    if (sensor_name == "current") return &monitoring.current_history;
+    if (sensor_name == "power") return &monitoring.power_history;
+    if (sensor_name == "voltage") return &monitoring.voltage_history;
+    return nullptr;
+}
+
+SensorStats* SystemData::getSensorStats(const std::string& sensor_name) {
+    if (sensor_name == "temperature") return &monitoring.temp_stats;
+    if (sensor_name == "current") return &monitoring.current_stats;
+    if (sensor_name == "power") return &monitoring.power_stats;
+    if (sensor_name == "voltage") return &monitoring.voltage_stats;
+    return nullptr;
+}
+
+AnomalyDetector* SystemData::getSensorDetector(const std::string& sensor_name) {
+    if (sensor_name == "temperature") return &monitoring.temp_detector;
+    if (sensor_name == "current") return &monitoring.current_detector;
+    if (sensor_name == "power") return &monitoring.power_detector;
+    if (sensor_name == "voltage") return &monitoring.voltage_detector;
+    return nullptr;
 }
\ No newline at end of file
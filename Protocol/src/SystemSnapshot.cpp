@@ -0,0 +1,322 @@
+#include "../include/SystemSnapshot.h"
+#include "../include/SystemData.h"
+#include "../include/Crc32.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+using Thresholds = SystemData::MonitoringData::Thresholds;
+using SensorConfig = SystemData::MonitoringData::SensorConfig;
+
+struct SnapshotHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t payload_size;
+    uint32_t payload_crc;
+    int64_t written_ms;
+    uint32_t alarm_count;
+    uint32_t reserved;
+};
+
+struct SnapshotSensor {
+    double min_value;
+    double max_value;
+    double anomaly_probability;
+    double anomaly_scale;
+    double detector_threshold;   ///< 0 = mode default
+    uint8_t enabled;
+    uint8_t monitor;
+    uint8_t detector_mode;
+    uint8_t reserved[5];
+};
+
+struct SnapshotState {
+    double nominal_output_power;
+    double frequency;
+    double thresholds[12];
+    SnapshotSensor sensors[4];
+    int32_t polling_interval_ms;
+    int32_t total_sensor_updates;
+    int32_t total_alarms_triggered;
+    int32_t alarm_id_counter;
+    uint8_t automatic_modulation;
+    uint8_t modulation;
+    uint8_t service_enabled;
+    uint8_t reserved[5];
+};
+
+struct SnapshotAlarm {
+    char id[16];
+    char sensor[16];
+    char severity[12];
+    uint8_t acknowledged;
+    uint8_t active;
+    uint8_t reserved[2];
+    char message[160];
+    double value;
+    double threshold;
+    int64_t timestamp_ms;
+};
+
+// The file layout must not depend on the compiler's padding choices
+static_assert(sizeof(SnapshotHeader) == 32, "snapshot header layout changed");
+static_assert(sizeof(SnapshotSensor) == 48, "snapshot sensor layout changed");
+static_assert(sizeof(SnapshotState) == 328, "snapshot state layout changed");
+static_assert(sizeof(SnapshotAlarm) == 232, "snapshot alarm layout changed");
+
+// Thresholds in file order
+constexpr double Thresholds::* THRESHOLD_FIELDS[] = {
+    &Thresholds::temp_warning_min, &Thresholds::temp_warning_max,
+    &Thresholds::temp_error_min, &Thresholds::temp_error_max,
+    &Thresholds::current_warning_min, &Thresholds::current_warning_max,
+    &Thresholds::current_error_min, &Thresholds::current_error_max,
+    &Thresholds::power_warning_min, &Thresholds::power_warning_max,
+    &Thresholds::power_error_min, &Thresholds::power_error_max,
+};
+static_assert(sizeof(THRESHOLD_FIELDS) / sizeof(THRESHOLD_FIELDS[0]) == 12,
+              "threshold count must match SnapshotState::thresholds");
+
+template <size_t N>
+void copyField(char (&dest)[N], const std::string& src) {
+    size_t len = std::min(src.size(), N - 1);
+    std::memcpy(dest, src.data(), len);
+    dest[len] = '\0';
+}
+
+template <size_t N>
+std::string readField(const char (&src)[N]) {
+    return std::string(src, strnlen(src, N));
+}
+
+int64_t toMillis(std::chrono::system_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+}
+
+bool writeAll(int fd, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+} // namespace
+
+bool SystemSnapshot::save(const SystemData& data, const std::string& path, std::string& error) {
+    return write(encode(data), path, error);
+}
+
+std::vector<uint8_t> SystemSnapshot::encode(const SystemData& data) {
+    const auto& m = data.monitoring;
+    std::vector<SystemData::MonitoringData::Alarm> alarms = data.getActiveAlarms();
+
+    SnapshotState state{};
+    state.nominal_output_power = data.nominal_output_power;
+    state.frequency = data.frequency;
+    for (size_t i = 0; i < 12; ++i) {
+        state.thresholds[i] = m.thresholds.*THRESHOLD_FIELDS[i];
+    }
+
+    const SensorConfig* configs[] = {&m.temp_config, &m.current_config, &m.power_config, &m.voltage_config};
+    const AnomalyDetector* detectors[] = {&m.temp_detector, &m.current_detector,
+                                          &m.power_detector, &m.voltage_detector};
+    for (size_t i = 0; i < 4; ++i) {
+        SnapshotSensor& sensor = state.sensors[i];
+        sensor.min_value = configs[i]->min_value;
+        sensor.max_value = configs[i]->max_value;
+        sensor.anomaly_probability = configs[i]->anomaly_probability;
+        sensor.anomaly_scale = configs[i]->anomaly_scale;
+        sensor.enabled = configs[i]->enabled;
+        sensor.monitor = configs[i]->monitor;
+        sensor.detector_mode = static_cast<uint8_t>(detectors[i]->mode());
+        sensor.detector_threshold = detectors[i]->configuredThreshold();
+    }
+
+    state.polling_interval_ms = m.polling_interval_ms;
+    state.total_sensor_updates = m.total_sensor_updates;
+    state.total_alarms_triggered = m.total_alarms_triggered;
+    state.alarm_id_counter = m.alarm_id_counter;
+    state.automatic_modulation = data.automatic_modulation;
+    state.modulation = data.modulation;
+    state.service_enabled = m.service_enabled;
+
+    size_t payload_size = sizeof(SnapshotState) + alarms.size() * sizeof(SnapshotAlarm);
+    std::vector<uint8_t> buffer(sizeof(SnapshotHeader) + payload_size);
+    uint8_t* payload = buffer.data() + sizeof(SnapshotHeader);
+    std::memcpy(payload, &state, sizeof(state));
+
+    for (size_t i = 0; i < alarms.size(); ++i) {
+        SnapshotAlarm record{};
+        copyField(record.id, alarms[i].id);
+        copyField(record.sensor, alarms[i].sensor);
+        copyField(record.severity, alarms[i].severity);
+        copyField(record.message, alarms[i].message);
+        record.acknowledged = alarms[i].acknowledged;
+        record.active = alarms[i].active;
+        record.value = alarms[i].value;
+        record.threshold = alarms[i].threshold;
+        record.timestamp_ms = toMillis(alarms[i].timestamp);
+        std::memcpy(payload + sizeof(SnapshotState) + i * sizeof(SnapshotAlarm), &record, sizeof(record));
+    }
+
+    SnapshotHeader header{};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.header_size = sizeof(SnapshotHeader);
+    header.payload_size = static_cast<uint32_t>(payload_size);
+    header.payload_crc = crc32(payload, payload_size);
+    header.written_ms = toMillis(std::chrono::system_clock::now());
+    header.alarm_count = static_cast<uint32_t>(alarms.size());
+    std::memcpy(buffer.data(), &header, sizeof(header));
+    return buffer;
+}
+
+bool SystemSnapshot::write(const std::vector<uint8_t>& buffer, const std::string& path, std::string& error) {
+    // Write aside, make it durable, then atomically replace the old snapshot
+    std::string temp_path = path + ".tmp";
+    int fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        error = "cannot create " + temp_path + ": " + strerror(errno);
+        return false;
+    }
+    if (!writeAll(fd, buffer.data(), buffer.size()) || ::fsync(fd) != 0) {
+        error = "cannot write " + temp_path + ": " + strerror(errno);
+        ::close(fd);
+        ::unlink(temp_path.c_str());
+        return false;
+    }
+    ::close(fd);
+
+    if (::rename(temp_path.c_str(), path.c_str()) != 0) {
+        error = "cannot rename to " + path + ": " + strerror(errno);
+        ::unlink(temp_path.c_str());
+        return false;
+    }
+
+    // Persist the rename itself
+    size_t slash = path.rfind('/');
+    std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    int dir_fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd != -1) {
+        ::fsync(dir_fd);
+        ::close(dir_fd);
+    }
+    return true;
+}
+
+bool SystemSnapshot::restore(SystemData& data, const std::string& path, std::string& error) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        error = "cannot open " + path + ": " + strerror(errno);
+        return false;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SnapshotHeader)) {
+        error = "snapshot " + path + " is truncated";
+        ::close(fd);
+        return false;
+    }
+    size_t file_size = static_cast<size_t>(st.st_size);
+
+    void* addr = ::mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        error = "cannot map " + path + ": " + strerror(errno);
+        return false;
+    }
+    const uint8_t* bytes = static_cast<const uint8_t*>(addr);
+
+    SnapshotHeader header;
+    std::memcpy(&header, bytes, sizeof(header));
+    const uint8_t* payload = bytes + sizeof(SnapshotHeader);
+
+    std::string reason;
+    if (header.magic != MAGIC) {
+        reason = "not a snapshot file";
+    } else if (header.version != VERSION || header.header_size != sizeof(SnapshotHeader)) {
+        reason = "unsupported snapshot version " + std::to_string(header.version);
+    } else if (header.payload_size != file_size - sizeof(SnapshotHeader) ||
+               header.payload_size != sizeof(SnapshotState) + size_t(header.alarm_count) * sizeof(SnapshotAlarm)) {
+        reason = "snapshot size mismatch";
+    } else if (crc32(payload, header.payload_size) != header.payload_crc) {
+        reason = "snapshot checksum mismatch";
+    }
+    if (!reason.empty()) {
+        error = reason + " in " + path;
+        ::munmap(addr, file_size);
+        return false;
+    }
+
+    SnapshotState state;
+    std::memcpy(&state, payload, sizeof(state));
+
+    auto& m = data.monitoring;
+    data.nominal_output_power = state.nominal_output_power;
+    data.frequency = state.frequency;
+    data.automatic_modulation = state.automatic_modulation != 0;
+    data.modulation = state.modulation != 0;
+    for (size_t i = 0; i < 12; ++i) {
+        m.thresholds.*THRESHOLD_FIELDS[i] = state.thresholds[i];
+    }
+
+    SensorConfig* configs[] = {&m.temp_config, &m.current_config, &m.power_config, &m.voltage_config};
+    AnomalyDetector* detectors[] = {&m.temp_detector, &m.current_detector,
+                                    &m.power_detector, &m.voltage_detector};
+    for (size_t i = 0; i < 4; ++i) {
+        const SnapshotSensor& sensor = state.sensors[i];
+        configs[i]->min_value = sensor.min_value;
+        configs[i]->max_value = sensor.max_value;
+        configs[i]->anomaly_probability = sensor.anomaly_probability;
+        configs[i]->anomaly_scale = sensor.anomaly_scale;
+        configs[i]->enabled = sensor.enabled != 0;
+        configs[i]->monitor = sensor.monitor != 0;
+        if (sensor.detector_mode <= static_cast<uint8_t>(DetectorMode::Mad)) {
+            detectors[i]->setMode(static_cast<DetectorMode>(sensor.detector_mode));
+        }
+        detectors[i]->setThreshold(sensor.detector_threshold);
+    }
+
+    m.polling_interval_ms = state.polling_interval_ms;
+    m.service_enabled = state.service_enabled != 0;
+    m.total_sensor_updates = state.total_sensor_updates;
+    m.total_alarms_triggered = state.total_alarms_triggered;
+
+    {
+        std::lock_guard<std::mutex> lock(m.alarms_mutex);
+        m.alarm_id_counter = state.alarm_id_counter;
+        m.active_alarms.clear();
+        for (uint32_t i = 0; i < header.alarm_count; ++i) {
+            SnapshotAlarm record;
+            std::memcpy(&record, payload + sizeof(SnapshotState) + i * sizeof(SnapshotAlarm), sizeof(record));
+
+            SystemData::MonitoringData::Alarm alarm;
+            alarm.id = readField(record.id);
+            alarm.sensor = readField(record.sensor);
+            alarm.severity = readField(record.severity);
+            alarm.message = readField(record.message);
+            alarm.acknowledged = record.acknowledged != 0;
+            alarm.active = record.active != 0;
+            alarm.value = record.value;
+            alarm.threshold = record.threshold;
+            alarm.timestamp = std::chrono::system_clock::time_point(
+                std::chrono::milliseconds(record.timestamp_ms));
+            m.active_alarms.push_back(alarm);
+        }
+    }
+
+    ::munmap(addr, file_size);
+    return data.rebuildThresholdRules(error);
+}
@@ -0,0 +1,64 @@
+#include "../include/TraceReplay.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+/**
+ * @brief TraceReplay constructor
+ */
+TraceReplay::TraceReplay(SystemData& system_data) : data(system_data) {}
+
+/**
+ * @brief Runs update + threshold check per sample, optionally paced
+ */
+TraceReplay::Result TraceReplay::run(const Options& options) {
+    using clock = std::chrono::steady_clock;
+    
+    Result result;
+    int alarms_before = data.monitoring.total_alarms_triggered;
+    
+    auto start = clock::now();
+    int64_t first_sample_ms = 0;
+    double total_tick_ns = 0.0;
+    
+    while (options.max_samples == 0 || result.samples < options.max_samples) {
+        auto tick_start = clock::now();
+        if (!data.updateMonitoringSensors()) {
+            break;
+        }
+        data.checkMonitoringThresholds();
+        auto tick_end = clock::now();
+        
+        double tick_ns = std::chrono::duration<double, std::nano>(tick_end - tick_start).count();
+        total_tick_ns += tick_ns;
+        result.max_tick_ns = std::max(result.max_tick_ns, tick_ns);
+        result.samples++;
+        
+        if (options.alarm_retention > 0 &&
+            data.monitoring.active_alarms.size() > options.alarm_retention) {
+            data.clearAllAlarms();
+        }
+        
+        if (options.speed > 0.0) {
+            int64_t sample_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                data.monitoring.last_update.time_since_epoch()).count();
+            if (result.samples == 1) {
+                first_sample_ms = sample_ms;
+            }
+            auto due = start + std::chrono::duration_cast<clock::duration>(
+                std::chrono::duration<double, std::milli>((sample_ms - first_sample_ms) / options.speed));
+            std::this_thread::sleep_until(due);
+        }
+    }
+    
+    result.elapsed_s = std::chrono::duration<double>(clock::now() - start).count();
+    result.alarms = static_cast<uint64_t>(data.monitoring.total_alarms_triggered - alarms_before);
+    if (result.samples > 0) {
+        result.avg_tick_ns = total_tick_ns / result.samples;
+    }
+    if (result.elapsed_s > 0.0) {
+        result.samples_per_second = result.samples / result.elapsed_s;
+    }
+    
+    return result;
+}
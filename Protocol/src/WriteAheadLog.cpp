@@ -0,0 +1,347 @@
+#include "../include/WriteAheadLog.h"
+#include "../include/Crc32.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+};
+
+struct RecordHeader {
+    uint32_t length;   ///< Body bytes following this header
+    uint32_t crc;      ///< CRC-32 of the body
+};
+
+// Body: type, parameter length, value length, parameter, value
+constexpr size_t BODY_FIXED = 4;
+
+bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool readAll(int fd, std::string& out) {
+    char buffer[4096];
+    for (;;) {
+        ssize_t n = ::read(fd, buffer, sizeof(buffer));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (n == 0) return true;
+        out.append(buffer, static_cast<size_t>(n));
+    }
+}
+
+std::string encodeHeader() {
+    FileHeader header{WriteAheadLog::MAGIC, WriteAheadLog::VERSION};
+    return std::string(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+} // namespace
+
+WriteAheadLog::WriteAheadLog(const std::string& path) : path_(path) {}
+
+WriteAheadLog::~WriteAheadLog() {
+    close();
+}
+
+bool WriteAheadLog::open(std::vector<Record>& recovered, std::string& error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ != -1) {
+        error = "journal already open";
+        return false;
+    }
+
+    int fd = ::open(path_.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        error = "cannot open " + path_ + ": " + strerror(errno);
+        return false;
+    }
+
+    std::string contents;
+    if (!readAll(fd, contents)) {
+        error = "cannot read " + path_ + ": " + strerror(errno);
+        ::close(fd);
+        return false;
+    }
+
+    if (contents.empty()) {
+        std::string header = encodeHeader();
+        if (!writeAll(fd, header.data(), header.size()) || ::fdatasync(fd) != 0) {
+            error = "cannot initialize " + path_ + ": " + strerror(errno);
+            ::close(fd);
+            return false;
+        }
+        contents = header;
+    }
+
+    FileHeader header;
+    if (contents.size() < sizeof(header)) {
+        error = path_ + " is not a journal";
+        ::close(fd);
+        return false;
+    }
+    std::memcpy(&header, contents.data(), sizeof(header));
+    if (header.magic != MAGIC || header.version != VERSION) {
+        error = path_ + " is not a version " + std::to_string(VERSION) + " journal";
+        ::close(fd);
+        return false;
+    }
+
+    // Recover records up to the first torn or corrupted one
+    size_t offset = sizeof(FileHeader);
+    while (offset + sizeof(RecordHeader) <= contents.size()) {
+        RecordHeader record;
+        std::memcpy(&record, contents.data() + offset, sizeof(record));
+        const char* body = contents.data() + offset + sizeof(record);
+        if (record.length < BODY_FIXED || record.length > contents.size() - offset - sizeof(record) ||
+            crc32(body, record.length) != record.crc) {
+            break;
+        }
+
+        uint8_t type = static_cast<uint8_t>(body[0]);
+        size_t parameter_len = static_cast<uint8_t>(body[1]);
+        uint16_t value_len;
+        std::memcpy(&value_len, body + 2, sizeof(value_len));
+        if (BODY_FIXED + parameter_len + value_len != record.length ||
+            (type != static_cast<uint8_t>(RecordType::Set) &&
+             type != static_cast<uint8_t>(RecordType::MonitorConfig))) {
+            break;
+        }
+
+        recovered.push_back(Record{static_cast<RecordType>(type),
+                                   std::string(body + BODY_FIXED, parameter_len),
+                                   std::string(body + BODY_FIXED + parameter_len, value_len)});
+        offset += sizeof(record) + record.length;
+    }
+
+    if (offset < contents.size()) {
+        if (::ftruncate(fd, static_cast<off_t>(offset)) != 0 || ::fdatasync(fd) != 0) {
+            error = "cannot truncate torn tail of " + path_ + ": " + strerror(errno);
+            ::close(fd);
+            return false;
+        }
+    }
+
+    fd_ = fd;
+    size_ = offset;
+    appended_seq_ = durable_seq_ = failed_seq_ = 0;
+    commits_ = failures_ = 0;
+    stopping_ = false;
+    committer_ = std::thread(&WriteAheadLog::commitLoop, this);
+    return true;
+}
+
+uint64_t WriteAheadLog::append(RecordType type, const std::string& parameter, const std::string& value) {
+    if (parameter.size() > UINT8_MAX || value.size() > UINT16_MAX) {
+        return 0;
+    }
+
+    std::string body;
+    body.reserve(BODY_FIXED + parameter.size() + value.size());
+    body.push_back(static_cast<char>(type));
+    body.push_back(static_cast<char>(parameter.size()));
+    uint16_t value_len = static_cast<uint16_t>(value.size());
+    body.append(reinterpret_cast<const char*>(&value_len), sizeof(value_len));
+    body += parameter;
+    body += value;
+
+    RecordHeader header{static_cast<uint32_t>(body.size()), crc32(body.data(), body.size())};
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ == -1 || stopping_) {
+        return 0;
+    }
+    pending_.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    pending_ += body;
+    size_ += sizeof(header) + body.size();
+    uint64_t sequence = ++appended_seq_;
+    pending_cv_.notify_one();
+    return sequence;
+}
+
+/**
+ * @brief Writes and syncs pending records, one group per iteration
+ */
+void WriteAheadLog::commitLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        pending_cv_.wait(lock, [this]() { return !pending_.empty() || stopping_; });
+        if (pending_.empty()) {
+            break;
+        }
+
+        std::string group;
+        group.swap(pending_);
+        uint64_t sequence = appended_seq_;
+        uint64_t start = size_ - group.size();
+        int fd = fd_;
+        writing_ = true;
+        lock.unlock();
+
+        bool ok = writeAll(fd, group.data(), group.size()) && ::fdatasync(fd) == 0;
+        if (!ok) {
+            // Never leave a partial record in front of later ones; if this
+            // fails too, recovery still stops at the torn record
+            int result = ::ftruncate(fd, static_cast<off_t>(start));
+            (void)result;
+        }
+
+        lock.lock();
+        writing_ = false;
+        commits_++;
+        if (ok) {
+            durable_seq_ = sequence;
+        } else {
+            failures_++;
+            failed_seq_ = sequence;
+            size_ -= group.size();
+        }
+        durable_cv_.notify_all();
+    }
+}
+
+bool WriteAheadLog::appendDurable(RecordType type, const std::string& parameter, const std::string& value) {
+    uint64_t sequence = append(type, parameter, value);
+    return sequence != 0 && waitDurable(sequence);
+}
+
+bool WriteAheadLog::waitDurable(uint64_t sequence) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    durable_cv_.wait(lock, [&]() {
+        return durable_seq_ >= sequence || failed_seq_ >= sequence || fd_ == -1;
+    });
+    return durable_seq_ >= sequence && failed_seq_ < sequence;
+}
+
+bool WriteAheadLog::sync() {
+    uint64_t sequence;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sequence = appended_seq_;
+    }
+    return waitDurable(sequence);
+}
+
+uint64_t WriteAheadLog::mark() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return size_;
+}
+
+bool WriteAheadLog::checkpoint(uint64_t mark, std::string& error) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (fd_ == -1) {
+        error = "journal not open";
+        return false;
+    }
+
+    // Let the committer drain so the file holds every record
+    durable_cv_.wait(lock, [this]() { return (pending_.empty() && !writing_) || fd_ == -1; });
+    if (fd_ == -1) {
+        error = "journal closed";
+        return false;
+    }
+    if (mark < sizeof(FileHeader) || mark > size_) {
+        error = "stale journal mark";
+        return false;
+    }
+    if (mark == sizeof(FileHeader)) {
+        return true;
+    }
+
+    if (mark == size_) {
+        if (::ftruncate(fd_, sizeof(FileHeader)) != 0 || ::fdatasync(fd_) != 0) {
+            error = "cannot truncate " + path_ + ": " + strerror(errno);
+            return false;
+        }
+        size_ = sizeof(FileHeader);
+        return true;
+    }
+    return rewriteFrom(mark, error);
+}
+
+/**
+ * @brief Replaces the log with the records from offset on
+ *
+ * Called with the mutex held and the committer idle.
+ */
+bool WriteAheadLog::rewriteFrom(uint64_t offset, std::string& error) {
+    std::string tail(size_ - offset, '\0');
+    if (::pread(fd_, &tail[0], tail.size(), static_cast<off_t>(offset)) != static_cast<ssize_t>(tail.size())) {
+        error = "cannot read " + path_ + ": " + strerror(errno);
+        return false;
+    }
+
+    std::string temp_path = path_ + ".tmp";
+    int fd = ::open(temp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        error = "cannot create " + temp_path + ": " + strerror(errno);
+        return false;
+    }
+
+    std::string contents = encodeHeader() + tail;
+    if (!writeAll(fd, contents.data(), contents.size()) || ::fdatasync(fd) != 0 ||
+        ::rename(temp_path.c_str(), path_.c_str()) != 0) {
+        error = "cannot rewrite " + path_ + ": " + strerror(errno);
+        ::close(fd);
+        ::unlink(temp_path.c_str());
+        return false;
+    }
+
+    ::close(fd_);
+    fd_ = fd;
+    size_ = contents.size();
+    return true;
+}
+
+void WriteAheadLog::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (fd_ == -1) return;
+        stopping_ = true;
+        pending_cv_.notify_one();
+    }
+    if (committer_.joinable()) {
+        committer_.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ::close(fd_);
+    fd_ = -1;
+    durable_cv_.notify_all();
+}
+
+bool WriteAheadLog::isOpen() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return fd_ != -1;
+}
+
+uint64_t WriteAheadLog::appended() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return appended_seq_;
+}
+
+uint64_t WriteAheadLog::commits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return commits_;
+}
+
+uint64_t WriteAheadLog::failures() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return failures_;
+}
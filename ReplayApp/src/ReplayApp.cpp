@@ -0,0 +1,173 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <memory>
+#include <getopt.h>
+#include "../../Protocol/include/SystemData.h"
+#include "../../Protocol/include/TraceReplay.h"
+
+struct CommandLineOptions {
+    std::string trace;
+    std::string generate;
+    std::string detector = "static";
+    size_t synthetic = 0;
+    size_t max_samples = 0;
+    double speed = 0.0;
+    bool loop = false;
+    bool help = false;
+};
+
+void showUsage(const char* programName) {
+    std::cout << "Radio Monitoring Trace Replay" << std::endl;
+    std::cout << "Usage: " << programName << " [OPTION]" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  -t, --trace FILE       Replay a CSV (.csv) or binary sensor trace" << std::endl;
+    std::cout << "  -y, --synthetic N      Replay N deterministic synthetic samples" << std::endl;
+    std::cout << "  -r, --random N         Replay N samples of the random simulator" << std::endl;
+    std::cout << "  -g, --generate FILE    Write the selected source to a trace file instead" << std::endl;
+    std::cout << "  -s, --speed X          Pace by trace timestamps at X times real time (0 = max)" << std::endl;
+    std::cout << "  -n, --samples N        Stop after N samples" << std::endl;
+    std::cout << "  -l, --loop             Loop the trace file" << std::endl;
+    std::cout << "  -d, --detector MODE    Detector for all sensors: static, zscore, mad" << std::endl;
+    std::cout << "  -h, --help             Show this help message" << std::endl;
+}
+
+bool parseCommandLine(int argc, char* argv[], CommandLineOptions& options, bool& random) {
+    static struct option longOptions[] = {
+        {"trace", required_argument, 0, 't'},
+        {"synthetic", required_argument, 0, 'y'},
+        {"random", required_argument, 0, 'r'},
+        {"generate", required_argument, 0, 'g'},
+        {"speed", required_argument, 0, 's'},
+        {"samples", required_argument, 0, 'n'},
+        {"loop", no_argument, 0, 'l'},
+        {"detector", required_argument, 0, 'd'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+    
+    const char* shortOptions = "t:y:r:g:s:n:ld:h";
+    
+    int optionIndex = 0;
+    int c;
+    
+    optind = 0;
+    opterr = 0;
+    
+    try {
+        while ((c = getopt_long(argc, argv, shortOptions, longOptions, &optionIndex)) != -1) {
+            switch (c) {
+                case 't':
+                    options.trace = optarg;
+                    break;
+                case 'y':
+                    options.synthetic = std::stoul(optarg);
+                    break;
+                case 'r':
+                    random = true;
+                    options.max_samples = std::stoul(optarg);
+                    break;
+                case 'g':
+                    options.generate = optarg;
+                    break;
+                case 's':
+                    options.speed = std::stod(optarg);
+                    break;
+                case 'n':
+                    options.max_samples = std::stoul(optarg);
+                    break;
+                case 'l':
+                    options.loop = true;
+                    break;
+                case 'd':
+                    options.detector = optarg;
+                    break;
+                case 'h':
+                    options.help = true;
+                    break;
+                default:
+                    std::cerr << "Unknown option: " << argv[optind - 1] << std::endl;
+                    return false;
+            }
+        }
+    } catch (const std::exception&) {
+        std::cerr << "Invalid numeric argument: " << argv[optind - 1] << std::endl;
+        return false;
+    }
+    
+    if (optind < argc) {
+        std::cerr << "Unexpected argument: " << argv[optind] << std::endl;
+        return false;
+    }
+    
+    int sourceCount = !options.trace.empty() + (options.synthetic > 0) + random;
+    if (!options.help && sourceCount != 1) {
+        std::cerr << "Error: Choose exactly one of --trace, --synthetic or --random." << std::endl;
+        return false;
+    }
+    
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    CommandLineOptions options;
+    bool random = false;
+    
+    if (!parseCommandLine(argc, argv, options, random)) {
+        showUsage(argv[0]);
+        return -1;
+    }
+    
+    if (options.help) {
+        showUsage(argv[0]);
+        return 0;
+    }
+    
+    SystemData data;
+    
+    if (!options.trace.empty()) {
+        auto source = std::make_unique<TraceSensorSource>(options.trace, options.loop);
+        if (!source->isOpen()) {
+            std::cerr << "Error: Cannot open trace " << options.trace << std::endl;
+            return -1;
+        }
+        data.setSensorSource(std::move(source));
+    } else if (options.synthetic > 0) {
+        data.setSensorSource(std::make_unique<SyntheticSensorSource>(options.synthetic));
+    }
+    
+    if (!options.generate.empty()) {
+        size_t count = options.max_samples ? options.max_samples : 
+                       options.synthetic ? options.synthetic : static_cast<size_t>(-1);
+        size_t written = TraceSensorSource::write(options.generate, *data.sensor_source, count);
+        std::cout << "Wrote " << written << " samples to " << options.generate << std::endl;
+        return written > 0 ? 0 : -1;
+    }
+    
+    DetectorMode mode;
+    if (!AnomalyDetector::parseMode(options.detector, mode)) {
+        std::cerr << "Error: Unknown detector " << options.detector << std::endl;
+        return -1;
+    }
+    for (const char* sensor : {"temperature", "current", "power", "voltage"}) {
+        data.getSensorDetector(sensor)->setMode(mode);
+    }
+    
+    TraceReplay::Options replayOptions;
+    replayOptions.speed = options.speed;
+    replayOptions.max_samples = options.max_samples;
+    
+    std::cout << "Replaying " << data.sensor_source->name() << " source..." << std::endl;
+    TraceReplay replay(data);
+    TraceReplay::Result result = replay.run(replayOptions);
+    
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Samples:        " << result.samples << std::endl;
+    std::cout << "Alarms:         " << result.alarms << std::endl;
+    std::cout << "Elapsed:        " << std::setprecision(3) << result.elapsed_s << " s" << std::endl;
+    std::cout << "Throughput:     " << std::setprecision(0) << result.samples_per_second << " samples/s" << std::endl;
+    std::cout << "Avg tick:       " << result.avg_tick_ns << " ns" << std::endl;
+    std::cout << "Max tick:       " << result.max_tick_ns << " ns" << std::endl;
+    
+    return 0;
+}
@@ -0,0 +1,158 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <getopt.h>
+#include "../../System/include/StatsPage.h"
+#include "../../System/include/IpcNames.h"
+
+struct CommandLineOptions {
+    double interval = 0.0;
+    size_t count = 0;
+    std::string instance;
+    bool help = false;
+};
+
+void showUsage(const char* programName) {
+    std::cout << "Radio Control Server Latency Statistics" << std::endl;
+    std::cout << "Usage: " << programName << " [OPTION]" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  -i, --interval SEC     Repeat every SEC seconds" << std::endl;
+    std::cout << "  -n, --count N          Stop after N reports (with --interval)" << std::endl;
+    std::cout << "  -I, --instance NAME    Server instance (default $" << INSTANCE_ENV
+              << ", else the unnamed instance)" << std::endl;
+    std::cout << "  -h, --help             Show this help message" << std::endl;
+}
+
+bool parseCommandLine(int argc, char* argv[], CommandLineOptions& options) {
+    static struct option longOptions[] = {
+        {"interval", required_argument, 0, 'i'},
+        {"count", required_argument, 0, 'n'},
+        {"instance", required_argument, 0, 'I'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    const char* shortOptions = "i:n:I:h";
+
+    int optionIndex = 0;
+    int c;
+
+    optind = 0;
+    opterr = 0;
+
+    try {
+        while ((c = getopt_long(argc, argv, shortOptions, longOptions, &optionIndex)) != -1) {
+            switch (c) {
+                case 'i':
+                    options.interval = std::stod(optarg);
+                    break;
+                case 'n':
+                    options.count = std::stoul(optarg);
+                    break;
+                case 'I':
+                    options.instance = optarg;
+                    break;
+                case 'h':
+                    options.help = true;
+                    break;
+                default:
+                    std::cerr << "Unknown option: " << argv[optind - 1] << std::endl;
+                    return false;
+            }
+        }
+    } catch (const std::exception&) {
+        std::cerr << "Invalid numeric argument: " << argv[optind - 1] << std::endl;
+        return false;
+    }
+
+    if (optind < argc) {
+        std::cerr << "Unexpected argument: " << argv[optind] << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Formats nanoseconds with a readable unit
+ */
+std::string formatDuration(double ns) {
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(1);
+    if (ns < 1e3) ss << ns << "ns";
+    else if (ns < 1e6) ss << ns / 1e3 << "us";
+    else if (ns < 1e9) ss << ns / 1e6 << "ms";
+    else ss << ns / 1e9 << "s";
+    return ss.str();
+}
+
+void printReport(const StatsPage& page) {
+    auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    std::cout << "Server PID " << page.pid << ", up " << (now_ms - page.start_time_ms) / 1000 << " s, "
+              << page.commands_total.load() << " commands ("
+              << page.commands_failed.load() << " failed), "
+              << page.monitoring_overruns.load() << " monitoring overruns" << std::endl;
+
+    std::cout << std::left << std::setw(16) << "metric" << std::right
+              << std::setw(10) << "count" << std::setw(10) << "mean"
+              << std::setw(10) << "p50" << std::setw(10) << "p99"
+              << std::setw(10) << "p999" << std::setw(10) << "max" << std::endl;
+
+    for (size_t i = 0; i < static_cast<size_t>(StatsMetric::Count); ++i) {
+        StatsMetric metric = static_cast<StatsMetric>(i);
+        const LatencyHistogram& h = page.histogram(metric);
+
+        std::cout << std::left << std::setw(16) << StatsPage::metricName(metric) << std::right
+                  << std::setw(10) << h.count.load()
+                  << std::setw(10) << formatDuration(h.mean())
+                  << std::setw(10) << formatDuration(h.percentile(0.50))
+                  << std::setw(10) << formatDuration(h.percentile(0.99))
+                  << std::setw(10) << formatDuration(h.percentile(0.999))
+                  << std::setw(10) << formatDuration(h.max.load()) << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    CommandLineOptions options;
+
+    if (!parseCommandLine(argc, argv, options)) {
+        showUsage(argv[0]);
+        return -1;
+    }
+
+    if (options.help) {
+        showUsage(argv[0]);
+        return 0;
+    }
+
+    std::string instance, error;
+    if (!IpcNames::resolveInstance(options.instance, instance, error)) {
+        std::cerr << error << std::endl;
+        return -1;
+    }
+    IpcNames names = IpcNames::forInstance(instance);
+    
+    const StatsPage* page = StatsPage::openReadOnly(names.stats_shm.c_str());
+    if (!page) {
+        std::cerr << "Stats page " << names.stats_shm << " not available. Is the server running?" << std::endl;
+        return 1;
+    }
+
+    for (size_t report = 1; ; ++report) {
+        printReport(*page);
+
+        if (options.interval <= 0 || (options.count && report >= options.count)) {
+            break;
+        }
+        std::cout << std::endl;
+        std::this_thread::sleep_for(std::chrono::duration<double>(options.interval));
+    }
+
+    StatsPage::unmap(page);
+    return 0;
+}
@@ -11,9 +11,5 @@ public:
     void updateAndCheckAlarms();
 
 private:
-    void checkTemperatureAlarms();
-
-    void checkOutputPowerAlarms();
-
-    void checkInputPowerAlarms();
+    void installDefaultRules();
 };
\ No newline at end of file
@@ -7,31 +7,30 @@
 
 #pragma once
 #include <iostream>
-#include <sys/mman.h>
-#include <fcntl.h>
-#include <unistd.h>
-#include <cstring>
-#include <semaphore.h>
-#include "SharedData.h"
+#include <string>
+#include "IpcNames.h"
+#include "../../ClientLib/include/RadioClient.h"
 
 /**
  * @brief Client class for communicating with radio control server
  * 
  * The Client class provides an interactive interface for sending commands
- * to the radio control server via shared memory and semaphores.
+ * to the radio control server, on top of a RadioClient connection.
  */
 class Client {
 private:
-    sem_t *sem_client;    ///< Client notification semaphore
-    sem_t *sem_server;    ///< Server response semaphore
-    int shm_fd;           ///< Shared memory file descriptor
-    SharedData* data;     ///< Pointer to shared memory data
+    RadioClient radio;    ///< Connection to the server instance
+    IpcNames names;       ///< Objects of the server instance to talk to
+    
+    static constexpr int CONNECT_TIMEOUT_MS = 10000;  ///< How long to wait for a starting server
 
 public:
     /**
      * @brief Constructs a new Client object
+     * 
+     * @param names IPC objects of the server instance to connect to
      */
-    Client();
+    explicit Client(const IpcNames& names = IpcNames::forInstance());
     
     /**
      * @brief Destroys the Client object and cleans up resources
@@ -46,18 +45,37 @@ public:
      */
     void run();
     
-private:
     /**
-     * @brief Initializes shared memory connection to server
-     * @return true if initialization successful, false otherwise
+     * @brief Connects to the server's semaphore and shared memory
+     * 
+     * Prints only a "Waiting for server" notice to stderr, so scripts
+     * can use the client's output as is. Does nothing if already
+     * connected.
+     * 
+     * @param timeout_ms How long to wait for a starting server
+     * @param error Receives the reason on failure
+     */
+    bool connect(int timeout_ms, std::string& error);
+    
+    /**
+     * @brief Sends one command and waits for its response
+     * 
+     * @param response Receives the server's response; "ERROR: ..."
+     *        responses still count as a completed exchange
+     * @param error Receives the reason when no response arrived
+     * @return false if not connected, the command is too long, or the
+     *         server did not answer within RadioClient::DEFAULT_TIMEOUT_MS
      */
-    bool initializeSharedMemory();
+    bool execute(const std::string& command, std::string& response, std::string& error);
+    
+    static constexpr size_t MAX_COMMAND_LENGTH = RadioClient::MAX_COMMAND_LENGTH;
     
     /**
-     * @brief Cleans up shared memory and semaphores
+     * @brief The underlying connection, for asynchronous requests
      */
-    void cleanup();
+    RadioClient& connection() { return radio; }
     
+private:    
     /**
      * @brief Displays help information about available commands
      */
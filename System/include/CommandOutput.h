@@ -0,0 +1,69 @@
+/**
+ * @file CommandOutput.h
+ * @brief Result printing and batch execution of the command-line client
+ * 
+ * @ingroup CommunicationClasses
+ */
+
+#pragma once
+#include <iostream>
+#include <string>
+#include "../../ClientLib/include/RadioClient.h"
+
+/**
+ * @brief Exit status of radio-client
+ *
+ * 0 if every command succeeded, 1 if the server answered any command
+ * with ERROR or a command was too long to send, 2 if the server could
+ * not be reached or stopped answering.
+ */
+enum ExitStatus {
+    EXIT_OK = 0,
+    EXIT_COMMAND_FAILED = 1,
+    EXIT_UNAVAILABLE = 2
+};
+
+enum class OutputFormat { Text, Json };
+
+/**
+ * @brief How runBatch() sends and prints commands
+ */
+struct BatchOptions {
+    OutputFormat format = OutputFormat::Text;
+    int timeout_ms = RadioClient::DEFAULT_TIMEOUT_MS;  ///< Per request
+    size_t pipeline = 8;                               ///< Requests in flight
+};
+
+/**
+ * @brief Quotes a string as a JSON string literal
+ *
+ * Escapes quotes, backslashes and control characters; other bytes,
+ * including UTF-8 sequences, are copied unchanged.
+ */
+std::string jsonString(const std::string& str);
+
+/**
+ * @brief Prints the outcome of one command
+ *
+ * Text output is the response alone on out, or "Error: ..." on err if
+ * the server did not answer. JSON output is one object per command on
+ * out in either case.
+ *
+ * @return ExitStatus of this command
+ */
+ExitStatus printResult(std::ostream& out, std::ostream& err, OutputFormat format,
+                       const std::string& command, const RadioResponse& result);
+
+/**
+ * @brief Sends every command line of the input, several at a time
+ *
+ * Blank lines and lines starting with # are skipped. Results are
+ * printed in input order. The server answers requests in submission
+ * order, so pipelining does not reorder a SET and a following GET.
+ * Stops at the first command the server does not answer; commands
+ * answered with ERROR do not stop the batch.
+ *
+ * @return ExitStatus Worst status of the printed commands
+ */
+ExitStatus runBatch(RadioClient& client, std::istream& input, std::ostream& out, std::ostream& err,
+                    const BatchOptions& options);
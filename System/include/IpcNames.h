@@ -0,0 +1,61 @@
+/**
+ * @file IpcNames.h
+ * @brief Names of the IPC objects and files of one server instance
+ * 
+ * @ingroup CommunicationClasses
+ */
+
+#pragma once
+#include <string>
+
+inline constexpr const char* INSTANCE_ENV = "RADIO_INSTANCE";
+
+/**
+ * @brief Shared memory, semaphore and file names of a server instance
+ * 
+ * Every resource a server creates is derived from its instance name, so
+ * several servers (one per radio) can run on one host without touching
+ * each other's objects. The default instance (empty name) uses the
+ * historical names, e.g. /radio_control_memory and
+ * /tmp/radio_server.pid; instance "r1" uses /radio_control_memory.r1 and
+ * /tmp/radio_server.r1.pid.
+ */
+struct IpcNames {
+    std::string instance;     ///< Empty for the default instance
+    std::string shm;          ///< Command/response segment
+    std::string sem_client;   ///< Posted by clients once per request
+    std::string stats_shm;    ///< StatsPage segment
+    std::string pid_file;
+    std::string log_ident;    ///< syslog identifier
+    std::string stdout_log;
+    std::string stderr_log;
+    std::string snapshot;
+    std::string wal;
+    std::string archive_dir;
+    std::string trace_dir;    ///< Only place MONITOR TRACE DUMP writes to
+    
+    /**
+     * @brief Builds the names for an instance
+     * 
+     * @param instance Validated instance name, empty for the default
+     */
+    static IpcNames forInstance(const std::string& instance = "");
+    
+    /**
+     * @brief Picks the instance from a command line value or RADIO_INSTANCE
+     * 
+     * @param cli_value Value of --instance, empty if not given
+     * @param instance Receives the chosen instance name
+     * @param error Receives the reason if the name is invalid
+     * @return false if the chosen name is invalid
+     */
+    static bool resolveInstance(const std::string& cli_value, std::string& instance, std::string& error);
+    
+    /**
+     * @brief Instance names are 1-32 characters of [A-Za-z0-9_-]
+     * 
+     * They end up in shared memory names and file paths, so separators
+     * and dots are not allowed.
+     */
+    static bool isValidInstance(const std::string& instance);
+};
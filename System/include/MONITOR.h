@@ -1,6 +1,8 @@
 #pragma once
 
 #include "../../Protocol/include/System.h"
+#include "../../Protocol/include/MonitoringConfig.h"
+#include "TelemetryArchive.h"
 
 /**
  * @brief Class for monitoring system commands
@@ -19,12 +21,21 @@
  * - MONITOR SENSORS - Get current sensor values
  * - MONITOR ALARMS - Get active alarms
  * - MONITOR CONFIG GET <param> - Get monitoring parameter
- * - MONITOR CONFIG SET <param> <value> - Set monitoring parameter
+ * - MONITOR CONFIG SET <param> <value> - Set monitoring parameter; with a
+ *   journal the change is undone and reported as an error unless it is on disk
  * - MONITOR ALARM ACK <id> - Acknowledge alarm
  * - MONITOR SERVICE <on/off> - Enable/disable monitoring service
  * - MONITOR UPDATE - Force sensor update
  * - MONITOR CHECK - Check thresholds
  * - MONITOR CLEAR - Clear acknowledged alarms
+ * - MONITOR HISTORY <sensor> <from> <to> <step> - Get sensor history
+ * - MONITOR ARCHIVE <sensor> <from> <to> - Summarize archived samples, alarm_<sensor> for alarms
+ * - MONITOR STATS [sensor|RESET] - Get streaming sensor statistics
+ * - MONITOR RULES [prefix] - List alarm rules
+ * - MONITOR RULE ADD <name> <severity> <expression> - Add or replace an alarm rule
+ * - MONITOR RULE DEL <name> - Remove an alarm rule
+ * - MONITOR TRACE <DUMP name|ON|OFF|CLEAR> - Control span tracing, export Chrome trace JSON
+ *   into the instance's trace directory
  */
 class MONITOR : public System {
 public:
@@ -43,7 +54,39 @@ public:
      */
     std::string execute(const std::string& command);
     
+    /**
+     * @brief Sets the telemetry archive used by the ARCHIVE command
+     * 
+     * @param archive Archive owned by the caller, or nullptr to disable
+     */
+    void setArchive(TelemetryArchive* archive);
+    
+    /**
+     * @brief Sets the directory TRACE DUMP writes into
+     * 
+     * Clients only name a file in it. The directory is created on the
+     * first dump and must be a directory owned by the server user that
+     * nobody else can write to.
+     * 
+     * @param dir Directory path, empty to disable TRACE DUMP
+     */
+    void setTraceDirectory(const std::string& dir);
+    
 private:
+    TelemetryArchive* archive_ = nullptr;  ///< On-disk telemetry archive
+    std::string trace_dir_;                ///< Where TRACE DUMP writes, empty if disabled
+    
+    /// Everything CONFIG SET can change, to undo a change that cannot be journaled
+    struct ConfigState {
+        MonitoringConfig config;
+        bool service_enabled;
+        DetectorMode detector_modes[4];
+        double detector_thresholds[4];   ///< Configured, 0 = mode default
+    };
+    
+    ConfigState saveConfig() const;
+    void restoreConfig(const ConfigState& state);
+    
     /**
      * @brief Handle STATUS command
      */
@@ -66,8 +109,13 @@ private:
     
     /**
      * @brief Handle CONFIG SET command
+     * 
+     * Besides service_enabled and the detector settings, accepts every
+     * key of a MonitoringConfig file and validates it the same way.
+     * 
+     * @param error Receives the reason the value was rejected
      */
-    bool handleConfigSet(const std::string& param, const std::string& value);
+    bool handleConfigSet(const std::string& param, const std::string& value, std::string& error);
     
     /**
      * @brief Handle ALARM ACK command
@@ -93,4 +141,57 @@ private:
      * @brief Handle CLEAR command
      */
     std::string handleClear();
+    
+    /**
+     * @brief Handle HISTORY command
+     * 
+     * @param sensor Sensor name
+     * @param from Range start in seconds ago
+     * @param to Range end in seconds ago
+     * @param step Point width in seconds
+     */
+    std::string handleHistory(const std::string& sensor, const std::string& from,
+                              const std::string& to, const std::string& step) const;
+    
+    /**
+     * @brief Handle ARCHIVE command
+     * 
+     * @param sensor Sensor name, or alarm_<sensor> for the archived alarms
+     * @param from Range start in seconds ago
+     * @param to Range end in seconds ago
+     */
+    std::string handleArchive(const std::string& sensor, const std::string& from,
+                              const std::string& to) const;
+    
+    /**
+     * @brief Handle STATS command
+     * 
+     * @param sensor Sensor name, "RESET", or empty for all sensors
+     */
+    std::string handleStats(const std::string& sensor);
+    
+    /**
+     * @brief Handle RULES command
+     * 
+     * @param prefix Only list rules whose name starts with it
+     */
+    std::string handleRules(const std::string& prefix) const;
+    
+    /**
+     * @brief Handle RULE ADD command
+     * 
+     * The rule takes effect on the next check without a restart.
+     */
+    std::string handleRuleAdd(const std::string& name, const std::string& severity,
+                              const std::string& expression);
+    
+    /**
+     * @brief Handle TRACE command
+     * 
+     * @param action DUMP, ON, OFF or CLEAR
+     * @param name Output file for DUMP: a new file in the trace
+     *        directory, without / or ..; existing files and symbolic
+     *        links are never written through
+     */
+    std::string handleTrace(const std::string& action, const std::string& name);
 };
\ No newline at end of file
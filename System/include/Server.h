@@ -11,49 +11,235 @@
 #include <thread>
 #include <atomic>
 #include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
 
 #include "SharedData.h"
 #include "Alarm.h"
 #include "MONITOR.h"
+#include "TelemetryArchive.h"
+#include "StatsPage.h"
+#include "IpcNames.h"
+
+#include "../../DaemonLib/include/EventLoop.h"
+#include "../../DaemonLib/include/Realtime.h"
 
 #include "../../Protocol/include/Set.h"
 #include "../../Protocol/include/Get.h"
+#include "../../Protocol/include/SystemSnapshot.h"
+#include "../../Protocol/include/MonitoringConfig.h"
+
+inline constexpr unsigned DEFAULT_IDLE_TIMEOUT_S = 90;  ///< Legacy inactivity shutdown
 
 class Server {
 private:
+    IpcNames names;  ///< Instance resources, initialized first
     SystemData shared_data;
+    AlarmBus alarm_bus;
+    WriteAheadLog wal;
     SET set_system;
     GET get_system;
     ALARM alarm_system;
     MONITOR monitor_system;
+    TelemetryArchive archive;
+    
+    sem_t* sem_client;  ///< Posted once per submitted request
+    SharedSegment segment;
+    ShmOptions shm_options;
+    SharedData* data;  ///< Mapped segment, MAP_FAILED if unavailable
+    StatsPage* stats = nullptr;  ///< Latency histograms read by radio-stats
+    unsigned idle_timeout_s = DEFAULT_IDLE_TIMEOUT_S;  ///< 0 keeps run() going until stopped
+    RealtimeConfig realtime;  ///< Thread pinning and scheduling
     
-    sem_t* sem_client;
-    sem_t* sem_server;
-    int shm_fd;
-    SharedData* data;
+    static constexpr int64_t SNAPSHOT_INTERVAL_NS = 60LL * 1000000000LL;  ///< Periodic snapshot from the monitoring thread
+    static constexpr int64_t SNAPSHOT_RETRY_NS = 100LL * 1000000LL;       ///< Next attempt while a command holds the state
+    
+    // Radio parameters and monitoring configuration: held by the command
+    // thread for each command, by the event loop only to copy a snapshot
+    // or apply a reloaded configuration, and by the reload thread to copy
+    // the running configuration. The event loop never waits for it; the
+    // others wait STATE_LOCK_TIMEOUT_MS, which only runs out behind a
+    // stalled command.
+    std::timed_mutex state_mutex;
+    static constexpr int STATE_LOCK_TIMEOUT_MS = 1000;
+    
+    // Configuration reload
+    std::string config_path;
+    std::shared_ptr<const MonitoringConfig> pending_config;  ///< Validated, applied at the next tick
+    std::thread reload_thread;                 ///< Reads the file after SIGHUP
+    std::atomic<bool> reload_running{false};
+    
+public:
+    static constexpr unsigned HEARTBEAT_INTERVAL_MS = 50;  ///< Healthy threads beat at least this often
+    
+    enum class StopReason {
+        Idle,    ///< Idle timeout, or IPC could not be set up
+        Signal   ///< SIGTERM or SIGINT
+    };
+    
+private:
+    // Event loop, run by the monitoring thread: signals, monitoring ticks,
+    // snapshots and the idle timeout
+    EventLoop events;
+    int tick_timer = -1;
+    int snapshot_timer = -1;
+    int idle_timer = -1;
+    int64_t tick_interval_ns = 0;  ///< Period the tick timer is armed with
+    int64_t tick_next_ns = 0;      ///< Scheduled time of the next tick
+    std::atomic<int64_t> last_command_ns{0};
+    std::atomic<bool> stopping{false};
+    std::atomic<StopReason> stop_reason{StopReason::Idle};
     
     // Monitoring thread
     std::thread monitoring_thread;
     std::atomic<bool> monitoring_running;
+    int heartbeat_timer = -1;
+    int reclaim_timer = -1;
+    
+    // Command thread, started by run(); a replacement gets a new generation
+    std::thread command_thread;
+    std::atomic<uint64_t> command_generation{0};
+    std::atomic<int> processing_slot{-1};  ///< Request slot being answered, -1 if none
+    std::mutex response_mutex;  ///< Generation check and answer of a request are one step
+    std::atomic<int64_t> command_started_ns{0};  ///< When the current command was taken, 0 while idle
+    std::atomic<bool> command_received{false};
+    std::mutex stop_mutex;
+    std::condition_variable stop_condition;
     
+    // Threads replaced after a stall keep running until their stuck call
+    // returns; the Server must outlive them
+    std::mutex threads_mutex;  ///< Guards thread replacement against shutdown
+    std::atomic<unsigned> abandoned_threads{0};
+    static constexpr int ABANDONED_WAIT_MS = 1000;
+    
+    static constexpr int64_t RECLAIM_INTERVAL_NS = 1000000000LL;  ///< How often exited clients are looked for
+    
+    void beatHeartbeats();
+    bool commandThreadBusy(int64_t now) const;
+    
+
     void initializeSharedMemory();
+    void initializeAlarmBus(bool archive_ready);
     std::string executeSET(const std::string& parameter, const std::string& value);
     std::string executeGET(const std::string& parameter);
     std::string executeALARM();
     std::string executeMONITOR(const std::string& command);
     std::string executeSTATUS();
+    void writeResponse(const std::string& response);
+    void storeResponse(SharedData::RequestSlot& slot, const std::string& response);
+    void snapshotTimer();
+    void saveSnapshot(std::unique_lock<std::timed_mutex>& state);
+    void recoverState();
+    void applyPendingConfig();
+    void startReload();
+    void initializeEventLoop();
+    void handleSignal(int signo);
+    void requestStop(StopReason reason);
+    void checkIdle();
+    
+    void commandLoop(uint64_t generation);
     
     // Monitoring thread function
-    void monitoringLoop();
+    void monitoringLoop(bool replacement = false);
+    void armTickTimer(int64_t first_ns);
+    void monitoringTick(uint64_t expirations);
+    void archiveSensorSample();
     
 public:
-    Server();
+    /**
+     * @param names IPC objects and files of this server instance
+     * @param config_path Monitoring configuration file, re-read on SIGHUP.
+     *        SIGTERM, SIGINT and SIGHUP must be blocked in every thread of
+     *        the process; the server then receives them on its event loop.
+     * @param shm_options Huge pages and locking of the command segment
+     */
+    explicit Server(const IpcNames& names = IpcNames::forInstance(),
+                    const std::string& config_path = "",
+                    const ShmOptions& shm_options = ShmOptions());
     ~Server();
     
     void processCommand(const std::string& command);
-    void run();
+    
+    /**
+     * @brief Serves client commands until stopped or idle
+     * 
+     * @return StopReason Signal after SIGTERM/SIGINT, Idle otherwise
+     */
+    StopReason run();
+    
+    /**
+     * @brief Sets the inactivity shutdown of run()
+     * 
+     * @param seconds Idle time before run() returns, 0 to never time out
+     */
+    void setIdleTimeout(unsigned seconds) { idle_timeout_s = seconds; }
+    
+    /**
+     * @brief Pins and schedules the monitoring and command threads
+     * 
+     * The monitoring policy is applied at once, the command policy while
+     * run() executes. Settings that lack privileges are logged and
+     * skipped. RealtimeConfig::lock_memory is handled by the daemon.
+     */
+    void setRealtime(const RealtimeConfig& config);
+    
+    /**
+     * @brief Loads and validates the config file, then queues it
+     * 
+     * Called on a helper thread after SIGHUP: the file is read on top of
+     * a copy of the running configuration, taken under the state lock,
+     * and the result is stored in pending_config. Nothing is applied
+     * here; the monitoring tick applies the queued configuration before
+     * it samples, so no tick sees a partially updated configuration.
+     * 
+     * @param error Receives the reason when the file is rejected, or when
+     *        a stalled command holds the state lock
+     * @return false if the file is unreadable or invalid; the running
+     *         configuration is then kept unchanged
+     */
+    bool reloadConfig(std::string& error);
     void cleanup();
     
+    /**
+     * @brief Heartbeat times of the monitoring and command threads
+     * 
+     * @return nullptr if the shared memory segment is unavailable
+     */
+    const std::atomic<int64_t>* monitoringHeartbeat() const {
+        return data != MAP_FAILED ? &data->monitoring_heartbeat.last_ns : nullptr;
+    }
+    const std::atomic<int64_t>* commandHeartbeat() const {
+        return data != MAP_FAILED ? &data->command_heartbeat.last_ns : nullptr;
+    }
+    
+    /**
+     * @brief Replaces a stalled thread, for the daemon watchdog
+     * 
+     * A thread cannot be killed safely, so the stalled one is abandoned:
+     * a new thread takes over its work and the old one exits as soon as
+     * its stuck call returns, without publishing anything. A client
+     * waiting for the stuck command gets an error response at once.
+     * 
+     * The abandoned command thread does not start another command, but
+     * the command it is stuck in runs to completion when the stuck call
+     * returns: a stalled SET still takes effect and is journaled. The
+     * error response says the outcome is unknown; read the value back.
+     * 
+     * While the stuck command still holds the server state, commands
+     * of the replacement thread are refused after STATE_LOCK_TIMEOUT_MS
+     * rather than run against a half-applied change.
+     * 
+     * restartCommands() leaves a command thread that is not inside a
+     * command alone; its heartbeat was only late because the event loop
+     * that beats it was.
+     * 
+     * @return false if the server is stopping
+     */
+    bool restartMonitoring();
+    bool restartCommands();
+    
     // Monitoring control
     void startMonitoring();
     void stopMonitoring();
@@ -3,13 +3,38 @@
 #include "Server.h"
 
 class ServerDaemon : public DaemonBase {
+private:
+    IpcNames names_;           ///< Instance resources, passed to each Server
+    unsigned idle_timeout_s_;  ///< Passed to Server::setIdleTimeout, 0 = persistent
+    std::string config_path_;  ///< Monitoring configuration, re-read on SIGHUP
+    RealtimeConfig realtime_;
+    ShmOptions shm_options_;
+    
 protected:
     void mainLoop() override;
     void cleanup() override;
     
 public:
-    ServerDaemon();
+    /**
+     * @param names IPC objects, pid file and logs of this instance
+     * @param idle_timeout_s Seconds without commands before the server is
+     *        rebuilt, 0 to keep one persistent server until the daemon stops
+     * @param config_path Monitoring configuration file, empty for none
+     */
+    explicit ServerDaemon(const IpcNames& names = IpcNames::forInstance(),
+                          unsigned idle_timeout_s = DEFAULT_IDLE_TIMEOUT_S,
+                          const std::string& config_path = "");
     ~ServerDaemon() override;
     
-    static void signalHandlerWrapper(int signum);
+    /**
+     * @brief Sets thread pinning, scheduling and memory locking
+     * 
+     * Takes effect in the daemon process; call before start().
+     */
+    void setRealtime(const RealtimeConfig& config) { realtime_ = config; }
+    
+    /**
+     * @brief Sets huge page backing and locking of the command segment
+     */
+    void setShmOptions(const ShmOptions& options) { shm_options_ = options; }
 };
\ No newline at end of file
@@ -1,16 +1,150 @@
 #pragma once
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <cstring>
+#include <string>
+#include <sched.h>
+#include <sys/types.h>
 
 inline constexpr const char* SHM_NAME = "/radio_control_memory";
 inline constexpr const char* SEM_CLIENT_NAME = "/sem_radio_client";
-inline constexpr const char* SEM_SERVER_NAME = "/sem_radio_server";
 
+inline constexpr size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * @brief Sequence lock for a block with one writer and lock-free readers
+ *
+ * The writer makes the sequence odd while it updates the block. A reader
+ * copies the block and retries when the sequence was odd or changed
+ * meanwhile, so it never sees half an update and never makes the writer
+ * wait: a dashboard polling the segment cannot delay the monitoring
+ * thread.
+ */
+struct SeqLock {
+    std::atomic<uint32_t> sequence;  ///< Odd while a write is in progress
+
+    void writeBegin() {
+        sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void writeEnd() {
+        sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Runs copy until it has seen a consistent block
+     *
+     * @param attempts Bound for a writer that died mid-update
+     * @return false if no consistent copy was made
+     */
+    template <typename Copy>
+    bool read(Copy copy, unsigned attempts = 1000) const {
+        for (unsigned i = 0; i < attempts; ++i) {
+            uint32_t before = sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                sched_yield();
+                continue;
+            }
+            copy();
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Completed writes so far
+    uint32_t writes() const { return sequence.load(std::memory_order_acquire) / 2; }
+};
+
+/**
+ * @brief Command/response segment shared by the server and its clients
+ *
+ * Every block written by a different thread or process starts on its own
+ * cache line, so a client writing a command, the command thread writing
+ * a response, the monitoring thread publishing sensors and the alarm
+ * dispatcher never invalidate each other's lines (no false sharing).
+ *
+ * The header is filled in by the server before it creates the client
+ * semaphore; clients check it so a client built against another layout
+ * refuses to attach instead of reading garbage.
+ *
+ * Commands travel in request slots, so several clients, and several
+ * requests of one client, can be outstanding at once:
+ *
+ *   1. A client claims a Connection entry once (claimConnection()).
+ *   2. Per request it claims a free slot, writes the command and
+ *      publishes it as Submitted with a new request id (submit()), then
+ *      posts the client semaphore once.
+ *   3. The command thread takes the oldest Submitted slot, answers it
+ *      and completes it (completeRequest()): the response carries the
+ *      request id back, and the connection's completion counter is
+ *      bumped and futex-woken.
+ *   4. The client reads the response and frees the slot.
+ *
+ * Slots and connections left behind by exited clients are reclaimed by
+ * the server (reclaimAbandoned()).
+ *
+ * The monitoring and command threads each have a heartbeat, beaten at
+ * least every Server::HEARTBEAT_INTERVAL_MS while they are healthy (the
+ * command heartbeat by the event loop, unless a command has been running
+ * for longer than that); the daemon watchdog and any other process can
+ * tell a stalled thread from an idle one by the age of the last beat.
+ */
 struct SharedData {
-    char command[256];
-    char response[1024];
-    
-    struct {
+    static constexpr uint32_t MAGIC = 0x52534D44;  // "RSMD"
+    static constexpr uint32_t VERSION = 5;
+    static constexpr uint32_t MAX_CONNECTIONS = 32;
+    static constexpr uint32_t REQUEST_SLOTS = 64;
+
+    struct alignas(CACHE_LINE_SIZE) Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t size;                   ///< sizeof(SharedData) of the server
+        int32_t server_pid;
+    } header;
+
+    // Request ids, shared by all clients so the server can serve in submission order
+    struct alignas(CACHE_LINE_SIZE) Requests {
+        std::atomic<uint64_t> last_id;
+    } requests;
+
+    struct alignas(CACHE_LINE_SIZE) Connection {
+        std::atomic<int32_t> owner_pid;     ///< Client process, 0 when free
+        std::atomic<uint32_t> epoch;        ///< Bumped by every claim, tells a previous owner's slots apart
+        std::atomic<uint32_t> completions;  ///< Futex word, bumped by the server after each response
+    } connections[MAX_CONNECTIONS];
+
+    enum SlotState : uint32_t {
+        SLOT_FREE = 0,
+        SLOT_CLAIMED,      ///< Client is writing the command
+        SLOT_SUBMITTED,    ///< Waiting for the command thread
+        SLOT_PROCESSING,
+        SLOT_DONE          ///< Response written, client has not read it yet
+    };
+
+    struct alignas(CACHE_LINE_SIZE) RequestSlot {
+        std::atomic<uint64_t> control;   ///< SlotState in the low half, owner token in the high half
+        uint64_t request_id;             ///< Assigned at submission
+        uint64_t response_id;            ///< request_id echoed by the server with the response
+        int64_t posted_ns;               ///< CLOCK_MONOTONIC submission time
+        char command[256];               ///< Written by the client
+        char response[1024];             ///< Written by the command thread
+
+        static uint64_t word(SlotState state, uint32_t owner) {
+            return static_cast<uint64_t>(owner) << 32 | state;
+        }
+        static SlotState stateOf(uint64_t word) { return static_cast<SlotState>(word & 0xFFFFFFFFu); }
+        static uint32_t ownerOf(uint64_t word) { return static_cast<uint32_t>(word >> 32); }
+    } slots[REQUEST_SLOTS];
+
+    // Written by the monitoring thread once per tick, under lock
+    struct alignas(CACHE_LINE_SIZE) Monitoring {
+        SeqLock lock;
         double temperature;
         double current;
         double power;
@@ -19,16 +153,197 @@ struct SharedData {
         bool service_enabled;
         char last_update[64];
     } monitoring;
-    
+
+    // Written by the alarm dispatcher, under lock
+    struct alignas(CACHE_LINE_SIZE) Alarms {
+        SeqLock lock;
+        unsigned int events;             ///< Alarms delivered by the alarm bus
+        char last[160];                  ///< Text of the most recent alarm
+    } alarms;
+
+    struct alignas(CACHE_LINE_SIZE) Heartbeat {
+        std::atomic<uint64_t> count;     ///< Beats since the server started
+        std::atomic<int64_t> last_ns;    ///< CLOCK_MONOTONIC time of the last beat
+
+        void beat(int64_t now_ns) {
+            last_ns.store(now_ns, std::memory_order_release);
+            count.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+
+    Heartbeat monitoring_heartbeat;      ///< Written by the monitoring thread
+    Heartbeat command_heartbeat;         ///< Written by the command thread
+
     SharedData() {
-        memset(command, 0, sizeof(command));
-        memset(response, 0, sizeof(response));
-        monitoring.temperature = 0.0;
-        monitoring.current = 0.0;
-        monitoring.power = 0.0;
-        monitoring.voltage = 0.0;
-        monitoring.active_alarms_count = 0;
+        memset(static_cast<void*>(this), 0, sizeof(*this));
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.size = sizeof(SharedData);
         monitoring.service_enabled = true;
-        memset(monitoring.last_update, 0, sizeof(monitoring.last_update));
     }
-};
\ No newline at end of file
+
+    bool isCompatible() const {
+        return header.magic == MAGIC && header.version == VERSION && header.size == sizeof(SharedData);
+    }
+
+    /**
+     * @brief Owner token of a connection, stored with each slot it claims
+     */
+    static uint32_t ownerToken(uint32_t connection, uint32_t epoch) {
+        return epoch << 8 | connection;
+    }
+
+    // Client side
+
+    /**
+     * @brief Takes a free connection entry for the calling process
+     *
+     * @param token Receives the owner token for claimSlot()
+     * @return int Connection index, -1 if all are taken
+     */
+    int claimConnection(uint32_t& token);
+
+    /**
+     * @brief Frees a connection and every slot it holds
+     *
+     * Slots the server is processing are left to reclaimAbandoned().
+     */
+    void releaseConnection(int connection, uint32_t token);
+
+    /**
+     * @brief Takes a free slot for the owner
+     *
+     * @param hint Slot to start searching at, spreads clients over the table
+     * @return int Slot index, -1 if all slots are in use
+     */
+    int claimSlot(uint32_t token, uint32_t hint);
+
+    /**
+     * @brief Copies the command into a claimed slot and hands it to the server
+     *
+     * The caller posts the client semaphore afterwards.
+     *
+     * @return uint64_t The request id the response will carry
+     */
+    uint64_t submit(int slot, uint32_t token, const char* command, size_t length, int64_t now_ns);
+
+    /**
+     * @brief Takes back a request the server has not picked up yet
+     *
+     * @return false if the server is already processing it
+     */
+    bool withdraw(int slot, uint32_t token);
+
+    // Server side
+
+    /**
+     * @brief Moves the oldest submitted request to processing
+     *
+     * @return int Slot index, -1 if no request is waiting
+     */
+    int takeNextRequest();
+
+    /**
+     * @brief Publishes the response in a processing slot and wakes its client
+     */
+    void completeRequest(int slot);
+
+    /**
+     * @brief Frees connections of exited processes and slots nobody will read
+     *
+     * @return unsigned Number of connections reclaimed
+     */
+    unsigned reclaimAbandoned();
+};
+
+static_assert(offsetof(SharedData, requests) % CACHE_LINE_SIZE == 0 &&
+              offsetof(SharedData, connections) % CACHE_LINE_SIZE == 0 &&
+              offsetof(SharedData, slots) % CACHE_LINE_SIZE == 0 &&
+              sizeof(SharedData::RequestSlot) % CACHE_LINE_SIZE == 0 &&
+              offsetof(SharedData, monitoring) % CACHE_LINE_SIZE == 0 &&
+              offsetof(SharedData, alarms) % CACHE_LINE_SIZE == 0 &&
+              offsetof(SharedData, command_heartbeat) % CACHE_LINE_SIZE == 0,
+              "writer domains of SharedData must not share cache lines");
+static_assert(SharedData::MAX_CONNECTIONS <= 256, "connection index must fit the low byte of an owner token");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex words must be plain 32-bit integers");
+
+/**
+ * @brief Wakes every process waiting on a futex word in shared memory
+ */
+void futexWake(std::atomic<uint32_t>& word);
+
+/**
+ * @brief Sleeps while a shared futex word still holds the expected value
+ *
+ * @param timeout_ns Relative timeout, negative to wait without limit
+ * @return false on timeout; true when woken, interrupted or the value
+ *         had already changed
+ */
+bool futexWait(std::atomic<uint32_t>& word, uint32_t expected, int64_t timeout_ns);
+
+/**
+ * @brief How the server backs and pins the segment
+ */
+struct ShmOptions {
+    bool hugepages = false;  ///< Use a hugetlbfs file when one is mounted
+    bool lock = false;       ///< mlock() the mapping
+};
+
+/**
+ * @brief Creates or attaches the SharedData segment of an instance
+ *
+ * @ingroup CommunicationClasses
+ *
+ * The segment is a POSIX shared memory object, or with
+ * ShmOptions::hugepages a file of the same name under HUGETLBFS_DIR;
+ * attach() looks for the hugetlbfs file first. Mappings are made with
+ * MAP_POPULATE so neither side takes page faults on the first command.
+ */
+class SharedSegment {
+public:
+    static constexpr const char* HUGETLBFS_DIR = "/dev/hugepages";
+
+    SharedSegment() = default;
+    ~SharedSegment() { unmap(); }
+
+    SharedSegment(const SharedSegment&) = delete;
+    SharedSegment& operator=(const SharedSegment&) = delete;
+
+    /**
+     * @brief Creates a fresh segment and constructs SharedData in it
+     *
+     * @param warning Receives options that could not be honoured; the
+     *        segment is still usable
+     * @return false with error if no segment could be created
+     */
+    bool create(const std::string& name, const ShmOptions& options,
+                std::string& error, std::string& warning);
+
+    /**
+     * @brief Maps an existing segment and checks its header
+     *
+     * @param writable false maps it PROT_READ, for observers that only
+     *        read the monitoring blocks
+     */
+    bool attach(const std::string& name, std::string& error, bool writable = true);
+
+    void unmap();
+
+    /**
+     * @brief Removes both possible backings of a segment name
+     */
+    static void unlink(const std::string& name);
+
+    SharedData* data() const { return data_; }
+    bool hugepages() const { return hugepages_; }
+    bool locked() const { return locked_; }
+
+private:
+    static std::string hugepagePath(const std::string& name);
+    bool map(int fd, size_t length, bool create, bool writable, std::string& error);
+
+    SharedData* data_ = nullptr;
+    size_t length_ = 0;
+    bool hugepages_ = false;
+    bool locked_ = false;
+};
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+inline constexpr const char* STATS_SHM_NAME = "/radio_control_stats";
+
+/**
+ * @brief Log-linear latency histogram in the HDR histogram layout
+ *
+ * Values below 16 get one bucket each; above that every power of two is
+ * split into 16 linear sub-buckets, so any recorded value is reported
+ * within 1/16 (6.25%) of its true value over the full 64-bit range with
+ * a fixed 976 buckets. Recording is one relaxed atomic increment per
+ * bucket and counter, so readers in another process can take snapshots
+ * while the server writes.
+ */
+struct LatencyHistogram {
+    static constexpr unsigned SUB_BUCKET_BITS = 4;
+    static constexpr uint64_t SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+    static constexpr size_t BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> max;
+    std::atomic<uint64_t> buckets[BUCKETS];
+
+    void record(uint64_t value);
+
+    /**
+     * @brief Value at or below which the given fraction of samples fall
+     *
+     * @param quantile Fraction in [0, 1], e.g. 0.999
+     * @return uint64_t Upper edge of the bucket holding that rank
+     */
+    uint64_t percentile(double quantile) const;
+
+    double mean() const;
+
+    static size_t bucketIndex(uint64_t value);
+    static uint64_t bucketUpper(size_t index);
+};
+
+/**
+ * @brief Instrumented server paths
+ */
+enum class StatsMetric : uint32_t {
+    Command,         ///< Server::processCommand, any command
+    Set,
+    Get,
+    Alarm,
+    Monitor,
+    Status,
+    MonitoringTick,  ///< One monitoring loop iteration
+    TickSample,      ///< Monitoring phases: sensor update
+    TickArchive,     ///< Telemetry archive append
+    TickEvaluate,    ///< Threshold and detector checks
+    TickPublish,     ///< Copy into the IPC shared memory
+    TickJitter,      ///< Monitoring wakeup delay behind schedule
+    Count
+};
+
+/**
+ * @brief Statistics segment shared by the server with read-only readers
+ *
+ * @ingroup MonitoringClasses
+ *
+ * Created by Server in its own POSIX shared memory object
+ * (STATS_SHM_NAME). Only the server maps it writable; tools such as
+ * radio-stats map it PROT_READ and never synchronize with the server,
+ * so reading the page cannot slow down command processing. Latencies
+ * are in nanoseconds.
+ */
+struct StatsPage {
+    static constexpr uint32_t MAGIC = 0x52535450;  // "RSTP"
+    static constexpr uint32_t VERSION = 2;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;                       ///< sizeof(StatsPage) of the writer
+    int32_t pid;                         ///< Server process
+    int64_t start_time_ms;               ///< Server start, wall clock
+
+    std::atomic<uint64_t> commands_total;
+    std::atomic<uint64_t> commands_failed;  ///< Responses starting with "ERROR"
+    std::atomic<uint64_t> monitoring_overruns;  ///< Ticks longer than the polling interval
+
+    LatencyHistogram histograms[static_cast<size_t>(StatsMetric::Count)];
+
+    LatencyHistogram& histogram(StatsMetric metric) {
+        return histograms[static_cast<size_t>(metric)];
+    }
+    const LatencyHistogram& histogram(StatsMetric metric) const {
+        return histograms[static_cast<size_t>(metric)];
+    }
+
+    /**
+     * @brief Creates and maps the segment for writing, zero-initialized
+     *
+     * @return StatsPage* Mapped page, or nullptr on failure
+     */
+    static StatsPage* create(const char* name = STATS_SHM_NAME);
+
+    /**
+     * @brief Maps an existing segment read-only and checks its header
+     *
+     * @return const StatsPage* Mapped page, or nullptr if missing or invalid
+     */
+    static const StatsPage* openReadOnly(const char* name = STATS_SHM_NAME);
+
+    /**
+     * @brief Unmaps a page returned by create() or openReadOnly()
+     */
+    static void unmap(const StatsPage* page);
+
+    /**
+     * @brief Unmaps and removes the segment created by create()
+     */
+    static void destroy(StatsPage* page, const char* name = STATS_SHM_NAME);
+
+    static const char* metricName(StatsMetric metric);
+};
+
+/**
+ * @brief Records the lifetime of a scope into a histogram
+ *
+ * Does nothing when the page is nullptr (stats segment unavailable).
+ */
+class StatsTimer {
+public:
+    StatsTimer(StatsPage* page, StatsMetric metric)
+        : histogram_(page ? &page->histogram(metric) : nullptr),
+          start_(std::chrono::steady_clock::now()) {}
+
+    ~StatsTimer() {
+        if (histogram_) {
+            histogram_->record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start_).count()));
+        }
+    }
+
+    StatsTimer(const StatsTimer&) = delete;
+    StatsTimer& operator=(const StatsTimer&) = delete;
+
+private:
+    LatencyHistogram* histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
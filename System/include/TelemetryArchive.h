@@ -0,0 +1,215 @@
+/**
+ * @file TelemetryArchive.h
+ * @brief Append-only compressed on-disk archive of monitoring sensor samples
+ *
+ * @ingroup MonitoringClasses
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <mutex>
+
+/**
+ * @brief Bit-level writer used by the Gorilla encoder
+ */
+class BitWriter {
+public:
+    void writeBit(bool bit);
+    void writeBits(uint64_t value, int count);
+    const std::vector<uint8_t>& bytes() const { return bytes_; }
+    size_t bitCount() const { return bit_count_; }
+    void clear();
+
+private:
+    std::vector<uint8_t> bytes_;
+    size_t bit_count_ = 0;
+};
+
+/**
+ * @brief Bit-level reader over a byte range
+ */
+class BitReader {
+public:
+    BitReader(const uint8_t* data, size_t size);
+    bool readBit();
+    uint64_t readBits(int count);
+    bool exhausted() const { return pos_ >= size_ * 8; }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t pos_ = 0;
+};
+
+/**
+ * @brief Gorilla-style encoder for one (timestamp, value) series block
+ *
+ * Timestamps use delta-of-delta encoding, values use XOR of consecutive
+ * IEEE-754 doubles with leading/trailing zero windows. Regular sampling
+ * and slowly changing values typically cost 1-2 bits for the timestamp
+ * and a handful of bits for the value.
+ */
+class GorillaEncoder {
+public:
+    void append(int64_t timestamp_ms, double value);
+    void clear();
+
+    uint32_t count() const { return count_; }
+    int64_t firstTimestamp() const { return first_ts_; }
+    int64_t lastTimestamp() const { return prev_ts_; }
+    const std::vector<uint8_t>& bytes() const { return writer_.bytes(); }
+
+private:
+    BitWriter writer_;
+    uint32_t count_ = 0;
+    int64_t first_ts_ = 0;
+    int64_t prev_ts_ = 0;
+    int64_t prev_delta_ = 0;
+    uint64_t prev_value_ = 0;
+    int prev_leading_ = -1;
+    int prev_trailing_ = 0;
+};
+
+/**
+ * @brief Decoder matching GorillaEncoder
+ */
+class GorillaDecoder {
+public:
+    GorillaDecoder(const uint8_t* data, size_t size, uint32_t count);
+
+    /**
+     * @brief Decodes the next point
+     * @return false when all points have been read
+     */
+    bool next(int64_t& timestamp_ms, double& value);
+
+private:
+    BitReader reader_;
+    uint32_t remaining_;
+    uint32_t index_ = 0;
+    int64_t prev_ts_ = 0;
+    int64_t prev_delta_ = 0;
+    uint64_t prev_value_ = 0;
+    int prev_leading_ = 0;
+    int prev_trailing_ = 0;
+};
+
+/**
+ * @brief Append-only archive of the monitoring sensor stream and alarms
+ *
+ * Samples are buffered per series in a GorillaEncoder and written as
+ * self-describing blocks to time-partitioned files
+ * (<directory>/<partition start ms>.gta). Queries memory-map the
+ * partitions overlapping the requested range and skip whole blocks
+ * outside of it using the block header, so a range scan only decodes
+ * the blocks it needs.
+ *
+ * Besides the four sensor series there is one alarm series per alarm
+ * source ("alarm_temperature", ..., "alarm_radio") holding the sensor
+ * value at each alarm. Alarms are rare, so each is written as its own
+ * block right away instead of waiting in the buffer.
+ *
+ * A block that was being written when the process died is detected
+ * by its length; open() cuts it off so later blocks follow the last
+ * complete one.
+ */
+class TelemetryArchive {
+public:
+    /**
+     * @brief Decoded archive point
+     */
+    struct Point {
+        int64_t timestamp_ms;
+        double value;
+    };
+
+    static constexpr int64_t DEFAULT_PARTITION_MS = 24LL * 60 * 60 * 1000;
+    static constexpr uint32_t DEFAULT_BLOCK_SAMPLES = 256;
+
+    /**
+     * @brief Constructs an archive rooted at directory
+     *
+     * @param directory Directory holding the partition files
+     * @param partition_ms Time span covered by one partition file
+     * @param block_samples Samples per series buffered before a block is written
+     */
+    TelemetryArchive(const std::string& directory,
+                     int64_t partition_ms = DEFAULT_PARTITION_MS,
+                     uint32_t block_samples = DEFAULT_BLOCK_SAMPLES);
+
+    /**
+     * @brief Flushes all buffered blocks
+     */
+    ~TelemetryArchive();
+
+    /**
+     * @brief Creates the archive directory if needed and truncates torn
+     *        blocks left at the end of existing partitions
+     * @return true if the archive can be written
+     */
+    bool open();
+
+    /**
+     * @brief Appends a sample of a sensor or an alarm
+     *
+     * @param sensor Series name: temperature, current, power, voltage, or
+     *        alarm_ followed by one of them or radio
+     * @param timestamp_ms Sample time in milliseconds since epoch
+     * @param value Sensor value
+     * @return false for unknown sensors or when the archive is not open
+     */
+    bool append(const std::string& sensor, int64_t timestamp_ms, double value);
+
+    /**
+     * @brief Writes all buffered blocks to disk
+     */
+    void flush();
+
+    /**
+     * @brief Reads all points of a series in [from_ms, to_ms]
+     *
+     * @return size_t Number of points appended to out
+     */
+    size_t query(const std::string& sensor, int64_t from_ms, int64_t to_ms,
+                 std::vector<Point>& out) const;
+
+    /**
+     * @brief Bytes written to partition files since open()
+     */
+    uint64_t bytesWritten() const;
+
+    /**
+     * @brief Samples appended since open()
+     */
+    uint64_t samplesWritten() const;
+
+    const std::string& directory() const { return directory_; }
+
+private:
+    static constexpr size_t SENSOR_SERIES = 4;
+    static constexpr size_t SERIES_COUNT = 9;  ///< Sensors, then alarm series
+
+    struct Series {
+        GorillaEncoder encoder;
+        int64_t partition = 0;
+    };
+
+    std::string directory_;
+    int64_t partition_ms_;
+    uint32_t block_samples_;
+    bool open_ = false;
+
+    Series series_[SERIES_COUNT];
+    uint64_t bytes_written_ = 0;
+    uint64_t samples_written_ = 0;
+
+    mutable std::mutex mutex_;
+
+    static int seriesIndex(const std::string& sensor);
+    std::string partitionPath(int64_t partition) const;
+    void writeBlock(uint16_t series, Series& s);
+};
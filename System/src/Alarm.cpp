@@ -1,17 +1,23 @@
 #include "../include/ALARM.h"
+#include <algorithm>
+#include <iostream>
 
 /**
  * @brief ALARM constructor
  */
-ALARM::ALARM(SystemData& system_data) : System(system_data) {}
+ALARM::ALARM(SystemData& system_data) : System(system_data) {
+    installDefaultRules();
+}
 
 /**
  * @brief Checks all alarms
  */
 void ALARM::checkAllAlarms() {
-    checkTemperatureAlarms();
-    checkOutputPowerAlarms();
-    checkInputPowerAlarms();
+    double values[AlarmRuleEngine::VARIABLE_COUNT];
+    data.ruleValues(values);
+    data.alarm_rules.evaluate(RuleDomain::Radio, values, 0, [&](const CompiledRule& rule) {
+        triggerAlarm(rule.source.message, rule.source.severity);
+    });
 }
 
 /**
@@ -23,49 +29,44 @@ void ALARM::updateAndCheckAlarms() {
 }
 
 /**
- * @brief Checks temperature alarms
- */
-void ALARM::checkTemperatureAlarms() {
-    // High temperature check
-    if (data.temp > 80 && data.temp <= 100) {
-        triggerAlarm("Warning: Temperature approaching critical levels (>80C)");
-    } else if (data.temp > 100 && data.temp <= 110) {
-        triggerAlarm("Error: Dangerous temperature (>100C)");
-    } else if (data.temp > 110) {
-        triggerAlarm("Critical: Critical temperature (>110C)");
-    }
-
-    if (data.temp < -20 && data.temp >= -30) {
-        triggerAlarm("Warning: Temperature approaching critical levels (<-20C)");
-    } else if (data.temp < -30 && data.temp >= -40) {
-        triggerAlarm("Error: Dangerous temperature (<-30C)");
-    } else if (data.temp < -40) {
-        triggerAlarm("Critical: Critical temperature (<-40C)");
-    }
-}
-
-/**
- * @brief Checks output power alarms
+ * @brief Installs the built-in radio rules that are not defined yet
  */
-void ALARM::checkOutputPowerAlarms() {
-    if (std::abs(data.real_output_power - data.nominal_output_power) > 2) {
-        triggerAlarm("Warning: Output power deviation >2dB");
-    }
+void ALARM::installDefaultRules() {
+    // Groups keep one temperature alarm per direction, most severe first
+    static const AlarmRule defaults[] = {
+        {"radio_temp_high_critical", "CRITICAL", "temp > 110",
+         "Critical: Critical temperature (>110C)", "radio_temp_high"},
+        {"radio_temp_high_error", "ERROR", "temp > 100",
+         "Error: Dangerous temperature (>100C)", "radio_temp_high"},
+        {"radio_temp_high_warning", "WARNING", "temp > 80",
+         "Warning: Temperature approaching critical levels (>80C)", "radio_temp_high"},
+        {"radio_temp_low_critical", "CRITICAL", "temp < -40",
+         "Critical: Critical temperature (<-40C)", "radio_temp_low"},
+        {"radio_temp_low_error", "ERROR", "temp < -30",
+         "Error: Dangerous temperature (<-30C)", "radio_temp_low"},
+        {"radio_temp_low_warning", "WARNING", "temp < -20",
+         "Warning: Temperature approaching critical levels (<-20C)", "radio_temp_low"},
+        {"radio_output_deviation", "WARNING", "abs(real_output_power - nominal_output_power) > 2",
+         "Warning: Output power deviation >2dB", ""},
+        {"radio_output_range", "ERROR", "real_output_power < -2 || real_output_power > 12",
+         "Error: Output power outside safe range (<-2dB or >12dB)", ""},
+        {"radio_input_low", "WARNING", "input_power < -30",
+         "Warning: Input power below -30dB", ""},
+        {"radio_input_high", "ERROR", "input_power > 0",
+         "Error: Input power above 0dB", ""},
+    };
 
-    if (data.real_output_power < -2 || data.real_output_power > 12) {
-        triggerAlarm("Error: Output power outside safe range (<-2dB or >12dB)");
-    }
-}
-
-/**
- * @brief Checks input power alarms
- */
-void ALARM::checkInputPowerAlarms() {
-    if (data.input_power < -30) {
-        triggerAlarm("Warning: Input power below -30dB");
+    std::vector<AlarmRule> rules = data.alarm_rules.rules();
+    for (const auto& rule : defaults) {
+        bool defined = std::any_of(rules.begin(), rules.end(),
+                                   [&](const AlarmRule& r) { return r.name == rule.name; });
+        if (!defined) {
+            rules.push_back(rule);
+        }
     }
 
-    if (data.input_power > 0) {
-        triggerAlarm("Error: Input power above 0dB");
+    std::string error;
+    if (!data.alarm_rules.load(rules, error)) {
+        std::cerr << "Failed to compile alarm rules: " << error << std::endl;
     }
 }
\ No newline at end of file
@@ -4,77 +4,41 @@
  */
 
 #include "../include/Client.h"
-#include <thread>
-#include <chrono>
 #include <syslog.h>
 
 /**
  * @brief Constructs a new Client object
  */
-Client::Client() : sem_client(nullptr), sem_server(nullptr), shm_fd(-1), data(nullptr) {
+Client::Client(const IpcNames& names)
+    : radio(names), names(names) {
 }
 
 /**
  * @brief Destroys the Client object and cleans up resources
  */
 Client::~Client() {
-    cleanup();
 }
 
-/**
- * @brief Initializes shared memory connection to server
- * @return true if initialization successful, false otherwise
- */
-bool Client::initializeSharedMemory() {
+bool Client::connect(int timeout_ms, std::string& error) {
+    if (radio.isConnected()) {
+        return true;
+    }
     syslog(LOG_INFO, "Client connecting to server...");
     
-    int attempts = 0;
-    const int max_attempts = 10;
-    
-    while (attempts < max_attempts) {
-        sem_client = sem_open(SEM_CLIENT_NAME, 0);
-        sem_server = sem_open(SEM_SERVER_NAME, 0);
-
-        if (sem_client != SEM_FAILED && sem_server != SEM_FAILED) {
-            break;
-        }
-        
-        if (sem_client == SEM_FAILED) {
-            std::cout << "Waiting for server semaphores... (" << attempts + 1 << "/" << max_attempts << ")" << std::endl;
-        }
-        
-        if (sem_client != SEM_FAILED) sem_close(sem_client);
-        if (sem_server != SEM_FAILED) sem_close(sem_server);
-        
-        sleep(1);
-        attempts++;
-    }
-
-    if (sem_client == SEM_FAILED || sem_server == SEM_FAILED) {
-        std::cerr << "Error: Server is not running! (could not open semaphores)" << std::endl;
-        return false;
-    }
-
-    shm_fd = shm_open(SHM_NAME, O_RDWR, 0666);
-    if (shm_fd == -1) {
-        std::cerr << "Error: Cannot open shared memory!" << std::endl;
-        sem_close(sem_client);
-        sem_close(sem_server);
-        return false;
-    }
+    // stderr: stdout carries only results in one-shot and batch mode
+    return radio.connect(timeout_ms, error, [this]() {
+        std::cerr << "Waiting for server"
+                  << (names.instance.empty() ? "" : " instance " + names.instance) << "..." << std::endl;
+    });
+}
 
-    data = static_cast<SharedData*>(
-        mmap(0, sizeof(SharedData), PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0));
-        
-    if (data == MAP_FAILED) {
-        std::cerr << "Error: Cannot map shared memory!" << std::endl;
-        close(shm_fd);
-        sem_close(sem_client);
-        sem_close(sem_server);
+bool Client::execute(const std::string& command, std::string& response, std::string& error) {
+    RadioResponse result = radio.execute(command);
+    if (!result.answered()) {
+        error = result.error;
         return false;
     }
-    
-    std::cout << "Successfully connected to server" << std::endl;
+    response = result.response;
     return true;
 }
 
@@ -83,7 +47,7 @@ bool Client::initializeSharedMemory() {
  */
 void Client::showHelp() {
     std::cout << "\n=== Radio Control System Commands ===" << std::endl;
-    std::cout << "Note: Server has 90-second inactivity timeout" << std::endl;
+    std::cout << "Note: Unless started with --persistent, the server restarts after inactivity" << std::endl;
     
     std::cout << "\nSET commands:" << std::endl;
     std::cout << "  SET nominal_output_power <0-10>    - Set output power in dBm" << std::endl;
@@ -106,11 +70,23 @@ void Client::showHelp() {
     std::cout << "  MONITOR ALARMS              - List active alarms" << std::endl;
     std::cout << "  MONITOR CONFIG GET <param>  - Get monitoring parameter" << std::endl;
     std::cout << "  MONITOR CONFIG SET <param> <value> - Set monitoring parameter" << std::endl;
+    std::cout << "    detector_<sensor> <static/zscore/mad>, detector_threshold_<sensor> <value>" << std::endl;
     std::cout << "  MONITOR ALARM ACK <id>      - Acknowledge alarm" << std::endl;
     std::cout << "  MONITOR SERVICE <on/off>    - Enable/disable monitoring service" << std::endl;
     std::cout << "  MONITOR UPDATE              - Force sensor update" << std::endl;
     std::cout << "  MONITOR CHECK               - Check thresholds" << std::endl;
     std::cout << "  MONITOR CLEAR               - Clear acknowledged alarms" << std::endl;
+    std::cout << "  MONITOR HISTORY <sensor> <from> <to> <step> - Sensor history (seconds ago, step in s)" << std::endl;
+    std::cout << "  MONITOR ARCHIVE <sensor> <from> <to> - Archived samples summary (seconds ago)," << std::endl;
+    std::cout << "                                         alarm_<sensor> for archived alarms" << std::endl;
+    std::cout << "  MONITOR STATS [sensor|RESET] - Streaming sensor statistics" << std::endl;
+    std::cout << "  MONITOR RULES [prefix]      - List alarm rules" << std::endl;
+    std::cout << "  MONITOR RULE ADD <name> <severity> <expr> - Add alarm rule" << std::endl;
+    std::cout << "    e.g. RULE ADD hot WARNING temperature > 60 && current > 7" << std::endl;
+    std::cout << "  MONITOR RULE DEL <name>     - Remove alarm rule" << std::endl;
+    std::cout << "  MONITOR TRACE DUMP <name>   - Write Chrome trace JSON (chrome://tracing, Perfetto)" << std::endl;
+    std::cout << "                                to a new file in the server's trace directory" << std::endl;
+    std::cout << "  MONITOR TRACE <on/off/clear> - Control span tracing" << std::endl;
     
     std::cout << "\nOther commands:" << std::endl;
     std::cout << "  ALARM                              - Check system alarms" << std::endl;
@@ -127,18 +103,23 @@ void Client::showHelp() {
  * the radio control server.
  */
 void Client::run() {
-    if (!initializeSharedMemory()) {
+    std::string error;
+    if (!connect(CONNECT_TIMEOUT_MS, error)) {
+        std::cerr << "Error: " << error << std::endl;
         return;
     }
+    std::cout << "Successfully connected to server" << std::endl;
 
     std::cout << "Radio Control Client connected to server." << std::endl;
-    std::cout << "Server will timeout after 90 seconds of inactivity." << std::endl;
+    std::cout << "A server started without --persistent restarts after inactivity." << std::endl;
     showHelp();
 
     while (true) {
         std::cout << "\nEnter command: ";
         std::string cmd;
-        std::getline(std::cin, cmd);
+        if (!std::getline(std::cin, cmd)) {
+            break;
+        }
 
         if (cmd == "EXIT" || cmd == "exit" || cmd == "quit") {
             break;
@@ -153,47 +134,23 @@ void Client::run() {
             continue;
         }
 
-        strncpy(data->command, cmd.c_str(), sizeof(data->command) - 1);
-        data->command[sizeof(data->command) - 1] = '\0';
-
-        sem_post(sem_client);
-
-        std::cout << "Waiting for server response..." << std::endl;
-        
-        struct timespec ts;
-        if (clock_gettime(CLOCK_REALTIME, &ts) == -1) {
-            std::cerr << "Error getting current time" << std::endl;
+        if (cmd.size() > MAX_COMMAND_LENGTH) {
+            std::cout << "Error: Command longer than " << MAX_COMMAND_LENGTH << " characters" << std::endl;
             continue;
         }
-        ts.tv_sec += 5;
+
+        std::cout << "Waiting for server response..." << std::endl;
         
-        if (sem_timedwait(sem_server, &ts) == 0) {
+        std::string response;
+        if (execute(cmd, response, error)) {
             std::cout << "\n=== Server Response ===" << std::endl;
-            std::cout << data->response << std::endl;
+            std::cout << response << std::endl;
             std::cout << "=======================" << std::endl;
         } else {
-            std::cout << "Error: Server response timeout (server may be inactive)" << std::endl;
+            std::cout << "Error: " << error << std::endl;
             break;
         }
     }
 
     std::cout << "Client disconnected." << std::endl;
 }
-
-/**
- * @brief Cleans up shared memory and semaphores
- */
-void Client::cleanup() {
-    if (data != MAP_FAILED) {
-        munmap(data, sizeof(SharedData));
-    }
-    if (shm_fd != -1) {
-        close(shm_fd);
-    }
-    if (sem_client != SEM_FAILED) {
-        sem_close(sem_client);
-    }
-    if (sem_server != SEM_FAILED) {
-        sem_close(sem_server);
-    }
-}
\ No newline at end of file
@@ -0,0 +1,120 @@
+/**
+ * @file CommandOutput.cpp
+ * @brief Result printing and batch execution of the command-line client
+ */
+
+#include "../include/CommandOutput.h"
+#include <deque>
+#include <future>
+#include <iomanip>
+#include <sstream>
+#include <utility>
+
+std::string jsonString(const std::string& str) {
+    std::ostringstream out;
+    out << '"';
+    for (unsigned char c : str) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (c == '\n') {
+            out << "\\n";
+        } else if (c < 0x20) {
+            out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c)
+                << std::dec << std::setfill(' ');
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+    return out.str();
+}
+
+ExitStatus printResult(std::ostream& out, std::ostream& err, OutputFormat format,
+                       const std::string& command, const RadioResponse& result) {
+    ExitStatus status = result.ok() ? EXIT_OK : EXIT_COMMAND_FAILED;
+    // A command that was never sent (too long) fails alone; anything
+    // else without a response means the server is gone or stuck
+    if (!result.answered() && result.status != RequestStatus::Invalid) {
+        status = EXIT_UNAVAILABLE;
+    }
+
+    if (format == OutputFormat::Text) {
+        if (!result.answered()) {
+            err << "Error: " << result.error << std::endl;
+        } else {
+            out << result.response << '\n';
+        }
+        return status;
+    }
+
+    out << "{\"command\":" << jsonString(command)
+        << ",\"ok\":" << (result.ok() ? "true" : "false");
+    if (!result.answered()) {
+        out << ",\"error\":" << jsonString(result.error);
+    } else {
+        out << ",\"request_id\":" << result.request_id
+            << ",\"response\":" << jsonString(result.response)
+            << ",\"latency_us\":" << std::fixed << std::setprecision(1) << result.latency_ns / 1000.0;
+        out.unsetf(std::ios::floatfield);
+    }
+    out << "}\n";
+    return status;
+}
+
+ExitStatus runBatch(RadioClient& client, std::istream& input, std::ostream& out, std::ostream& err,
+                    const BatchOptions& options) {
+    ExitStatus status = EXIT_OK;
+    std::deque<std::pair<std::string, std::future<RadioResponse>>> in_flight;
+
+    // Prints the oldest result; false once the server stopped answering
+    auto completeOldest = [&]() {
+        ExitStatus result = printResult(out, err, options.format, in_flight.front().first,
+                                        in_flight.front().second.get());
+        in_flight.pop_front();
+        if (result != EXIT_OK) {
+            status = result;
+        }
+        return result != EXIT_UNAVAILABLE;
+    };
+
+    std::string line;
+    while (true) {
+        // Everything sent is answered and flushed whenever the next read
+        // may block, so a producer feeding commands one at a time sees
+        // each answer
+        if (input.rdbuf()->in_avail() <= 0) {
+            while (!in_flight.empty()) {
+                if (!completeOldest()) return status;
+            }
+            out.flush();
+        }
+        if (!std::getline(input, line)) {
+            break;
+        }
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        size_t first = line.find_first_not_of(" \t");
+        if (first == std::string::npos || line[first] == '#') {
+            continue;
+        }
+
+        std::string command = line.substr(first);
+        std::future<RadioResponse> result;
+        if (options.pipeline == 1) {
+            // Strictly one at a time: execute() skips the completion thread
+            std::promise<RadioResponse> answered;
+            answered.set_value(client.execute(command, options.timeout_ms));
+            result = answered.get_future();
+        } else {
+            result = client.submit(command, options.timeout_ms);
+        }
+        in_flight.emplace_back(std::move(command), std::move(result));
+        if (in_flight.size() >= options.pipeline && !completeOldest()) {
+            return status;
+        }
+    }
+
+    while (!in_flight.empty()) {
+        if (!completeOldest()) break;
+    }
+    return status;
+}
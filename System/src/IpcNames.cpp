@@ -0,0 +1,55 @@
+/**
+ * @file IpcNames.cpp
+ * @brief Per-instance names of IPC objects and files
+ */
+
+#include "../include/IpcNames.h"
+#include "../include/SharedData.h"
+#include "../include/StatsPage.h"
+#include <cctype>
+#include <cstdlib>
+
+IpcNames IpcNames::forInstance(const std::string& instance) {
+    std::string suffix = instance.empty() ? "" : "." + instance;
+    
+    IpcNames names;
+    names.instance = instance;
+    names.shm = SHM_NAME + suffix;
+    names.sem_client = SEM_CLIENT_NAME + suffix;
+    names.stats_shm = STATS_SHM_NAME + suffix;
+    names.pid_file = "/tmp/radio_server" + suffix + ".pid";
+    names.log_ident = "radio_server" + suffix;
+    names.stdout_log = "/tmp/radio_server" + suffix + "_stdout.log";
+    names.stderr_log = "/tmp/radio_server" + suffix + "_stderr.log";
+    names.snapshot = "/tmp/radio_snapshot" + suffix + ".bin";
+    names.wal = "/tmp/radio_config" + suffix + ".wal";
+    names.archive_dir = "/tmp/radio_archive" + suffix;
+    names.trace_dir = "/tmp/radio_traces" + suffix;
+    return names;
+}
+
+bool IpcNames::resolveInstance(const std::string& cli_value, std::string& instance, std::string& error) {
+    instance = cli_value;
+    if (instance.empty()) {
+        const char* env = std::getenv(INSTANCE_ENV);
+        instance = env ? env : "";
+    }
+    
+    if (!instance.empty() && !isValidInstance(instance)) {
+        error = "Invalid instance name '" + instance + "' (use 1-32 of A-Z a-z 0-9 _ -)";
+        return false;
+    }
+    return true;
+}
+
+bool IpcNames::isValidInstance(const std::string& instance) {
+    if (instance.empty() || instance.size() > 32) {
+        return false;
+    }
+    for (char c : instance) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '-') {
+            return false;
+        }
+    }
+    return true;
+}
@@ -1,14 +1,35 @@
 #include "../include/MONITOR.h"
+#include "../../DaemonLib/include/Trace.h"
 #include <sstream>
 #include <iomanip>
 #include <ctime>
 #include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 /**
  * @brief MONITOR constructor
  */
 MONITOR::MONITOR(SystemData& system_data) : System(system_data) {}
 
+/**
+ * @brief Sets telemetry archive
+ */
+void MONITOR::setArchive(TelemetryArchive* archive) {
+    archive_ = archive;
+}
+
+/**
+ * @brief Sets the trace dump directory
+ */
+void MONITOR::setTraceDirectory(const std::string& dir) {
+    trace_dir_ = dir;
+}
+
 /**
  * @brief Executes monitoring command
  */
@@ -34,8 +55,16 @@ std::string MONITOR::execute(const std::string& command) {
             std::string value;
             std::getline(ss, value);
             if (!value.empty() && value[0] == ' ') value = value.substr(1);
-            return handleConfigSet(param2, value) ? 
-                   "SUCCESS: Parameter set" : "ERROR: Failed to set parameter";
+            ConfigState previous = saveConfig();
+            std::string error;
+            if (!handleConfigSet(param2, value, error)) {
+                return "ERROR: Failed to set parameter: " + error;
+            }
+            if (data.wal && !data.wal->appendDurable(WriteAheadLog::RecordType::MonitorConfig, param2, value)) {
+                restoreConfig(previous);
+                return "ERROR: Parameter could not be journaled, previous value kept";
+            }
+            return "SUCCESS: Parameter set";
         }
     }
     else if (action == "ALARM") {
@@ -57,8 +86,39 @@ std::string MONITOR::execute(const std::string& command) {
     else if (action == "CLEAR") {
         return handleClear();
     }
+    else if (action == "HISTORY") {
+        std::string param3, param4;
+        ss >> param3 >> param4;
+        return handleHistory(param1, param2, param3, param4);
+    }
+    else if (action == "ARCHIVE") {
+        std::string param3;
+        ss >> param3;
+        return handleArchive(param1, param2, param3);
+    }
+    else if (action == "STATS") {
+        return handleStats(param1);
+    }
+    else if (action == "RULES") {
+        return handleRules(param1);
+    }
+    else if (action == "RULE") {
+        if (param1 == "ADD") {
+            std::string severity, expression;
+            ss >> severity;
+            std::getline(ss, expression);
+            return handleRuleAdd(param2, severity, expression);
+        }
+        else if (param1 == "DEL") {
+            return data.alarm_rules.removeRule(param2) ?
+                   "SUCCESS: Rule removed" : "ERROR: Rule not found";
+        }
+    }
+    else if (action == "TRACE") {
+        return handleTrace(param1, param2);
+    }
     
-    return "ERROR: Unknown MONITOR command. Use: STATUS, SENSORS, ALARMS, CONFIG, ALARM ACK, SERVICE, UPDATE, CHECK, CLEAR";
+    return "ERROR: Unknown MONITOR command. Use: STATUS, SENSORS, ALARMS, CONFIG, ALARM ACK, SERVICE, UPDATE, CHECK, CLEAR, HISTORY, ARCHIVE, STATS, RULES, RULE ADD/DEL, TRACE";
 }
 
 std::string MONITOR::handleStatus() const {
@@ -72,15 +132,41 @@ std::string MONITOR::handleStatus() const {
        << "=======================\n"
        << "Service: " << (data.monitoring.service_enabled ? "ENABLED" : "DISABLED") << "\n"
        << "Polling Interval: " << data.monitoring.polling_interval_ms << " ms\n"
+       << "Sensor Source: " << data.sensor_source->name() << "\n"
        << "Last Update: " << last_update_duration << " seconds ago\n"
        << "Total Updates: " << data.monitoring.total_sensor_updates << "\n"
        << "Total Alarms: " << data.monitoring.total_alarms_triggered << "\n"
-       << "Active Alarms: " << data.monitoring.active_alarms.size() << "\n"
-       << "\nSensor Monitoring:\n"
+       << "Active Alarms: " << data.monitoring.active_alarms.size() << "\n";
+    if (data.wal) {
+        ss << "Journal: " << data.wal->appended() << " records, " << data.wal->commits()
+           << " commits, " << data.wal->failures() << " failed\n";
+    }
+    if (data.alarm_bus) {
+        ss << "Alarm Bus: " << data.alarm_bus->delivered() << "/" << data.alarm_bus->published()
+           << " delivered, " << data.alarm_bus->dropped() << " dropped\n";
+    }
+    
+    // Loop self-telemetry in microseconds
+    const auto& loop = data.monitoring.loop;
+    auto us = [](const std::atomic<int64_t>& ns) { return ns.load(std::memory_order_relaxed) / 1000; };
+    ss << "\nMonitoring Loop:\n"
+       << "Ticks: " << loop.ticks.load() << ", Overruns: " << loop.overruns.load() << "\n"
+       << "Last Tick: " << us(loop.tick_ns) << " us (sample " << us(loop.sample_ns)
+       << ", archive " << us(loop.archive_ns) << ", evaluate " << us(loop.evaluate_ns)
+       << ", publish " << us(loop.publish_ns) << ")\n"
+       << "Max Tick: " << us(loop.max_tick_ns) << " us\n"
+       << "Wakeup Jitter: " << us(loop.jitter_ns) << " us last, "
+       << loop.averageJitter() / 1000 << " us avg, " << us(loop.max_jitter_ns) << " us max\n";
+    ss << "\nSensor Monitoring:\n"
        << "Temperature: " << (data.monitoring.temp_config.monitor ? "ON" : "OFF") << "\n"
        << "Current: " << (data.monitoring.current_config.monitor ? "ON" : "OFF") << "\n"
        << "Power: " << (data.monitoring.power_config.monitor ? "ON" : "OFF") << "\n"
-       << "Voltage: " << (data.monitoring.voltage_config.monitor ? "ON" : "OFF");
+       << "Voltage: " << (data.monitoring.voltage_config.monitor ? "ON" : "OFF") << "\n"
+       << "\nDetectors:\n"
+       << "Temperature: " << AnomalyDetector::modeName(data.monitoring.temp_detector.mode()) << "\n"
+       << "Current: " << AnomalyDetector::modeName(data.monitoring.current_detector.mode()) << "\n"
+       << "Power: " << AnomalyDetector::modeName(data.monitoring.power_detector.mode()) << "\n"
+       << "Voltage: " << AnomalyDetector::modeName(data.monitoring.voltage_detector.mode());
     
     return ss.str();
 }
@@ -178,6 +264,12 @@ std::string MONITOR::handleConfigGet(const std::string& param) const {
     else if (param == "voltage_range") {
         ss << data.monitoring.voltage_config.min_value << "," << data.monitoring.voltage_config.max_value;
     }
+    else if (param.rfind("detector_threshold_", 0) == 0 && data.getSensorDetector(param.substr(19))) {
+        ss << data.getSensorDetector(param.substr(19))->threshold();
+    }
+    else if (param.rfind("detector_", 0) == 0 && data.getSensorDetector(param.substr(9))) {
+        ss << AnomalyDetector::modeName(data.getSensorDetector(param.substr(9))->mode());
+    }
     else {
         return "ERROR: Unknown parameter";
     }
@@ -185,12 +277,13 @@ std::string MONITOR::handleConfigGet(const std::string& param) const {
     return "SUCCESS: " + param + " = " + ss.str();
 }
 
-bool MONITOR::handleConfigSet(const std::string& param, const std::string& value_str) {
+bool MONITOR::handleConfigSet(const std::string& param, const std::string& value_str, std::string& error) {
     if (param.empty() || value_str.empty()) {
+        error = "Use CONFIG SET <param> <value>";
         return false;
     }
     
-    // Handle different parameter types
+    // Settings that are not part of the configuration file
     if (param == "service_enabled") {
         if (value_str == "true" || value_str == "1" || value_str == "on") {
             data.monitoring.service_enabled = true;
@@ -199,61 +292,78 @@ bool MONITOR::handleConfigSet(const std::string& param, const std::string& value
             data.monitoring.service_enabled = false;
             return true;
         }
+        error = "service_enabled must be on or off";
         return false;
     }
-    else if (param == "polling_interval") {
+    else if (param.rfind("detector_threshold_", 0) == 0) {
+        AnomalyDetector* detector = data.getSensorDetector(param.substr(19));
+        if (!detector) {
+            error = "unknown sensor " + param.substr(19);
+            return false;
+        }
         try {
-            int value = std::stoi(value_str);
-            if (value > 0) {
-                data.monitoring.polling_interval_ms = value;
-                return true;
+            double value = std::stod(value_str);
+            if (value < 0) {
+                error = param + " must not be negative";
+                return false;
             }
+            detector->setThreshold(value);
+            return true;
         } catch (...) {
+            error = param + " must be a number";
             return false;
         }
     }
-    else if (param == "monitor_temperature") {
-        if (value_str == "true" || value_str == "1" || value_str == "on") {
-            data.monitoring.temp_config.monitor = true;
-            return true;
-        } else if (value_str == "false" || value_str == "0" || value_str == "off") {
-            data.monitoring.temp_config.monitor = false;
-            return true;
-        }
-        return false;
-    }
-    else if (param == "monitor_current") {
-        if (value_str == "true" || value_str == "1" || value_str == "on") {
-            data.monitoring.current_config.monitor = true;
-            return true;
-        } else if (value_str == "false" || value_str == "0" || value_str == "off") {
-            data.monitoring.current_config.monitor = false;
-            return true;
+    else if (param.rfind("detector_", 0) == 0) {
+        AnomalyDetector* detector = data.getSensorDetector(param.substr(9));
+        DetectorMode mode;
+        if (!detector || !AnomalyDetector::parseMode(value_str, mode)) {
+            error = param + " must be static, zscore or mad";
+            return false;
         }
-        return false;
+        detector->setMode(mode);
+        return true;
     }
-    else if (param == "monitor_power") {
-        if (value_str == "true" || value_str == "1" || value_str == "on") {
-            data.monitoring.power_config.monitor = true;
-            return true;
-        } else if (value_str == "false" || value_str == "0" || value_str == "off") {
-            data.monitoring.power_config.monitor = false;
-            return true;
-        }
+    
+    // Everything else is a configuration file key, with the same checks
+    // as a reloaded file, so the journal never holds a value a reload or
+    // replay would reject
+    MonitoringConfig config(data);
+    if (!config.set(param, value_str, error) || !config.validate(error)) {
         return false;
     }
-    else if (param == "monitor_voltage") {
-        if (value_str == "true" || value_str == "1" || value_str == "on") {
-            data.monitoring.voltage_config.monitor = true;
-            return true;
-        } else if (value_str == "false" || value_str == "0" || value_str == "off") {
-            data.monitoring.voltage_config.monitor = false;
-            return true;
+    return config.apply(data, error);
+}
+
+MONITOR::ConfigState MONITOR::saveConfig() const {
+    ConfigState state{MonitoringConfig(data), data.monitoring.service_enabled, {}, {}};
+    const AnomalyDetector* detectors[] = {
+        &data.monitoring.temp_detector, &data.monitoring.current_detector,
+        &data.monitoring.power_detector, &data.monitoring.voltage_detector
+    };
+    for (size_t i = 0; i < 4; ++i) {
+        state.detector_modes[i] = detectors[i]->mode();
+        state.detector_thresholds[i] = detectors[i]->configuredThreshold();
+    }
+    return state;
+}
+
+void MONITOR::restoreConfig(const ConfigState& state) {
+    // The saved configuration compiled before, so its rules compile again
+    std::string error;
+    state.config.apply(data, error);
+    data.monitoring.service_enabled = state.service_enabled;
+    AnomalyDetector* detectors[] = {
+        &data.monitoring.temp_detector, &data.monitoring.current_detector,
+        &data.monitoring.power_detector, &data.monitoring.voltage_detector
+    };
+    for (size_t i = 0; i < 4; ++i) {
+        // setMode() clears the window, so only a changed mode is set back
+        if (detectors[i]->mode() != state.detector_modes[i]) {
+            detectors[i]->setMode(state.detector_modes[i]);
         }
-        return false;
+        detectors[i]->setThreshold(state.detector_thresholds[i]);
     }
-    
-    return false;
 }
 
 bool MONITOR::handleAlarmAck(const std::string& alarm_id) {
@@ -308,4 +418,228 @@ std::string MONITOR::handleClear() {
     auto alarms = data.getActiveAlarms();
     return "Acknowledged alarms cleared. Remaining active alarms: " + 
            std::to_string(alarms.size());
+}
+
+std::string MONITOR::handleHistory(const std::string& sensor, const std::string& from,
+                                   const std::string& to, const std::string& step) const {
+    SensorHistory* history = data.getSensorHistory(sensor);
+    if (!history) {
+        return "ERROR: Unknown sensor (use temperature, current, power, voltage)";
+    }
+    
+    long long from_s, to_s, step_s;
+    try {
+        from_s = std::stoll(from);
+        to_s = std::stoll(to);
+        step_s = std::stoll(step);
+    } catch (...) {
+        return "ERROR: Usage: MONITOR HISTORY <sensor> <from_s_ago> <to_s_ago> <step_s>";
+    }
+    
+    if (from_s < to_s || to_s < 0 || step_s <= 0) {
+        return "ERROR: Expected from >= to >= 0 and step > 0";
+    }
+    
+    int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    
+    std::vector<SensorHistory::Point> points;
+    SensorHistory::Tier tier = history->query(now_ms - from_s * 1000, now_ms - to_s * 1000,
+                                              step_s * 1000, points);
+    
+    // Keep the reply within the shared memory response buffer
+    const size_t max_points = 16;
+    
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(2);
+    ss << "History " << sensor << " (tier " << SensorHistory::tierName(tier)
+       << ", " << points.size() << " points):\n";
+    
+    size_t first = points.size() > max_points ? points.size() - max_points : 0;
+    if (first > 0) {
+        ss << "  ... " << first << " older points omitted\n";
+    }
+    
+    for (size_t i = first; i < points.size(); ++i) {
+        std::time_t t = static_cast<std::time_t>(points[i].start_ms / 1000);
+        std::tm tm = *std::localtime(&t);
+        char time_buf[16];
+        std::strftime(time_buf, sizeof(time_buf), "%H:%M:%S", &tm);
+        
+        ss << "  " << time_buf << " min " << points[i].min
+           << " avg " << points[i].avg << " max " << points[i].max << "\n";
+    }
+    
+    return ss.str();
+}
+
+std::string MONITOR::handleArchive(const std::string& sensor, const std::string& from,
+                                   const std::string& to) const {
+    if (!archive_) {
+        return "ERROR: Telemetry archive is not enabled";
+    }
+    
+    long long from_s, to_s;
+    try {
+        from_s = std::stoll(from);
+        to_s = std::stoll(to);
+    } catch (...) {
+        return "ERROR: Usage: MONITOR ARCHIVE <sensor> <from_s_ago> <to_s_ago>";
+    }
+    
+    if (from_s < to_s || to_s < 0) {
+        return "ERROR: Expected from >= to >= 0";
+    }
+    
+    int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    
+    std::vector<TelemetryArchive::Point> points;
+    auto start = std::chrono::steady_clock::now();
+    size_t count = archive_->query(sensor, now_ms - from_s * 1000, now_ms - to_s * 1000, points);
+    auto elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    
+    if (count == 0) {
+        return "No archived samples for " + sensor + " in range";
+    }
+    
+    double min = points[0].value, max = points[0].value, sum = 0.0;
+    for (const auto& point : points) {
+        min = std::min(min, point.value);
+        max = std::max(max, point.value);
+        sum += point.value;
+    }
+    
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(2);
+    ss << "Archive " << sensor << ":\n"
+       << "  Samples: " << count << "\n"
+       << "  Min: " << min << "\n"
+       << "  Max: " << max << "\n"
+       << "  Avg: " << sum / count << "\n"
+       << "  Scan time: " << elapsed_us << " us\n"
+       << "  Archive size: " << archive_->bytesWritten() << " bytes for "
+       << archive_->samplesWritten() << " samples";
+    
+    return ss.str();
+}
+
+std::string MONITOR::handleStats(const std::string& sensor) {
+    static const char* const sensors[] = {"temperature", "current", "power", "voltage"};
+    
+    if (sensor == "RESET") {
+        for (const char* name : sensors) {
+            data.getSensorStats(name)->reset();
+        }
+        return "SUCCESS: Statistics reset";
+    }
+    
+    if (!sensor.empty() && !data.getSensorStats(sensor)) {
+        return "ERROR: Unknown sensor (use temperature, current, power, voltage)";
+    }
+    
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(2);
+    ss << "Sensor Statistics:\n"
+       << "==================";
+    
+    for (const char* name : sensors) {
+        if (!sensor.empty() && sensor != name) continue;
+        
+        SensorStats::Snapshot s = data.getSensorStats(name)->snapshot();
+        ss << "\n" << name << ": n=" << s.count
+           << " ewma=" << s.ewma << " mean=" << s.mean << " sd=" << s.stddev
+           << "\n  min=" << s.min << " p50=" << s.p50 << " p95=" << s.p95
+           << " p99=" << s.p99 << " max=" << s.max;
+    }
+    
+    return ss.str();
+}
+
+std::string MONITOR::handleRules(const std::string& prefix) const {
+    std::vector<AlarmRule> rules = data.alarm_rules.rules();
+    
+    std::stringstream list;
+    size_t count = 0;
+    for (const auto& rule : rules) {
+        if (rule.name.rfind(prefix, 0) != 0) continue;
+        list << "\n" << rule.name << " [" << rule.severity << "] " << rule.expression;
+        count++;
+    }
+    
+    return "Alarm Rules (" + std::to_string(count) + "):" + list.str();
+}
+
+std::string MONITOR::handleRuleAdd(const std::string& name, const std::string& severity,
+                                   const std::string& expression) {
+    std::string level = severity;
+    std::transform(level.begin(), level.end(), level.begin(), ::toupper);
+    size_t start = expression.find_first_not_of(' ');
+    if (name.empty() || start == std::string::npos) {
+        return "ERROR: Use RULE ADD <name> <severity> <expression>";
+    }
+    if (level != "WARNING" && level != "ERROR" && level != "CRITICAL") {
+        return "ERROR: Invalid severity (use WARNING, ERROR, CRITICAL)";
+    }
+    
+    AlarmRule rule;
+    rule.name = name;
+    rule.severity = level;
+    rule.expression = expression.substr(start);
+    rule.message = "Rule " + name + ": " + rule.expression;
+    
+    std::string error;
+    if (!data.alarm_rules.addRule(rule, error)) {
+        return "ERROR: " + error;
+    }
+    return "SUCCESS: Rule " + name + " installed";
+}
+
+std::string MONITOR::handleTrace(const std::string& action, const std::string& name) {
+    Tracer& tracer = Tracer::instance();
+    std::string mode = action;
+    std::transform(mode.begin(), mode.end(), mode.begin(), ::toupper);
+    
+    if (mode == "ON" || mode == "OFF") {
+        tracer.setEnabled(mode == "ON");
+        return "SUCCESS: Tracing " + std::string(mode == "ON" ? "enabled" : "disabled");
+    }
+    if (mode == "CLEAR") {
+        tracer.clear();
+        return "SUCCESS: Trace buffers cleared";
+    }
+    if (mode == "DUMP") {
+        if (trace_dir_.empty()) {
+            return "ERROR: Trace dumps are not enabled";
+        }
+        // Any local client can send commands: only a plain file name in
+        // the server's own directory is accepted
+        if (name.empty() || name.size() > NAME_MAX || name == "." ||
+            name.find('/') != std::string::npos || name.find("..") != std::string::npos) {
+            return "ERROR: Use TRACE DUMP <name>, a file name without / or ..";
+        }
+        
+        if (mkdir(trace_dir_.c_str(), 0750) != 0 && errno != EEXIST) {
+            return "ERROR: Cannot create " + trace_dir_ + ": " + strerror(errno);
+        }
+        struct stat st;
+        if (lstat(trace_dir_.c_str(), &st) != 0 || !S_ISDIR(st.st_mode) ||
+            st.st_uid != geteuid() || (st.st_mode & (S_IWGRP | S_IWOTH)) != 0) {
+            return "ERROR: " + trace_dir_ + " is not a private directory of the server user";
+        }
+        
+        std::string path = trace_dir_ + "/" + name;
+        int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0640);
+        if (fd == -1) {
+            return "ERROR: Cannot create " + path + ": " + strerror(errno);
+        }
+        size_t events = 0;
+        if (!tracer.dump(fd, events)) {
+            unlink(path.c_str());
+            return "ERROR: Cannot write trace to " + path;
+        }
+        return "SUCCESS: " + std::to_string(events) + " spans written to " + path;
+    }
+    return "ERROR: Use TRACE DUMP <name>, TRACE ON, TRACE OFF or TRACE CLEAR";
 }
\ No newline at end of file
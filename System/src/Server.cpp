@@ -1,90 +1,419 @@
 #include "../include/Server.h"
+#include "../../DaemonLib/include/Logger.h"
+#include "../../DaemonLib/include/Trace.h"
+#include "../../Protocol/include/Probes.h"
 #include <thread>
 #include <chrono>
+#include <algorithm>
 #include <syslog.h>
+#include <csignal>
+#include <cerrno>
 
-Server::Server() 
-    : set_system(shared_data), get_system(shared_data), 
+/// Generation of the command thread running on this thread, 0 elsewhere
+static thread_local uint64_t command_thread_generation = 0;
+/// Request slot the command thread on this thread answers
+static thread_local SharedData::RequestSlot* command_thread_slot = nullptr;
+
+Server::Server(const IpcNames& names, const std::string& config_path,
+               const ShmOptions& shm_options) 
+    : names(names), wal(names.wal), set_system(shared_data), get_system(shared_data), 
       alarm_system(shared_data), monitor_system(shared_data),
-      monitoring_running(false) { 
+      archive(names.archive_dir), shm_options(shm_options),
+      config_path(config_path), monitoring_running(false) { 
     
-    std::cout << "Server constructor called" << std::endl;
+    RLOG_INFO("Server constructor called");
     
-    auto alarm_callback = [](const std::string& alarm_msg) {
-        std::cout << "[ALARM] " << alarm_msg << std::endl;
-    };
+    initializeSharedMemory();
     
-    set_system.setAlarmCallback(alarm_callback);
-    get_system.setAlarmCallback(alarm_callback);
-    alarm_system.setAlarmCallback(alarm_callback);
-    monitor_system.setAlarmCallback(alarm_callback);
+    recoverState();
     
-    initializeSharedMemory();
+    stats = StatsPage::create(names.stats_shm.c_str());
+    if (!stats) {
+        RLOG_WARN("Failed to create stats page: {}", strerror(errno));
+    }
     
+    bool archive_ready = archive.open();
+    if (archive_ready) {
+        monitor_system.setArchive(&archive);
+    }
+    monitor_system.setTraceDirectory(names.trace_dir);
+    
+    initializeAlarmBus(archive_ready);
+    
+    initializeEventLoop();
     startMonitoring();
 }
 
 Server::~Server() {
     stopMonitoring();
+    
+    // An abandoned thread still inside a stuck call would touch this
+    // object after it is destroyed; a clean shutdown is no longer possible
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ABANDONED_WAIT_MS);
+    while (abandoned_threads.load() > 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if (abandoned_threads.load() > 0) {
+        RLOG_ERROR("{} stalled thread(s) never returned, exiting", abandoned_threads.load());
+        Logger::instance().flush();
+        _exit(EXIT_FAILURE);
+    }
+    
+    // A configuration reloaded just before the stop is kept
+    if (reload_thread.joinable()) {
+        reload_thread.join();
+    }
+    applyPendingConfig();
+    
+    shared_data.wal = nullptr;
+    {
+        std::unique_lock<std::timed_mutex> state(state_mutex);
+        saveSnapshot(state);
+    }
+    wal.close();
+    shared_data.alarm_bus = nullptr;
+    alarm_bus.stop();
     cleanup();
 }
 
 /**
- * @brief Initializes shared memory and semaphores for IPC
+ * @brief Subscribes alarm consumers and starts the alarm dispatcher
+ * 
+ * Alarm producers only queue events; logging, the shared memory summary
+ * and the archive are updated on the dispatcher thread.
  */
-void Server::initializeSharedMemory() {
-    std::cout << "Initializing shared memory..." << std::endl;
+void Server::initializeAlarmBus(bool archive_ready) {
+    alarm_bus.subscribe([](const AlarmEvent& event) {
+        TRACE_SCOPE("alarm.log", "alarm");
+        RLOG_WARN("[ALARM] {}", event.message);
+    });
     
-    sem_unlink(SEM_CLIENT_NAME);
-    sem_unlink(SEM_SERVER_NAME);
-    shm_unlink(SHM_NAME);
+    if (data != MAP_FAILED) {
+        alarm_bus.subscribe([this](const AlarmEvent& event) {
+            TRACE_SCOPE("alarm.shm", "alarm");
+            data->alarms.lock.writeBegin();
+            data->alarms.events++;
+            strncpy(data->alarms.last, event.message, sizeof(data->alarms.last) - 1);
+            data->alarms.lock.writeEnd();
+        });
+    }
     
-    std::cout << "Creating semaphores..." << std::endl;
-    sem_client = sem_open(SEM_CLIENT_NAME, O_CREAT | O_EXCL, 0644, 0);
-    sem_server = sem_open(SEM_SERVER_NAME, O_CREAT | O_EXCL, 0644, 0);
+    if (archive_ready) {
+        alarm_bus.subscribe([this](const AlarmEvent& event) {
+            TRACE_SCOPE("alarm.archive", "alarm");
+            archive.append(std::string("alarm_") + event.sensor, event.timestamp_ms, event.value);
+        });
+    }
     
-    if (sem_client == SEM_FAILED) {
-        std::cerr << "Failed to create sem_client: " << strerror(errno) << std::endl;
-        return;
+    shared_data.alarm_bus = &alarm_bus;
+    alarm_bus.start();
+}
+
+/**
+ * @brief Restores the last snapshot and replays the journal on top
+ * 
+ * Configuration changes are journaled only after replay, so replayed
+ * records are not appended again.
+ */
+void Server::recoverState() {
+    std::string error;
+    if (SystemSnapshot::restore(shared_data, names.snapshot, error)) {
+        RLOG_INFO("State restored from {}", names.snapshot);
     } else {
-        std::cout << "sem_client created successfully" << std::endl;
+        RLOG_INFO("Starting with default state: {}", error);
+        
+        // The snapshot already holds any configuration reloaded earlier
+        MonitoringConfig config(shared_data);
+        if (!config_path.empty() && access(config_path.c_str(), F_OK) == 0) {
+            if (!config.loadFile(config_path, error)) {
+                RLOG_WARN("Ignoring monitoring configuration: {}", error);
+            } else if (config.apply(shared_data, error)) {
+                RLOG_INFO("Monitoring configuration loaded from {}", config_path);
+            } else {
+                RLOG_ERROR("Monitoring configuration loaded from {} with errors: {}", config_path, error);
+            }
+        }
     }
     
-    if (sem_server == SEM_FAILED) {
-        std::cerr << "Failed to create sem_server: " << strerror(errno) << std::endl;
+    std::vector<WriteAheadLog::Record> records;
+    error.clear();
+    if (!wal.open(records, error)) {
+        RLOG_WARN("Configuration journal disabled: {}", error);
         return;
-    } else {
-        std::cout << "sem_server created successfully" << std::endl;
     }
+    
+    size_t applied = 0;
+    for (const auto& record : records) {
+        bool ok = record.type == WriteAheadLog::RecordType::Set
+            ? set_system.execute(record.parameter, record.value)
+            : monitor_system.execute("CONFIG SET " + record.parameter + " " + record.value)
+                  .compare(0, 7, "SUCCESS") == 0;
+        if (ok) applied++;
+    }
+    if (!records.empty()) {
+        RLOG_INFO("Replayed {} of {} journal records from {}", applied, records.size(), names.wal);
+    }
+    
+    shared_data.wal = &wal;
+}
 
-    std::cout << "Creating shared memory..." << std::endl;
-    shm_fd = shm_open(SHM_NAME, O_CREAT | O_RDWR, 0666);
-    if (shm_fd == -1) {
-        std::cerr << "Failed to create shared memory: " << strerror(errno) << std::endl;
+/**
+ * @brief Snapshot timer: saves unless a command is changing the state
+ * 
+ * Never waits for the command thread; a busy state is tried again
+ * SNAPSHOT_RETRY_NS later.
+ */
+void Server::snapshotTimer() {
+    std::unique_lock<std::timed_mutex> state(state_mutex, std::try_to_lock);
+    if (!state.owns_lock()) {
+        events.setTimer(snapshot_timer, Tracer::now() + SNAPSHOT_RETRY_NS, SNAPSHOT_INTERVAL_NS);
         return;
+    }
+    saveSnapshot(state);
+}
+
+/**
+ * @brief Writes the state snapshot used by the next start
+ * 
+ * The state is copied while the caller's state lock is held, so no
+ * command is half applied in it, and a SET the journal rejected is
+ * already undone. The lock is released before the file is written.
+ * 
+ * A successful snapshot covers every journal record appended before it
+ * was taken, so those records are dropped.
+ */
+void Server::saveSnapshot(std::unique_lock<std::timed_mutex>& state) {
+    uint64_t mark = wal.mark();
+    std::vector<uint8_t> image = SystemSnapshot::encode(shared_data);
+    state.unlock();
+    
+    std::string error;
+    if (!SystemSnapshot::write(image, names.snapshot, error)) {
+        RLOG_ERROR("Failed to save snapshot: {}", error);
+    } else if (wal.isOpen() && !wal.checkpoint(mark, error)) {
+        RLOG_WARN("Failed to checkpoint journal: {}", error);
+    }
+}
+
+bool Server::reloadConfig(std::string& error) {
+    if (config_path.empty()) {
+        error = "no configuration file";
+        return false;
+    }
+    
+    // The file is read on top of the running configuration
+    std::shared_ptr<MonitoringConfig> config;
+    {
+        std::unique_lock<std::timed_mutex> state(state_mutex, std::defer_lock);
+        if (!state.try_lock_for(std::chrono::milliseconds(STATE_LOCK_TIMEOUT_MS))) {
+            error = "server state is held by a stalled command";
+            return false;
+        }
+        config = std::make_shared<MonitoringConfig>(shared_data);
+    }
+    
+    // Parsing and validation happen before anything is swapped in
+    if (!config->loadFile(config_path, error)) {
+        return false;
+    }
+    std::atomic_store(&pending_config, std::shared_ptr<const MonitoringConfig>(std::move(config)));
+    return true;
+}
+
+/**
+ * @brief Runs reloadConfig() on a helper thread
+ * 
+ * Reading the file and waiting for the state lock must not hold up the
+ * event loop. A SIGHUP that arrives while a reload is still running is
+ * ignored with a warning.
+ */
+void Server::startReload() {
+    if (reload_running.exchange(true)) {
+        RLOG_WARN("Configuration reload already running, SIGHUP ignored");
+        return;
+    }
+    if (reload_thread.joinable()) {
+        reload_thread.join();
+    }
+    reload_thread = std::thread([this]() {
+        std::string error;
+        if (!reloadConfig(error)) {
+            RLOG_ERROR("Configuration reload rejected: {}", error);
+        }
+        reload_running = false;
+    });
+}
+
+/**
+ * @brief Applies a configuration queued by reloadConfig()
+ * 
+ * Runs on the event loop thread, so never in the middle of a tick
+ * (and once more from the destructor). While
+ * a command holds the state the configuration stays queued for the next
+ * tick. The snapshot is saved right away so the reloaded configuration
+ * survives a restart.
+ */
+void Server::applyPendingConfig() {
+    if (!std::atomic_load(&pending_config)) return;
+    std::unique_lock<std::timed_mutex> state(state_mutex, std::try_to_lock);
+    if (!state.owns_lock()) return;
+    auto config = std::atomic_exchange(&pending_config, std::shared_ptr<const MonitoringConfig>());
+    if (!config) return;
+    
+    std::string error;
+    if (config->apply(shared_data, error)) {
+        RLOG_INFO("Monitoring configuration reloaded from {}", config_path);
     } else {
-        std::cout << "Shared memory created successfully" << std::endl;
+        RLOG_ERROR("Monitoring configuration reloaded from {} with errors: {}", config_path, error);
+    }
+    saveSnapshot(state);
+}
+
+/**
+ * @brief Registers the event loop sources
+ * 
+ * Signals arrive through a signalfd, so stop and reload requests run as
+ * normal code on the event loop thread instead of in signal handlers.
+ * The signals must be blocked in every thread (ServerDaemon does this).
+ */
+void Server::initializeEventLoop() {
+    if (!events.isValid()) {
+        RLOG_ERROR("Failed to create event loop: {}", strerror(errno));
+        return;
     }
     
-    ftruncate(shm_fd, sizeof(SharedData));
-    data = static_cast<SharedData*>(
-        mmap(0, sizeof(SharedData), PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0));
-        
-    if (data == MAP_FAILED) {
-        std::cerr << "Failed to map shared memory: " << strerror(errno) << std::endl;
+    if (events.addSignals({SIGTERM, SIGINT, SIGHUP}, [this](int signo) { handleSignal(signo); }) == -1) {
+        RLOG_WARN("Signal handling disabled: {}", strerror(errno));
+    }
+    tick_timer = events.addTimer([this](uint64_t expirations) { monitoringTick(expirations); });
+    snapshot_timer = events.addTimer([this](uint64_t) { snapshotTimer(); });
+    idle_timer = events.addTimer([this](uint64_t) { checkIdle(); });
+    heartbeat_timer = events.addTimer([this](uint64_t) { beatHeartbeats(); });
+    reclaim_timer = events.addTimer([this](uint64_t) {
+        unsigned reclaimed = data != MAP_FAILED ? data->reclaimAbandoned() : 0;
+        if (reclaimed > 0) {
+            RLOG_INFO("Reclaimed {} connection(s) of exited clients", reclaimed);
+        }
+    });
+    if (tick_timer == -1 || snapshot_timer == -1 || idle_timer == -1 || heartbeat_timer == -1 ||
+        reclaim_timer == -1) {
+        RLOG_ERROR("Failed to create timers: {}", strerror(errno));
+    }
+}
+
+/**
+ * @brief Heartbeat timer: beats for the monitoring and command threads
+ * 
+ * The command thread blocks in sem_wait() while idle, so it cannot beat
+ * by itself without polling. The event loop beats for it unless it has
+ * been inside one command for longer than a heartbeat interval; a stuck
+ * command therefore shows as a stale command heartbeat.
+ */
+void Server::beatHeartbeats() {
+    if (data == MAP_FAILED) return;
+    int64_t now = Tracer::now();
+    data->monitoring_heartbeat.beat(now);
+    if (!commandThreadBusy(now)) {
+        data->command_heartbeat.beat(now);
+    }
+}
+
+/**
+ * @brief Whether the command thread has been in its current command
+ *        for a heartbeat interval or longer
+ */
+bool Server::commandThreadBusy(int64_t now) const {
+    int64_t started = command_started_ns.load(std::memory_order_acquire);
+    return started != 0 && now - started >= HEARTBEAT_INTERVAL_MS * 1000000LL;
+}
+
+void Server::handleSignal(int signo) {
+    if (signo == SIGHUP) {
+        RLOG_INFO("SIGHUP received, reloading {}", config_path);
+        startReload();
         return;
+    }
+    
+    RLOG_INFO("Stop signal {} received", signo);
+    requestStop(StopReason::Signal);
+}
+
+/**
+ * @brief Ends run(): wakes the command thread and run() itself
+ */
+void Server::requestStop(StopReason reason) {
+    if (!stopping.exchange(true)) {
+        stop_reason = reason;
+        if (sem_client != SEM_FAILED) {
+            sem_post(sem_client);
+        }
+        std::lock_guard<std::mutex> lock(stop_mutex);
+        stop_condition.notify_all();
+    }
+}
+
+/**
+ * @brief Idle timer expiry: stop, or re-arm for the latest command
+ * 
+ * Commands only store their time; the timer is moved forward here, so
+ * the command path never touches the timer.
+ */
+void Server::checkIdle() {
+    int64_t deadline = last_command_ns.load(std::memory_order_relaxed) +
+                       static_cast<int64_t>(idle_timeout_s) * 1000000000LL;
+    if (Tracer::now() >= deadline) {
+        requestStop(StopReason::Idle);
     } else {
-        std::cout << "Shared memory mapped successfully" << std::endl;
+        events.setTimer(idle_timer, deadline);
+    }
+}
+
+/**
+ * @brief Initializes shared memory and the client semaphore for IPC
+ * 
+ * The segment is sized and cleared before the semaphore exists: clients
+ * treat the appearance of the semaphore as "server ready" and map the
+ * segment right after opening it.
+ */
+void Server::initializeSharedMemory() {
+    RLOG_INFO("Initializing shared memory {}...", names.shm);
+    
+    sem_unlink(names.sem_client.c_str());
+    
+    sem_client = SEM_FAILED;
+    data = static_cast<SharedData*>(MAP_FAILED);
+
+    RLOG_INFO("Creating shared memory...");
+    std::string error, warning;
+    if (!segment.create(names.shm, shm_options, error, warning)) {
+        RLOG_ERROR("Failed to create shared memory: {}", error);
+        return;
     }
+    if (!warning.empty()) {
+        RLOG_WARN("Shared memory: {}", warning);
+    }
+    data = segment.data();
+    
+    RLOG_INFO("Shared memory initialized successfully (layout v{}, {} bytes, {} pages{})",
+              SharedData::VERSION, sizeof(SharedData), segment.hugepages() ? "huge" : "regular",
+              segment.locked() ? ", locked" : "");
     
-    memset(data, 0, sizeof(SharedData));
-    std::cout << "Shared memory initialized successfully" << std::endl;
+    RLOG_INFO("Creating semaphore...");
+    sem_client = sem_open(names.sem_client.c_str(), O_CREAT | O_EXCL, 0644, 0);
+    if (sem_client == SEM_FAILED) {
+        RLOG_ERROR("Failed to create sem_client: {}", strerror(errno));
+        return;
+    } else {
+        RLOG_INFO("sem_client created successfully");
+    }
 }
 
 /**
  * @brief Executes SET command with parameter validation
  */
 std::string Server::executeSET(const std::string& parameter, const std::string& value) {
+    StatsTimer timer(stats, StatsMetric::Set);
+    TRACE_SCOPE("execute.set");
     bool success = set_system.execute(parameter, value);
     if (success) {
         return "SUCCESS: Parameter " + parameter + " set to " + value;
@@ -97,6 +426,8 @@ std::string Server::executeSET(const std::string& parameter, const std::string&
  * @brief Executes GET command to retrieve parameter value
  */
 std::string Server::executeGET(const std::string& parameter) {
+    StatsTimer timer(stats, StatsMetric::Get);
+    TRACE_SCOPE("execute.get");
     std::string result = get_system.execute(parameter);
     if (result.find("Error: Unknown parameter") != std::string::npos) {
         return "ERROR: Unknown parameter " + parameter;
@@ -108,6 +439,8 @@ std::string Server::executeGET(const std::string& parameter) {
  * @brief Executes ALARM command to check system status
  */
 std::string Server::executeALARM() {
+    StatsTimer timer(stats, StatsMetric::Alarm);
+    TRACE_SCOPE("execute.alarm");
     alarm_system.updateAndCheckAlarms();
     return "SUCCESS: Alarm check completed";
 }
@@ -116,6 +449,8 @@ std::string Server::executeALARM() {
  * @brief Executes MONITOR command
  */
 std::string Server::executeMONITOR(const std::string& command) {
+    StatsTimer timer(stats, StatsMetric::Monitor);
+    TRACE_SCOPE("execute.monitor");
     return monitor_system.execute(command);
 }
 
@@ -123,6 +458,8 @@ std::string Server::executeMONITOR(const std::string& command) {
  * @brief Executes STATUS command
  */
 std::string Server::executeSTATUS() {
+    StatsTimer timer(stats, StatsMetric::Status);
+    TRACE_SCOPE("execute.status");
     std::stringstream status;
     status << "SYSTEM STATUS:\n"
            << "================\n"
@@ -147,8 +484,18 @@ std::string Server::executeSTATUS() {
  * @brief Processes incoming command from client
  */
 void Server::processCommand(const std::string& command) {
-    std::cout << "Processing command: " << command << std::endl;
+    StatsTimer timer(stats, StatsMetric::Command);
+    TRACE_SCOPE("command");
+    RLOG_INFO("Processing command: {}", command);
     
+    // Snapshots and configuration reloads never see a command half applied
+    std::unique_lock<std::timed_mutex> state(state_mutex, std::defer_lock);
+    if (!state.try_lock_for(std::chrono::milliseconds(STATE_LOCK_TIMEOUT_MS))) {
+        writeResponse("ERROR: Server state is held by a stalled command, try again later");
+        return;
+    }
+    
+    TraceSpan parse("parse");
     std::stringstream ss(command);
     std::string action, parameter, value;
     ss >> action;
@@ -160,10 +507,12 @@ void Server::processCommand(const std::string& command) {
         if (!monitor_cmd.empty() && monitor_cmd[0] == ' ') {
             monitor_cmd = monitor_cmd.substr(1);
         }
+        parse.end();
+        RADIO_PROBE2(command__dispatch, action.c_str(), monitor_cmd.c_str());
         
         std::string response = executeMONITOR(monitor_cmd);
-        strncpy(data->response, response.c_str(), sizeof(data->response) - 1);
-        data->response[sizeof(data->response) - 1] = '\0';
+        state.unlock();
+        writeResponse(response);
         return;
     }
     
@@ -171,6 +520,8 @@ void Server::processCommand(const std::string& command) {
     ss >> parameter;
     std::getline(ss, value);
     if (!value.empty() && value[0] == ' ') value = value.substr(1);
+    parse.end();
+    RADIO_PROBE2(command__dispatch, action.c_str(), parameter.c_str());
     
     std::string response;
     
@@ -189,128 +540,455 @@ void Server::processCommand(const std::string& command) {
     else {
         response = "ERROR: Invalid command format. Use: SET <param> <value>, GET <param>, ALARM, MONITOR <command>, or STATUS";
     }
+    state.unlock();
+    
+    writeResponse(response);
+}
+
+/**
+ * @brief Answers the request the command thread is processing
+ */
+void Server::writeResponse(const std::string& response) {
+    // A replaced command thread must not overwrite the stalled answer
+    // restartCommands() wrote, nor its successor's responses
+    std::lock_guard<std::mutex> lock(response_mutex);
+    if (command_thread_generation != 0 && command_thread_generation != command_generation.load()) {
+        return;
+    }
+    if (command_thread_slot) {
+        storeResponse(*command_thread_slot, response);
+    }
+}
+
+/**
+ * @brief Copies a response into a request slot and counts it
+ */
+void Server::storeResponse(SharedData::RequestSlot& slot, const std::string& response) {
+    TRACE_SCOPE("response.copy");
+    strncpy(slot.response, response.c_str(), sizeof(slot.response) - 1);
+    slot.response[sizeof(slot.response) - 1] = '\0';
     
-    strncpy(data->response, response.c_str(), sizeof(data->response) - 1);
-    data->response[sizeof(data->response) - 1] = '\0';
+    if (stats) {
+        stats->commands_total.fetch_add(1, std::memory_order_relaxed);
+        if (response.compare(0, 5, "ERROR") == 0) {
+            stats->commands_failed.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
 }
 
 /**
- * @brief Monitoring thread function
+ * @brief Monitoring thread function: runs the event loop
+ * 
+ * Monitoring ticks, snapshots, signals and the idle timeout are all
+ * event loop sources, so the thread only wakes when one of them fires.
  */
-void Server::monitoringLoop() {
+void Server::monitoringLoop(bool replacement) {
     syslog(LOG_INFO, "Monitoring thread started");
+    Tracer::instance().setThreadName("monitoring");
+    if (!replacement) {
+        shared_data.monitoring.loop.reset();
+    }
+    
+    int64_t now = Tracer::now();
+    if (data != MAP_FAILED) {
+        data->monitoring_heartbeat.beat(now);
+    }
+    armTickTimer(now);
+    events.setTimer(snapshot_timer, now + SNAPSHOT_INTERVAL_NS, SNAPSHOT_INTERVAL_NS);
+    events.setTimer(heartbeat_timer, now + HEARTBEAT_INTERVAL_MS * 1000000LL, HEARTBEAT_INTERVAL_MS * 1000000LL);
+    events.setTimer(reclaim_timer, now + RECLAIM_INTERVAL_NS, RECLAIM_INTERVAL_NS);
+    
+    if (!events.run()) {
+        // Replaced after a stall; the timers belong to the new thread
+        abandoned_threads--;
+        syslog(LOG_WARNING, "Stalled monitoring thread returned after its replacement");
+        return;
+    }
+    
+    events.setTimer(tick_timer, 0);
+    events.setTimer(snapshot_timer, 0);
+    events.setTimer(heartbeat_timer, 0);
+    events.setTimer(reclaim_timer, 0);
+    syslog(LOG_INFO, "Monitoring thread stopped");
+}
+
+/**
+ * @brief Starts periodic ticks at first_ns with the configured interval
+ */
+void Server::armTickTimer(int64_t first_ns) {
+    tick_interval_ns = std::max<int64_t>(shared_data.monitoring.polling_interval_ms, 1) * 1000000;
+    tick_next_ns = first_ns;
+    events.setTimer(tick_timer, first_ns, tick_interval_ns);
+}
+
+/**
+ * @brief One monitoring iteration, driven by the periodic tick timer
+ * 
+ * Ticks run at a fixed rate on the timer's schedule, so the period does
+ * not stretch by the tick duration. Expirations missed while a tick
+ * overran are collapsed into one call instead of firing back to back;
+ * the overrun itself is counted by the loop telemetry.
+ */
+void Server::monitoringTick(uint64_t expirations) {
+    applyPendingConfig();
+    
+    Tracer& tracer = Tracer::instance();
+    auto& loop = shared_data.monitoring.loop;
+    int64_t interval = tick_interval_ns;
+    int64_t scheduled = tick_next_ns + static_cast<int64_t>(expirations - 1) * interval;
+    tick_next_ns = scheduled + interval;
     
-    while (monitoring_running) {
-        if (shared_data.monitoring.service_enabled) {
-            // Update sensors
-            shared_data.updateMonitoringSensors();
-            
-            // Check thresholds
-            shared_data.checkMonitoringThresholds();
-            
-            // Update shared memory
-            data->monitoring.temperature = shared_data.monitoring.temperature;
-            data->monitoring.current = shared_data.monitoring.current;
-            data->monitoring.power = shared_data.monitoring.power;
-            data->monitoring.voltage = shared_data.monitoring.voltage;
-            data->monitoring.active_alarms_count = shared_data.monitoring.active_alarms.size();
-            data->monitoring.service_enabled = shared_data.monitoring.service_enabled;
-            
-            // Update last update time
-            auto now = std::chrono::system_clock::now();
-            std::time_t now_time = std::chrono::system_clock::to_time_t(now);
-            std::strftime(data->monitoring.last_update, sizeof(data->monitoring.last_update),
-                         "%H:%M:%S", std::localtime(&now_time));
+    if (shared_data.monitoring.service_enabled) {
+        int64_t start = Tracer::now();
+        int64_t jitter = std::max<int64_t>(start - scheduled, 0);
+        
+        // Update sensors
+        shared_data.updateMonitoringSensors();
+        int64_t sampled = Tracer::now();
+        
+        // Persist samples
+        archiveSensorSample();
+        int64_t archived = Tracer::now();
+        
+        // Check thresholds; radio rules read parameters that commands
+        // change, so they are skipped on a tick that overlaps a command
+        {
+            std::unique_lock<std::timed_mutex> state(state_mutex, std::try_to_lock);
+            shared_data.checkMonitoringThresholds(state.owns_lock());
         }
+        int64_t evaluated = Tracer::now();
+        
+        // Update shared memory; readers such as radio-client --watch
+        // copy it without a command and retry a torn copy
+        auto now = std::chrono::system_clock::now();
+        std::time_t now_time = std::chrono::system_clock::to_time_t(now);
+        data->monitoring.lock.writeBegin();
+        data->monitoring.temperature = shared_data.monitoring.temperature;
+        data->monitoring.current = shared_data.monitoring.current;
+        data->monitoring.power = shared_data.monitoring.power;
+        data->monitoring.voltage = shared_data.monitoring.voltage;
+        data->monitoring.active_alarms_count = shared_data.monitoring.active_alarms.size();
+        data->monitoring.service_enabled = shared_data.monitoring.service_enabled;
+        std::strftime(data->monitoring.last_update, sizeof(data->monitoring.last_update),
+                     "%H:%M:%S", std::localtime(&now_time));
+        data->monitoring.lock.writeEnd();
+        int64_t published = Tracer::now();
+        
+        loop.record(jitter, sampled - start, archived - sampled,
+                    evaluated - archived, published - evaluated, interval);
         
-        // Sleep for polling interval
-        std::this_thread::sleep_for(
-            std::chrono::milliseconds(shared_data.monitoring.polling_interval_ms)
-        );
+        tracer.record("sensors.update", "monitoring", start, sampled);
+        tracer.record("archive", "monitoring", sampled, archived);
+        tracer.record("thresholds", "monitoring", archived, evaluated);
+        tracer.record("shm.publish", "monitoring", evaluated, published);
+        tracer.record("monitoring.tick", "monitoring", start, published);
+        
+        if (stats) {
+            stats->histogram(StatsMetric::MonitoringTick).record(published - start);
+            stats->histogram(StatsMetric::TickSample).record(sampled - start);
+            stats->histogram(StatsMetric::TickArchive).record(archived - sampled);
+            stats->histogram(StatsMetric::TickEvaluate).record(evaluated - archived);
+            stats->histogram(StatsMetric::TickPublish).record(published - evaluated);
+            stats->histogram(StatsMetric::TickJitter).record(jitter);
+            if (published - start > interval) {
+                stats->monitoring_overruns.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    } else if (data->monitoring.service_enabled) {
+        // Observers of the segment see the service stop, not stale values
+        data->monitoring.lock.writeBegin();
+        data->monitoring.service_enabled = false;
+        data->monitoring.lock.writeEnd();
     }
     
-    syslog(LOG_INFO, "Monitoring thread stopped");
+    // A changed polling interval restarts the schedule from now
+    int64_t configured = std::max<int64_t>(shared_data.monitoring.polling_interval_ms, 1) * 1000000;
+    if (configured != tick_interval_ns) {
+        armTickTimer(Tracer::now() + configured);
+    }
+}
+
+/**
+ * @brief Appends the latest sensor values to the telemetry archive
+ */
+void Server::archiveSensorSample() {
+    const auto& m = shared_data.monitoring;
+    int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        m.last_update.time_since_epoch()).count();
+    
+    if (m.temp_config.enabled && m.temp_config.monitor) {
+        archive.append("temperature", now_ms, m.temperature);
+    }
+    if (m.current_config.enabled && m.current_config.monitor) {
+        archive.append("current", now_ms, m.current);
+    }
+    if (m.power_config.enabled && m.power_config.monitor) {
+        archive.append("power", now_ms, m.power);
+    }
+    if (m.voltage_config.enabled && m.voltage_config.monitor) {
+        archive.append("voltage", now_ms, m.voltage);
+    }
 }
 
 void Server::startMonitoring() {
     if (!monitoring_running) {
         monitoring_running = true;
-        monitoring_thread = std::thread(&Server::monitoringLoop, this);
-        std::cout << "Monitoring service started" << std::endl;
+        monitoring_thread = std::thread(&Server::monitoringLoop, this, false);
+        RLOG_INFO("Monitoring service started");
     }
 }
 
 void Server::stopMonitoring() {
-    if (monitoring_running) {
+    std::thread finished;
+    {
+        std::lock_guard<std::mutex> lock(threads_mutex);
+        if (!monitoring_running) return;
         monitoring_running = false;
-        if (monitoring_thread.joinable()) {
-            monitoring_thread.join();
+        events.stop();
+        finished = std::move(monitoring_thread);
+    }
+    if (finished.joinable()) {
+        finished.join();
+    }
+    RLOG_INFO("Monitoring service stopped");
+}
+
+bool Server::restartMonitoring() {
+    std::lock_guard<std::mutex> lock(threads_mutex);
+    if (!monitoring_running || !monitoring_thread.joinable()) {
+        return false;
+    }
+    
+    RLOG_ERROR("Monitoring thread stalled, starting a replacement");
+    abandoned_threads++;
+    monitoring_thread.detach();
+    monitoring_thread = std::thread(&Server::monitoringLoop, this, true);
+    
+    std::string error;
+    if (!realtime.monitoring.isDefault() && !realtime.monitoring.apply(monitoring_thread.native_handle(), error)) {
+        RLOG_WARN("Monitoring thread tuning incomplete: {}", error);
+    }
+    return true;
+}
+
+bool Server::restartCommands() {
+    std::lock_guard<std::mutex> lock(threads_mutex);
+    if (stopping || !command_thread.joinable()) {
+        return false;
+    }
+    
+    int64_t now = Tracer::now();
+    if (!commandThreadBusy(now)) {
+        RLOG_WARN("Command heartbeat was late but the command thread is not stuck in a command");
+        data->command_heartbeat.beat(now);
+        return true;
+    }
+    
+    RLOG_ERROR("Command thread stalled, starting a replacement");
+    abandoned_threads++;
+    command_thread.detach();
+    
+    // Answer the client of the stuck command instead of letting it time
+    // out. The stalled thread checks the generation and answers under
+    // the same lock, so a late answer of it is dropped, not written over
+    // this one.
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> response_lock(response_mutex);
+        generation = ++command_generation;
+        int slot = processing_slot.exchange(-1);
+        if (slot >= 0) {
+            storeResponse(data->slots[slot], "ERROR: Command stalled, server recovered; it may still take effect");
+            data->completeRequest(slot);
         }
-        std::cout << "Monitoring service stopped" << std::endl;
+    }
+    command_started_ns = 0;
+    
+    command_thread = std::thread(&Server::commandLoop, this, generation);
+    return true;
+}
+
+void Server::setRealtime(const RealtimeConfig& config) {
+    realtime = config;
+    if (config.monitoring.isDefault() || !monitoring_thread.joinable()) {
+        return;
+    }
+    
+    std::string error;
+    if (config.monitoring.apply(monitoring_thread.native_handle(), error)) {
+        RLOG_INFO("Monitoring thread: {}", config.monitoring.describe());
+    } else {
+        RLOG_WARN("Monitoring thread tuning incomplete: {}", error);
     }
 }
 
 /**
- * @brief Main server loop - waits for client commands with 90-second timeout
+ * @brief Main server loop - serves client commands on the command thread
+ * 
+ * Returns once requestStop() is called for a stop signal or the idle
+ * timeout. Shared memory, semaphores and all system state live as long
+ * as the Server object, so a persistent server (idle timeout 0) keeps
+ * them for its whole lifetime.
  */
-void Server::run() {
+Server::StopReason Server::run() {
     syslog(LOG_INFO, "Server run method started");
 
-    std::cout << "Radio Control Server started..." << std::endl;
-    std::cout << "Monitoring service: " << (monitoring_running ? "RUNNING" : "STOPPED") << std::endl;
-    std::cout << "Server will automatically shutdown after 90 seconds of inactivity." << std::endl;
-
-    time_t startTime = time(nullptr);
-    bool commandReceived = false;
-
-    while (time(nullptr) - startTime < 90) {
-        if (sem_trywait(sem_client) == 0) {
-            commandReceived = true;
-            
-            processCommand(data->command);
-            
-            sem_post(sem_server);
-
-            std::cout << "Response sent to client. Waiting for next command..." << std::endl;
-            
-            startTime = time(nullptr);
-            
-            sleep(1);
-        } 
-        else 
-        {
-            sleep(1);
-        }
+    RLOG_INFO("Radio Control Server started...");
+    RLOG_INFO("Monitoring service: {}", monitoring_running ? "RUNNING" : "STOPPED");
+    if (idle_timeout_s > 0) {
+        RLOG_INFO("Server will automatically shutdown after {} seconds of inactivity.", idle_timeout_s);
+    } else {
+        RLOG_INFO("Persistent mode: no inactivity shutdown.");
+    }
+    
+    if (sem_client == SEM_FAILED || data == MAP_FAILED) {
+        RLOG_ERROR("IPC is not initialized, not serving commands");
+        return StopReason::Idle;
     }
 
-    if (!commandReceived) {
-        std::cout << "90-second timeout! No commands received." << std::endl;
-    } else {
-        std::cout << "90-second inactivity timeout reached. Server shutting down." << std::endl;
+    last_command_ns = Tracer::now();
+    if (idle_timeout_s > 0) {
+        events.setTimer(idle_timer, last_command_ns + static_cast<int64_t>(idle_timeout_s) * 1000000000LL);
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(threads_mutex);
+        command_thread = std::thread(&Server::commandLoop, this, ++command_generation);
+    }
+    {
+        std::unique_lock<std::mutex> lock(stop_mutex);
+        stop_condition.wait(lock, [this]() { return stopping.load(); });
+    }
+    
+    std::thread finished;
+    {
+        std::lock_guard<std::mutex> lock(threads_mutex);
+        finished = std::move(command_thread);
+    }
+    if (finished.joinable()) {
+        finished.join();
+    }
+    
+    events.setTimer(idle_timer, 0);
+    if (stop_reason == StopReason::Idle) {
+        if (!command_received) {
+            RLOG_INFO("Idle timeout! No commands received.");
+        } else {
+            RLOG_INFO("Inactivity timeout reached. Server shutting down.");
+        }
     }
 
-    std::cout << "Server shutdown completed." << std::endl;
+    RLOG_INFO("Server shutdown completed.");
     syslog(LOG_INFO, "Server run method completed");
+    return stop_reason;
+}
+
+/**
+ * @brief Command thread: waits for client requests and answers them
+ * 
+ * Each post of the client semaphore announces one submitted request;
+ * the oldest waiting request is answered first, whichever client sent
+ * it. A post may find nothing to do when its client withdrew a timed
+ * out request.
+ * 
+ * The thread blocks on the client semaphore without a timeout, so an
+ * idle server does not wake it. Its heartbeat is beaten by the event
+ * loop (beatHeartbeats()), which also reclaims what exited clients left
+ * behind. A thread replaced by restartCommands() exits after its
+ * current command without answering it.
+ */
+void Server::commandLoop(uint64_t generation) {
+    command_thread_generation = generation;
+    Tracer::instance().setThreadName("commands");
+    
+    std::string policy_error;
+    if (!realtime.commands.isDefault()) {
+        if (realtime.commands.apply(pthread_self(), policy_error)) {
+            RLOG_INFO("Command thread: {}", realtime.commands.describe());
+        } else {
+            RLOG_WARN("Command thread tuning incomplete: {}", policy_error);
+        }
+    }
+
+    data->command_heartbeat.beat(Tracer::now());
+    
+    while (!stopping) {
+        if (sem_wait(sem_client) != 0) {
+            if (errno == EINTR) continue;
+            RLOG_ERROR("sem_wait failed: {}", strerror(errno));
+            requestStop(StopReason::Idle);
+            break;
+        }
+        if (stopping) {
+            break;
+        }
+        
+        int slot = data->takeNextRequest();
+        if (slot < 0) {
+            continue;
+        }
+        SharedData::RequestSlot& request = data->slots[slot];
+        command_thread_slot = &request;
+        processing_slot = slot;
+        command_received = true;
+        
+        // Time from the client's post until this thread picked the command up
+        int64_t woken_ns = Tracer::now();
+        command_started_ns.store(woken_ns, std::memory_order_release);
+        if (request.posted_ns > 0 && request.posted_ns < woken_ns) {
+            Tracer::instance().record("ipc.wakeup", "ipc", request.posted_ns, woken_ns);
+        }
+        RADIO_PROBE1(command__receive, request.command);
+        
+        // Replaced before the command started: its client was already answered
+        if (command_generation.load() != generation) {
+            abandoned_threads--;
+            RLOG_WARN("Stalled command thread returned after its replacement");
+            return;
+        }
+        processCommand(request.command);
+        
+        // Unless restartCommands() answered it meanwhile, the response
+        // written by processCommand() is still the current one
+        bool replaced;
+        {
+            std::lock_guard<std::mutex> lock(response_mutex);
+            replaced = command_generation.load() != generation;
+            if (!replaced) {
+                processing_slot = -1;
+                RADIO_PROBE2(response__send, request.response, strncmp(request.response, "ERROR", 5) == 0);
+                data->completeRequest(slot);
+            }
+        }
+        if (replaced) {
+            abandoned_threads--;
+            RLOG_WARN("Stalled command thread returned after its replacement");
+            return;
+        }
+        command_thread_slot = nullptr;
+        command_started_ns.store(0, std::memory_order_release);
+
+        RLOG_DEBUG("Response sent to client. Waiting for next command...");
+        
+        last_command_ns.store(Tracer::now(), std::memory_order_relaxed);
+    }
 }
 
 /**
  * @brief Cleans up shared memory and semaphores
  */
 void Server::cleanup() {
+    StatsPage::destroy(stats, names.stats_shm.c_str());
+    stats = nullptr;
+    
     if (data != MAP_FAILED) {
-        munmap(data, sizeof(SharedData));
-    }
-    if (shm_fd != -1) {
-        close(shm_fd);
-        shm_unlink(SHM_NAME);
+        segment.unmap();
+        SharedSegment::unlink(names.shm);
+        data = static_cast<SharedData*>(MAP_FAILED);
     }
     
     if (sem_client != SEM_FAILED) {
         sem_close(sem_client);
-        sem_unlink(SEM_CLIENT_NAME);
-    }
-    if (sem_server != SEM_FAILED) {
-        sem_close(sem_server);
-        sem_unlink(SEM_SERVER_NAME);
+        sem_unlink(names.sem_client.c_str());
     }
 }
\ No newline at end of file
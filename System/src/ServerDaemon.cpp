@@ -1,94 +1,160 @@
 #include "../include/ServerDaemon.h"
+#include "../../DaemonLib/include/Logger.h"
+#include "../../Protocol/include/Probes.h"
 #include <chrono>
 #include <thread>
 #include <csignal>
+#include <cerrno>
 #include <syslog.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <iostream>
+#include <vector>
 
-static ServerDaemon* currentDaemonInstance = nullptr;
+/**
+ * @brief Waits for a blocked SIGTERM/SIGINT, used between server instances
+ * 
+ * @return true if a stop signal arrived within the timeout
+ */
+static bool waitForStopSignal(unsigned seconds) {
+    sigset_t stop_mask;
+    sigemptyset(&stop_mask);
+    sigaddset(&stop_mask, SIGTERM);
+    sigaddset(&stop_mask, SIGINT);
+    
+    timespec timeout = {static_cast<time_t>(seconds), 0};
+    int signo;
+    while ((signo = sigtimedwait(&stop_mask, nullptr, &timeout)) == -1 && errno == EINTR) {
+    }
+    return signo > 0;
+}
 
-ServerDaemon::ServerDaemon() 
-    : DaemonBase("/tmp/radio_server.pid", "radio_server") {
-    currentDaemonInstance = this;
+/**
+ * @brief Watches the threads of one Server while it exists
+ */
+class ServerWatch {
+public:
+    ServerWatch(Watchdog& watchdog, Server& server) : watchdog_(watchdog) {
+        if (!watchdog.isRunning() || !server.monitoringHeartbeat()) return;
+        ids_.push_back(watchdog.watch("monitoring thread", server.monitoringHeartbeat(),
+                                      [&server]() { return server.restartMonitoring(); }));
+        ids_.push_back(watchdog.watch("command thread", server.commandHeartbeat(),
+                                      [&server]() { return server.restartCommands(); }));
+    }
+    
+    ~ServerWatch() {
+        for (int id : ids_) {
+            watchdog_.unwatch(id);
+        }
+    }
+    
+    ServerWatch(const ServerWatch&) = delete;
+    ServerWatch& operator=(const ServerWatch&) = delete;
+    
+private:
+    Watchdog& watchdog_;
+    std::vector<int> ids_;
+};
+
+ServerDaemon::ServerDaemon(const IpcNames& names, unsigned idle_timeout_s, const std::string& config_path) 
+    : DaemonBase(names.pid_file, names.log_ident), names_(names), idle_timeout_s_(idle_timeout_s),
+      config_path_(config_path) {
 }
 
 ServerDaemon::~ServerDaemon() {
     cleanup();
-    currentDaemonInstance = nullptr;
-}
-
-void ServerDaemon::signalHandlerWrapper(int signum) {
-    switch(signum) {
-        case SIGTERM:
-        case SIGINT:
-            if (currentDaemonInstance) {
-                syslog(LOG_INFO, "ServerDaemon stopping via signal %d", signum);
-                currentDaemonInstance->requestStop();
-            }
-            break;
-        case SIGHUP:
-            syslog(LOG_INFO, "ServerDaemon received SIGHUP");
-            break;
-    }
 }
 
 void ServerDaemon::mainLoop() {
     syslog(LOG_INFO, "Radio Control Server Daemon starting main loop");
     
-    struct sigaction sa;
-    sa.sa_handler = ServerDaemon::signalHandlerWrapper;
-    sigemptyset(&sa.sa_mask);
-    sa.sa_flags = 0;
+    // Block the signals before any thread starts so every thread inherits
+    // the mask; the Server event loop receives them from a signalfd
+    sigset_t signal_mask;
+    sigemptyset(&signal_mask);
+    sigaddset(&signal_mask, SIGTERM);
+    sigaddset(&signal_mask, SIGINT);
+    sigaddset(&signal_mask, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &signal_mask, nullptr);
     
-    sigaction(SIGTERM, &sa, nullptr);
-    sigaction(SIGINT, &sa, nullptr);
-    sigaction(SIGHUP, &sa, nullptr);
-    
-    int fd_stdout = open("/tmp/radio_server_stdout.log", O_WRONLY|O_CREAT|O_TRUNC, 0644);
-    int fd_stderr = open("/tmp/radio_server_stderr.log", O_WRONLY|O_CREAT|O_TRUNC, 0644);
+    // A restarted worker keeps the log of the one that stalled
+    int log_mode = workerRestarts() > 0 ? O_APPEND : O_TRUNC;
+    int fd_stdout = open(names_.stdout_log.c_str(), O_WRONLY|O_CREAT|log_mode, 0644);
+    int fd_stderr = open(names_.stderr_log.c_str(), O_WRONLY|O_CREAT|log_mode, 0644);
     
     if (fd_stdout != -1 && fd_stderr != -1) {
         dup2(fd_stdout, STDOUT_FILENO);
         dup2(fd_stderr, STDERR_FILENO);
     }
     
-    std::cout << "=== Radio Server Starting ===" << std::endl;
+    RLOG_INFO("=== Radio Server Starting ===");
+    if (workerRestarts() > 0) {
+        RLOG_WARN("Worker restarted by the supervisor ({} restarts)", workerRestarts());
+    }
+    
+    // mlockall() does not survive fork(), so it is done here in the daemon
+    if (realtime_.lock_memory) {
+        std::string error;
+        if (RealtimeConfig::lockMemory(error)) {
+            RLOG_INFO("Process memory locked");
+        } else {
+            RLOG_WARN("Running without locked memory: {}", error);
+        }
+    }
+    unsigned restarts = 0;
     
     while (isDaemonRunning()) {
         try {
-            std::cout << "Creating new Server instance..." << std::endl;
-            Server server;
-            std::cout << "Server instance created, calling run()..." << std::endl;
-            server.run();
-            std::cout << "Server run() completed" << std::endl;
+            {
+                // Destroyed before the restart delay, so its signalfd no
+                // longer competes with waitForStopSignal()
+                RLOG_INFO("Creating new Server instance...");
+                Server server(names_, config_path_, shm_options_);
+                server.setIdleTimeout(idle_timeout_s_);
+                server.setRealtime(realtime_);
+                notifyReady();
+                RLOG_INFO("Server instance created, calling run()...");
+                Server::StopReason reason;
+                {
+                    ServerWatch watch(watchdog(), server);
+                    reason = server.run();
+                }
+                if (reason == Server::StopReason::Signal) {
+                    requestStop();
+                }
+                RLOG_INFO("Server run() completed");
+            }
             
             if (isDaemonRunning()) {
-                std::cout << "Restarting server in 5 seconds..." << std::endl;
+                RLOG_INFO("Restarting server in 5 seconds...");
+                RADIO_PROBE2(daemon__restart, ++restarts, 0);
                 
-                if (waitWithInterrupt(5)) {
-                    std::cout << "Restart cancelled - daemon is stopping" << std::endl;
+                if (waitForStopSignal(5)) {
+                    requestStop();
+                    RLOG_INFO("Restart cancelled - daemon is stopping");
                     break;
                 }
             }
             
         } catch (const std::exception& e) {
-            std::cerr << "Server exception: " << e.what() << std::endl;
+            RLOG_ERROR("Server exception: {}", e.what());
             syslog(LOG_ERR, "Server exception: %s", e.what());
             
             if (isDaemonRunning()) {
-                std::cout << "Restarting server after exception in 5 seconds..." << std::endl;
+                RLOG_INFO("Restarting server after exception in 5 seconds...");
+                RADIO_PROBE2(daemon__restart, ++restarts, 1);
                 
-                if (waitWithInterrupt(5)) {
-                    std::cout << "Restart cancelled after exception - daemon is stopping" << std::endl;
+                if (waitForStopSignal(5)) {
+                    requestStop();
+                    RLOG_INFO("Restart cancelled after exception - daemon is stopping");
                     break;
                 }
             }
         }
     }
     
-    std::cout << "=== Radio Server Stopping ===" << std::endl;
+    RLOG_INFO("=== Radio Server Stopping ===");
+    Logger::instance().flush();
     
     if (fd_stdout != -1) close(fd_stdout);
     if (fd_stderr != -1) close(fd_stderr);
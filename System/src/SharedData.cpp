@@ -1,6 +1,284 @@
 /**
  * @file SharedData.cpp
- * @brief Definitions of shared memory constants for client-server communication
+ * @brief Creation and attachment of the shared memory segment
  */
 
-#include "../include/SharedData.h"
\ No newline at end of file
+#include "../include/SharedData.h"
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <ctime>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+
+static_assert(std::atomic<int64_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free &&
+              std::atomic<int32_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "shared atomics must be lock-free to be shared between processes");
+
+void futexWake(std::atomic<uint32_t>& word) {
+    // Not FUTEX_PRIVATE: waiters live in other processes
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+bool futexWait(std::atomic<uint32_t>& word, uint32_t expected, int64_t timeout_ns) {
+    timespec timeout;
+    timespec* limit = nullptr;
+    if (timeout_ns >= 0) {
+        timeout.tv_sec = static_cast<time_t>(timeout_ns / 1000000000LL);
+        timeout.tv_nsec = static_cast<long>(timeout_ns % 1000000000LL);
+        limit = &timeout;
+    }
+    long rc = syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected, limit, nullptr, 0);
+    return rc == 0 || errno != ETIMEDOUT;
+}
+
+int SharedData::claimConnection(uint32_t& token) {
+    int32_t pid = static_cast<int32_t>(getpid());
+    for (uint32_t i = 0; i < MAX_CONNECTIONS; ++i) {
+        int32_t free_pid = 0;
+        if (connections[i].owner_pid.compare_exchange_strong(free_pid, pid, std::memory_order_acq_rel)) {
+            token = ownerToken(i, connections[i].epoch.fetch_add(1, std::memory_order_acq_rel) + 1);
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+void SharedData::releaseConnection(int connection, uint32_t token) {
+    for (auto& slot : slots) {
+        uint64_t word = slot.control.load(std::memory_order_acquire);
+        if (RequestSlot::ownerOf(word) == token && RequestSlot::stateOf(word) != SLOT_PROCESSING) {
+            slot.control.compare_exchange_strong(word, 0, std::memory_order_acq_rel);
+        }
+    }
+    connections[connection].owner_pid.store(0, std::memory_order_release);
+}
+
+int SharedData::claimSlot(uint32_t token, uint32_t hint) {
+    for (uint32_t n = 0; n < REQUEST_SLOTS; ++n) {
+        uint32_t i = (hint + n) % REQUEST_SLOTS;
+        uint64_t free_word = 0;
+        if (slots[i].control.compare_exchange_strong(free_word, RequestSlot::word(SLOT_CLAIMED, token),
+                                                     std::memory_order_acq_rel)) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+uint64_t SharedData::submit(int slot, uint32_t token, const char* command, size_t length, int64_t now_ns) {
+    RequestSlot& request = slots[slot];
+    if (length >= sizeof(request.command)) {
+        length = sizeof(request.command) - 1;
+    }
+    memcpy(request.command, command, length);
+    request.command[length] = '\0';
+    request.posted_ns = now_ns;
+    request.request_id = requests.last_id.fetch_add(1, std::memory_order_relaxed) + 1;
+    request.control.store(RequestSlot::word(SLOT_SUBMITTED, token), std::memory_order_release);
+    return request.request_id;
+}
+
+bool SharedData::withdraw(int slot, uint32_t token) {
+    uint64_t submitted = RequestSlot::word(SLOT_SUBMITTED, token);
+    return slots[slot].control.compare_exchange_strong(submitted, 0, std::memory_order_acq_rel);
+}
+
+int SharedData::takeNextRequest() {
+    while (true) {
+        int oldest = -1;
+        uint64_t oldest_word = 0;
+        for (uint32_t i = 0; i < REQUEST_SLOTS; ++i) {
+            uint64_t word = slots[i].control.load(std::memory_order_acquire);
+            if (RequestSlot::stateOf(word) == SLOT_SUBMITTED &&
+                (oldest < 0 || slots[i].request_id < slots[oldest].request_id)) {
+                oldest = static_cast<int>(i);
+                oldest_word = word;
+            }
+        }
+        if (oldest < 0) {
+            return -1;
+        }
+        // Loses only to a client withdrawing the request; look again
+        if (slots[oldest].control.compare_exchange_strong(
+                oldest_word, RequestSlot::word(SLOT_PROCESSING, RequestSlot::ownerOf(oldest_word)),
+                std::memory_order_acq_rel)) {
+            return oldest;
+        }
+    }
+}
+
+void SharedData::completeRequest(int slot) {
+    RequestSlot& request = slots[slot];
+    request.response_id = request.request_id;
+
+    uint64_t word = request.control.load(std::memory_order_relaxed);
+    uint32_t owner = RequestSlot::ownerOf(word);
+    request.control.store(RequestSlot::word(SLOT_DONE, owner), std::memory_order_release);
+
+    Connection& connection = connections[(owner & 0xFF) % MAX_CONNECTIONS];
+    connection.completions.fetch_add(1, std::memory_order_release);
+    futexWake(connection.completions);
+}
+
+unsigned SharedData::reclaimAbandoned() {
+    unsigned reclaimed = 0;
+    for (auto& connection : connections) {
+        int32_t pid = connection.owner_pid.load(std::memory_order_acquire);
+        if (pid > 0 && kill(pid, 0) == -1 && errno == ESRCH &&
+            connection.owner_pid.compare_exchange_strong(pid, 0, std::memory_order_acq_rel)) {
+            reclaimed++;
+        }
+    }
+
+    // A slot whose owner token no longer matches a live connection has
+    // nobody left to finish or read it. Submitted and processing slots
+    // are answered first, which makes them done.
+    for (auto& slot : slots) {
+        uint64_t word = slot.control.load(std::memory_order_acquire);
+        SlotState state = RequestSlot::stateOf(word);
+        if (state != SLOT_CLAIMED && state != SLOT_DONE) {
+            continue;
+        }
+        uint32_t owner = RequestSlot::ownerOf(word);
+        uint32_t index = (owner & 0xFF) % MAX_CONNECTIONS;
+        const Connection& connection = connections[index];
+        bool live = connection.owner_pid.load(std::memory_order_acquire) != 0 &&
+                    ownerToken(index, connection.epoch.load(std::memory_order_acquire)) == owner;
+        if (!live) {
+            slot.control.compare_exchange_strong(word, 0, std::memory_order_acq_rel);
+        }
+    }
+    return reclaimed;
+}
+
+std::string SharedSegment::hugepagePath(const std::string& name) {
+    return std::string(HUGETLBFS_DIR) + (name.empty() || name[0] != '/' ? "/" : "") + name;
+}
+
+void SharedSegment::unlink(const std::string& name) {
+    shm_unlink(name.c_str());
+    ::unlink(hugepagePath(name).c_str());
+}
+
+bool SharedSegment::map(int fd, size_t length, bool create, bool writable, std::string& error) {
+    void* addr = mmap(nullptr, length, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                      MAP_SHARED | MAP_POPULATE, fd, 0);
+    if (addr == MAP_FAILED) {
+        error = std::string("mmap failed: ") + strerror(errno);
+        return false;
+    }
+
+    data_ = create ? new (addr) SharedData() : static_cast<SharedData*>(addr);
+    length_ = length;
+    return true;
+}
+
+bool SharedSegment::create(const std::string& name, const ShmOptions& options,
+                           std::string& error, std::string& warning) {
+    unmap();
+    unlink(name);
+    error.clear();
+    warning.clear();
+
+    if (options.hugepages) {
+        std::string path = hugepagePath(name);
+        int fd = ::open(path.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0666);
+        struct statfs fs;
+        if (fd != -1 && fstatfs(fd, &fs) == 0) {
+            // hugetlbfs files are sized and mapped in whole huge pages
+            size_t page = static_cast<size_t>(fs.f_bsize);
+            size_t length = (sizeof(SharedData) + page - 1) / page * page;
+            if (ftruncate(fd, length) == 0 && map(fd, length, true, true, error)) {
+                hugepages_ = true;
+            }
+        }
+        if (!hugepages_) {
+            warning = "huge pages unavailable (" + (fd == -1 ? path + ": " + strerror(errno) : error) +
+                      "), using regular pages";
+            error.clear();
+            ::unlink(path.c_str());
+        }
+        if (fd != -1) close(fd);
+    }
+
+    if (!hugepages_) {
+        int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0666);
+        if (fd == -1) {
+            error = "shm_open " + name + " failed: " + strerror(errno);
+            return false;
+        }
+        bool ok = ftruncate(fd, sizeof(SharedData)) == 0;
+        if (!ok) {
+            error = std::string("ftruncate failed: ") + strerror(errno);
+        }
+        ok = ok && map(fd, sizeof(SharedData), true, true, error);
+        close(fd);
+        if (!ok) {
+            shm_unlink(name.c_str());
+            return false;
+        }
+    }
+
+    data_->header.server_pid = getpid();
+
+    if (options.lock) {
+        locked_ = mlock(data_, length_) == 0;
+        if (!locked_) {
+            if (!warning.empty()) warning += "; ";
+            warning += std::string("mlock failed: ") + strerror(errno);
+        }
+    }
+    return true;
+}
+
+bool SharedSegment::attach(const std::string& name, std::string& error, bool writable) {
+    unmap();
+
+    int flags = writable ? O_RDWR : O_RDONLY;
+    int fd = ::open(hugepagePath(name).c_str(), flags | O_CLOEXEC);
+    hugepages_ = fd != -1;
+    if (fd == -1) {
+        fd = shm_open(name.c_str(), flags, 0666);
+    }
+    if (fd == -1) {
+        error = "cannot open shared memory " + name + ": " + strerror(errno);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SharedData::Header)) {
+        error = "shared memory " + name + " is not initialized";
+        close(fd);
+        return false;
+    }
+
+    bool ok = map(fd, static_cast<size_t>(st.st_size), false, writable, error);
+    close(fd);
+    if (!ok) return false;
+
+    if (!data_->isCompatible()) {
+        error = "shared memory " + name + " has layout version " + std::to_string(data_->header.version) +
+                ", expected " + std::to_string(SharedData::VERSION);
+        unmap();
+        return false;
+    }
+    return true;
+}
+
+void SharedSegment::unmap() {
+    if (data_) {
+        if (locked_) munlock(data_, length_);
+        munmap(data_, length_);
+    }
+    data_ = nullptr;
+    length_ = 0;
+    hugepages_ = false;
+    locked_ = false;
+}
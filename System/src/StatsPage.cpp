@@ -0,0 +1,145 @@
+#include "../include/StatsPage.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "stats page atomics must be lock-free to be shared between processes");
+
+size_t LatencyHistogram::bucketIndex(uint64_t value) {
+    if (value < SUB_BUCKETS) {
+        return static_cast<size_t>(value);
+    }
+    unsigned msb = 63 - static_cast<unsigned>(__builtin_clzll(value));
+    unsigned shift = msb - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKETS + ((value >> shift) & (SUB_BUCKETS - 1));
+}
+
+uint64_t LatencyHistogram::bucketUpper(size_t index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    unsigned shift = static_cast<unsigned>(index / SUB_BUCKETS) - 1;
+    uint64_t sub = index % SUB_BUCKETS;
+    uint64_t lower = (SUB_BUCKETS + sub) << shift;
+    return lower + ((uint64_t(1) << shift) - 1);
+}
+
+void LatencyHistogram::record(uint64_t value) {
+    buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+
+    uint64_t current = max.load(std::memory_order_relaxed);
+    while (value > current &&
+           !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+uint64_t LatencyHistogram::percentile(double quantile) const {
+    uint64_t total = 0;
+    for (const auto& bucket : buckets) {
+        total += bucket.load(std::memory_order_relaxed);
+    }
+    if (total == 0) return 0;
+
+    uint64_t rank = static_cast<uint64_t>(quantile * static_cast<double>(total) + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > total) rank = total;
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            // Never report beyond the largest value actually recorded
+            uint64_t upper = bucketUpper(i);
+            uint64_t highest = max.load(std::memory_order_relaxed);
+            return upper < highest ? upper : highest;
+        }
+    }
+    return max.load(std::memory_order_relaxed);
+}
+
+double LatencyHistogram::mean() const {
+    uint64_t n = count.load(std::memory_order_relaxed);
+    return n ? static_cast<double>(sum.load(std::memory_order_relaxed)) / n : 0.0;
+}
+
+StatsPage* StatsPage::create(const char* name) {
+    shm_unlink(name);
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd == -1) return nullptr;
+
+    if (ftruncate(fd, sizeof(StatsPage)) == -1) {
+        close(fd);
+        shm_unlink(name);
+        return nullptr;
+    }
+
+    void* addr = mmap(nullptr, sizeof(StatsPage), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        shm_unlink(name);
+        return nullptr;
+    }
+
+    // A fresh object is zero-filled, which is a valid state for the atomics
+    StatsPage* page = static_cast<StatsPage*>(addr);
+    page->size = sizeof(StatsPage);
+    page->pid = getpid();
+    page->start_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    page->version = VERSION;
+    std::atomic_thread_fence(std::memory_order_release);
+    page->magic = MAGIC;
+    return page;
+}
+
+const StatsPage* StatsPage::openReadOnly(const char* name) {
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd == -1) return nullptr;
+
+    void* addr = mmap(nullptr, sizeof(StatsPage), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) return nullptr;
+
+    const StatsPage* page = static_cast<const StatsPage*>(addr);
+    if (page->magic != MAGIC || page->version != VERSION || page->size != sizeof(StatsPage)) {
+        munmap(addr, sizeof(StatsPage));
+        return nullptr;
+    }
+    return page;
+}
+
+void StatsPage::unmap(const StatsPage* page) {
+    if (page) {
+        munmap(const_cast<StatsPage*>(page), sizeof(StatsPage));
+    }
+}
+
+void StatsPage::destroy(StatsPage* page, const char* name) {
+    if (page) {
+        unmap(page);
+        shm_unlink(name);
+    }
+}
+
+const char* StatsPage::metricName(StatsMetric metric) {
+    switch (metric) {
+        case StatsMetric::Command: return "command";
+        case StatsMetric::Set: return "set";
+        case StatsMetric::Get: return "get";
+        case StatsMetric::Alarm: return "alarm";
+        case StatsMetric::Monitor: return "monitor";
+        case StatsMetric::Status: return "status";
+        case StatsMetric::MonitoringTick: return "monitoring_tick";
+        case StatsMetric::TickSample: return "tick_sample";
+        case StatsMetric::TickArchive: return "tick_archive";
+        case StatsMetric::TickEvaluate: return "tick_evaluate";
+        case StatsMetric::TickPublish: return "tick_publish";
+        case StatsMetric::TickJitter: return "tick_jitter";
+        case StatsMetric::Count: break;
+    }
+    return "unknown";
+}
@@ -0,0 +1,514 @@
+/**
+ * @file TelemetryArchive.cpp
+ * @brief Implementation of the Gorilla-encoded telemetry archive
+ */
+
+#include "../include/TelemetryArchive.h"
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <syslog.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+
+namespace {
+
+constexpr uint32_t BLOCK_MAGIC = 0x31425447; // "GTB1"
+
+/**
+ * @brief On-disk block header, followed by payload padded to 8 bytes
+ */
+struct BlockHeader {
+    uint32_t magic;
+    uint16_t series;
+    uint16_t reserved;
+    uint32_t count;
+    uint32_t payload_bytes;
+    int64_t first_ts;
+    int64_t last_ts;
+};
+
+static_assert(sizeof(BlockHeader) == 32, "BlockHeader layout must stay stable");
+
+uint64_t doubleBits(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+double bitsDouble(uint64_t bits) {
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+int64_t signExtend(uint64_t value, int bits) {
+    uint64_t sign = 1ULL << (bits - 1);
+    return static_cast<int64_t>((value ^ sign) - sign);
+}
+
+int64_t floorDiv(int64_t a, int64_t b) {
+    int64_t q = a / b;
+    if ((a % b != 0) && ((a < 0) != (b < 0))) q--;
+    return q;
+}
+
+const char* const SERIES_NAMES[] = {"temperature", "current", "power", "voltage",
+                                     "alarm_temperature", "alarm_current", "alarm_power",
+                                     "alarm_voltage", "alarm_radio"};
+
+/**
+ * @brief Cuts a partition file after its last complete block
+ *
+ * Blocks are appended, so anything after a torn block would be
+ * unreachable for query(); cutting it lets new blocks follow the last
+ * valid one.
+ */
+void truncateTornTail(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDWR);
+    if (fd == -1) return;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return;
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    size_t offset = 0;
+    BlockHeader header;
+    while (offset + sizeof(header) <= size &&
+           pread(fd, &header, sizeof(header), static_cast<off_t>(offset)) == static_cast<ssize_t>(sizeof(header)) &&
+           header.magic == BLOCK_MAGIC) {
+        size_t padded = (header.payload_bytes + 7u) & ~static_cast<size_t>(7);
+        if (offset + sizeof(header) + padded > size) break;
+        offset += sizeof(header) + padded;
+    }
+
+    if (offset < size) {
+        if (ftruncate(fd, static_cast<off_t>(offset)) == 0) {
+            syslog(LOG_WARNING, "Telemetry archive: dropped %zu torn bytes at the end of %s",
+                   size - offset, path.c_str());
+        } else {
+            syslog(LOG_ERR, "Telemetry archive: cannot truncate %s: %s", path.c_str(), strerror(errno));
+        }
+    }
+    close(fd);
+}
+
+} // namespace
+
+// BitWriter
+
+void BitWriter::writeBit(bool bit) {
+    if (bit_count_ % 8 == 0) {
+        bytes_.push_back(0);
+    }
+    if (bit) {
+        bytes_.back() |= static_cast<uint8_t>(0x80 >> (bit_count_ % 8));
+    }
+    bit_count_++;
+}
+
+void BitWriter::writeBits(uint64_t value, int count) {
+    while (count > 0) {
+        int used = static_cast<int>(bit_count_ % 8);
+        if (used == 0) {
+            bytes_.push_back(0);
+        }
+        int room = 8 - used;
+        int take = std::min(room, count);
+        uint8_t chunk = static_cast<uint8_t>((value >> (count - take)) & ((1u << take) - 1));
+        bytes_.back() |= static_cast<uint8_t>(chunk << (room - take));
+        bit_count_ += take;
+        count -= take;
+    }
+}
+
+void BitWriter::clear() {
+    bytes_.clear();
+    bit_count_ = 0;
+}
+
+// BitReader
+
+BitReader::BitReader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+bool BitReader::readBit() {
+    if (exhausted()) return false;
+    bool bit = (data_[pos_ / 8] >> (7 - pos_ % 8)) & 1;
+    pos_++;
+    return bit;
+}
+
+uint64_t BitReader::readBits(int count) {
+    uint64_t value = 0;
+    while (count > 0 && !exhausted()) {
+        int used = static_cast<int>(pos_ % 8);
+        int room = 8 - used;
+        int take = std::min(room, count);
+        uint8_t byte = data_[pos_ / 8];
+        uint8_t chunk = static_cast<uint8_t>((byte >> (room - take)) & ((1u << take) - 1));
+        value = (value << take) | chunk;
+        pos_ += take;
+        count -= take;
+    }
+    return value;
+}
+
+// GorillaEncoder
+
+void GorillaEncoder::append(int64_t timestamp_ms, double value) {
+    uint64_t bits = doubleBits(value);
+
+    if (count_ == 0) {
+        first_ts_ = timestamp_ms;
+        writer_.writeBits(static_cast<uint64_t>(timestamp_ms), 64);
+        writer_.writeBits(bits, 64);
+        prev_ts_ = timestamp_ms;
+        prev_delta_ = 0;
+        prev_value_ = bits;
+        prev_leading_ = -1;
+        count_++;
+        return;
+    }
+
+    // Timestamp: delta-of-delta with variable-length buckets
+    int64_t delta = timestamp_ms - prev_ts_;
+    int64_t dod = delta - prev_delta_;
+
+    if (dod == 0) {
+        writer_.writeBit(0);
+    } else if (dod >= -64 && dod <= 63) {
+        writer_.writeBits(0b10, 2);
+        writer_.writeBits(static_cast<uint64_t>(dod) & 0x7F, 7);
+    } else if (dod >= -256 && dod <= 255) {
+        writer_.writeBits(0b110, 3);
+        writer_.writeBits(static_cast<uint64_t>(dod) & 0x1FF, 9);
+    } else if (dod >= -2048 && dod <= 2047) {
+        writer_.writeBits(0b1110, 4);
+        writer_.writeBits(static_cast<uint64_t>(dod) & 0xFFF, 12);
+    } else {
+        writer_.writeBits(0b1111, 4);
+        writer_.writeBits(static_cast<uint64_t>(dod), 64);
+    }
+    prev_delta_ = delta;
+    prev_ts_ = timestamp_ms;
+
+    // Value: XOR with previous, reusing the previous meaningful window when possible
+    uint64_t x = bits ^ prev_value_;
+    if (x == 0) {
+        writer_.writeBit(0);
+    } else {
+        writer_.writeBit(1);
+        int leading = std::min(__builtin_clzll(x), 31);
+        int trailing = __builtin_ctzll(x);
+
+        if (prev_leading_ >= 0 && leading >= prev_leading_ && trailing >= prev_trailing_) {
+            writer_.writeBit(0);
+            int meaningful = 64 - prev_leading_ - prev_trailing_;
+            writer_.writeBits(x >> prev_trailing_, meaningful);
+        } else {
+            writer_.writeBit(1);
+            int meaningful = 64 - leading - trailing;
+            writer_.writeBits(static_cast<uint64_t>(leading), 5);
+            writer_.writeBits(static_cast<uint64_t>(meaningful & 0x3F), 6);
+            writer_.writeBits(x >> trailing, meaningful);
+            prev_leading_ = leading;
+            prev_trailing_ = trailing;
+        }
+    }
+    prev_value_ = bits;
+    count_++;
+}
+
+void GorillaEncoder::clear() {
+    writer_.clear();
+    count_ = 0;
+    first_ts_ = 0;
+    prev_ts_ = 0;
+    prev_delta_ = 0;
+    prev_value_ = 0;
+    prev_leading_ = -1;
+    prev_trailing_ = 0;
+}
+
+// GorillaDecoder
+
+GorillaDecoder::GorillaDecoder(const uint8_t* data, size_t size, uint32_t count)
+    : reader_(data, size), remaining_(count) {}
+
+bool GorillaDecoder::next(int64_t& timestamp_ms, double& value) {
+    if (remaining_ == 0) return false;
+    remaining_--;
+
+    if (index_++ == 0) {
+        prev_ts_ = static_cast<int64_t>(reader_.readBits(64));
+        prev_value_ = reader_.readBits(64);
+        timestamp_ms = prev_ts_;
+        value = bitsDouble(prev_value_);
+        return true;
+    }
+
+    int64_t dod;
+    if (!reader_.readBit()) {
+        dod = 0;
+    } else if (!reader_.readBit()) {
+        dod = signExtend(reader_.readBits(7), 7);
+    } else if (!reader_.readBit()) {
+        dod = signExtend(reader_.readBits(9), 9);
+    } else if (!reader_.readBit()) {
+        dod = signExtend(reader_.readBits(12), 12);
+    } else {
+        dod = static_cast<int64_t>(reader_.readBits(64));
+    }
+    prev_delta_ += dod;
+    prev_ts_ += prev_delta_;
+
+    if (reader_.readBit()) {
+        if (reader_.readBit()) {
+            prev_leading_ = static_cast<int>(reader_.readBits(5));
+            int meaningful = static_cast<int>(reader_.readBits(6));
+            if (meaningful == 0) meaningful = 64;
+            prev_trailing_ = 64 - prev_leading_ - meaningful;
+        }
+        int meaningful = 64 - prev_leading_ - prev_trailing_;
+        uint64_t x = reader_.readBits(meaningful) << prev_trailing_;
+        prev_value_ ^= x;
+    }
+
+    timestamp_ms = prev_ts_;
+    value = bitsDouble(prev_value_);
+    return true;
+}
+
+// TelemetryArchive
+
+TelemetryArchive::TelemetryArchive(const std::string& directory, int64_t partition_ms,
+                                   uint32_t block_samples)
+    : directory_(directory), partition_ms_(partition_ms), block_samples_(block_samples) {}
+
+TelemetryArchive::~TelemetryArchive() {
+    flush();
+}
+
+bool TelemetryArchive::open() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (mkdir(directory_.c_str(), 0755) != 0 && errno != EEXIST) {
+        syslog(LOG_ERR, "Telemetry archive: cannot create %s: %s",
+               directory_.c_str(), strerror(errno));
+        return false;
+    }
+
+    if (DIR* dir = opendir(directory_.c_str())) {
+        while (struct dirent* entry = readdir(dir)) {
+            const char* ext = std::strstr(entry->d_name, ".gta");
+            if (ext && ext[4] == '\0') {
+                truncateTornTail(directory_ + "/" + entry->d_name);
+            }
+        }
+        closedir(dir);
+    }
+
+    open_ = true;
+    return true;
+}
+
+int TelemetryArchive::seriesIndex(const std::string& sensor) {
+    for (size_t i = 0; i < SERIES_COUNT; ++i) {
+        if (sensor == SERIES_NAMES[i]) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+std::string TelemetryArchive::partitionPath(int64_t partition) const {
+    return directory_ + "/" + std::to_string(partition * partition_ms_) + ".gta";
+}
+
+bool TelemetryArchive::append(const std::string& sensor, int64_t timestamp_ms, double value) {
+    int index = seriesIndex(sensor);
+    if (index < 0) return false;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!open_) return false;
+
+    Series& s = series_[index];
+    int64_t partition = floorDiv(timestamp_ms, partition_ms_);
+
+    if (s.encoder.count() > 0 &&
+        (partition != s.partition || timestamp_ms < s.encoder.lastTimestamp())) {
+        writeBlock(static_cast<uint16_t>(index), s);
+    }
+
+    if (s.encoder.count() == 0) {
+        s.partition = partition;
+    }
+
+    s.encoder.append(timestamp_ms, value);
+    samples_written_++;
+
+    if (s.encoder.count() >= block_samples_ || static_cast<size_t>(index) >= SENSOR_SERIES) {
+        writeBlock(static_cast<uint16_t>(index), s);
+    }
+
+    return true;
+}
+
+void TelemetryArchive::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!open_) return;
+
+    for (size_t i = 0; i < SERIES_COUNT; ++i) {
+        if (series_[i].encoder.count() > 0) {
+            writeBlock(static_cast<uint16_t>(i), series_[i]);
+        }
+    }
+}
+
+/**
+ * @brief Appends the buffered block of a series with a single writev
+ */
+void TelemetryArchive::writeBlock(uint16_t series, Series& s) {
+    const std::vector<uint8_t>& payload = s.encoder.bytes();
+
+    BlockHeader header{};
+    header.magic = BLOCK_MAGIC;
+    header.series = series;
+    header.count = s.encoder.count();
+    header.payload_bytes = static_cast<uint32_t>(payload.size());
+    header.first_ts = s.encoder.firstTimestamp();
+    header.last_ts = s.encoder.lastTimestamp();
+
+    static const uint8_t padding[8] = {0};
+    size_t pad = (8 - payload.size() % 8) % 8;
+
+    struct iovec iov[3];
+    iov[0].iov_base = &header;
+    iov[0].iov_len = sizeof(header);
+    iov[1].iov_base = const_cast<uint8_t*>(payload.data());
+    iov[1].iov_len = payload.size();
+    iov[2].iov_base = const_cast<uint8_t*>(padding);
+    iov[2].iov_len = pad;
+
+    std::string path = partitionPath(s.partition);
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd == -1) {
+        syslog(LOG_ERR, "Telemetry archive: cannot open %s: %s", path.c_str(), strerror(errno));
+    } else {
+        struct stat st;
+        off_t start = fstat(fd, &st) == 0 ? st.st_size : -1;
+        ssize_t total = static_cast<ssize_t>(sizeof(header) + payload.size() + pad);
+        ssize_t written = writev(fd, iov, 3);
+        if (written == total) {
+            bytes_written_ += static_cast<uint64_t>(written);
+        } else {
+            syslog(LOG_ERR, "Telemetry archive: write to %s failed: %s", path.c_str(),
+                   written < 0 ? strerror(errno) : "short write");
+            // Never leave a partial block in front of later ones
+            if (written > 0 && start >= 0 && ftruncate(fd, start) != 0) {
+                syslog(LOG_ERR, "Telemetry archive: cannot truncate %s: %s", path.c_str(), strerror(errno));
+            }
+        }
+        close(fd);
+    }
+
+    s.encoder.clear();
+}
+
+size_t TelemetryArchive::query(const std::string& sensor, int64_t from_ms, int64_t to_ms,
+                               std::vector<Point>& out) const {
+    int index = seriesIndex(sensor);
+    if (index < 0 || to_ms < from_ms) return 0;
+
+    size_t before = out.size();
+
+    // Collect overlapping partitions in chronological order
+    std::vector<int64_t> starts;
+    DIR* dir = opendir(directory_.c_str());
+    if (dir) {
+        while (struct dirent* entry = readdir(dir)) {
+            const char* name = entry->d_name;
+            const char* ext = std::strstr(name, ".gta");
+            if (!ext || ext[4] != '\0') continue;
+
+            char* end = nullptr;
+            long long start = std::strtoll(name, &end, 10);
+            if (end != ext) continue;
+            if (start > to_ms || start + partition_ms_ <= from_ms) continue;
+            starts.push_back(start);
+        }
+        closedir(dir);
+    }
+    std::sort(starts.begin(), starts.end());
+
+    auto emit = [&](const uint8_t* payload, size_t size, uint32_t count) {
+        GorillaDecoder decoder(payload, size, count);
+        int64_t ts;
+        double value;
+        while (decoder.next(ts, value)) {
+            if (ts > to_ms) break;
+            if (ts >= from_ms) out.push_back({ts, value});
+        }
+    };
+
+    for (int64_t start : starts) {
+        std::string path = directory_ + "/" + std::to_string(start) + ".gta";
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd == -1) continue;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(BlockHeader))) {
+            close(fd);
+            continue;
+        }
+
+        size_t size = static_cast<size_t>(st.st_size);
+        void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) continue;
+        madvise(map, size, MADV_SEQUENTIAL);
+
+        const uint8_t* base = static_cast<const uint8_t*>(map);
+        size_t offset = 0;
+
+        while (offset + sizeof(BlockHeader) <= size) {
+            BlockHeader header;
+            std::memcpy(&header, base + offset, sizeof(header));
+            if (header.magic != BLOCK_MAGIC) break;
+
+            size_t padded = (header.payload_bytes + 7u) & ~static_cast<size_t>(7);
+            if (offset + sizeof(BlockHeader) + header.payload_bytes > size) break; // torn tail
+
+            if (header.series == index && header.last_ts >= from_ms && header.first_ts <= to_ms) {
+                emit(base + offset + sizeof(BlockHeader), header.payload_bytes, header.count);
+            }
+            offset += sizeof(BlockHeader) + padded;
+        }
+
+        munmap(map, size);
+    }
+
+    // Samples not yet written to disk
+    std::lock_guard<std::mutex> lock(mutex_);
+    const GorillaEncoder& pending = series_[index].encoder;
+    if (pending.count() > 0 && pending.lastTimestamp() >= from_ms && pending.firstTimestamp() <= to_ms) {
+        emit(pending.bytes().data(), pending.bytes().size(), pending.count());
+    }
+
+    return out.size() - before;
+}
+
+uint64_t TelemetryArchive::bytesWritten() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_written_;
+}
+
+uint64_t TelemetryArchive::samplesWritten() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return samples_written_;
+}
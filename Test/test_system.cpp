@@ -1,9 +1,43 @@
 #include <gtest/gtest.h>
+#include <thread>
+#include <atomic>
 #include "../Protocol/include/SystemData.h"
 #include "../Protocol/include/System.h"
 #include "../Protocol/include/Set.h"
 #include "../Protocol/include/Get.h"
 #include "../System/include/Alarm.h"
+#include "../System/include/MONITOR.h"
+#include "../Protocol/include/SensorHistory.h"
+#include "../System/include/TelemetryArchive.h"
+#include "../Protocol/include/SensorStats.h"
+#include "../Protocol/include/AnomalyDetector.h"
+#include "../Protocol/include/SensorSource.h"
+#include "../Protocol/include/TraceReplay.h"
+#include "../Protocol/include/AlarmRules.h"
+#include "../Protocol/include/AlarmBus.h"
+#include "../Protocol/include/SystemSnapshot.h"
+#include "../Protocol/include/WriteAheadLog.h"
+#include "../Protocol/include/MonitoringConfig.h"
+#include "../DaemonLib/include/Logger.h"
+#include "../System/include/StatsPage.h"
+#include "../System/include/IpcNames.h"
+#include "../System/include/SharedData.h"
+#include "../DaemonLib/include/Trace.h"
+#include "../DaemonLib/include/EventLoop.h"
+#include "../DaemonLib/include/Realtime.h"
+#include "../DaemonLib/include/Watchdog.h"
+#include "../ClientLib/include/RadioClient.h"
+#include "../ClientLib/include/radio_client.h"
+#include "../System/include/CommandOutput.h"
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <csignal>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <future>
+#include <algorithm>
 
 // SystemData tests
 TEST(SystemData, can_create_system_data)
@@ -317,6 +351,1547 @@ TEST(ALARM, no_alarms_under_normal_conditions)
     EXPECT_FALSE(alarm_triggered);
 }
 
+// SensorHistory tests
+TEST(SensorHistory, query_returns_raw_samples_for_small_step)
+{
+    SensorHistory history;
+    for (int i = 0; i < 10; ++i) {
+        history.record(1000000 + i * 100, i);
+    }
+    
+    std::vector<SensorHistory::Point> points;
+    EXPECT_EQ(SensorHistory::Tier::Raw, history.query(1000000, 1000900, 100, points));
+    ASSERT_EQ(10u, points.size());
+    EXPECT_DOUBLE_EQ(3.0, points[3].avg);
+}
+
+TEST(SensorHistory, query_rolls_up_min_max_avg)
+{
+    SensorHistory history;
+    for (int i = 0; i < 120; ++i) {
+        history.record(60000 * 1000LL + i * 1000, i % 60);
+    }
+    
+    std::vector<SensorHistory::Point> points;
+    EXPECT_EQ(SensorHistory::Tier::Minute,
+              history.query(60000 * 1000LL, 60000 * 1000LL + 119000, 60000, points));
+    ASSERT_EQ(2u, points.size());
+    EXPECT_DOUBLE_EQ(0.0, points[0].min);
+    EXPECT_DOUBLE_EQ(59.0, points[0].max);
+    EXPECT_DOUBLE_EQ(29.5, points[0].avg);
+    EXPECT_EQ(60u, points[0].count);
+}
+
+TEST(SensorHistory, query_includes_bucket_overlapping_range_start)
+{
+    SensorHistory history;
+    for (int i = 0; i < 120; ++i) {
+        history.record(60000 * 1000LL + i * 1000, i % 60);
+    }
+    
+    // Lies inside the first minute bucket, which starts before it
+    std::vector<SensorHistory::Point> points;
+    EXPECT_EQ(SensorHistory::Tier::Minute,
+              history.query(60000 * 1000LL + 30000, 60000 * 1000LL + 50000, 60000, points));
+    ASSERT_EQ(1u, points.size());
+    EXPECT_EQ(60000 * 1000LL + 30000, points[0].start_ms);
+    EXPECT_DOUBLE_EQ(59.0, points[0].max);
+    EXPECT_EQ(60u, points[0].count);
+}
+
+TEST(SensorHistory, raw_ring_is_bounded)
+{
+    SensorHistory history;
+    for (size_t i = 0; i < SensorHistory::RAW_CAPACITY * 2; ++i) {
+        history.record(static_cast<int64_t>(i), 1.0);
+    }
+    
+    std::vector<SensorHistory::Point> points;
+    history.query(0, SensorHistory::RAW_CAPACITY * 2, 1, points);
+    EXPECT_EQ(SensorHistory::RAW_CAPACITY, points.size());
+    EXPECT_EQ(SensorHistory::RAW_CAPACITY * 2, history.totalSamples());
+}
+
+TEST(SystemData, updateMonitoringSensors_records_history)
+{
+    SystemData data;
+    data.updateMonitoringSensors();
+    data.updateMonitoringSensors();
+    
+    EXPECT_EQ(2u, data.getSensorHistory("temperature")->totalSamples());
+    EXPECT_EQ(nullptr, data.getSensorHistory("unknown"));
+}
+
+// TelemetryArchive tests
+TEST(TelemetryArchive, gorilla_roundtrip_preserves_points)
+{
+    GorillaEncoder encoder;
+    std::vector<std::pair<int64_t, double>> input;
+    int64_t ts = 1700000000000LL;
+    for (int i = 0; i < 500; ++i) {
+        ts += 1000 + (i % 7 == 0 ? 3 : 0) - (i % 11 == 0 ? 5000 : 0);
+        double value = 25.0 + (i % 13) * 0.25 - (i % 5 == 0 ? 1e6 : 0.0);
+        input.push_back({ts, value});
+        encoder.append(ts, value);
+    }
+    
+    GorillaDecoder decoder(encoder.bytes().data(), encoder.bytes().size(), encoder.count());
+    int64_t out_ts;
+    double out_value;
+    for (const auto& point : input) {
+        ASSERT_TRUE(decoder.next(out_ts, out_value));
+        EXPECT_EQ(point.first, out_ts);
+        EXPECT_DOUBLE_EQ(point.second, out_value);
+    }
+    EXPECT_FALSE(decoder.next(out_ts, out_value));
+}
+
+TEST(TelemetryArchive, query_reads_flushed_and_pending_blocks)
+{
+    char dir_template[] = "/tmp/radio_archive_testXXXXXX";
+    ASSERT_NE(nullptr, mkdtemp(dir_template));
+    
+    {
+        TelemetryArchive archive(dir_template, 60 * 1000, 16);
+        ASSERT_TRUE(archive.open());
+        for (int i = 0; i < 100; ++i) {
+            EXPECT_TRUE(archive.append("temperature", 1000LL * i, i * 0.5));
+        }
+        EXPECT_FALSE(archive.append("unknown", 0, 0.0));
+        
+        std::vector<TelemetryArchive::Point> points;
+        EXPECT_EQ(41u, archive.query("temperature", 10000, 50000, points));
+        EXPECT_EQ(10000, points.front().timestamp_ms);
+        EXPECT_DOUBLE_EQ(25.0, points.back().value);
+    }
+    
+    TelemetryArchive reopened(dir_template, 60 * 1000, 16);
+    std::vector<TelemetryArchive::Point> points;
+    EXPECT_EQ(100u, reopened.query("temperature", 0, 100000, points));
+    
+    std::system((std::string("rm -rf ") + dir_template).c_str());
+}
+
+TEST(TelemetryArchive, alarms_are_written_at_once_and_read_back)
+{
+    char dir_template[] = "/tmp/radio_archive_testXXXXXX";
+    ASSERT_NE(nullptr, mkdtemp(dir_template));
+    
+    TelemetryArchive archive(dir_template, 60 * 1000, 16);
+    ASSERT_TRUE(archive.open());
+    EXPECT_TRUE(archive.append("alarm_temperature", 5000, 91.5));
+    EXPECT_TRUE(archive.append("alarm_radio", 6000, 0.0));
+    EXPECT_FALSE(archive.append("alarm_pressure", 6000, 1.0));
+    EXPECT_TRUE(archive.append("temperature", 5000, 91.5));
+    
+    // Alarms are on disk before any flush, unlike buffered sensor samples
+    TelemetryArchive reader(dir_template, 60 * 1000, 16);
+    std::vector<TelemetryArchive::Point> points;
+    ASSERT_EQ(1u, reader.query("alarm_temperature", 0, 10000, points));
+    EXPECT_EQ(5000, points[0].timestamp_ms);
+    EXPECT_DOUBLE_EQ(91.5, points[0].value);
+    EXPECT_EQ(1u, reader.query("alarm_radio", 0, 10000, points));
+    EXPECT_EQ(0u, reader.query("temperature", 0, 10000, points));
+    
+    std::system((std::string("rm -rf ") + dir_template).c_str());
+}
+
+TEST(TelemetryArchive, reopen_cuts_torn_block_so_new_blocks_stay_readable)
+{
+    char dir_template[] = "/tmp/radio_archive_testXXXXXX";
+    ASSERT_NE(nullptr, mkdtemp(dir_template));
+    
+    {
+        TelemetryArchive archive(dir_template, 60 * 1000, 16);
+        ASSERT_TRUE(archive.open());
+        for (int i = 0; i < 32; ++i) {
+            archive.append("temperature", 1000LL * i, i);
+        }
+    }
+    
+    // Half a block header, as left by a crash in the middle of a write
+    std::string partition = std::string(dir_template) + "/0.gta";
+    {
+        std::ofstream torn(partition, std::ios::binary | std::ios::app);
+        torn.write("GTB1\x00\x00\x00\x00\x10", 9);
+    }
+    
+    {
+        TelemetryArchive archive(dir_template, 60 * 1000, 16);
+        ASSERT_TRUE(archive.open());
+        for (int i = 32; i < 48; ++i) {
+            archive.append("temperature", 1000LL * i, i);
+        }
+    }
+    
+    TelemetryArchive reopened(dir_template, 60 * 1000, 16);
+    std::vector<TelemetryArchive::Point> points;
+    EXPECT_EQ(48u, reopened.query("temperature", 0, 60000, points));
+    EXPECT_DOUBLE_EQ(47.0, points.back().value);
+    
+    std::system((std::string("rm -rf ") + dir_template).c_str());
+}
+
+// SensorStats tests
+TEST(SensorStats, computes_mean_variance_and_quantiles)
+{
+    SensorStats stats(0.5);
+    for (int i = 1; i <= 10000; ++i) {
+        stats.update(i);
+    }
+    
+    SensorStats::Snapshot s = stats.snapshot();
+    EXPECT_EQ(10000u, s.count);
+    EXPECT_DOUBLE_EQ(5000.5, s.mean);
+    EXPECT_NEAR(2886.9, s.stddev, 0.1);
+    EXPECT_DOUBLE_EQ(1.0, s.min);
+    EXPECT_DOUBLE_EQ(10000.0, s.max);
+    EXPECT_NEAR(5000.0, s.p50, 200.0);
+    EXPECT_NEAR(9900.0, s.p99, 200.0);
+    EXPECT_GT(s.ewma, 9990.0);
+}
+
+TEST(SensorStats, sketch_memory_is_bounded)
+{
+    KllSketch sketch(100);
+    for (int i = 0; i < 1000000; ++i) {
+        sketch.update(i % 1000);
+    }
+    
+    EXPECT_EQ(1000000u, sketch.count());
+    EXPECT_LT(sketch.retained(), 400u);
+}
+
+// AnomalyDetector tests
+TEST(AnomalyDetector, static_mode_never_triggers)
+{
+    AnomalyDetector detector;
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_FALSE(detector.update(i % 2 ? 1000.0 : -1000.0).triggered);
+    }
+}
+
+TEST(AnomalyDetector, configuration_changes_while_scoring)
+{
+    AnomalyDetector detector;
+    detector.setMode(DetectorMode::Mad);
+    std::atomic<bool> stop{false};
+    std::thread monitoring([&]() {
+        for (int i = 0; !stop; ++i) {
+            AnomalyDetector::Result result = detector.update(50.0 + (i % 7) * 0.1);
+            EXPECT_FALSE(std::isnan(result.score));
+        }
+    });
+    
+    const DetectorMode modes[] = {DetectorMode::ZScore, DetectorMode::Mad, DetectorMode::Static};
+    for (int i = 0; i < 3000; ++i) {
+        detector.setMode(modes[i % 3]);
+        detector.setThreshold(i % 2 ? 4.0 : 0.0);
+    }
+    stop = true;
+    monitoring.join();
+    
+    // Last change: i = 2999
+    EXPECT_EQ(DetectorMode::Static, detector.mode());
+    EXPECT_DOUBLE_EQ(4.0, detector.configuredThreshold());
+    EXPECT_DOUBLE_EQ(4.0, detector.threshold());
+}
+
+TEST(AnomalyDetector, triggers_once_per_excursion)
+{
+    for (DetectorMode mode : {DetectorMode::ZScore, DetectorMode::Mad}) {
+        AnomalyDetector detector;
+        detector.setMode(mode);
+        
+        for (int i = 0; i < 64; ++i) {
+            EXPECT_FALSE(detector.update(50.0 + (i % 5) * 0.1).triggered);
+        }
+        
+        EXPECT_TRUE(detector.update(80.0).triggered);
+        EXPECT_FALSE(detector.update(80.0).triggered);
+        
+        AnomalyDetector::Result result;
+        EXPECT_TRUE(detector.takeTrigger(result));
+        EXPECT_GT(result.score, detector.threshold());
+        EXPECT_FALSE(detector.takeTrigger(result));
+    }
+}
+
+TEST(SystemData, detector_mode_replaces_static_thresholds)
+{
+    SystemData data;
+    data.monitoring.current_config.monitor = false;
+    data.monitoring.power_config.monitor = false;
+    data.monitoring.voltage_config.monitor = false;
+    data.monitoring.temp_detector.setMode(DetectorMode::Mad);
+    
+    // Normal operating point above the static warning band
+    for (int i = 0; i < 32; ++i) {
+        data.monitoring.temperature = 75.0 + (i % 3) * 0.2;
+        data.monitoring.temp_detector.update(data.monitoring.temperature);
+        data.checkMonitoringThresholds();
+    }
+    EXPECT_TRUE(data.getActiveAlarms().empty());
+    
+    data.monitoring.temperature = 120.0;
+    data.monitoring.temp_detector.update(data.monitoring.temperature);
+    data.checkMonitoringThresholds();
+    data.checkMonitoringThresholds();
+    ASSERT_EQ(1u, data.getActiveAlarms().size());
+    EXPECT_EQ("temperature", data.getActiveAlarms()[0].sensor);
+}
+
+// SensorSource tests
+TEST(SensorSource, synthetic_source_is_deterministic)
+{
+    SyntheticSensorSource a(10, 1000, 7);
+    SyntheticSensorSource b(10, 1000, 7);
+    SensorSample sa, sb;
+    
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(a.next(sa));
+        ASSERT_TRUE(b.next(sb));
+        EXPECT_DOUBLE_EQ(sa.temperature, sb.temperature);
+        EXPECT_DOUBLE_EQ(sa.voltage, sb.voltage);
+    }
+    EXPECT_FALSE(a.next(sa));
+}
+
+TEST(SensorSource, trace_roundtrip_in_csv_and_binary)
+{
+    for (const char* path : {"/tmp/radio_trace_test.csv", "/tmp/radio_trace_test.bin"}) {
+        SyntheticSensorSource source(50, 500, 3, 0.001, 1700000000000LL);
+        EXPECT_EQ(50u, TraceSensorSource::write(path, source, 100));
+        
+        SyntheticSensorSource expected(50, 500, 3, 0.001, 1700000000000LL);
+        TraceSensorSource trace(path);
+        ASSERT_TRUE(trace.isOpen());
+        
+        SensorSample want, got;
+        size_t count = 0;
+        while (trace.next(got)) {
+            ASSERT_TRUE(expected.next(want));
+            EXPECT_EQ(want.timestamp_ms, got.timestamp_ms);
+            EXPECT_NEAR(want.power, got.power, 1e-5);
+            count++;
+        }
+        EXPECT_EQ(50u, count);
+        std::remove(path);
+    }
+}
+
+TEST(TraceReplay, replays_source_through_pipeline)
+{
+    SystemData data;
+    data.setSensorSource(std::make_unique<SyntheticSensorSource>(500, 1000, 1, 0.05));
+    
+    TraceReplay replay(data);
+    TraceReplay::Result result = replay.run(TraceReplay::Options());
+    
+    EXPECT_EQ(500u, result.samples);
+    EXPECT_EQ(500, data.monitoring.total_sensor_updates);
+    EXPECT_GT(result.alarms, 0u);
+    EXPECT_EQ(500u, data.getSensorStats("power")->snapshot().count);
+}
+
+// AlarmRuleEngine tests
+TEST(AlarmRuleEngine, evaluates_compiled_expressions)
+{
+    AlarmRuleEngine engine;
+    std::string error;
+    ASSERT_TRUE(engine.load({
+        {"deviation", "WARNING", "abs(real_output_power - nominal_output_power) > 2 && !(temp < 0)", "", ""},
+        {"combined", "ERROR", "temperature > 60 && current * 2 >= 14", "", ""}
+    }, error)) << error;
+    
+    double values[AlarmRuleEngine::VARIABLE_COUNT] = {};
+    values[static_cast<size_t>(RuleVariable::RealOutputPower)] = 5.0;
+    values[static_cast<size_t>(RuleVariable::Temperature)] = 65.0;
+    values[static_cast<size_t>(RuleVariable::Current)] = 7.0;
+    
+    std::vector<std::string> fired;
+    auto collect = [&](const CompiledRule& rule) { fired.push_back(rule.source.name); };
+    
+    EXPECT_EQ(1u, engine.evaluate(RuleDomain::Radio, values, 0, collect));
+    EXPECT_EQ(1u, engine.evaluate(RuleDomain::Monitor, values, 0x1, collect));
+    EXPECT_EQ(0u, engine.evaluate(RuleDomain::Monitor, values, 0x2, collect));
+    ASSERT_EQ(2u, fired.size());
+    EXPECT_EQ("deviation", fired[0]);
+    EXPECT_EQ("combined", fired[1]);
+}
+
+TEST(AlarmRuleEngine, rejects_invalid_rules_and_keeps_active_set)
+{
+    AlarmRuleEngine engine;
+    std::string error;
+    ASSERT_TRUE(engine.addRule({"hot", "WARNING", "temp > 80", "", ""}, error));
+    
+    EXPECT_FALSE(engine.addRule({"bad", "WARNING", "temp >", "", ""}, error));
+    EXPECT_FALSE(engine.addRule({"bad", "WARNING", "pressure > 1", "", ""}, error));
+    EXPECT_NE(std::string::npos, error.find("pressure"));
+    ASSERT_EQ(1u, engine.rules().size());
+    
+    EXPECT_TRUE(engine.removeRule("hot"));
+    EXPECT_FALSE(engine.removeRule("hot"));
+    EXPECT_TRUE(engine.rules().empty());
+}
+
+TEST(AlarmRuleEngine, threshold_rebuild_keeps_concurrent_rules_and_exact_limits)
+{
+    SystemData data;
+    const int rules = 200;
+    std::thread reload([&]() {
+        std::string error;
+        for (int i = 0; i < rules; ++i) {
+            EXPECT_TRUE(data.rebuildThresholdRules(error)) << error;
+        }
+    });
+    std::string error;
+    for (int i = 0; i < rules; ++i) {
+        EXPECT_TRUE(data.alarm_rules.addRule({"custom_" + std::to_string(i), "WARNING", "temp > 80", "", ""}, error));
+    }
+    reload.join();
+    
+    int custom = 0;
+    for (const auto& rule : data.alarm_rules.rules()) {
+        if (rule.name.rfind("custom_", 0) == 0) ++custom;
+    }
+    EXPECT_EQ(rules, custom);
+    
+    data.monitoring.thresholds.temp_warning_max = 60.123456789012;
+    ASSERT_TRUE(data.rebuildThresholdRules(error)) << error;
+    bool found = false;
+    for (const auto& rule : data.alarm_rules.rules()) {
+        if (rule.name == "threshold_temperature_warning_max") {
+            found = true;
+            std::string limit = rule.expression.substr(rule.expression.rfind(' ') + 1);
+            EXPECT_EQ(60.123456789012, std::stod(limit)) << rule.expression;
+        }
+    }
+    EXPECT_TRUE(found);
+}
+
+TEST(AlarmRuleEngine, group_reports_first_matching_rule)
+{
+    SystemData data;
+    ALARM alarm(data);
+    std::vector<std::string> messages;
+    alarm.setAlarmCallback([&](const std::string& message) { messages.push_back(message); });
+    
+    data.temp = 105.0;
+    data.nominal_output_power = 5.0;
+    data.real_output_power = 5.0;
+    data.input_power = -15.0;
+    alarm.checkAllAlarms();
+    ASSERT_EQ(1u, messages.size());
+    EXPECT_EQ(0u, messages[0].find("Error: Dangerous temperature"));
+    
+    std::string error;
+    ASSERT_TRUE(data.alarm_rules.addRule({"warm", "WARNING", "temp > 100 && input_power < 0", "", ""}, error));
+    messages.clear();
+    alarm.checkAllAlarms();
+    EXPECT_EQ(2u, messages.size());
+}
+
+TEST(AlarmRuleEngine, rules_listing_counts_only_matching_rules)
+{
+    SystemData data;
+    MONITOR monitor(data);
+    std::string error;
+    ASSERT_TRUE(data.alarm_rules.addRule({"temp_a", "WARNING", "temperature > 1", "", ""}, error));
+    ASSERT_TRUE(data.alarm_rules.addRule({"temp_b", "WARNING", "temperature > 2", "", ""}, error));
+    
+    std::string listing = monitor.execute("RULES temp_");
+    EXPECT_EQ(0u, listing.find("Alarm Rules (2):")) << listing;
+    EXPECT_EQ(2, std::count(listing.begin(), listing.end(), '\n'));
+    EXPECT_EQ("Alarm Rules (0):", monitor.execute("RULES none_"));
+    
+    listing = monitor.execute("RULES");
+    EXPECT_EQ(0u, listing.find("Alarm Rules (" + std::to_string(data.alarm_rules.rules().size()) + "):"));
+}
+
+// AlarmBus tests
+TEST(AlarmBus, delivers_events_from_many_producers)
+{
+    AlarmBus bus(256);
+    std::atomic<int> received{0};
+    std::atomic<int> monitor_events{0};
+    bus.subscribe([&](const AlarmEvent&) { received++; });
+    bus.subscribe([&](const AlarmEvent& event) {
+        if (event.source == AlarmEvent::Source::Monitor) monitor_events++;
+    });
+    bus.start();
+    
+    std::vector<std::thread> producers;
+    for (int t = 0; t < 4; ++t) {
+        producers.emplace_back([&bus]() {
+            for (int i = 0; i < 50; ++i) {
+                bus.publish(AlarmEvent::Source::Monitor, "temperature", "WARNING", "test");
+            }
+        });
+    }
+    for (auto& producer : producers) producer.join();
+    bus.stop();
+    
+    EXPECT_EQ(200u, bus.published());
+    EXPECT_EQ(0u, bus.dropped());
+    EXPECT_EQ(200, received.load());
+    EXPECT_EQ(200, monitor_events.load());
+}
+
+TEST(AlarmBus, drops_when_full_and_publishes_alarms)
+{
+    AlarmBus bus(4);
+    for (int i = 0; i < 6; ++i) {
+        bus.publish(AlarmEvent::Source::Radio, "radio", "ERROR", "overflow");
+    }
+    EXPECT_EQ(4u, bus.published());
+    EXPECT_EQ(2u, bus.dropped());
+    EXPECT_EQ(4u, bus.drain());
+    
+    SystemData data;
+    data.alarm_bus = &bus;
+    std::string last_message;
+    bus.subscribe([&](const AlarmEvent& event) { last_message = event.message; });
+    
+    data.addAlarm("power", "Power above error threshold", "ERROR", 95.0, 90.0);
+    EXPECT_EQ(1u, bus.drain());
+    EXPECT_EQ("Power above error threshold", last_message);
+}
+
+TEST(AlarmBus, monitoring_tick_publishes_radio_rules)
+{
+    AlarmBus bus(16);
+    SystemData data;
+    data.alarm_bus = &bus;
+    std::vector<AlarmEvent::Source> sources;
+    bus.subscribe([&](const AlarmEvent& event) { sources.push_back(event.source); });
+    
+    std::string error;
+    ASSERT_TRUE(data.alarm_rules.addRule({"hot_radio", "ERROR", "temp > 100", "Radio too hot", ""},
+                                         error)) << error;
+    data.temp = 105.0;
+    
+    // Without the radio rules only the monitoring domain is evaluated
+    data.checkMonitoringThresholds();
+    EXPECT_EQ(0u, bus.drain());
+    
+    data.checkMonitoringThresholds(true);
+    EXPECT_EQ(1u, bus.drain());
+    ASSERT_EQ(1u, sources.size());
+    EXPECT_EQ(AlarmEvent::Source::Radio, sources[0]);
+    EXPECT_TRUE(data.getActiveAlarms().empty());
+}
+
+// Logger tests
+TEST(Logger, formats_records_from_threads_in_order)
+{
+    char path[] = "/tmp/radio_logger_testXXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_NE(-1, fd);
+    
+    Logger& logger = Logger::instance();
+    logger.flush();
+    logger.setOutput(fd);
+    
+    std::string command = "SET frequency 30";
+    RLOG_INFO("Processing command: {}", command);
+    std::thread worker([]() {
+        RLOG_WARN("value={} ok={} name={}", 2.5, true, "sensor");
+    });
+    worker.join();
+    RLOG_DEBUG("elided {}", 1);
+    RLOG_ERROR("missing {} {}", 7);
+    logger.flush();
+    logger.setOutput(STDOUT_FILENO);
+    
+    std::string text(4096, '\0');
+    ssize_t n = pread(fd, &text[0], text.size(), 0);
+    close(fd);
+    unlink(path);
+    ASSERT_GT(n, 0);
+    text.resize(n);
+    
+    EXPECT_NE(std::string::npos, text.find("INFO  ["));
+    EXPECT_NE(std::string::npos, text.find("Processing command: SET frequency 30\n"));
+    EXPECT_NE(std::string::npos, text.find("value=2.5 ok=true name=sensor\n"));
+    EXPECT_NE(std::string::npos, text.find("missing 7 {}\n"));
+    EXPECT_EQ(std::string::npos, text.find("elided"));
+    EXPECT_LT(text.find("Processing command"), text.find("value=2.5"));
+}
+
+// StatsPage tests
+TEST(StatsPage, histogram_percentiles_within_bucket_precision)
+{
+    std::unique_ptr<LatencyHistogram> h(new LatencyHistogram());
+    for (uint64_t v = 1; v <= 100000; ++v) {
+        h->record(v * 100);
+    }
+    
+    EXPECT_EQ(100000u, h->count.load());
+    EXPECT_EQ(10000000u, h->max.load());
+    EXPECT_NEAR(5000000.0, static_cast<double>(h->percentile(0.50)), 5000000.0 / 16);
+    EXPECT_NEAR(9900000.0, static_cast<double>(h->percentile(0.99)), 9900000.0 / 16);
+    EXPECT_NEAR(9990000.0, static_cast<double>(h->percentile(0.999)), 9990000.0 / 16);
+    EXPECT_NEAR(5000050.0, h->mean(), 1.0);
+    
+    for (uint64_t v : {0ull, 15ull, 16ull, 17ull, 1000ull, 123456789ull, ~0ull}) {
+        size_t index = LatencyHistogram::bucketIndex(v);
+        ASSERT_LT(index, LatencyHistogram::BUCKETS);
+        EXPECT_GE(LatencyHistogram::bucketUpper(index), v);
+        EXPECT_LE(LatencyHistogram::bucketUpper(index) - v, v / 16);
+    }
+}
+
+TEST(StatsPage, reader_sees_writer_updates)
+{
+    const char* name = "/radio_control_stats_test";
+    StatsPage* page = StatsPage::create(name);
+    ASSERT_NE(nullptr, page);
+    
+    {
+        StatsTimer timer(page, StatsMetric::Get);
+    }
+    page->commands_total.fetch_add(3);
+    
+    const StatsPage* reader = StatsPage::openReadOnly(name);
+    ASSERT_NE(nullptr, reader);
+    EXPECT_EQ(3u, reader->commands_total.load());
+    EXPECT_EQ(1u, reader->histogram(StatsMetric::Get).count.load());
+    EXPECT_EQ(0u, reader->histogram(StatsMetric::Set).count.load());
+    
+    StatsPage::unmap(reader);
+    StatsPage::destroy(page, name);
+    EXPECT_EQ(nullptr, StatsPage::openReadOnly(name));
+}
+
+TEST(SystemData, loop_telemetry_accounts_phases_jitter_and_overruns)
+{
+    SystemData data;
+    auto& loop = data.monitoring.loop;
+    
+    loop.record(100, 1000, 2000, 3000, 4000, 1000000);
+    loop.record(300, 500000, 200000, 300000, 100000, 1000000);
+    
+    EXPECT_EQ(2u, loop.ticks.load());
+    EXPECT_EQ(1u, loop.overruns.load());
+    EXPECT_EQ(1100000, loop.tick_ns.load());
+    EXPECT_EQ(1100000, loop.max_tick_ns.load());
+    EXPECT_EQ(500000, loop.sample_ns.load());
+    EXPECT_EQ(300, loop.max_jitter_ns.load());
+    EXPECT_EQ(200, loop.averageJitter());
+    
+    loop.reset();
+    EXPECT_EQ(0u, loop.ticks.load());
+    EXPECT_EQ(0, loop.averageJitter());
+}
+
+TEST(SystemSnapshot, restores_configuration_thresholds_and_alarms)
+{
+    std::string path = "/tmp/radio_snapshot_test_" + std::to_string(getpid()) + ".bin";
+    std::string error;
+    
+    SystemData original;
+    original.nominal_output_power = 7.0;
+    original.frequency = 25.3;
+    original.automatic_modulation = false;
+    original.monitoring.thresholds.temp_warning_max = 55.0;
+    original.monitoring.power_config.monitor = false;
+    original.monitoring.polling_interval_ms = 250;
+    original.monitoring.current_detector.setMode(DetectorMode::Mad);
+    original.monitoring.current_detector.setThreshold(4.5);
+    std::string id = original.addAlarm("temperature", "Hot", "ERROR", 90.0, 85.0);
+    original.acknowledgeAlarm(id);
+    ASSERT_TRUE(SystemSnapshot::save(original, path, error)) << error;
+    
+    SystemData restored;
+    ASSERT_TRUE(SystemSnapshot::restore(restored, path, error)) << error;
+    std::remove(path.c_str());
+    
+    EXPECT_DOUBLE_EQ(7.0, restored.nominal_output_power);
+    EXPECT_DOUBLE_EQ(25.3, restored.frequency);
+    EXPECT_FALSE(restored.automatic_modulation);
+    EXPECT_DOUBLE_EQ(55.0, restored.monitoring.thresholds.temp_warning_max);
+    EXPECT_FALSE(restored.monitoring.power_config.monitor);
+    EXPECT_EQ(250, restored.monitoring.polling_interval_ms);
+    EXPECT_EQ(DetectorMode::Mad, restored.monitoring.current_detector.mode());
+    EXPECT_DOUBLE_EQ(4.5, restored.monitoring.current_detector.threshold());
+    EXPECT_EQ(1, restored.monitoring.total_alarms_triggered);
+    
+    auto alarms = restored.getActiveAlarms();
+    ASSERT_EQ(1u, alarms.size());
+    EXPECT_EQ(id, alarms[0].id);
+    EXPECT_EQ("Hot", alarms[0].message);
+    EXPECT_TRUE(alarms[0].acknowledged);
+    
+    // New alarm ids continue after the restored ones
+    EXPECT_NE(id, restored.addAlarm("current", "High", "WARNING", 9.5, 9.0));
+    
+    // Restored thresholds drive the compiled rules
+    bool found = false;
+    for (const auto& rule : restored.alarm_rules.rules()) {
+        if (rule.name == "threshold_temperature_warning_max") {
+            EXPECT_DOUBLE_EQ(55.0, rule.threshold);
+            found = true;
+        }
+    }
+    EXPECT_TRUE(found);
+}
+
+TEST(SystemSnapshot, rejects_corrupted_file_without_changes)
+{
+    std::string path = "/tmp/radio_snapshot_bad_" + std::to_string(getpid()) + ".bin";
+    std::string error;
+    
+    SystemData original;
+    original.frequency = 25.9;
+    ASSERT_TRUE(SystemSnapshot::save(original, path, error)) << error;
+    
+    // Flip one payload byte
+    FILE* file = std::fopen(path.c_str(), "r+b");
+    ASSERT_NE(nullptr, file);
+    std::fseek(file, 40, SEEK_SET);
+    int byte = std::fgetc(file);
+    std::fseek(file, 40, SEEK_SET);
+    std::fputc(byte ^ 0xFF, file);
+    std::fclose(file);
+    
+    SystemData target;
+    EXPECT_FALSE(SystemSnapshot::restore(target, path, error));
+    EXPECT_NE(std::string::npos, error.find("checksum"));
+    EXPECT_DOUBLE_EQ(25.0, target.frequency);
+    
+    std::remove(path.c_str());
+    EXPECT_FALSE(SystemSnapshot::restore(target, path, error));
+}
+
+TEST(WriteAheadLog, journals_successful_sets_durably_with_group_commit)
+{
+    std::string path = "/tmp/radio_wal_test_" + std::to_string(getpid()) + ".wal";
+    std::remove(path.c_str());
+    std::string error;
+    std::vector<WriteAheadLog::Record> records;
+    
+    {
+        WriteAheadLog wal(path);
+        ASSERT_TRUE(wal.open(records, error)) << error;
+        EXPECT_TRUE(records.empty());
+        
+        SystemData data;
+        data.wal = &wal;
+        SET set(data);
+        EXPECT_TRUE(set.execute("frequency", "25.5"));
+        EXPECT_EQ(1u, wal.commits());   // answered only once on disk
+        EXPECT_FALSE(set.execute("frequency", "99"));   // rejected, not journaled
+        
+        // Records queued during a sync share the next one
+        for (int i = 0; i < 100; ++i) {
+            wal.append(WriteAheadLog::RecordType::Set, "nominal_output_power", std::to_string(i % 10));
+        }
+        EXPECT_TRUE(wal.sync());
+        EXPECT_EQ(101u, wal.appended());
+        EXPECT_LT(wal.commits(), 101u);
+        EXPECT_EQ(0u, wal.failures());
+        
+        // A change that cannot be journaled is undone and fails
+        wal.close();
+        EXPECT_FALSE(set.execute("frequency", "25.8"));
+        EXPECT_DOUBLE_EQ(25.5, data.frequency);
+        
+        MONITOR monitor(data);
+        int polling_interval_ms = data.monitoring.polling_interval_ms;
+        EXPECT_EQ(0u, monitor.execute("CONFIG SET polling_interval 500").find("ERROR"));
+        EXPECT_EQ(polling_interval_ms, data.monitoring.polling_interval_ms);
+        EXPECT_EQ(0u, monitor.execute("CONFIG SET detector_temperature zscore").find("ERROR"));
+        EXPECT_EQ(DetectorMode::Static, data.monitoring.temp_detector.mode());
+        EXPECT_EQ(0u, monitor.execute("CONFIG SET monitor_voltage off").find("ERROR"));
+        EXPECT_TRUE(data.monitoring.voltage_config.monitor);
+    }
+    
+    WriteAheadLog reopened(path);
+    ASSERT_TRUE(reopened.open(records, error)) << error;
+    ASSERT_EQ(101u, records.size());
+    EXPECT_EQ(WriteAheadLog::RecordType::Set, records[0].type);
+    EXPECT_EQ("frequency", records[0].parameter);
+    EXPECT_EQ("25.5", records[0].value);
+    EXPECT_EQ("9", records[100].value);
+    
+    reopened.close();
+    std::remove(path.c_str());
+}
+
+TEST(WriteAheadLog, recovery_cuts_torn_tail_and_checkpoint_drops_covered_records)
+{
+    std::string path = "/tmp/radio_wal_torn_" + std::to_string(getpid()) + ".wal";
+    std::remove(path.c_str());
+    std::string error;
+    std::vector<WriteAheadLog::Record> records;
+    
+    {
+        WriteAheadLog wal(path);
+        ASSERT_TRUE(wal.open(records, error)) << error;
+        wal.append(WriteAheadLog::RecordType::Set, "frequency", "25.1");
+        wal.append(WriteAheadLog::RecordType::MonitorConfig, "polling_interval_ms", "500");
+        ASSERT_TRUE(wal.sync());
+    }
+    
+    // Simulate a crash in the middle of the second record
+    FILE* file = std::fopen(path.c_str(), "r+b");
+    ASSERT_NE(nullptr, file);
+    std::fseek(file, 0, SEEK_END);
+    long size = std::ftell(file);
+    std::fclose(file);
+    ASSERT_EQ(0, truncate(path.c_str(), size - 3));
+    
+    WriteAheadLog wal(path);
+    ASSERT_TRUE(wal.open(records, error)) << error;
+    ASSERT_EQ(1u, records.size());
+    EXPECT_EQ("25.1", records[0].value);
+    
+    // Records after the mark survive a checkpoint
+    uint64_t mark = wal.mark();
+    wal.append(WriteAheadLog::RecordType::MonitorConfig, "polling_interval_ms", "250");
+    ASSERT_TRUE(wal.checkpoint(mark, error)) << error;
+    wal.close();
+    
+    records.clear();
+    WriteAheadLog reopened(path);
+    ASSERT_TRUE(reopened.open(records, error)) << error;
+    ASSERT_EQ(1u, records.size());
+    EXPECT_EQ(WriteAheadLog::RecordType::MonitorConfig, records[0].type);
+    EXPECT_EQ("250", records[0].value);
+    
+    reopened.close();
+    std::remove(path.c_str());
+}
+
+TEST(MonitoringConfig, loads_file_over_running_values_and_applies)
+{
+    std::string path = "/tmp/radio_config_" + std::to_string(getpid()) + ".conf";
+    {
+        std::ofstream file(path);
+        file << "# reloaded settings\n"
+             << "polling_interval = 250\n"
+             << "temperature_warning_max = 60   # lower than default\n"
+             << "voltage_enabled = off\n"
+             << "power_anomaly_probability = 0.25\n";
+    }
+    
+    SystemData data;
+    double current_max = data.monitoring.current_config.max_value;
+    MonitoringConfig config(data);
+    std::string error;
+    ASSERT_TRUE(config.loadFile(path, error)) << error;
+    
+    // Nothing changes until apply()
+    EXPECT_NE(250, data.monitoring.polling_interval_ms);
+    EXPECT_TRUE(config.apply(data, error)) << error;
+    EXPECT_EQ(250, data.monitoring.polling_interval_ms);
+    EXPECT_DOUBLE_EQ(60.0, data.monitoring.thresholds.temp_warning_max);
+    EXPECT_FALSE(data.monitoring.voltage_config.enabled);
+    EXPECT_DOUBLE_EQ(0.25, data.monitoring.power_config.anomaly_probability);
+    EXPECT_DOUBLE_EQ(current_max, data.monitoring.current_config.max_value);
+    
+    std::remove(path.c_str());
+}
+
+TEST(MonitoringConfig, rejects_unknown_keys_and_inconsistent_thresholds)
+{
+    std::string path = "/tmp/radio_config_bad_" + std::to_string(getpid()) + ".conf";
+    SystemData data;
+    std::string error;
+    
+    {
+        std::ofstream file(path);
+        file << "polling_interval = 500\n" << "temperature_maximum = 90\n";
+    }
+    MonitoringConfig unknown(data);
+    EXPECT_FALSE(unknown.loadFile(path, error));
+    EXPECT_NE(std::string::npos, error.find(":2:")) << error;
+    
+    {
+        std::ofstream file(path);
+        file << "temperature_warning_max = 95\n";  // above temperature_error_max
+    }
+    MonitoringConfig unordered(data);
+    EXPECT_FALSE(unordered.loadFile(path, error));
+    EXPECT_NE(std::string::npos, error.find("temperature")) << error;
+    
+    {
+        std::ofstream file(path);
+        file << "current_min = 5\n" << "current_max = 1\n";
+    }
+    MonitoringConfig range(data);
+    EXPECT_FALSE(range.loadFile(path, error));
+    
+    MonitoringConfig missing(data);
+    EXPECT_FALSE(missing.loadFile(path + ".missing", error));
+    
+    std::remove(path.c_str());
+}
+
+TEST(MonitoringConfig, runtime_config_set_accepts_what_a_reload_accepts)
+{
+    SystemData data;
+    MONITOR monitor(data);
+    int polling_interval_ms = data.monitoring.polling_interval_ms;
+    
+    EXPECT_EQ(0u, monitor.execute("CONFIG SET polling_interval 5").find("ERROR"));
+    EXPECT_EQ(0u, monitor.execute("CONFIG SET polling_interval 3600001").find("ERROR"));
+    EXPECT_EQ(0u, monitor.execute("CONFIG SET polling_interval 2.5").find("ERROR"));
+    EXPECT_EQ(polling_interval_ms, data.monitoring.polling_interval_ms);
+    EXPECT_EQ("SUCCESS: Parameter set", monitor.execute("CONFIG SET polling_interval 10"));
+    EXPECT_EQ(10, data.monitoring.polling_interval_ms);
+    
+    // File keys work at runtime too, with the same ordering checks
+    std::string rejected = monitor.execute("CONFIG SET temperature_warning_max 95");
+    EXPECT_NE(std::string::npos, rejected.find("temperature thresholds")) << rejected;
+    EXPECT_EQ("SUCCESS: Parameter set", monitor.execute("CONFIG SET temperature_warning_max 60"));
+    EXPECT_DOUBLE_EQ(60.0, data.monitoring.thresholds.temp_warning_max);
+    bool rebuilt = false;
+    for (const auto& rule : data.alarm_rules.rules()) {
+        rebuilt |= rule.name == "threshold_temperature_warning_max" && rule.threshold == 60.0;
+    }
+    EXPECT_TRUE(rebuilt);
+    
+    EXPECT_EQ("SUCCESS: Parameter set", monitor.execute("CONFIG SET monitor_power off"));
+    EXPECT_FALSE(data.monitoring.power_config.monitor);
+    EXPECT_EQ(0u, monitor.execute("CONFIG SET monitor_power maybe").find("ERROR"));
+    EXPECT_EQ(0u, monitor.execute("CONFIG SET no_such_key 1").find("ERROR"));
+}
+
+TEST(EventLoop, dispatches_signals_timers_and_cross_thread_events)
+{
+    // signalfd only sees blocked signals
+    sigset_t mask, previous;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGUSR1);
+    ASSERT_EQ(0, pthread_sigmask(SIG_BLOCK, &mask, &previous));
+    
+    EventLoop loop;
+    ASSERT_TRUE(loop.isValid());
+    
+    int signals = 0;
+    uint64_t ticks = 0;
+    uint64_t events = 0;
+    
+    ASSERT_NE(-1, loop.addSignals({SIGUSR1}, [&](int signo) {
+        EXPECT_EQ(SIGUSR1, signo);
+        signals++;
+    }));
+    int timer = loop.addTimer([&](uint64_t expirations) {
+        ticks += expirations;
+        if (ticks >= 3) loop.stop();
+    });
+    ASSERT_NE(-1, timer);
+    int event = loop.addEvent([&](uint64_t count) { events += count; });
+    ASSERT_NE(-1, event);
+    
+    raise(SIGUSR1);
+    std::thread notifier([&]() { loop.notify(event); });
+    notifier.join();
+    ASSERT_TRUE(loop.setTimer(timer, Tracer::now() + 1000000, 1000000));
+    
+    auto start = std::chrono::steady_clock::now();
+    loop.run();
+    
+    EXPECT_EQ(1, signals);
+    EXPECT_GE(ticks, 3u);
+    EXPECT_EQ(1u, events);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+    
+    // stop() before run() makes run() return at once
+    loop.setTimer(timer, 0);
+    loop.stop();
+    loop.run();
+    
+    pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+}
+
+TEST(IpcNames, instances_get_disjoint_resources_and_default_keeps_legacy_names)
+{
+    IpcNames legacy = IpcNames::forInstance();
+    EXPECT_EQ(SHM_NAME, legacy.shm);
+    EXPECT_EQ(SEM_CLIENT_NAME, legacy.sem_client);
+    EXPECT_EQ(STATS_SHM_NAME, legacy.stats_shm);
+    EXPECT_EQ("/tmp/radio_server.pid", legacy.pid_file);
+    
+    IpcNames r1 = IpcNames::forInstance("r1");
+    IpcNames r2 = IpcNames::forInstance("r2");
+    for (const IpcNames* names : {&r1, &r2}) {
+        EXPECT_NE(legacy.shm, names->shm);
+        EXPECT_NE(legacy.sem_client, names->sem_client);
+        EXPECT_NE(legacy.pid_file, names->pid_file);
+        EXPECT_NE(legacy.snapshot, names->snapshot);
+        EXPECT_NE(legacy.wal, names->wal);
+        EXPECT_NE(legacy.archive_dir, names->archive_dir);
+    }
+    EXPECT_NE(r1.shm, r2.shm);
+    EXPECT_NE(r1.stdout_log, r2.stdout_log);
+    
+    EXPECT_TRUE(IpcNames::isValidInstance("radio-2_b"));
+    EXPECT_FALSE(IpcNames::isValidInstance("../etc"));
+    EXPECT_FALSE(IpcNames::isValidInstance("a.b"));
+    EXPECT_FALSE(IpcNames::isValidInstance(std::string(33, 'x')));
+    
+    std::string instance, error;
+    setenv(INSTANCE_ENV, "from_env", 1);
+    ASSERT_TRUE(IpcNames::resolveInstance("", instance, error));
+    EXPECT_EQ("from_env", instance);
+    ASSERT_TRUE(IpcNames::resolveInstance("cli", instance, error));
+    EXPECT_EQ("cli", instance);
+    setenv(INSTANCE_ENV, "bad/name", 1);
+    EXPECT_FALSE(IpcNames::resolveInstance("", instance, error));
+    unsetenv(INSTANCE_ENV);
+    ASSERT_TRUE(IpcNames::resolveInstance("", instance, error));
+    EXPECT_EQ("", instance);
+}
+
+TEST(Realtime, parses_policies_and_restores_thread_after_scope)
+{
+    ThreadPolicy policy;
+    std::string error;
+    EXPECT_TRUE(policy.isDefault());
+    ASSERT_TRUE(ThreadPolicy::parseScheduling("fifo:80", policy, error)) << error;
+    EXPECT_EQ(SCHED_FIFO, policy.policy);
+    EXPECT_EQ(80, policy.priority);
+    ASSERT_TRUE(ThreadPolicy::parseScheduling("rr:1", policy, error)) << error;
+    EXPECT_EQ(SCHED_RR, policy.policy);
+    EXPECT_FALSE(ThreadPolicy::parseScheduling("fifo:0", policy, error));
+    EXPECT_FALSE(ThreadPolicy::parseScheduling("fifo", policy, error));
+    EXPECT_FALSE(ThreadPolicy::parseScheduling("idle:5", policy, error));
+    ASSERT_TRUE(ThreadPolicy::parseScheduling("other", policy, error));
+    EXPECT_TRUE(policy.isDefault());
+    
+    cpu_set_t before;
+    ASSERT_EQ(0, pthread_getaffinity_np(pthread_self(), sizeof(before), &before));
+    int cpu = -1;
+    for (int i = 0; i < CPU_SETSIZE && cpu < 0; ++i) {
+        if (CPU_ISSET(i, &before)) cpu = i;
+    }
+    ASSERT_GE(cpu, 0);
+    
+    policy.cpu = cpu;
+    {
+        ScopedThreadPolicy scoped(policy, error);
+        ASSERT_TRUE(scoped.applied()) << error;
+        cpu_set_t pinned;
+        pthread_getaffinity_np(pthread_self(), sizeof(pinned), &pinned);
+        EXPECT_EQ(1, CPU_COUNT(&pinned));
+        EXPECT_TRUE(CPU_ISSET(cpu, &pinned));
+    }
+    
+    cpu_set_t after;
+    pthread_getaffinity_np(pthread_self(), sizeof(after), &after);
+    EXPECT_TRUE(CPU_EQUAL(&before, &after));
+}
+
+TEST(SharedSegment, attaches_only_to_compatible_layout)
+{
+    EXPECT_EQ(0u, offsetof(SharedData, slots) % CACHE_LINE_SIZE);
+    EXPECT_EQ(0u, sizeof(SharedData::RequestSlot) % CACHE_LINE_SIZE);
+    EXPECT_NE(offsetof(SharedData, requests) / CACHE_LINE_SIZE,
+              offsetof(SharedData, connections) / CACHE_LINE_SIZE);
+    EXPECT_EQ(0u, offsetof(SharedData, alarms) % CACHE_LINE_SIZE);
+    
+    const std::string name = "/radio_control_memory_test";
+    std::string error, warning;
+    SharedSegment server;
+    ASSERT_TRUE(server.create(name, ShmOptions{true, false}, error, warning)) << error;
+    EXPECT_EQ(warning.empty(), server.hugepages());
+    EXPECT_TRUE(server.data()->isCompatible());
+    EXPECT_EQ(getpid(), server.data()->header.server_pid);
+    EXPECT_TRUE(server.data()->monitoring.service_enabled);
+    strcpy(server.data()->slots[0].response, "SUCCESS: ready");
+    
+    SharedSegment client;
+    ASSERT_TRUE(client.attach(name, error)) << error;
+    EXPECT_STREQ("SUCCESS: ready", client.data()->slots[0].response);
+    client.unmap();
+    
+    server.data()->header.version = SharedData::VERSION + 1;
+    EXPECT_FALSE(client.attach(name, error));
+    EXPECT_NE(std::string::npos, error.find("version")) << error;
+    EXPECT_EQ(nullptr, client.data());
+    
+    server.unmap();
+    SharedSegment::unlink(name);
+    EXPECT_FALSE(client.attach(name, error));
+}
+
+TEST(SharedSegment, read_only_observer_never_sees_torn_monitoring_block)
+{
+    const std::string name = "/radio_control_memory_seqlock_test";
+    std::string error, warning;
+    SharedSegment server;
+    ASSERT_TRUE(server.create(name, ShmOptions{false, false}, error, warning)) << error;
+    SharedSegment observer;
+    ASSERT_TRUE(observer.attach(name, error, false)) << error;
+    
+    SharedData::Monitoring& published = server.data()->monitoring;
+    const SharedData::Monitoring& seen = observer.data()->monitoring;
+    const uint32_t writes = 20000;
+    // The writer starts only once the reader is running, so reads overlap writes
+    std::promise<void> reading;
+    std::thread writer([&]() {
+        reading.get_future().wait();
+        for (uint32_t i = 1; i <= writes; ++i) {
+            published.lock.writeBegin();
+            published.temperature = i;
+            published.voltage = i;
+            std::string text = std::to_string(i);
+            memcpy(published.last_update, text.c_str(), text.size() + 1);
+            published.lock.writeEnd();
+        }
+    });
+    
+    // Failures are counted and checked after the join: an ASSERT here
+    // would return with the writer still running
+    size_t reads = 0, failed_reads = 0, torn_reads = 0;
+    reading.set_value();
+    do {
+        double temperature = 0, voltage = 0;
+        char last_update[sizeof(seen.last_update)];
+        bool consistent = seen.lock.read([&]() {
+            temperature = seen.temperature;
+            voltage = seen.voltage;
+            memcpy(last_update, seen.last_update, sizeof(last_update));
+        });
+        last_update[sizeof(last_update) - 1] = '\0';
+        if (!consistent) {
+            ++failed_reads;
+        } else if (temperature != voltage ||
+                   (temperature != 0 && static_cast<unsigned long>(temperature) !=
+                                            std::strtoul(last_update, nullptr, 10))) {
+            ++torn_reads;
+        }
+        ++reads;
+    } while (seen.lock.writes() < writes);
+    writer.join();
+    EXPECT_GT(reads, 0u);
+    EXPECT_EQ(0u, failed_reads);
+    EXPECT_EQ(0u, torn_reads);
+    
+    observer.unmap();
+    server.unmap();
+    SharedSegment::unlink(name);
+}
+
+/**
+ * @brief Minimal command thread for client tests
+ *
+ * Echoes commands and answers FAIL ones with an error. While paused it
+ * takes no requests; answering PAUSE pauses it.
+ */
+class EchoServer {
+public:
+    explicit EchoServer(const std::string& instance) : names(IpcNames::forInstance(instance)) {}
+    ~EchoServer() { stop(); }
+
+    bool start(std::string& error) {
+        SharedSegment::unlink(names.shm);
+        sem_unlink(names.sem_client.c_str());
+        std::string warning;
+        if (!segment_.create(names.shm, ShmOptions(), error, warning)) return false;
+        data = segment_.data();
+        sem_client_ = sem_open(names.sem_client.c_str(), O_CREAT | O_EXCL, 0644, 0);
+        if (sem_client_ == SEM_FAILED) {
+            error = "sem_open failed";
+            return false;
+        }
+        serving_ = std::thread(&EchoServer::serve, this);
+        return true;
+    }
+
+    void stop() {
+        if (serving_.joinable()) {
+            stopping_ = true;
+            sem_post(sem_client_);
+            serving_.join();
+        }
+        if (sem_client_ != SEM_FAILED) {
+            sem_close(sem_client_);
+            sem_client_ = SEM_FAILED;
+            sem_unlink(names.sem_client.c_str());
+        }
+        if (data) {
+            data = nullptr;
+            segment_.unmap();
+            SharedSegment::unlink(names.shm);
+        }
+    }
+
+    IpcNames names;
+    SharedData* data = nullptr;
+    std::atomic<bool> paused{false};
+    std::atomic<int> served{0};
+
+private:
+    void serve() {
+        while (!stopping_) {
+            timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec++;
+            if (sem_timedwait(sem_client_, &deadline) != 0) continue;
+            while (paused && !stopping_) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            int slot = data->takeNextRequest();
+            if (slot < 0) continue;
+            SharedData::RequestSlot& request = data->slots[slot];
+            std::string command = request.command;
+            snprintf(request.response, sizeof(request.response), "%s %s",
+                     command.compare(0, 4, "FAIL") == 0 ? "ERROR:" : "ECHO", command.c_str());
+            if (command == "PAUSE") paused = true;
+            served++;
+            data->completeRequest(slot);
+        }
+    }
+
+    SharedSegment segment_;
+    sem_t* sem_client_ = SEM_FAILED;
+    std::thread serving_;
+    std::atomic<bool> stopping_{false};
+};
+
+TEST(RadioClient, pipelines_requests_and_matches_responses_by_id)
+{
+    EchoServer server("client_lib_test");
+    std::string error;
+    ASSERT_TRUE(server.start(error)) << error;
+    SharedData* data = server.data;
+    
+    RadioClient client(server.names);
+    ASSERT_TRUE(client.connect(1000, error)) << error;
+    
+    std::vector<std::future<RadioResponse>> results;
+    for (size_t i = 0; i < RadioClient::MAX_OUTSTANDING + 4; ++i) {
+        results.push_back(client.submit("GET " + std::to_string(i)));
+    }
+    uint64_t previous_id = 0;
+    for (size_t i = 0; i < results.size(); ++i) {
+        RadioResponse result = results[i].get();
+        ASSERT_EQ(RequestStatus::Ok, result.status) << result.error;
+        EXPECT_EQ("ECHO GET " + std::to_string(i), result.response);
+        EXPECT_GT(result.request_id, previous_id);
+        previous_id = result.request_id;
+    }
+    
+    std::promise<RadioResponse> failed;
+    client.submit("FAIL now", [&failed](const RadioResponse& result) { failed.set_value(result); });
+    EXPECT_EQ(RequestStatus::CommandFailed, failed.get_future().get().status);
+    EXPECT_EQ(RequestStatus::Invalid, client.execute(std::string(300, 'x')).status);
+    
+    // A request the server does not pick up in time is withdrawn
+    server.paused = true;
+    RadioResponse late = client.execute("GET late", 50);
+    EXPECT_EQ(RequestStatus::Timeout, late.status);
+    EXPECT_EQ(0u, client.outstanding());
+    server.paused = false;
+    EXPECT_EQ("ECHO GET after", client.execute("GET after").response);
+    
+    char text[64];
+    radio_client* c_client = radio_client_open("client_lib_test", 1000, text, sizeof(text));
+    ASSERT_NE(nullptr, c_client) << text;
+    EXPECT_EQ(RADIO_OK, radio_client_execute(c_client, "GET c", 0, text, sizeof(text)));
+    EXPECT_STREQ("ECHO GET c", text);
+    radio_client_close(c_client);
+    
+    client.disconnect();
+    for (const auto& connection : data->connections) {
+        EXPECT_EQ(0, connection.owner_pid.load());
+    }
+    for (const auto& slot : data->slots) {
+        EXPECT_EQ(0u, slot.control.load());
+    }
+}
+
+TEST(RadioClient, request_is_not_sent_when_window_stays_full)
+{
+    EchoServer server("client_window_test");
+    std::string error;
+    ASSERT_TRUE(server.start(error)) << error;
+    RadioClient client(server.names);
+    ASSERT_TRUE(client.connect(1000, error)) << error;
+    
+    server.paused = true;
+    std::vector<std::future<RadioResponse>> window;
+    for (size_t i = 0; i < RadioClient::MAX_OUTSTANDING; ++i) {
+        window.push_back(client.submit("GET " + std::to_string(i), 5000));
+    }
+    ASSERT_EQ(RadioClient::MAX_OUTSTANDING, client.outstanding());
+    
+    auto started = std::chrono::steady_clock::now();
+    RadioResponse over = client.execute("GET over", 50);
+    EXPECT_GE(std::chrono::steady_clock::now() - started, std::chrono::milliseconds(50));
+    EXPECT_EQ(RequestStatus::Timeout, over.status);
+    EXPECT_EQ(0u, over.request_id);
+    EXPECT_NE(std::string::npos, over.error.find("outstanding"));
+    RadioResponse submitted = client.submit("GET over", 50).get();
+    EXPECT_EQ(RequestStatus::Timeout, submitted.status);
+    EXPECT_EQ(0u, submitted.request_id);
+    EXPECT_EQ(RadioClient::MAX_OUTSTANDING, client.outstanding());
+    
+    // Once the server answers, the window frees up
+    server.paused = false;
+    for (size_t i = 0; i < window.size(); ++i) {
+        EXPECT_EQ("ECHO GET " + std::to_string(i), window[i].get().response);
+    }
+    EXPECT_EQ("ECHO GET after", client.execute("GET after", 1000).response);
+    EXPECT_EQ(static_cast<int>(RadioClient::MAX_OUTSTANDING) + 1, server.served);
+}
+
+// Command-line client output
+TEST(CommandOutput, json_string_escapes_quotes_backslashes_and_control_characters)
+{
+    EXPECT_EQ("\"\"", jsonString(""));
+    EXPECT_EQ("\"GET frequency\"", jsonString("GET frequency"));
+    EXPECT_EQ("\"say \\\"hi\\\"\"", jsonString("say \"hi\""));
+    EXPECT_EQ("\"C:\\\\tmp\"", jsonString("C:\\tmp"));
+    EXPECT_EQ("\"a\\nb\"", jsonString("a\nb"));
+    EXPECT_EQ("\"\\u0009\\u000d\\u001f\"", jsonString("\t\r\x1f"));
+    // Not ASCII control characters: copied as they are
+    EXPECT_EQ("\"25 \xc2\xb0" "C \x7f\"", jsonString("25 \xc2\xb0" "C \x7f"));
+}
+
+TEST(CommandOutput, exit_status_separates_failed_commands_from_unavailable_server)
+{
+    auto statusOf = [](RequestStatus status, OutputFormat format, std::string& out, std::string& err) {
+        RadioResponse result;
+        result.status = status;
+        if (result.answered()) {
+            result.request_id = 7;
+            result.response = status == RequestStatus::Ok ? "OK" : "ERROR: bad";
+            result.latency_ns = 1500;
+        } else {
+            result.error = "no \"answer\"";
+        }
+        std::ostringstream out_stream, err_stream;
+        ExitStatus exit_status = printResult(out_stream, err_stream, format, "GET x", result);
+        out = out_stream.str();
+        err = err_stream.str();
+        return exit_status;
+    };
+    std::string out, err;
+    
+    EXPECT_EQ(EXIT_OK, statusOf(RequestStatus::Ok, OutputFormat::Text, out, err));
+    EXPECT_EQ("OK\n", out);
+    EXPECT_EQ("", err);
+    EXPECT_EQ(EXIT_COMMAND_FAILED, statusOf(RequestStatus::CommandFailed, OutputFormat::Text, out, err));
+    EXPECT_EQ("ERROR: bad\n", out);
+    // Too long to send: only this command failed
+    EXPECT_EQ(EXIT_COMMAND_FAILED, statusOf(RequestStatus::Invalid, OutputFormat::Text, out, err));
+    EXPECT_EQ("", out);
+    EXPECT_EQ("Error: no \"answer\"\n", err);
+    EXPECT_EQ(EXIT_UNAVAILABLE, statusOf(RequestStatus::Timeout, OutputFormat::Text, out, err));
+    EXPECT_EQ(EXIT_UNAVAILABLE, statusOf(RequestStatus::Disconnected, OutputFormat::Text, out, err));
+    
+    EXPECT_EQ(EXIT_COMMAND_FAILED, statusOf(RequestStatus::CommandFailed, OutputFormat::Json, out, err));
+    EXPECT_EQ("{\"command\":\"GET x\",\"ok\":false,\"request_id\":7,\"response\":\"ERROR: bad\","
+              "\"latency_us\":1.5}\n", out);
+    EXPECT_EQ(EXIT_UNAVAILABLE, statusOf(RequestStatus::Timeout, OutputFormat::Json, out, err));
+    EXPECT_EQ("{\"command\":\"GET x\",\"ok\":false,\"error\":\"no \\\"answer\\\"\"}\n", out);
+    EXPECT_EQ("", err);
+}
+
+TEST(CommandOutput, batch_prints_in_input_order_and_stops_at_first_unanswered_command)
+{
+    EchoServer server("command_output_test");
+    std::string error;
+    ASSERT_TRUE(server.start(error)) << error;
+    RadioClient client(server.names);
+    ASSERT_TRUE(client.connect(1000, error)) << error;
+    
+    // Failed commands do not stop the batch; comments and blank lines are skipped
+    std::istringstream commands("GET 1\n# comment\n\n  FAIL 2\r\nGET 3\n");
+    std::ostringstream out, err;
+    BatchOptions options;
+    options.pipeline = 4;
+    EXPECT_EQ(EXIT_COMMAND_FAILED, runBatch(client, commands, out, err, options));
+    EXPECT_EQ("ECHO GET 1\nERROR: FAIL 2\nECHO GET 3\n", out.str());
+    EXPECT_EQ("", err.str());
+    
+    // The server stops answering after PAUSE: GET 5 times out and ends
+    // the batch, GET 6 is not printed even if it was already sent
+    for (size_t pipeline : {size_t(1), size_t(4)}) {
+        SCOPED_TRACE(pipeline);
+        std::istringstream stalling("GET 4\nPAUSE\nGET 5\nGET 6\n");
+        std::ostringstream stalled_out, stalled_err;
+        options.pipeline = pipeline;
+        options.timeout_ms = 100;
+        options.format = OutputFormat::Json;
+        int served = server.served;
+        EXPECT_EQ(EXIT_UNAVAILABLE, runBatch(client, stalling, stalled_out, stalled_err, options));
+        std::string printed = stalled_out.str();
+        EXPECT_NE(std::string::npos, printed.find("\"response\":\"ECHO PAUSE\""));
+        EXPECT_NE(std::string::npos, printed.find("{\"command\":\"GET 5\",\"ok\":false,\"error\":"));
+        EXPECT_EQ(std::string::npos, printed.find("GET 6"));
+        EXPECT_EQ(3, std::count(printed.begin(), printed.end(), '\n'));
+        
+        // Let a pipelined GET 6 time out too before the server resumes
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (client.outstanding() > 0 && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        EXPECT_EQ(0u, client.outstanding());
+        server.paused = false;
+        EXPECT_TRUE(client.execute("GET resumed").ok());
+        // Neither GET 5 nor GET 6 reached the server
+        EXPECT_EQ(served + 3, server.served);
+    }
+}
+
+TEST(Watchdog, restarts_stalled_components_then_escalates)
+{
+    const int64_t ms = 1000000;
+    Watchdog watchdog;
+    watchdog.setDeadline(100 * ms);
+    std::vector<std::string> escalated;
+    watchdog.setEscalation([&](const std::string& name) { escalated.push_back(name); });
+    
+    int64_t start = Tracer::now();
+    std::atomic<int64_t> healthy{start}, stalled{start};
+    int healthy_restarts = 0, stalled_restarts = 0;
+    watchdog.watch("beating thread", &healthy, [&]() { healthy_restarts++; return true; });
+    watchdog.watch("stuck thread", &stalled, [&]() { stalled_restarts++; return true; });
+    
+    // The healthy component keeps beating; the other one stops after start
+    int64_t now = Tracer::now();
+    for (unsigned i = 0; i < Watchdog::MAX_RESTARTS; ++i) {
+        now += 100 * ms + 1;
+        healthy = now;
+        watchdog.check(now);
+    }
+    EXPECT_EQ(0, healthy_restarts);
+    EXPECT_EQ(static_cast<int>(Watchdog::MAX_RESTARTS), stalled_restarts);
+    EXPECT_TRUE(escalated.empty());
+    
+    // A beat after a restart counts as recovered; the next stall restarts again
+    stalled = now + 1;
+    now += 101 * ms;
+    healthy = now;
+    watchdog.check(now);
+    EXPECT_EQ(static_cast<int>(Watchdog::MAX_RESTARTS) + 1, stalled_restarts);
+    EXPECT_TRUE(escalated.empty());
+    
+    // Stalled through all restarts: escalated exactly once
+    for (int i = 0; i < 6; ++i) {
+        now += 101 * ms;
+        healthy = now;
+        watchdog.check(now);
+    }
+    ASSERT_EQ(1u, escalated.size());
+    EXPECT_EQ("stuck thread", escalated[0]);
+    EXPECT_EQ(0, healthy_restarts);
+    EXPECT_EQ(2 * Watchdog::MAX_RESTARTS, watchdog.restarts());
+}
+
+TEST(EventLoop, second_thread_takes_over_from_stuck_handler)
+{
+    EventLoop loop;
+    int timer = -1;
+    std::atomic<bool> release{false};
+    std::atomic<int> calls{0};
+    std::atomic<bool> stuck_entered{false};
+    timer = loop.addTimer([&](uint64_t) {
+        if (calls++ == 0) {
+            stuck_entered = true;
+            while (!release) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    int64_t period = 5 * 1000000LL;
+    loop.setTimer(timer, Tracer::now() + period, period);
+    
+    std::atomic<int> first_result{-1};
+    std::thread first([&]() { first_result = loop.run() ? 1 : 0; });
+    while (!stuck_entered) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    
+    std::atomic<int> second_result{-1};
+    std::thread second([&]() { second_result = loop.run() ? 1 : 0; });
+    while (calls < 3) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    
+    release = true;
+    first.join();
+    EXPECT_EQ(0, first_result.load());
+    
+    loop.stop();
+    second.join();
+    EXPECT_EQ(1, second_result.load());
+}
+
+TEST(Tracer, dump_writes_recorded_spans_as_chrome_json)
+{
+    Tracer& tracer = Tracer::instance();
+    tracer.clear();
+    
+    std::thread worker([&tracer]() {
+        tracer.setThreadName("worker");
+        TRACE_SCOPE("test.worker_span", "test");
+    });
+    worker.join();
+    {
+        TraceSpan span("test.main_span", "test");
+        span.end();
+    }
+    
+    std::string path = "/tmp/radio_trace_test_" + std::to_string(getpid()) + ".json";
+    size_t events = 0;
+    ASSERT_TRUE(tracer.dump(path, events));
+    EXPECT_EQ(2u, events);
+    
+    std::ifstream in(path);
+    std::stringstream json;
+    json << in.rdbuf();
+    std::remove(path.c_str());
+    
+    EXPECT_EQ(0u, json.str().find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["));
+    EXPECT_NE(std::string::npos, json.str().find("\"name\":\"test.worker_span\",\"cat\":\"test\""));
+    EXPECT_NE(std::string::npos, json.str().find("\"name\":\"test.main_span\""));
+    EXPECT_NE(std::string::npos, json.str().find("\"args\":{\"name\":\"worker\"}"));
+    
+    tracer.clear();
+    ASSERT_TRUE(tracer.dump(path, events));
+    std::remove(path.c_str());
+    EXPECT_EQ(0u, events);
+}
+
+TEST(Tracer, trace_dump_command_only_creates_files_in_trace_directory)
+{
+    SystemData data;
+    MONITOR monitor(data);
+    EXPECT_EQ("ERROR: Trace dumps are not enabled", monitor.execute("TRACE DUMP t.json"));
+    
+    std::string dir = "/tmp/radio_traces_test_" + std::to_string(getpid());
+    std::string outside = dir + "_outside";
+    monitor.setTraceDirectory(dir);
+    
+    std::string dumped = monitor.execute("TRACE DUMP t.json");
+    EXPECT_EQ(0u, dumped.find("SUCCESS")) << dumped;
+    EXPECT_EQ(0, access((dir + "/t.json").c_str(), F_OK));
+    // Never overwritten, never written through a link
+    EXPECT_EQ(0u, monitor.execute("TRACE DUMP t.json").find("ERROR"));
+    { std::ofstream(outside) << "keep"; }
+    ASSERT_EQ(0, symlink(outside.c_str(), (dir + "/link.json").c_str()));
+    EXPECT_EQ(0u, monitor.execute("TRACE DUMP link.json").find("ERROR"));
+    std::ifstream kept(outside);
+    std::string content;
+    kept >> content;
+    EXPECT_EQ("keep", content);
+    
+    for (const char* name : {"../escape.json", "/tmp/escape.json", "sub/t.json", "..", "."}) {
+        EXPECT_EQ(0u, monitor.execute(std::string("TRACE DUMP ") + name).find("ERROR: Use TRACE DUMP")) << name;
+    }
+    
+    // A directory others can write to is not used
+    ASSERT_EQ(0, chmod(dir.c_str(), 0777));
+    EXPECT_EQ(0u, monitor.execute("TRACE DUMP u.json").find("ERROR"));
+    
+    std::remove((dir + "/t.json").c_str());
+    std::remove((dir + "/link.json").c_str());
+    std::remove(outside.c_str());
+    rmdir(dir.c_str());
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();